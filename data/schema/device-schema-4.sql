@@ -0,0 +1,13 @@
+DROP TABLE IF EXISTS device_%deviceid_fts;
+
+CREATE VIRTUAL TABLE device_%deviceid_fts USING fts5(
+  ftstitle, ftsalbum, ftsartist, ftsalbumartist, ftscomposer, ftsperformer, ftsgrouping, ftsgenre, ftscomment,
+  prefix = '2 3',
+  tokenize = "unicode61 remove_diacritics 1"
+);
+
+INSERT INTO device_%deviceid_fts (ROWID, ftstitle, ftsalbum, ftsartist, ftsalbumartist, ftscomposer, ftsperformer, ftsgrouping, ftsgenre, ftscomment)
+SELECT ROWID, title, album, artist, albumartist, composer, performer, grouping, genre, comment
+FROM device_%deviceid_songs;
+
+UPDATE devices SET schema_version=4 WHERE ROWID=%deviceid;
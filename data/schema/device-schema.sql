@@ -77,7 +77,8 @@ CREATE INDEX idx_device_%deviceid_songs_comp_artist ON device_%deviceid_songs (c
 
 CREATE VIRTUAL TABLE device_%deviceid_fts USING fts5(
   ftstitle, ftsalbum, ftsartist, ftsalbumartist, ftscomposer, ftsperformer, ftsgrouping, ftsgenre, ftscomment,
+  prefix = '2 3',
   tokenize = "unicode61 remove_diacritics 1"
 );
 
-UPDATE devices SET schema_version=3 WHERE ROWID=%deviceid;
+UPDATE devices SET schema_version=4 WHERE ROWID=%deviceid;
@@ -0,0 +1,13 @@
+CREATE TABLE IF NOT EXISTS fingerprint_cache (
+  device INTEGER NOT NULL DEFAULT 0,
+  inode INTEGER NOT NULL DEFAULT 0,
+  filesize INTEGER NOT NULL DEFAULT 0,
+  audio_hash TEXT NOT NULL,
+  fingerprint TEXT NOT NULL
+);
+
+CREATE INDEX IF NOT EXISTS idx_fingerprint_cache_audio_hash ON fingerprint_cache (audio_hash);
+
+CREATE INDEX IF NOT EXISTS idx_fingerprint_cache_file ON fingerprint_cache (device, inode);
+
+UPDATE schema_version SET version=16;
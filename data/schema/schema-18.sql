@@ -0,0 +1,23 @@
+DROP TABLE IF EXISTS %allsongstables_fts;
+
+CREATE VIRTUAL TABLE %allsongstables_fts USING fts5(
+
+  ftstitle,
+  ftsalbum,
+  ftsartist,
+  ftsalbumartist,
+  ftscomposer,
+  ftsperformer,
+  ftsgrouping,
+  ftsgenre,
+  ftscomment,
+  prefix = '2 3',
+  tokenize = "unicode61 remove_diacritics 1"
+
+);
+
+INSERT INTO %allsongstables_fts (ROWID, ftstitle, ftsalbum, ftsartist, ftsalbumartist, ftscomposer, ftsperformer, ftsgrouping, ftsgenre, ftscomment)
+SELECT ROWID, title, album, artist, albumartist, composer, performer, grouping, genre, comment
+FROM %allsongstables;
+
+UPDATE schema_version SET version=18;
@@ -0,0 +1,15 @@
+DROP TABLE IF EXISTS fingerprint_cache;
+
+CREATE TABLE fingerprint_cache (
+  filename TEXT NOT NULL DEFAULT '',
+  device INTEGER NOT NULL DEFAULT 0,
+  inode INTEGER NOT NULL DEFAULT 0,
+  filesize INTEGER NOT NULL DEFAULT 0,
+  audio_hash TEXT NOT NULL,
+  fingerprint TEXT NOT NULL,
+  UNIQUE (audio_hash, filesize)
+);
+
+CREATE INDEX IF NOT EXISTS idx_fingerprint_cache_file ON fingerprint_cache (device, inode);
+
+UPDATE schema_version SET version=19;
@@ -4,7 +4,7 @@ CREATE TABLE IF NOT EXISTS schema_version (
 
 DELETE FROM schema_version;
 
-INSERT INTO schema_version (version) VALUES (15);
+INSERT INTO schema_version (version) VALUES (19);
 
 CREATE TABLE IF NOT EXISTS directories (
   path TEXT NOT NULL,
@@ -591,7 +591,9 @@ CREATE TABLE IF NOT EXISTS playlist_items (
 
   cue_path TEXT,
 
-  rating INTEGER DEFAULT -1
+  rating INTEGER DEFAULT -1,
+
+  position INTEGER NOT NULL DEFAULT 0
 
 );
 
@@ -612,6 +614,16 @@ CREATE TABLE IF NOT EXISTS radio_channels (
   thumbnail_url TEXT
 );
 
+CREATE TABLE IF NOT EXISTS fingerprint_cache (
+  filename TEXT NOT NULL DEFAULT '',
+  device INTEGER NOT NULL DEFAULT 0,
+  inode INTEGER NOT NULL DEFAULT 0,
+  filesize INTEGER NOT NULL DEFAULT 0,
+  audio_hash TEXT NOT NULL,
+  fingerprint TEXT NOT NULL,
+  UNIQUE (audio_hash, filesize)
+);
+
 CREATE INDEX IF NOT EXISTS idx_url ON songs (url);
 
 CREATE INDEX IF NOT EXISTS idx_comp_artist ON songs (compilation_effective, artist);
@@ -624,6 +636,10 @@ CREATE INDEX IF NOT EXISTS idx_album ON songs (album);
 
 CREATE INDEX IF NOT EXISTS idx_title ON songs (title);
 
+CREATE INDEX IF NOT EXISTS idx_fingerprint_cache_file ON fingerprint_cache (device, inode);
+
+CREATE INDEX IF NOT EXISTS idx_playlist_items_playlist ON playlist_items (playlist, position);
+
 CREATE VIEW IF NOT EXISTS duplicated_songs as select artist dup_artist, album dup_album, title dup_title from songs as inner_songs where artist != '' and album != '' and title != '' and unavailable = 0 group by artist, album , title having count(*) > 1;
 
 CREATE VIRTUAL TABLE IF NOT EXISTS songs_fts USING fts5(
@@ -637,6 +653,7 @@ CREATE VIRTUAL TABLE IF NOT EXISTS songs_fts USING fts5(
   ftsgrouping,
   ftsgenre,
   ftscomment,
+  prefix = '2 3',
   tokenize = "unicode61 remove_diacritics 1"
 
 );
@@ -652,6 +669,7 @@ CREATE VIRTUAL TABLE IF NOT EXISTS subsonic_songs_fts USING fts5(
   ftsgrouping,
   ftsgenre,
   ftscomment,
+  prefix = '2 3',
   tokenize = "unicode61 remove_diacritics 1"
 
 );
@@ -667,6 +685,7 @@ CREATE VIRTUAL TABLE IF NOT EXISTS tidal_artists_songs_fts USING fts5(
   ftsgrouping,
   ftsgenre,
   ftscomment,
+  prefix = '2 3',
   tokenize = "unicode61 remove_diacritics 1"
 
 );
@@ -682,6 +701,7 @@ CREATE VIRTUAL TABLE IF NOT EXISTS tidal_albums_songs_fts USING fts5(
   ftsgrouping,
   ftsgenre,
   ftscomment,
+  prefix = '2 3',
   tokenize = "unicode61 remove_diacritics 1"
 
 );
@@ -697,6 +717,7 @@ CREATE VIRTUAL TABLE IF NOT EXISTS tidal_songs_fts USING fts5(
   ftsgrouping,
   ftsgenre,
   ftscomment,
+  prefix = '2 3',
   tokenize = "unicode61 remove_diacritics 1"
 
 );
@@ -712,6 +733,7 @@ CREATE VIRTUAL TABLE IF NOT EXISTS qobuz_artists_songs_fts USING fts5(
   ftsgrouping,
   ftsgenre,
   ftscomment,
+  prefix = '2 3',
   tokenize = "unicode61 remove_diacritics 1"
 
 );
@@ -727,6 +749,7 @@ CREATE VIRTUAL TABLE IF NOT EXISTS qobuz_albums_songs_fts USING fts5(
   ftsgrouping,
   ftsgenre,
   ftscomment,
+  prefix = '2 3',
   tokenize = "unicode61 remove_diacritics 1"
 
 );
@@ -742,6 +765,7 @@ CREATE VIRTUAL TABLE IF NOT EXISTS qobuz_songs_fts USING fts5(
   ftsgrouping,
   ftsgenre,
   ftscomment,
+  prefix = '2 3',
   tokenize = "unicode61 remove_diacritics 1"
 
 );
@@ -757,6 +781,7 @@ CREATE VIRTUAL TABLE IF NOT EXISTS %allsongstables_fts USING fts5(
   ftsgrouping,
   ftsgenre,
   ftscomment,
+  prefix = '2 3',
   tokenize = "unicode61 remove_diacritics 1"
 
 );
@@ -27,6 +27,7 @@
 #include <QBuffer>
 #include <QByteArray>
 #include <QMap>
+#include <QElapsedTimer>
 #include <QString>
 #include <QLocalSocket>
 #include <QAbstractSocket>
@@ -50,6 +51,10 @@ class _MessageHandlerBase : public QObject {
   // After this is true, messages cannot be sent to the handler any more.
   bool is_device_closed() const { return is_device_closed_; }
 
+ signals:
+  // Emitted when the last reply to a request sent with SendRequest() arrives, with the time it took.
+  void ReplyFinished(const qint64 latency_msec);
+
  protected slots:
   void WriteMessage(const QByteArray &data);
   void DeviceReadyRead();
@@ -104,12 +109,16 @@ class AbstractMessageHandler : public _MessageHandlerBase {
   // Called when a message is received from the socket.
   virtual void MessageArrived(const MessageType &message) { Q_UNUSED(message); }
 
+  // Returns true if more replies will follow this one for the same request.
+  virtual bool IsPartialReply(const MessageType &message) const { Q_UNUSED(message); return false; }
+
   // _MessageHandlerBase
   bool RawMessageArrived(const QByteArray &data) override;
   void AbortAll() override;
 
  private:
   QMap<int, ReplyType*> pending_replies_;
+  QMap<int, QElapsedTimer> pending_timers_;
 };
 
 template<typename MT>
@@ -133,6 +142,7 @@ void AbstractMessageHandler<MT>::SendMessageAsync(const MessageType &message) {
 template<typename MT>
 void AbstractMessageHandler<MT>::SendRequest(ReplyType *reply) {
   pending_replies_[reply->id()] = reply;
+  pending_timers_[reply->id()].start();
   SendMessage(reply->request_message());
 }
 
@@ -152,8 +162,14 @@ bool AbstractMessageHandler<MT>::RawMessageArrived(const QByteArray &data) {
 
   if (pending_replies_.contains(message.id())) {
     // This is a reply to a message that we created earlier.
-    ReplyType *reply = pending_replies_.take(message.id());
-    reply->SetReply(message);
+    if (IsPartialReply(message)) {
+      pending_replies_.value(message.id())->SetPartialReply(message);
+    }
+    else {
+      ReplyType *reply = pending_replies_.take(message.id());
+      reply->SetReply(message);
+      emit ReplyFinished(pending_timers_.take(message.id()).elapsed());
+    }
   }
   else {
     MessageArrived(message);
@@ -170,6 +186,7 @@ void AbstractMessageHandler<MT>::AbortAll() {
     reply->Abort();
   }
   pending_replies_.clear();
+  pending_timers_.clear();
 
 }
 
@@ -19,12 +19,13 @@
 #include "messagereply.h"
 
 #include <QObject>
+#include <QMutexLocker>
 #include <QtDebug>
 
 #include "core/logging.h"
 
 _MessageReplyBase::_MessageReplyBase(QObject *parent)
-    : QObject(parent), finished_(false), success_(false) {}
+    : QObject(parent), finished_(false), success_(false), has_partial_reply_(false) {}
 
 bool _MessageReplyBase::WaitForFinished() {
 
@@ -38,8 +39,12 @@ bool _MessageReplyBase::WaitForFinished() {
 void _MessageReplyBase::Abort() {
 
   Q_ASSERT(!finished_);
-  finished_ = true;
-  success_ = false;
+  {
+    QMutexLocker l(&mutex_);
+    finished_ = true;
+    success_ = false;
+    partial_reply_condition_.wakeAll();
+  }
 
   emit Finished();
   qLog(Debug) << "Releasing ID" << id() << "(aborted)";
@@ -21,6 +21,8 @@
 
 #include <QtGlobal>
 #include <QObject>
+#include <QMutex>
+#include <QWaitCondition>
 #include <QSemaphore>
 #include <QString>
 #include <QTimer>
@@ -47,12 +49,18 @@ class _MessageReplyBase : public QObject {
 
  signals:
   void Finished();
+  // Emitted for each partial reply to a request that is answered with a stream of messages.
+  void PartialReply();
 
  protected:
   bool finished_;
   bool success_;
 
   QSemaphore semaphore_;
+  QMutex mutex_;
+  // Signalled with mutex_ held when a partial reply arrives or the reply finishes.
+  QWaitCondition partial_reply_condition_;
+  bool has_partial_reply_;
 };
 
 // A reply future class that is returned immediately for requests that will occur in the background.  Similar to QNetworkReply.
@@ -67,6 +75,17 @@ class MessageReply : public _MessageReplyBase {
 
   void SetReply(const MessageType &message);
 
+  // Merges a partial reply into the reply message without finishing the reply.
+  void SetPartialReply(const MessageType &message);
+
+  // Returns the partial replies merged so far and clears them from the reply message.  Can be called from any thread.
+  MessageType TakePartialReply();
+
+  // Waits until a partial reply arrives or the reply finishes, then takes the replies merged so far like TakePartialReply().
+  // Sets finished when the reply has finished, the returned message then holds the rest of the reply.
+  // Never call this from the MessageHandler's thread or it will block forever.
+  MessageType WaitForPartialReply(bool *finished);
+
  private:
   MessageType request_message_;
   MessageType reply_message_;
@@ -83,9 +102,13 @@ void MessageReply<MessageType>::SetReply(const MessageType &message) {
 
   Q_ASSERT(!finished_);
 
-  reply_message_.MergeFrom(message);
-  finished_ = true;
-  success_ = true;
+  {
+    QMutexLocker l(&mutex_);
+    reply_message_.MergeFrom(message);
+    finished_ = true;
+    success_ = true;
+    partial_reply_condition_.wakeAll();
+  }
 
   qLog(Debug) << "Releasing ID" << id() << "(finished)";
 
@@ -96,4 +119,46 @@ void MessageReply<MessageType>::SetReply(const MessageType &message) {
 
 }
 
+template<typename MessageType>
+void MessageReply<MessageType>::SetPartialReply(const MessageType &message) {
+
+  Q_ASSERT(!finished_);
+
+  {
+    QMutexLocker l(&mutex_);
+    reply_message_.MergeFrom(message);
+    has_partial_reply_ = true;
+    partial_reply_condition_.wakeAll();
+  }
+
+  QMetaObject::invokeMethod(this, "PartialReply", Qt::QueuedConnection);
+
+}
+
+template<typename MessageType>
+MessageType MessageReply<MessageType>::TakePartialReply() {
+
+  QMutexLocker l(&mutex_);
+  MessageType message;
+  message.Swap(&reply_message_);
+  has_partial_reply_ = false;
+  return message;
+
+}
+
+template<typename MessageType>
+MessageType MessageReply<MessageType>::WaitForPartialReply(bool *finished) {
+
+  QMutexLocker l(&mutex_);
+  while (!finished_ && !has_partial_reply_) {
+    partial_reply_condition_.wait(&mutex_);
+  }
+  *finished = finished_;
+  MessageType message;
+  message.Swap(&reply_message_);
+  has_partial_reply_ = false;
+  return message;
+
+}
+
 #endif  // MESSAGEREPLY_H
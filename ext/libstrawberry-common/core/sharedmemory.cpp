@@ -0,0 +1,67 @@
+/* This file is part of Strawberry.
+   Copyright 2026, agent <agent@local>
+
+   Strawberry is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Strawberry is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+
+#include <QtGlobal>
+#include <QCoreApplication>
+#include <QObject>
+#include <QSharedMemory>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QString>
+
+#include "core/logging.h"
+#include "sharedmemory.h"
+
+namespace SharedMemory {
+
+const qint64 kThreshold = 256 * 1024;
+const qint64 kMaxSize = 64 * 1024 * 1024;
+
+namespace {
+QAtomicInt sNextId(0);
+}
+
+QSharedMemory *Create(const qint64 size, QObject *parent) {
+
+  if (size <= 0 || size > kMaxSize) return nullptr;
+
+  const QString key = QString("%1-%2-%3").arg(QCoreApplication::applicationName().toLower()).arg(QCoreApplication::applicationPid()).arg(sNextId.fetchAndAddOrdered(1));
+  QSharedMemory *shared_memory = new QSharedMemory(key, parent);
+  if (!shared_memory->create(static_cast<int>(size))) {
+    qLog(Warning) << "Could not create shared memory segment of" << size << "bytes:" << shared_memory->errorString();
+    delete shared_memory;
+    return nullptr;
+  }
+
+  return shared_memory;
+
+}
+
+QSharedMemory *Create(const QByteArray &data, QObject *parent) {
+
+  QSharedMemory *shared_memory = Create(data.size(), parent);
+  if (shared_memory) {
+    memcpy(shared_memory->data(), data.constData(), static_cast<size_t>(data.size()));
+  }
+
+  return shared_memory;
+
+}
+
+}  // namespace SharedMemory
@@ -0,0 +1,47 @@
+/* This file is part of Strawberry.
+   Copyright 2026, agent <agent@local>
+
+   Strawberry is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Strawberry is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SHAREDMEMORY_H
+#define SHAREDMEMORY_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QString>
+
+class QObject;
+class QSharedMemory;
+
+// Passes large payloads between the main process and the workers in a QSharedMemory segment instead of through the message socket.
+// The process that creates a segment owns it, the other process only attaches to it while handling the message that carries its key.
+// Segments sent back in replies are kept by the worker for a short time only, the client attaches to them as soon as the reply arrives.
+namespace SharedMemory {
+
+// Payloads smaller than this are sent inside the message.
+extern const qint64 kThreshold;
+
+// Largest segment created, larger payloads are sent inside the message.
+extern const qint64 kMaxSize;
+
+// Creates a segment with a unique key and room for size bytes.  Returns nullptr if the segment could not be created.
+QSharedMemory *Create(const qint64 size, QObject *parent = nullptr);
+
+// Creates a segment holding a copy of data.  Returns nullptr if the segment could not be created.
+QSharedMemory *Create(const QByteArray &data, QObject *parent = nullptr);
+
+}  // namespace SharedMemory
+
+#endif  // SHAREDMEMORY_H
@@ -20,4 +20,7 @@
 
 #include "workerpool.h"
 
+const int _WorkerPoolBase::kWorkerBacklog = 2;
+const int _WorkerPoolBase::kWorkerIdleMsec = 30000;
+
 _WorkerPoolBase::_WorkerPoolBase(QObject *parent) : QObject(parent) {}
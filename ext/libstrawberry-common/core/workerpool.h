@@ -29,6 +29,8 @@
 #include <QCoreApplication>
 #include <QThread>
 #include <QMutex>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <QLocalServer>
 #include <QProcess>
 #include <QFile>
@@ -52,6 +54,21 @@ class _WorkerPoolBase : public QObject {
  public:
   explicit _WorkerPoolBase(QObject *parent = nullptr);
 
+  // Request counters for one worker, shown in the debug console.
+  struct WorkerStats {
+    WorkerStats() : pending(0), replies(0), total_latency_msec(0), max_latency_msec(0) {}
+    int pending;  // Requests sent to the worker that haven't been answered yet.
+    qint64 replies;
+    qint64 total_latency_msec;
+    qint64 max_latency_msec;
+  };
+
+ protected:
+  // An extra worker is started when every worker has this many requests pending.
+  static const int kWorkerBacklog;
+  // Extra workers are stopped after being idle for this long.
+  static const int kWorkerIdleMsec;
+
  signals:
   // Emitted when a worker failed to start.  This usually happens when the worker wasn't found, or couldn't be executed.
   void WorkerFailedToStart();
@@ -63,6 +80,8 @@ class _WorkerPoolBase : public QObject {
   virtual void ProcessReadyReadStandardError() {}
   virtual void ProcessError(QProcess::ProcessError) {}
   virtual void SendQueuedMessages() {}
+  virtual void HandlerReplyFinished(const qint64 latency_msec) { Q_UNUSED(latency_msec); }
+  virtual void CheckIdleWorkers() {}
 };
 
 
@@ -70,6 +89,8 @@ class _WorkerPoolBase : public QObject {
 // A local socket server is started for each process, and the address is passed to the process as argv[1].
 // The process is expected to connect back to the socket server, and when it does a HandlerType is created for it.
 // Instances of HandlerType are created in the WorkerPool's thread.
+// Requests go to the worker with the fewest pending requests.
+// If a maximum worker count is set, extra workers are started when all workers are backlogged and stopped again when idle.
 template<typename HandlerType>
 class WorkerPool : public _WorkerPoolBase {
  public:
@@ -86,6 +107,9 @@ class WorkerPool : public _WorkerPoolBase {
   // Sets the number of worker process to use.  Defaults to 1 <= (processors / 2) <= 2.
   void SetWorkerCount(const int count);
 
+  // Sets the number of worker processes the pool can grow to under load.  Defaults to the worker count, call this after SetWorkerCount().
+  void SetMaxWorkerCount(const int count);
+
   // Sets the prefix to use for the local server (on unix this is a named pipe in /tmp).
   // Defaults to QApplication::applicationName().
   // A random number is appended to this name when creating each server.
@@ -99,6 +123,9 @@ class WorkerPool : public _WorkerPoolBase {
   // Can be called from any thread.
   ReplyType *SendMessageWithReply(MessageType *message);
 
+  // Returns the request counters for each running worker.  Can be called from any thread.
+  QList<WorkerStats> worker_stats() const;
+
  protected:
   // These are all reimplemented slots, they are called on the WorkerPool's thread.
   void DoStart() override;
@@ -107,19 +134,26 @@ class WorkerPool : public _WorkerPoolBase {
   void ProcessReadyReadStandardError() override;
   void ProcessError(QProcess::ProcessError error) override;
   void SendQueuedMessages() override;
+  void HandlerReplyFinished(const qint64 latency_msec) override;
+  void CheckIdleWorkers() override;
 
  private:
   struct Worker {
-    Worker() : local_server_(nullptr), local_socket_(nullptr), process_(nullptr), handler_(nullptr) {}
+    Worker() : local_server_(nullptr), local_socket_(nullptr), process_(nullptr), handler_(nullptr), last_active_msec_(0) {}
 
     QLocalServer *local_server_;
     QLocalSocket *local_socket_;
     QProcess *process_;
     HandlerType *handler_;
+
+    WorkerStats stats_;
+    qint64 last_active_msec_;
   };
 
   // Must only ever be called on my thread.
   void StartOneWorker(Worker *worker);
+  void AddWorker();
+  void RemoveWorker(const int worker_index);
 
   template<typename T>
   Worker *FindWorker(T Worker::*member, T value) {
@@ -143,8 +177,11 @@ class WorkerPool : public _WorkerPoolBase {
   // and sets the request's ID to the ID of the reply.  Can be called from any thread
   ReplyType *NewReply(MessageType *message);
 
-  // Returns the next handler, or nullptr if there isn't one.  Must be called from my thread.
-  HandlerType *NextHandler() const;
+  // Returns the connected worker with the fewest pending requests, or nullptr if there isn't one.  Must be called from my thread.
+  Worker *NextWorker();
+
+  // Starts another worker if every worker is backlogged.  Must be called from my thread.
+  void GrowIfBacklogged();
 
  private:
   QString local_server_name_;
@@ -152,8 +189,14 @@ class WorkerPool : public _WorkerPoolBase {
   QString executable_path_;
 
   int worker_count_;
-  mutable int next_worker_;
+  int max_worker_count_;
+  int next_worker_;
   QList<Worker> workers_;
+  // Protects workers_ and the stats in it against worker_stats() from other threads.
+  mutable QMutex workers_mutex_;
+
+  QTimer *idle_timer_;
+  QElapsedTimer uptime_;
 
   QAtomicInt next_id_;
 
@@ -166,9 +209,11 @@ template<typename HandlerType>
 WorkerPool<HandlerType>::WorkerPool(QObject *parent)
     : _WorkerPoolBase(parent),
       next_worker_(0),
+      idle_timer_(nullptr),
       next_id_(0) {
 
   worker_count_ = qBound(1, QThread::idealThreadCount() / 2, 4);
+  max_worker_count_ = worker_count_;
   local_server_name_ = qApp->applicationName().toLower();
 
   if (local_server_name_.isEmpty()) {
@@ -212,6 +257,13 @@ template<typename HandlerType>
 void WorkerPool<HandlerType>::SetWorkerCount(const int count) {
   Q_ASSERT(workers_.isEmpty());
   worker_count_ = count;
+  max_worker_count_ = count;
+}
+
+template<typename HandlerType>
+void WorkerPool<HandlerType>::SetMaxWorkerCount(const int count) {
+  Q_ASSERT(workers_.isEmpty());
+  max_worker_count_ = qMax(count, worker_count_);
 }
 
 template<typename HandlerType>
@@ -264,13 +316,56 @@ void WorkerPool<HandlerType>::DoStart() {
     qLog(Debug) << "Using worker" << executable_name_;
   }
 
+  uptime_.start();
+
+  if (max_worker_count_ > worker_count_) {
+    idle_timer_ = new QTimer(this);
+    idle_timer_->setInterval(kWorkerIdleMsec);
+    QObject::connect(idle_timer_, &QTimer::timeout, this, &WorkerPool::CheckIdleWorkers);
+    idle_timer_->start();
+  }
+
   // Start all the workers
   for (int i = 0; i < worker_count_; ++i) {
-    Worker worker;
-    StartOneWorker(&worker);
+    AddWorker();
+  }
 
-    workers_ << worker;
+}
+
+template<typename HandlerType>
+void WorkerPool<HandlerType>::AddWorker() {
+
+  Q_ASSERT(QThread::currentThread() == thread());
+
+  Worker worker;
+  StartOneWorker(&worker);
+  worker.last_active_msec_ = uptime_.elapsed();
+
+  QMutexLocker l(&workers_mutex_);
+  workers_ << worker;
+
+}
+
+template<typename HandlerType>
+void WorkerPool<HandlerType>::RemoveWorker(const int worker_index) {
+
+  Q_ASSERT(QThread::currentThread() == thread());
+
+  Worker worker;
+  {
+    QMutexLocker l(&workers_mutex_);
+    worker = workers_.takeAt(worker_index);
   }
+  if (next_worker_ >= workers_.count()) next_worker_ = 0;
+
+  qLog(Debug) << "Stopping idle worker" << worker.process_;
+
+  // Closing the socket makes the worker exit.
+  QObject::disconnect(worker.process_, nullptr, this, nullptr);
+  QObject::connect(worker.process_, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), worker.process_, &QProcess::deleteLater);
+  worker.local_socket_->close();
+  DeleteQObjectPointerLater(&worker.handler_);
+  DeleteQObjectPointerLater(&worker.local_socket_);
 
 }
 
@@ -284,6 +379,12 @@ void WorkerPool<HandlerType>::StartOneWorker(Worker *worker) {
   DeleteQObjectPointerLater(&worker->process_);
   DeleteQObjectPointerLater(&worker->handler_);
 
+  {
+    // Requests to the previous process are aborted when its handler is deleted.
+    QMutexLocker l(&workers_mutex_);
+    worker->stats_.pending = 0;
+  }
+
   worker->local_server_ = new QLocalServer(this);
   worker->process_ = new QProcess(this);
 
@@ -340,6 +441,7 @@ void WorkerPool<HandlerType>::NewConnection() {
 
   // Create the handler.
   worker->handler_ = new HandlerType(worker->local_socket_, this);
+  QObject::connect(worker->handler_, &HandlerType::ReplyFinished, this, &WorkerPool::HandlerReplyFinished);
 
   SendQueuedMessages();
 
@@ -438,32 +540,113 @@ void WorkerPool<HandlerType>::SendQueuedMessages() {
     ReplyType *reply = message_queue_.dequeue();
 
     // Find a worker for this message
-    HandlerType *handler = NextHandler();
-    if (!handler) {
+    Worker *worker = NextWorker();
+    if (!worker) {
       // No available handlers - put the message on the front of the queue.
       message_queue_.prepend(reply);
       qLog(Debug) << "No available handlers to process request";
       break;
     }
 
-    handler->SendRequest(reply);
+    {
+      QMutexLocker stats_lock(&workers_mutex_);
+      ++worker->stats_.pending;
+    }
+    worker->last_active_msec_ = uptime_.elapsed();
+    worker->handler_->SendRequest(reply);
   }
 
+  GrowIfBacklogged();
+
 }
 
 template<typename HandlerType>
-HandlerType *WorkerPool<HandlerType>::NextHandler() const {
+typename WorkerPool<HandlerType>::Worker *WorkerPool<HandlerType>::NextWorker() {
 
+  // Start after the last worker used, so workers with the same load take turns.
+  Worker *next_worker = nullptr;
+  int next_worker_index = 0;
   for (int i = 0; i < workers_.count(); ++i) {
     const int worker_index = (next_worker_ + i) % workers_.count();
+    Worker *worker = &workers_[worker_index];
+    if (!worker->handler_ || worker->handler_->is_device_closed()) continue;
+    if (!next_worker || worker->stats_.pending < next_worker->stats_.pending) {
+      next_worker = worker;
+      next_worker_index = worker_index;
+    }
+  }
+
+  if (next_worker) {
+    next_worker_ = (next_worker_index + 1) % workers_.count();
+  }
+
+  return next_worker;
+
+}
+
+template<typename HandlerType>
+void WorkerPool<HandlerType>::GrowIfBacklogged() {
+
+  if (workers_.count() >= max_worker_count_) return;
+
+  for (const Worker &worker : workers_) {
+    // Don't start more workers while one is still starting, or while any worker can take more requests.
+    if (!worker.handler_ || worker.stats_.pending < kWorkerBacklog) return;
+  }
+
+  qLog(Debug) << "All" << workers_.count() << "workers are backlogged, starting another worker";
+  AddWorker();
+
+}
+
+template<typename HandlerType>
+void WorkerPool<HandlerType>::HandlerReplyFinished(const qint64 latency_msec) {
+
+  Q_ASSERT(QThread::currentThread() == thread());
 
-    if (workers_[worker_index].handler_ && !workers_[worker_index].handler_->is_device_closed()) {
-      next_worker_ = (worker_index + 1) % workers_.count();
-      return workers_[worker_index].handler_;
+  HandlerType *handler = static_cast<HandlerType*>(sender());
+  Worker *worker = FindWorker(&Worker::handler_, handler);
+  if (!worker) return;
+
+  QMutexLocker l(&workers_mutex_);
+  worker->stats_.pending = qMax(0, worker->stats_.pending - 1);
+  ++worker->stats_.replies;
+  worker->stats_.total_latency_msec += latency_msec;
+  worker->stats_.max_latency_msec = qMax(worker->stats_.max_latency_msec, latency_msec);
+  worker->last_active_msec_ = uptime_.elapsed();
+
+}
+
+template<typename HandlerType>
+void WorkerPool<HandlerType>::CheckIdleWorkers() {
+
+  Q_ASSERT(QThread::currentThread() == thread());
+
+  // Stop one idle worker at a time, keeping at least the configured worker count.
+  if (workers_.count() <= worker_count_) return;
+
+  for (int i = workers_.count() - 1; i >= 0; --i) {
+    const Worker &worker = workers_[i];
+    if (worker.handler_ && worker.stats_.pending == 0 && uptime_.elapsed() - worker.last_active_msec_ >= kWorkerIdleMsec) {
+      RemoveWorker(i);
+      break;
     }
   }
 
-  return nullptr;
+}
+
+template<typename HandlerType>
+QList<typename WorkerPool<HandlerType>::WorkerStats> WorkerPool<HandlerType>::worker_stats() const {
+
+  QMutexLocker l(&workers_mutex_);
+
+  QList<WorkerStats> stats;
+  stats.reserve(workers_.count());
+  for (const Worker &worker : workers_) {
+    stats << worker.stats_;
+  }
+
+  return stats;
 
 }
 
@@ -24,14 +24,28 @@
 #include <QObject>
 #include <QIODevice>
 #include <QByteArray>
+#include <QElapsedTimer>
+#include <QSharedMemory>
+#include <QTimer>
 
+#include "core/logging.h"
+#include "core/sharedmemory.h"
 #include "tagreaderworker.h"
 
+const int TagReaderWorker::kReadFilesPartialSize = 50;
+const qint64 TagReaderWorker::kReadFilesPartialIntervalMsec = 100;
+const int TagReaderWorker::kSharedMemoryLifetimeMsec = 10000;
+
 TagReaderWorker::TagReaderWorker(QIODevice *socket, QObject *parent)
     : AbstractMessageHandler<spb::tagreader::Message>(socket, parent) {}
 
 void TagReaderWorker::MessageArrived(const spb::tagreader::Message &message) {
 
+  if (message.has_read_files_request()) {
+    ReadFiles(message);
+    return;
+  }
+
   spb::tagreader::Message reply;
 
   bool success = HandleMessage(message, reply, &tag_reader_);
@@ -45,6 +59,37 @@ void TagReaderWorker::MessageArrived(const spb::tagreader::Message &message) {
 
 }
 
+void TagReaderWorker::ReadFiles(const spb::tagreader::Message &message) {
+
+  // Results are sent back in partial replies as they are read, so the client can start using them before the whole batch is done.
+  spb::tagreader::Message reply;
+  QElapsedTimer timer;
+  timer.start();
+
+  const spb::tagreader::ReadFilesRequest &request = message.read_files_request();
+  for (int i = 0; i < request.filenames_size(); ++i) {
+    const QString filename = QStringFromStdString(request.filenames(i));
+    spb::tagreader::ReadFilesResult *result = reply.mutable_read_files_response()->add_results();
+    result->set_index(i);
+    bool success = tag_reader_.ReadFile(filename, result->mutable_metadata());
+    if (!success) {
+#if defined(USE_TAGLIB)
+      tag_reader_gme_.ReadFile(filename, result->mutable_metadata());
+#endif
+    }
+
+    if (i < request.filenames_size() - 1 && (reply.read_files_response().results_size() >= kReadFilesPartialSize || timer.elapsed() >= kReadFilesPartialIntervalMsec)) {
+      SendReply(message, &reply);
+      reply.Clear();
+      timer.restart();
+    }
+  }
+
+  reply.mutable_read_files_response()->set_finished(true);
+  SendReply(message, &reply);
+
+}
+
 void TagReaderWorker::DeviceClosed() {
 
   AbstractMessageHandler<spb::tagreader::Message>::DeviceClosed();
@@ -70,12 +115,41 @@ bool TagReaderWorker::HandleMessage(const spb::tagreader::Message &message, spb:
     return success;
   }
   else if (message.has_load_embedded_art_request()) {
-    QByteArray data = reader->LoadEmbeddedArt(QStringFromStdString(message.load_embedded_art_request().filename()));
-    reply.mutable_load_embedded_art_response()->set_data(data.constData(), data.size());
+    const spb::tagreader::LoadEmbeddedArtRequest &request = message.load_embedded_art_request();
+    const QString filename = QStringFromStdString(request.filename());
+    spb::tagreader::LoadEmbeddedArtResponse *response = reply.mutable_load_embedded_art_response();
+    const QByteArray data = reader->LoadEmbeddedArt(filename);
+    QSharedMemory *shared_memory = nullptr;
+    if (request.use_shared_memory() && data.size() >= SharedMemory::kThreshold) {
+      shared_memory = SharedMemory::Create(data, this);
+    }
+    // Large art goes back in a segment that is kept until the client has had time to attach to it.
+    if (shared_memory) {
+      response->set_shared_memory_key(DataCommaSizeFromQString(shared_memory->key()));
+      response->set_shared_memory_data_size(data.size());
+      QTimer::singleShot(kSharedMemoryLifetimeMsec, shared_memory, &QSharedMemory::deleteLater);
+    }
+    else {
+      response->set_data(data.constData(), data.size());
+    }
     return true;
   }
   else if (message.has_save_embedded_art_request()) {
-    bool success = reader->SaveEmbeddedArt(QStringFromStdString(message.save_embedded_art_request().filename()), QByteArray(message.save_embedded_art_request().data().data(), static_cast<qint64>(message.save_embedded_art_request().data().size())));
+    const spb::tagreader::SaveEmbeddedArtRequest &request = message.save_embedded_art_request();
+    bool success = false;
+    if (request.has_shared_memory_key()) {
+      QSharedMemory shared_memory(QStringFromStdString(request.shared_memory_key()));
+      if (shared_memory.attach(QSharedMemory::ReadOnly) && shared_memory.size() >= request.shared_memory_data_size()) {
+        success = reader->SaveEmbeddedArt(QStringFromStdString(request.filename()), QByteArray::fromRawData(static_cast<const char*>(shared_memory.constData()), static_cast<int>(request.shared_memory_data_size())));
+        shared_memory.detach();
+      }
+      else {
+        qLog(Error) << "Could not attach to shared memory segment for" << QStringFromStdString(request.filename()) << shared_memory.errorString();
+      }
+    }
+    else {
+      success = reader->SaveEmbeddedArt(QStringFromStdString(request.filename()), QByteArray::fromRawData(request.data().data(), static_cast<int>(request.data().size())));
+    }
     reply.mutable_save_embedded_art_response()->set_success(success);
     return success;
   }
@@ -21,6 +21,7 @@
 
 #include "config.h"
 
+#include <QtGlobal>
 #include <QObject>
 
 #include "core/messagehandler.h"
@@ -46,6 +47,14 @@ class TagReaderWorker : public AbstractMessageHandler<spb::tagreader::Message> {
   void DeviceClosed() override;
 
  private:
+  static const int kReadFilesPartialSize;
+  static const qint64 kReadFilesPartialIntervalMsec;
+  // How long a shared memory segment created for a reply is kept, the client attaches to it when the reply arrives.
+  static const int kSharedMemoryLifetimeMsec;
+
+  // Reads a batch of files, sending the metadata back in several replies.
+  void ReadFiles(const spb::tagreader::Message &message);
+
   // Handle message using specific TagReaderBase implementation. Returns true on successful message handle.
   bool HandleMessage(const spb::tagreader::Message &message, spb::tagreader::Message &reply, TagReaderBase* reader);
 
@@ -29,7 +29,6 @@
 #include <cstdint>
 
 #include <QWidget>
-#include <QVector>
 #include <QPainter>
 #include <QPalette>
 #include <QBasicTimer>
@@ -87,15 +86,16 @@ void Analyzer::Base::ChangeTimeout(const int timeout) {
 
 void Analyzer::Base::transform(Scope &scope) {
 
-  QVector<float> aux(fht_->size());
-  if (static_cast<unsigned long int>(aux.size()) >= scope.size()) {
-    std::copy(scope.begin(), scope.end(), aux.begin());
+  // The scratch buffer is kept between frames, it's only reallocated when the size of the transform changes.
+  aux_.resize(fht_->size());
+  if (aux_.size() >= scope.size()) {
+    std::copy(scope.begin(), scope.end(), aux_.begin());
   }
   else {
-    std::copy(scope.begin(), scope.begin() + aux.size(), aux.begin());
+    std::copy(scope.begin(), scope.begin() + static_cast<Scope::difference_type>(aux_.size()), aux_.begin());
   }
 
-  fht_->logSpectrum(scope.data(), aux.data());
+  fht_->logSpectrum(scope.data(), aux_.data());
   fht_->scale(scope.data(), 1.0F / 20);
 
   scope.resize(fht_->size() / 2);  // second half of values are rubbish
@@ -110,13 +110,10 @@ void Analyzer::Base::paintEvent(QPaintEvent *e) {
   switch (engine_->state()) {
     case Engine::Playing: {
       const Engine::Scope &thescope = engine_->scope(timeout_);
-      int i = 0;
 
       // convert to mono here - our built in analyzers need mono, but the engines provide interleaved pcm
-      for (uint x = 0; static_cast<int>(x) < fht_->size(); ++x) {
-        lastscope_[x] = static_cast<float>(thescope[i] + thescope[i + 1]) / (2 * (1U << 15U));
-        i += 2;
-      }
+      lastscope_.resize(fht_->size());
+      fht_->downmix(thescope.data(), lastscope_.data(), qMin(fht_->size(), static_cast<int>(thescope.size() / 2)));
 
       is_playing_ = true;
       transform(lastscope_);
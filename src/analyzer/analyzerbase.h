@@ -85,6 +85,7 @@ class Base : public QWidget {
   FHT *fht_;
   EngineBase *engine_;
   Scope lastscope_;
+  Scope aux_;
 
   bool new_frame_;
   bool is_playing_;
@@ -20,26 +20,426 @@
    along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include "fht.h"
+
+#include "config.h"
 
 #include <algorithm>
 #include <cmath>
 
+#include <QtGlobal>
+#include <QList>
 #include <QVector>
+#include <QString>
 #include <QtMath>
 
-FHT::FHT(uint n) : num_((n < 3) ? 0 : 1 << n), exp2_((n < 3) ? static_cast<int>(-1) : static_cast<int>(n)) {
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define FHT_SSE2
+#  include <emmintrin.h>
+#  if defined(__GNUC__)
+#    define FHT_AVX2
+#    include <immintrin.h>
+#  endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  define FHT_NEON
+#  include <arm_neon.h>
+#endif
+
+#include "fht.h"
+
+namespace {
+
+// The kernels start at offset, the vector kernels leave the values after the last full vector to the scalar kernel.
+// A butterfly combines the two transforms of n / 2 values in a block of n values, cas holds the n / 2 cosine values followed by the n / 2 sine values.
+using ButterflyFunction = void (*)(const float*, float*, const float*, const int, int);
+// Replaces the first n / 2 transformed values with their doubled power.
+using Power2Function = void (*)(float*, const int, int);
+using SpectrumFunction = void (*)(float*, const int, int);
+using ScaleFunction = void (*)(float*, const float, const int, int);
+using DownmixFunction = void (*)(const qint16*, float*, const int, int);
+
+struct KernelFunctions {
+  ButterflyFunction butterfly;
+  Power2Function power2;
+  SpectrumFunction spectrum;
+  ScaleFunction scale;
+  DownmixFunction downmix;
+};
+
+// The value mirrored to i is at n - i, the first value is mirrored to itself.
+
+inline void Butterfly(const float *in, float *out, const float *cas, const int n, const int i) {
+
+  const int ndiv2 = n / 2;
+  const float a = cas[i] * in[ndiv2 + i] + cas[ndiv2 + i] * in[(n - i) & (n - 1)];
+  out[i] = in[i] + a;
+  out[ndiv2 + i] = in[i] - a;
+
+}
+
+inline void Power2(float *p, const int n, const int i) {
+
+  const float q = p[(n - i) & (n - 1)];
+  p[i] = p[i] * p[i] + q * q;
+
+}
+
+void ButterflyScalar(const float *in, float *out, const float *cas, const int n, int offset) {
+
+  for (; offset < n / 2; ++offset) {
+    Butterfly(in, out, cas, n, offset);
+  }
+
+}
+
+void Power2Scalar(float *p, const int n, int offset) {
+
+  for (; offset < n / 2; ++offset) {
+    Power2(p, n, offset);
+  }
+
+}
+
+void SpectrumScalar(float *p, const int n, int offset) {
+
+  for (; offset < n; ++offset) {
+    p[offset] = std::sqrt(p[offset] * 0.5F);
+  }
+
+}
+
+void ScaleScalar(float *p, const float d, const int n, int offset) {
+
+  for (; offset < n; ++offset) {
+    p[offset] *= d;
+  }
+
+}
+
+void DownmixScalar(const qint16 *in, float *out, const int frames, int offset) {
+
+  for (; offset < frames; ++offset) {
+    out[offset] = static_cast<float>(in[offset * 2] + in[offset * 2 + 1]) * (1.0F / 65536.0F);
+  }
+
+}
+
+#ifdef FHT_SSE2
+
+__m128 ReverseSSE2(const __m128 v) {
+
+  return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3));
+
+}
+
+void ButterflySSE2(const float *in, float *out, const float *cas, const int n, int offset) {
+
+  const int ndiv2 = n / 2;
+  if (offset == 0) Butterfly(in, out, cas, n, offset++);
+  for (; offset + 4 <= ndiv2; offset += 4) {
+    const __m128 x = _mm_loadu_ps(in + offset);
+    const __m128 mirrored = ReverseSSE2(_mm_loadu_ps(in + n - offset - 3));
+    const __m128 a = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(cas + offset), _mm_loadu_ps(in + ndiv2 + offset)), _mm_mul_ps(_mm_loadu_ps(cas + ndiv2 + offset), mirrored));
+    _mm_storeu_ps(out + offset, _mm_add_ps(x, a));
+    _mm_storeu_ps(out + ndiv2 + offset, _mm_sub_ps(x, a));
+  }
+  ButterflyScalar(in, out, cas, n, offset);
+
+}
+
+void Power2SSE2(float *p, const int n, int offset) {
+
+  if (offset == 0) Power2(p, n, offset++);
+  for (; offset + 4 <= n / 2; offset += 4) {
+    const __m128 x = _mm_loadu_ps(p + offset);
+    const __m128 mirrored = ReverseSSE2(_mm_loadu_ps(p + n - offset - 3));
+    _mm_storeu_ps(p + offset, _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(mirrored, mirrored)));
+  }
+  Power2Scalar(p, n, offset);
+
+}
+
+void SpectrumSSE2(float *p, const int n, int offset) {
+
+  const __m128 half = _mm_set1_ps(0.5F);
+  for (; offset + 4 <= n; offset += 4) {
+    _mm_storeu_ps(p + offset, _mm_sqrt_ps(_mm_mul_ps(_mm_loadu_ps(p + offset), half)));
+  }
+  SpectrumScalar(p, n, offset);
+
+}
+
+void ScaleSSE2(float *p, const float d, const int n, int offset) {
+
+  const __m128 factor = _mm_set1_ps(d);
+  for (; offset + 4 <= n; offset += 4) {
+    _mm_storeu_ps(p + offset, _mm_mul_ps(_mm_loadu_ps(p + offset), factor));
+  }
+  ScaleScalar(p, d, n, offset);
+
+}
+
+void DownmixSSE2(const qint16 *in, float *out, const int frames, int offset) {
+
+  // _mm_madd_epi16 adds the left and right samples of each frame.
+  const __m128i ones = _mm_set1_epi16(1);
+  const __m128 factor = _mm_set1_ps(1.0F / 65536.0F);
+  for (; offset + 4 <= frames; offset += 4) {
+    const __m128i sums = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + offset * 2)), ones);
+    _mm_storeu_ps(out + offset, _mm_mul_ps(_mm_cvtepi32_ps(sums), factor));
+  }
+  DownmixScalar(in, out, frames, offset);
+
+}
+
+#endif  // FHT_SSE2
+
+#ifdef FHT_AVX2
+
+// The SSE2 kernels finish the tails, the upper halves of the AVX registers are cleared before calling them to avoid the AVX to SSE transition penalty.
+
+__attribute__((target("avx2"))) __m256 ReverseAVX2(const __m256 v) {
+
+  return _mm256_permutevar8x32_ps(v, _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+}
+
+__attribute__((target("avx2"))) void ButterflyAVX2(const float *in, float *out, const float *cas, const int n, int offset) {
+
+  const int ndiv2 = n / 2;
+  if (offset == 0) Butterfly(in, out, cas, n, offset++);
+  for (; offset + 8 <= ndiv2; offset += 8) {
+    const __m256 x = _mm256_loadu_ps(in + offset);
+    const __m256 mirrored = ReverseAVX2(_mm256_loadu_ps(in + n - offset - 7));
+    const __m256 a = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(cas + offset), _mm256_loadu_ps(in + ndiv2 + offset)), _mm256_mul_ps(_mm256_loadu_ps(cas + ndiv2 + offset), mirrored));
+    _mm256_storeu_ps(out + offset, _mm256_add_ps(x, a));
+    _mm256_storeu_ps(out + ndiv2 + offset, _mm256_sub_ps(x, a));
+  }
+  _mm256_zeroupper();
+  ButterflySSE2(in, out, cas, n, offset);
+
+}
+
+__attribute__((target("avx2"))) void Power2AVX2(float *p, const int n, int offset) {
+
+  if (offset == 0) Power2(p, n, offset++);
+  for (; offset + 8 <= n / 2; offset += 8) {
+    const __m256 x = _mm256_loadu_ps(p + offset);
+    const __m256 mirrored = ReverseAVX2(_mm256_loadu_ps(p + n - offset - 7));
+    _mm256_storeu_ps(p + offset, _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(mirrored, mirrored)));
+  }
+  _mm256_zeroupper();
+  Power2SSE2(p, n, offset);
+
+}
+
+__attribute__((target("avx2"))) void SpectrumAVX2(float *p, const int n, int offset) {
+
+  const __m256 half = _mm256_set1_ps(0.5F);
+  for (; offset + 8 <= n; offset += 8) {
+    _mm256_storeu_ps(p + offset, _mm256_sqrt_ps(_mm256_mul_ps(_mm256_loadu_ps(p + offset), half)));
+  }
+  _mm256_zeroupper();
+  SpectrumSSE2(p, n, offset);
+
+}
+
+__attribute__((target("avx2"))) void ScaleAVX2(float *p, const float d, const int n, int offset) {
+
+  const __m256 factor = _mm256_set1_ps(d);
+  for (; offset + 8 <= n; offset += 8) {
+    _mm256_storeu_ps(p + offset, _mm256_mul_ps(_mm256_loadu_ps(p + offset), factor));
+  }
+  _mm256_zeroupper();
+  ScaleSSE2(p, d, n, offset);
+
+}
+
+__attribute__((target("avx2"))) void DownmixAVX2(const qint16 *in, float *out, const int frames, int offset) {
+
+  // _mm256_madd_epi16 adds pairs within each 128 bit lane, so the frames stay in order.
+  const __m256i ones = _mm256_set1_epi16(1);
+  const __m256 factor = _mm256_set1_ps(1.0F / 65536.0F);
+  for (; offset + 8 <= frames; offset += 8) {
+    const __m256i sums = _mm256_madd_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + offset * 2)), ones);
+    _mm256_storeu_ps(out + offset, _mm256_mul_ps(_mm256_cvtepi32_ps(sums), factor));
+  }
+  _mm256_zeroupper();
+  DownmixSSE2(in, out, frames, offset);
+
+}
+
+#endif  // FHT_AVX2
+
+#ifdef FHT_NEON
+
+float32x4_t ReverseNEON(const float32x4_t v) {
+
+  const float32x4_t r = vrev64q_f32(v);
+  return vcombine_f32(vget_high_f32(r), vget_low_f32(r));
+
+}
+
+void ButterflyNEON(const float *in, float *out, const float *cas, const int n, int offset) {
+
+  const int ndiv2 = n / 2;
+  if (offset == 0) Butterfly(in, out, cas, n, offset++);
+  for (; offset + 4 <= ndiv2; offset += 4) {
+    const float32x4_t x = vld1q_f32(in + offset);
+    const float32x4_t mirrored = ReverseNEON(vld1q_f32(in + n - offset - 3));
+    const float32x4_t a = vaddq_f32(vmulq_f32(vld1q_f32(cas + offset), vld1q_f32(in + ndiv2 + offset)), vmulq_f32(vld1q_f32(cas + ndiv2 + offset), mirrored));
+    vst1q_f32(out + offset, vaddq_f32(x, a));
+    vst1q_f32(out + ndiv2 + offset, vsubq_f32(x, a));
+  }
+  ButterflyScalar(in, out, cas, n, offset);
+
+}
+
+void Power2NEON(float *p, const int n, int offset) {
+
+  if (offset == 0) Power2(p, n, offset++);
+  for (; offset + 4 <= n / 2; offset += 4) {
+    const float32x4_t x = vld1q_f32(p + offset);
+    const float32x4_t mirrored = ReverseNEON(vld1q_f32(p + n - offset - 3));
+    vst1q_f32(p + offset, vaddq_f32(vmulq_f32(x, x), vmulq_f32(mirrored, mirrored)));
+  }
+  Power2Scalar(p, n, offset);
+
+}
+
+void SpectrumNEON(float *p, const int n, int offset) {
+
+#if defined(__aarch64__)
+  for (; offset + 4 <= n; offset += 4) {
+    vst1q_f32(p + offset, vsqrtq_f32(vmulq_n_f32(vld1q_f32(p + offset), 0.5F)));
+  }
+#endif
+  SpectrumScalar(p, n, offset);
+
+}
+
+void ScaleNEON(float *p, const float d, const int n, int offset) {
+
+  for (; offset + 4 <= n; offset += 4) {
+    vst1q_f32(p + offset, vmulq_n_f32(vld1q_f32(p + offset), d));
+  }
+  ScaleScalar(p, d, n, offset);
+
+}
+
+void DownmixNEON(const qint16 *in, float *out, const int frames, int offset) {
+
+  // vpaddlq_s16 adds the left and right samples of each frame.
+  for (; offset + 4 <= frames; offset += 4) {
+    const int32x4_t sums = vpaddlq_s16(vld1q_s16(in + offset * 2));
+    vst1q_f32(out + offset, vmulq_n_f32(vcvtq_f32_s32(sums), 1.0F / 65536.0F));
+  }
+  DownmixScalar(in, out, frames, offset);
+
+}
+
+#endif  // FHT_NEON
+
+const KernelFunctions &Functions(const FHT::Kernel kernel) {
+
+  static const KernelFunctions scalar = { ButterflyScalar, Power2Scalar, SpectrumScalar, ScaleScalar, DownmixScalar };
+
+  switch (kernel) {
+#ifdef FHT_SSE2
+    case FHT::Kernel::SSE2: {
+      static const KernelFunctions sse2 = { ButterflySSE2, Power2SSE2, SpectrumSSE2, ScaleSSE2, DownmixSSE2 };
+      return sse2;
+    }
+#endif
+#ifdef FHT_AVX2
+    case FHT::Kernel::AVX2: {
+      static const KernelFunctions avx2 = { ButterflyAVX2, Power2AVX2, SpectrumAVX2, ScaleAVX2, DownmixAVX2 };
+      return avx2;
+    }
+#endif
+#ifdef FHT_NEON
+    case FHT::Kernel::NEON: {
+      static const KernelFunctions neon = { ButterflyNEON, Power2NEON, SpectrumNEON, ScaleNEON, DownmixNEON };
+      return neon;
+    }
+#endif
+    default:
+      return scalar;
+  }
+
+}
+
+QList<FHT::Kernel> DetectKernels() {
+
+  QList<FHT::Kernel> kernels = QList<FHT::Kernel>() << FHT::Kernel::Scalar;
+
+#ifdef FHT_SSE2
+  kernels << FHT::Kernel::SSE2;
+#endif
+#ifdef FHT_AVX2
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    kernels << FHT::Kernel::AVX2;
+  }
+#endif
+#ifdef FHT_NEON
+  kernels << FHT::Kernel::NEON;
+#endif
+
+  return kernels;
+
+}
+
+}  // namespace
+
+FHT::FHT(uint n) : FHT(n, defaultKernel()) {}
+
+FHT::FHT(uint n, Kernel kernel) : num_((n < 3) ? 0 : 1 << n), exp2_((n < 3) ? static_cast<int>(-1) : static_cast<int>(n)), kernel_(supportedKernels().contains(kernel) ? kernel : Kernel::Scalar) {
 
   if (n > 3) {
     buf_vector_.resize(num_);
+    work_vector_.resize(num_);
     tab_vector_.resize(num_ * 2);
     makeCasTable();
+    makePermutation();
   }
 
 }
 
 FHT::~FHT() = default;
 
+QList<FHT::Kernel> FHT::supportedKernels() {
+
+  static const QList<Kernel> kernels = DetectKernels();
+  return kernels;
+
+}
+
+FHT::Kernel FHT::defaultKernel() {
+
+  static const Kernel kernel = supportedKernels().last();
+  return kernel;
+
+}
+
+QString FHT::kernelName(const Kernel kernel) {
+
+  switch (kernel) {
+    case Kernel::Scalar:
+      return "Scalar";
+    case Kernel::SSE2:
+      return "SSE2";
+    case Kernel::AVX2:
+      return "AVX2";
+    case Kernel::NEON:
+      return "NEON";
+  }
+
+  return QString();
+
+}
+
 int FHT::sizeExp() const { return exp2_; }
 int FHT::size() const { return num_; }
 
@@ -61,10 +461,51 @@ void FHT::makeCasTable(void) {
     if (sintab > tab_() + num_ * 2) sintab = tab_() + 1;
   }
 
+  // The butterflies of n values use every num_ / (n / 2)th pair of the table.
+  cas_vector_.resize(num_ * 2 - 16);
+  float *cas = cas_vector_.data();
+  for (int n = 16; n <= num_; n *= 2) {
+    const int ndiv2 = n / 2;
+    const int step = num_ / ndiv2;
+    for (int i = 0; i < ndiv2; ++i) {
+      cas[i] = tab_()[i * step];
+      cas[ndiv2 + i] = tab_()[i * step + 1];
+    }
+    cas += n;
+  }
+
+}
+
+void FHT::makePermutation() {
+
+  perm_vector_.resize(num_);
+  int *perm = perm_vector_.data();
+  for (int i = 0; i < num_; ++i) perm[i] = i;
+
+  // Each level of the recursion moves the even values of a block to its first half and the odd values to its second half.
+  QVector<int> level(num_);
+  for (int n = num_; n > 8; n /= 2) {
+    for (int k = 0; k < num_; k += n) {
+      for (int i = 0; i < n / 2; ++i) {
+        level[k + i] = perm[k + 2 * i];
+        level[k + n / 2 + i] = perm[k + 2 * i + 1];
+      }
+    }
+    std::copy(level.begin(), level.end(), perm);
+  }
+
+}
+
+void FHT::downmix(const qint16 *in, float *out, const int frames) const {
+
+  Functions(kernel_).downmix(in, out, frames, 0);
+
 }
 
 void FHT::scale(float *p, float d) const {
-  for (int i = 0; i < (num_ / 2); i++) *p++ *= d;
+
+  Functions(kernel_).scale(p, d, num_ / 2, 0);
+
 }
 
 void FHT::ewma(float *d, float *s, float w) const {
@@ -101,8 +542,9 @@ void FHT::logSpectrum(float *out, float *p) {
 void FHT::semiLogSpectrum(float *p) {
 
   power2(p);
+  // 10 * log10(sqrt(x)) is 5 * log10(x).
   for (int i = 0; i < (num_ / 2); i++, p++) {
-    float e = 10.0F * static_cast<float>(log10(sqrt(*p / static_cast<float>(2))));
+    float e = 5.0F * std::log10(*p * 0.5F);
     *p = e < 0 ? 0 : e;
   }
 
@@ -111,43 +553,27 @@ void FHT::semiLogSpectrum(float *p) {
 void FHT::spectrum(float *p) {
 
   power2(p);
-  for (int i = 0; i < (num_ / 2); i++, p++) {
-    *p = static_cast<float>(sqrt(*p / 2));
-  }
+  Functions(kernel_).spectrum(p, num_ / 2, 0);
 
 }
 
 void FHT::power(float *p) {
 
   power2(p);
-  for (int i = 0; i < (num_ / 2); i++) *p++ /= 2;
+  Functions(kernel_).scale(p, 0.5F, num_ / 2, 0);
 
 }
 
 void FHT::power2(float *p) {
 
-  _transform(p, num_, 0);
-
-  *p = static_cast<float>(2 * pow(*p, 2));
-  p++;
-
-  float *q = p + num_ - 2;
-  for (int i = 1; i < (num_ / 2); i++) {
-    *p = static_cast<float>(pow(*p, 2) + pow(*q, 2));
-    p++;
-    q--;
-  }
+  _transform(p);
+  Functions(kernel_).power2(p, num_, 0);
 
 }
 
 void FHT::transform(float *p) {
 
-  if (num_ == 8) {
-    transform8(p);
-  }
-  else {
-    _transform(p, num_, 0);
-  }
+  _transform(p);
 
 }
 
@@ -180,46 +606,30 @@ void FHT::transform8(float *p) {
 
 }
 
-void FHT::_transform(float *p, int n, int k) {
+void FHT::_transform(float *p) {
 
-  if (n == 8) {
-    transform8(p + k);
+  if (num_ < 16) {
+    if (num_ == 8) transform8(p);
     return;
   }
 
-  int i = 0, j = 0, ndiv2 = n / 2;
-  float a = 0.0, *t1 = nullptr, *t2 = nullptr, *t3 = nullptr, *t4 = nullptr, *ptab = nullptr, *pp = nullptr;
-
-  for (i = 0, t1 = buf_(), t2 = buf_() + ndiv2, pp = &p[k]; i < ndiv2; i++)
-    *t1++ = *pp++, *t2++ = *pp++;
-
-  std::copy(buf_(), buf_() + n, p + k);
+  // Sort the values into the order of the 8 value transforms.
+  float *in = buf_();
+  const int *perm = perm_vector_.constData();
+  for (int i = 0; i < num_; ++i) in[i] = p[perm[i]];
 
-  _transform(p, ndiv2, k);
-  _transform(p, ndiv2, k + ndiv2);
+  for (int k = 0; k < num_; k += 8) transform8(in + k);
 
-  j = num_ / ndiv2 - 1;
-  t1 = buf_();
-  t2 = t1 + ndiv2;
-  t3 = p + k + ndiv2;
-  ptab = tab_();
-  pp = p + k;
-
-  a = *ptab++ * *t3++;
-  a += *ptab * *pp;
-  ptab += j;
-
-  *t1++ = *pp + a;
-  *t2++ = *pp++ - a;
-
-  for (i = 1, t4 = p + k + n; i < ndiv2; i++, ptab += j) {
-    a = *ptab++ * *t3++;
-    a += *ptab * *--t4;
-
-    *t1++ = *pp + a;
-    *t2++ = *pp++ - a;
+  // Each stage combines pairs of blocks into blocks of twice the size, alternating between the scratch buffers and ending in p.
+  const ButterflyFunction butterfly = Functions(kernel_).butterfly;
+  const float *cas = cas_vector_.constData();
+  for (int n = 16; n <= num_; n *= 2) {
+    float *out = n == num_ ? p : (in == buf_() ? work_vector_.data() : buf_());
+    for (int k = 0; k < num_; k += n) {
+      butterfly(in + k, out + k, cas, n, 0);
+    }
+    cas += n;
+    in = out;
   }
 
-  std::copy(buf_(), buf_() + n, p + k);
-
 }
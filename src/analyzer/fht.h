@@ -23,7 +23,10 @@
 #ifndef FHT_H
 #define FHT_H
 
+#include <QtGlobal>
+#include <QList>
 #include <QVector>
+#include <QString>
 
 /**
  * Implementation of the Hartley Transform after Bracewell's discrete
@@ -32,13 +35,30 @@
  * University in 1994 and is now freely available[1].
  *
  * [1] Computer in Physics, Vol. 9, No. 4, Jul/Aug 1995 pp 373-379
+ *
+ * The butterflies and the spectrum loops use the fastest SIMD kernel
+ * supported by the CPU, which is detected at runtime.
  */
 class FHT {
+ public:
+  enum class Kernel {
+    Scalar,
+    SSE2,
+    AVX2,
+    NEON
+  };
+
+ private:
   const int num_;
   const int exp2_;
+  const Kernel kernel_;
 
+  // Scratch buffers, the transform alternates between them so nothing is allocated while transforming.
   QVector<float> buf_vector_;
+  QVector<float> work_vector_;
   QVector<float> tab_vector_;
+  QVector<float> cas_vector_;
+  QVector<int> perm_vector_;
   QVector<int> log_vector_;
 
   float *buf_();
@@ -49,13 +69,21 @@ class FHT {
    * Create a table of "cas" (cosine and sine) values.
    * Has only to be done in the constructor and saves from
    * calculating the same values over and over while transforming.
+   * The values used by each butterfly stage are copied to cas_vector_,
+   * so the kernels can load them contiguously.
    */
   void makeCasTable();
 
   /**
-   * Recursive in-place Hartley transform. For internal use only!
+   * Create the permutation that sorts the input into the order of
+   * the 8 value transforms, as the recursive algorithm would.
+   */
+  void makePermutation();
+
+  /**
+   * Iterative in-place Hartley transform. For internal use only!
    */
-  void _transform(float*, int, int);
+  void _transform(float*);
 
  public:
   /**
@@ -64,6 +92,20 @@ class FHT {
   * @see makeCasTable()
   */
   explicit FHT(uint);
+  FHT(uint, Kernel);
+
+  /**
+   * Kernels supported by this CPU, the first is the scalar kernel, the last is the fastest.
+   */
+  static QList<Kernel> supportedKernels();
+  static Kernel defaultKernel();
+  static QString kernelName(const Kernel kernel);
+
+  /**
+   * Converts interleaved 16 bit stereo samples to mono values between -1 and 1.
+   * @param out must have room for frames values.
+   */
+  void downmix(const qint16 *in, float *out, const int frames) const;
 
   ~FHT();
   int sizeExp() const;
@@ -130,6 +130,9 @@ void SCollection::Init() {
   QObject::connect(app_->lastfm_import(), &LastFMImport::UpdateLastPlayed, backend_, &CollectionBackend::UpdateLastPlayed);
   QObject::connect(app_->lastfm_import(), &LastFMImport::UpdatePlayCount, backend_, &CollectionBackend::UpdatePlayCount);
 
+  // Load the songs into memory before the watcher starts looking up songs.
+  backend_->LoadSongCacheAsync();
+
   // This will start the watcher checking for updates
   backend_->LoadDirectoriesAsync();
 
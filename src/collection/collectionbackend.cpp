@@ -38,6 +38,7 @@
 #include <QUrl>
 #include <QFileInfo>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QRegularExpression>
 #include <QSqlDatabase>
 #include <QSqlQuery>
@@ -55,6 +56,8 @@
 #include "collectionquery.h"
 #include "collectiontask.h"
 
+const int CollectionBackend::kMaxBindValues = 999;
+
 CollectionBackend::CollectionBackend(QObject *parent)
     : CollectionBackendInterface(parent),
       db_(nullptr),
@@ -64,6 +67,12 @@ CollectionBackend::CollectionBackend(QObject *parent)
 
   original_thread_ = thread();
 
+  // Keep the song cache up to date before the songs are passed on to anyone else.
+  QObject::connect(this, &CollectionBackend::SongsDiscovered, this, [this](const SongList &songs) { song_cache_.AddOrUpdateSongs(songs); }, Qt::DirectConnection);
+  QObject::connect(this, &CollectionBackend::SongsDeleted, this, [this](const SongList &songs) { song_cache_.RemoveSongs(songs); }, Qt::DirectConnection);
+  QObject::connect(this, &CollectionBackend::SongsStatisticsChanged, this, [this](const SongList &songs) { song_cache_.AddOrUpdateSongs(songs); }, Qt::DirectConnection);
+  QObject::connect(this, &CollectionBackend::SongsRatingChanged, this, [this](const SongList &songs) { song_cache_.AddOrUpdateSongs(songs); }, Qt::DirectConnection);
+
 }
 
 void CollectionBackend::Init(Database *db, TaskManager *task_manager, const Song::Source source, const QString &songs_table, const QString &fts_table, const QString &dirs_table, const QString &subdirs_table) {
@@ -95,6 +104,10 @@ void CollectionBackend::Exit() {
 
   Q_ASSERT(QThread::currentThread() == thread());
 
+  if (song_cache_.is_loaded()) {
+    qLog(Debug) << "Song cache of" << songs_table_ << "has" << song_cache_.size() << "songs," << song_cache_.hits() << "lookups were answered from the cache and" << song_cache_.misses() << "from the database";
+  }
+
   moveToThread(original_thread_);
   emit ExitFinished();
 
@@ -119,6 +132,10 @@ void CollectionBackend::LoadDirectoriesAsync() {
   QMetaObject::invokeMethod(this, "LoadDirectories", Qt::QueuedConnection);
 }
 
+void CollectionBackend::LoadSongCacheAsync() {
+  QMetaObject::invokeMethod(this, "LoadSongCache", Qt::QueuedConnection);
+}
+
 void CollectionBackend::UpdateTotalSongCountAsync() {
   QMetaObject::invokeMethod(this, "UpdateTotalSongCount", Qt::QueuedConnection);
 }
@@ -147,8 +164,8 @@ void CollectionBackend::LoadDirectories() {
 
   DirectoryList dirs = GetAllDirectories();
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   for (const Directory &dir : dirs) {
     emit DirectoryDiscovered(dir, SubdirsInDirectory(dir.id, db));
@@ -156,6 +173,36 @@ void CollectionBackend::LoadDirectories() {
 
 }
 
+void CollectionBackend::LoadSongCache() {
+
+  QElapsedTimer timer;
+  timer.start();
+
+  SongList songs;
+  {
+    QMutexLocker l(db_->ReadMutex());
+    QSqlDatabase db(db_->ConnectReadOnly());
+
+    SqlQuery q(db);
+    q.prepare(QString("SELECT ROWID, " + Song::kColumnSpec + " FROM %1").arg(songs_table_));
+    if (!q.Exec()) {
+      db_->ReportErrors(q);
+      return;
+    }
+
+    while (q.next()) {
+      Song song(source_);
+      song.InitFromQuery(q, true, 0);
+      songs << song;
+    }
+  }
+
+  song_cache_.Load(songs);
+
+  qLog(Debug) << "Loaded" << songs.count() << "songs from" << songs_table_ << "into the song cache in" << timer.elapsed() << "ms";
+
+}
+
 void CollectionBackend::ChangeDirPath(const int id, const QString &old_path, const QString &new_path) {
 
   QMutexLocker l(db_->Mutex());
@@ -205,12 +252,15 @@ void CollectionBackend::ChangeDirPath(const int id, const QString &old_path, con
 
   t.Commit();
 
+  // The URLs of all songs in the directory changed.
+  if (song_cache_.is_loaded()) LoadSongCache();
+
 }
 
 DirectoryList CollectionBackend::GetAllDirectories() {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   DirectoryList ret;
 
@@ -234,8 +284,8 @@ DirectoryList CollectionBackend::GetAllDirectories() {
 
 SubdirectoryList CollectionBackend::SubdirsInDirectory(const int id) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db = db_->Connect();
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db = db_->ConnectReadOnly();
   return SubdirsInDirectory(id, db);
 
 }
@@ -265,8 +315,8 @@ SubdirectoryList CollectionBackend::SubdirsInDirectory(const int id, QSqlDatabas
 
 void CollectionBackend::UpdateTotalSongCount() {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   SqlQuery q(db);
   q.prepare(QString("SELECT COUNT(*) FROM %1 WHERE unavailable = 0").arg(songs_table_));
@@ -285,8 +335,8 @@ void CollectionBackend::UpdateTotalSongCount() {
 
 void CollectionBackend::UpdateTotalArtistCount() {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   SqlQuery q(db);
   q.prepare(QString("SELECT COUNT(DISTINCT artist) FROM %1 WHERE unavailable = 0").arg(songs_table_));
@@ -305,8 +355,8 @@ void CollectionBackend::UpdateTotalArtistCount() {
 
 void CollectionBackend::UpdateTotalAlbumCount() {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   SqlQuery q(db);
   q.prepare(QString("SELECT COUNT(*) FROM (SELECT DISTINCT effective_albumartist, album FROM %1 WHERE unavailable = 0)").arg(songs_table_));
@@ -387,8 +437,8 @@ void CollectionBackend::RemoveDirectory(const Directory &dir) {
 
 SongList CollectionBackend::FindSongsInDirectory(const int id) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   SqlQuery q(db);
   q.prepare(QString("SELECT ROWID, " + Song::kColumnSpec + " FROM %1 WHERE directory_id = :directory_id").arg(songs_table_));
@@ -401,7 +451,7 @@ SongList CollectionBackend::FindSongsInDirectory(const int id) {
   SongList ret;
   while (q.next()) {
     Song song(source_);
-    song.InitFromQuery(q, true);
+    song.InitFromQuery(q, true, 0);
     ret << song;
   }
   return ret;
@@ -410,8 +460,8 @@ SongList CollectionBackend::FindSongsInDirectory(const int id) {
 
 SongList CollectionBackend::SongsWithMissingFingerprint(const int id) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   SqlQuery q(db);
   q.prepare(QString("SELECT ROWID, " + Song::kColumnSpec + " FROM %1 WHERE directory_id = :directory_id AND unavailable = 0 AND (fingerprint IS NULL OR fingerprint = '')").arg(songs_table_));
@@ -424,7 +474,7 @@ SongList CollectionBackend::SongsWithMissingFingerprint(const int id) {
   SongList ret;
   while (q.next()) {
     Song song(source_);
-    song.InitFromQuery(q, true);
+    song.InitFromQuery(q, true, 0);
     ret << song;
   }
   return ret;
@@ -511,8 +561,8 @@ void CollectionBackend::AddOrUpdateSubdirs(const SubdirectoryList &subdirs) {
 
 SongList CollectionBackend::GetAllSongs() {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   SqlQuery q(db);
   q.prepare(QString("SELECT ROWID, " + Song::kColumnSpec + " FROM %1").arg(songs_table_));
@@ -524,7 +574,7 @@ SongList CollectionBackend::GetAllSongs() {
   SongList songs;
   while (q.next()) {
     Song song;
-    song.InitFromQuery(q, true);
+    song.InitFromQuery(q, true, 0);
     songs << song;
   }
   return songs;
@@ -542,131 +592,138 @@ void CollectionBackend::AddOrUpdateSongs(const SongList &songs) {
 
   ScopedTransaction transaction(&db);
 
-  SongList added_songs;
-  SongList deleted_songs;
+  // Do a sanity check first - make sure the song's directory still exists
+  // This is to fix a possible race condition when a directory is removed while CollectionWatcher is scanning it.
+  QSet<int> directory_ids;
+  if (!dirs_table_.isEmpty()) {
+    SqlQuery check_dirs(db);
+    check_dirs.prepare(QString("SELECT ROWID FROM %1").arg(dirs_table_));
+    if (!check_dirs.Exec()) {
+      db_->ReportErrors(check_dirs);
+      return;
+    }
+    while (check_dirs.next()) {
+      directory_ids << check_dirs.value(0).toInt();
+    }
+  }
 
+  // Get the previous song data for the whole batch at once.
+  QStringList ids;
+  QStringList song_ids;
   for (const Song &song : songs) {
-
-    // Do a sanity check first - make sure the song's directory still exists
-    // This is to fix a possible race condition when a directory is removed while CollectionWatcher is scanning it.
-    if (!dirs_table_.isEmpty()) {
-      SqlQuery check_dir(db);
-      check_dir.prepare(QString("SELECT ROWID FROM %1 WHERE ROWID = :id").arg(dirs_table_));
-      check_dir.BindValue(":id", song.directory_id());
-      if (!check_dir.Exec()) {
-        db_->ReportErrors(check_dir);
-        return;
-      }
-
-      if (!check_dir.next()) continue;
-
+    if (!dirs_table_.isEmpty() && !directory_ids.contains(song.directory_id())) continue;
+    if (song.id() != -1) {
+      ids << QString::number(song.id());
+    }
+    else if (!song.song_id().isEmpty()) {
+      song_ids << song.song_id();
     }
+  }
 
-    if (song.id() != -1) {  // This song exists in the DB.
+  QMap<int, Song> old_songs_by_id;
+  if (!ids.isEmpty()) {
+    const SongList old_songs = GetSongsById(ids, db);
+    for (const Song &old_song : old_songs) {
+      old_songs_by_id.insert(old_song.id(), old_song);
+    }
+  }
 
-      // Get the previous song data first
-      Song old_song(GetSongById(song.id()));
-      if (!old_song.is_valid()) continue;
+  QMap<QString, Song> old_songs_by_song_id;
+  if (!song_ids.isEmpty()) {
+    const SongList old_songs = GetSongsBySongId(song_ids, db);
+    for (const Song &old_song : old_songs) {
+      old_songs_by_song_id.insert(old_song.song_id(), old_song);
+    }
+  }
 
-      // Update
-      {
-        SqlQuery q(db);
-        q.prepare(QString("UPDATE %1 SET " + Song::kUpdateSpec + " WHERE ROWID = :id").arg(songs_table_));
-        song.BindToQuery(&q);
-        q.BindValue(":id", song.id());
-        if (!q.Exec()) {
-          db_->ReportErrors(q);
-          return;
-        }
-      }
+  // The same statements are executed for every song, so only prepare them once.
+  SqlQuery update(db);
+  update.prepare(QString("UPDATE %1 SET " + Song::kUpdateSpec + " WHERE ROWID = :id").arg(songs_table_));
+  SqlQuery update_fts(db);
+  update_fts.prepare(QString("UPDATE %1 SET " + Song::kFtsUpdateSpec + " WHERE ROWID = :id").arg(fts_table_));
+  SqlQuery insert(db);
+  insert.prepare(QString("INSERT INTO %1 (" + Song::kColumnSpec + ") VALUES (" + Song::kBindSpec + ")").arg(songs_table_));
+  SqlQuery insert_fts(db);
+  insert_fts.prepare(QString("INSERT INTO %1 (ROWID, " + Song::kFtsColumnSpec + ") VALUES (:id, " + Song::kFtsBindSpec + ")").arg(fts_table_));
 
-      {
-        SqlQuery q(db);
-        q.prepare(QString("UPDATE %1 SET " + Song::kFtsUpdateSpec + " WHERE ROWID = :id").arg(fts_table_));
-        song.BindToFtsQuery(&q);
-        q.BindValue(":id", song.id());
-        if (!q.Exec()) {
-          db_->ReportErrors(q);
-          return;
-        }
-      }
+  SongList added_songs;
+  SongList deleted_songs;
 
-      deleted_songs << old_song;
-      added_songs << song;
+  for (const Song &song : songs) {
 
-      continue;
+    if (!dirs_table_.isEmpty() && !directory_ids.contains(song.directory_id())) continue;
 
+    Song old_song;
+    if (song.id() != -1) {  // This song exists in the DB.
+      old_song = old_songs_by_id.value(song.id());
+      if (!old_song.is_valid()) continue;
     }
     else if (!song.song_id().isEmpty()) {  // Song has a unique id, check if the song exists.
+      old_song = old_songs_by_song_id.value(song.song_id());
+      if (!old_song.is_valid() || old_song.id() == -1) old_song = Song();
+    }
+
+    if (old_song.is_valid()) {
 
-      // Get the previous song data first
-      Song old_song(GetSongBySongId(song.song_id()));
+      Song new_song = song;
+      new_song.set_id(old_song.id());
 
-      if (old_song.is_valid() && old_song.id() != -1) {
+      // Update
+      update.BindValue(":id", new_song.id());
+      new_song.BindToQuery(&update);
+      if (!update.Exec()) {
+        db_->ReportErrors(update);
+        return;
+      }
 
-        Song new_song = song;
-        new_song.set_id(old_song.id());
+      update_fts.BindValue(":id", new_song.id());
+      new_song.BindToFtsQuery(&update_fts);
+      if (!update_fts.Exec()) {
+        db_->ReportErrors(update_fts);
+        return;
+      }
 
-        // Update
-        {
-          SqlQuery q(db);
-          q.prepare(QString("UPDATE %1 SET " + Song::kUpdateSpec + " WHERE ROWID = :id").arg(songs_table_));
-          new_song.BindToQuery(&q);
-          q.BindValue(":id", new_song.id());
-          if (!q.Exec()) {
-            db_->ReportErrors(q);
-            return;
-          }
-        }
+      // Later duplicates in the same batch should see this version as the previous one.
+      if (song.id() != -1) {
+        old_songs_by_id.insert(new_song.id(), new_song);
+      }
+      else {
+        old_songs_by_song_id.insert(new_song.song_id(), new_song);
+      }
 
-        {
-          SqlQuery q(db);
-          q.prepare(QString("UPDATE %1 SET " + Song::kFtsUpdateSpec + " WHERE ROWID = :id").arg(fts_table_));
-          new_song.BindToFtsQuery(&q);
-          q.BindValue(":id", new_song.id());
-          if (!q.Exec()) {
-            db_->ReportErrors(q);
-            return;
-          }
-        }
+      deleted_songs << old_song;
+      added_songs << new_song;
 
-        deleted_songs << old_song;
-        added_songs << new_song;
+      continue;
 
-        continue;
-      }
     }
 
     // Create new song
 
-    int id = -1;
-    {  // Insert the row and create a new ID
-      SqlQuery q(db);
-      q.prepare(QString("INSERT INTO %1 (" + Song::kColumnSpec + ") VALUES (" + Song::kBindSpec + ")").arg(songs_table_));
-      song.BindToQuery(&q);
-      if (!q.Exec()) {
-        db_->ReportErrors(q);
-        return;
-      }
-      // Get the new ID
-      id = q.lastInsertId().toInt();
+    // Insert the row and create a new ID
+    song.BindToQuery(&insert);
+    if (!insert.Exec()) {
+      db_->ReportErrors(insert);
+      return;
     }
+    // Get the new ID
+    const int id = insert.lastInsertId().toInt();
 
     if (id == -1) return;
 
-    {  // Add to the FTS index
-      SqlQuery q(db);
-      q.prepare(QString("INSERT INTO %1 (ROWID, " + Song::kFtsColumnSpec + ") VALUES (:id, " + Song::kFtsBindSpec + ")").arg(fts_table_));
-      q.BindValue(":id", id);
-      song.BindToFtsQuery(&q);
-      if (!q.Exec()) {
-        db_->ReportErrors(q);
-        return;
-      }
+    // Add to the FTS index
+    insert_fts.BindValue(":id", id);
+    song.BindToFtsQuery(&insert_fts);
+    if (!insert_fts.Exec()) {
+      db_->ReportErrors(insert_fts);
+      return;
     }
 
     Song song_copy(song);
     song_copy.set_id(id);
+    if (!song_copy.song_id().isEmpty()) {
+      old_songs_by_song_id.insert(song_copy.song_id(), song_copy);
+    }
     added_songs << song_copy;
 
   }
@@ -706,6 +763,19 @@ void CollectionBackend::UpdateSongsBySongID(const SongMap &new_songs) {
     }
   }
 
+  SqlQuery update(db);
+  update.prepare(QString("UPDATE %1 SET " + Song::kUpdateSpec + " WHERE ROWID = :id").arg(songs_table_));
+  SqlQuery update_fts(db);
+  update_fts.prepare(QString("UPDATE %1 SET " + Song::kFtsUpdateSpec + " WHERE ROWID = :id").arg(fts_table_));
+  SqlQuery insert(db);
+  insert.prepare(QString("INSERT INTO %1 (" + Song::kColumnSpec + ") VALUES (" + Song::kBindSpec + ")").arg(songs_table_));
+  SqlQuery insert_fts(db);
+  insert_fts.prepare(QString("INSERT INTO %1 (ROWID, " + Song::kFtsColumnSpec + ") VALUES (:id, " + Song::kFtsBindSpec + ")").arg(fts_table_));
+  SqlQuery remove(db);
+  remove.prepare(QString("DELETE FROM %1 WHERE ROWID = :id").arg(songs_table_));
+  SqlQuery remove_fts(db);
+  remove_fts.prepare(QString("DELETE FROM %1 WHERE ROWID = :id").arg(fts_table_));
+
   // Add or update songs.
   QList new_songs_list = new_songs.values();
   for (const Song &new_song : new_songs_list) {
@@ -715,25 +785,18 @@ void CollectionBackend::UpdateSongsBySongID(const SongMap &new_songs) {
 
       if (!new_song.IsMetadataEqual(old_song)) {  // Update existing song.
 
-        {
-          SqlQuery q(db);
-          q.prepare(QString("UPDATE %1 SET " + Song::kUpdateSpec + " WHERE ROWID = :id").arg(songs_table_));
-          new_song.BindToQuery(&q);
-          q.BindValue(":id", old_song.id());
-          if (!q.Exec()) {
-            db_->ReportErrors(q);
-            return;
-          }
+        new_song.BindToQuery(&update);
+        update.BindValue(":id", old_song.id());
+        if (!update.Exec()) {
+          db_->ReportErrors(update);
+          return;
         }
-        {
-          SqlQuery q(db);
-          q.prepare(QString("UPDATE %1 SET " + Song::kFtsUpdateSpec + " WHERE ROWID = :id").arg(fts_table_));
-          new_song.BindToFtsQuery(&q);
-          q.BindValue(":id", old_song.id());
-          if (!q.Exec()) {
-            db_->ReportErrors(q);
-            return;
-          }
+
+        new_song.BindToFtsQuery(&update_fts);
+        update_fts.BindValue(":id", old_song.id());
+        if (!update_fts.Exec()) {
+          db_->ReportErrors(update_fts);
+          return;
         }
 
         deleted_songs << old_song;
@@ -745,30 +808,22 @@ void CollectionBackend::UpdateSongsBySongID(const SongMap &new_songs) {
 
     }
     else {  // Add new song
-      int id = -1;
-      {
-        SqlQuery q(db);
-        q.prepare(QString("INSERT INTO %1 (" + Song::kColumnSpec + ") VALUES (" + Song::kBindSpec + ")").arg(songs_table_));
-        new_song.BindToQuery(&q);
-        if (!q.Exec()) {
-          db_->ReportErrors(q);
-          return;
-        }
-        // Get the new ID
-        id = q.lastInsertId().toInt();
+      new_song.BindToQuery(&insert);
+      if (!insert.Exec()) {
+        db_->ReportErrors(insert);
+        return;
       }
+      // Get the new ID
+      const int id = insert.lastInsertId().toInt();
 
       if (id == -1) return;
 
-      {  // Add to the FTS index
-        SqlQuery q(db);
-        q.prepare(QString("INSERT INTO %1 (ROWID, " + Song::kFtsColumnSpec + ") VALUES (:id, " + Song::kFtsBindSpec + ")").arg(fts_table_));
-        q.BindValue(":id", id);
-        new_song.BindToFtsQuery(&q);
-        if (!q.Exec()) {
-          db_->ReportErrors(q);
-          return;
-        }
+      // Add to the FTS index
+      insert_fts.BindValue(":id", id);
+      new_song.BindToFtsQuery(&insert_fts);
+      if (!insert_fts.Exec()) {
+        db_->ReportErrors(insert_fts);
+        return;
       }
 
       Song new_song_copy(new_song);
@@ -781,23 +836,15 @@ void CollectionBackend::UpdateSongsBySongID(const SongMap &new_songs) {
   QList old_songs_list = old_songs.values();
   for (const Song &old_song : old_songs_list) {
     if (!new_songs.contains(old_song.song_id())) {
-      {
-        SqlQuery q(db);
-        q.prepare(QString("DELETE FROM %1 WHERE ROWID = :id").arg(songs_table_));
-        q.BindValue(":id", old_song.id());
-        if (!q.Exec()) {
-          db_->ReportErrors(q);
-          return;
-        }
+      remove.BindValue(":id", old_song.id());
+      if (!remove.Exec()) {
+        db_->ReportErrors(remove);
+        return;
       }
-      {
-        SqlQuery q(db);
-        q.prepare(QString("DELETE FROM %1 WHERE ROWID = :id").arg(fts_table_));
-        q.BindValue(":id", old_song.id());
-        if (!q.Exec()) {
-          db_->ReportErrors(q);
-          return;
-        }
+      remove_fts.BindValue(":id", old_song.id());
+      if (!remove_fts.Exec()) {
+        db_->ReportErrors(remove_fts);
+        return;
       }
       deleted_songs << old_song;
     }
@@ -833,6 +880,8 @@ void CollectionBackend::UpdateMTimesOnly(const SongList &songs) {
   }
   transaction.Commit();
 
+  song_cache_.UpdateMTimes(songs);
+
 }
 
 void CollectionBackend::DeleteSongs(const SongList &songs) {
@@ -894,6 +943,15 @@ void CollectionBackend::MarkSongsUnavailable(const SongList &songs, const bool u
     emit SongsDiscovered(songs);
   }
 
+  // Unavailable songs are kept in the song cache, so they are found when they become available again.
+  SongList cached_songs;
+  cached_songs.reserve(songs.count());
+  for (Song song : songs) {
+    song.set_unavailable(unavailable);
+    cached_songs << song;
+  }
+  song_cache_.AddOrUpdateSongs(cached_songs);
+
   UpdateTotalSongCountAsync();
   UpdateTotalArtistCountAsync();
   UpdateTotalAlbumCountAsync();
@@ -902,8 +960,8 @@ void CollectionBackend::MarkSongsUnavailable(const SongList &songs, const bool u
 
 QStringList CollectionBackend::GetAll(const QString &column, const QueryOptions &opt) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   CollectionQuery query(db, songs_table_, fts_table_, opt);
   query.SetColumnSpec("DISTINCT " + column);
@@ -929,8 +987,8 @@ QStringList CollectionBackend::GetAllArtists(const QueryOptions &opt) {
 
 QStringList CollectionBackend::GetAllArtistsWithAlbums(const QueryOptions &opt) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   // Albums with 'albumartist' field set:
   CollectionQuery query(db, songs_table_, fts_table_, opt);
@@ -977,8 +1035,8 @@ CollectionBackend::AlbumList CollectionBackend::GetAlbumsByArtist(const QString
 
 SongList CollectionBackend::GetArtistSongs(const QString &effective_albumartist, const QueryOptions &opt) {
 
-  QSqlDatabase db(db_->Connect());
-  QMutexLocker l(db_->Mutex());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   CollectionQuery query(db, songs_table_, fts_table_, opt);
   query.AddCompilationRequirement(false);
@@ -995,8 +1053,8 @@ SongList CollectionBackend::GetArtistSongs(const QString &effective_albumartist,
 
 SongList CollectionBackend::GetAlbumSongs(const QString &effective_albumartist, const QString &album, const QueryOptions &opt) {
 
-  QSqlDatabase db(db_->Connect());
-  QMutexLocker l(db_->Mutex());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   CollectionQuery query(db, songs_table_, fts_table_, opt);
   query.AddCompilationRequirement(false);
@@ -1014,8 +1072,8 @@ SongList CollectionBackend::GetAlbumSongs(const QString &effective_albumartist,
 
 SongList CollectionBackend::GetSongsByAlbum(const QString &album, const QueryOptions &opt) {
 
-  QSqlDatabase db(db_->Connect());
-  QMutexLocker l(db_->Mutex());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   CollectionQuery query(db, songs_table_, fts_table_, opt);
   query.AddCompilationRequirement(false);
@@ -1038,7 +1096,7 @@ bool CollectionBackend::ExecCollectionQuery(CollectionQuery *query, SongList &so
 
   while (query->Next()) {
     Song song(source_);
-    song.InitFromQuery(*query, true);
+    song.InitFromQuery(*query, true, 0);
     songs << song;
   }
   return true;
@@ -1053,7 +1111,7 @@ bool CollectionBackend::ExecCollectionQuery(CollectionQuery *query, SongMap &son
 
   while (query->Next()) {
     Song song(source_);
-    song.InitFromQuery(*query, true);
+    song.InitFromQuery(*query, true, 0);
     songs.insert(song.song_id(), song);
   }
   return true;
@@ -1062,16 +1120,28 @@ bool CollectionBackend::ExecCollectionQuery(CollectionQuery *query, SongMap &son
 
 Song CollectionBackend::GetSongById(const int id) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  Song song;
+  if (song_cache_.GetSongById(id, &song)) return song;
+
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
   return GetSongById(id, db);
 
 }
 
 SongList CollectionBackend::GetSongsById(const QList<int> &ids) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  if (song_cache_.is_loaded()) {
+    SongList songs;
+    for (const int id : ids) {
+      Song song;
+      if (song_cache_.GetSongById(id, &song) && song.is_valid()) songs << song;
+    }
+    return songs;
+  }
+
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   QStringList str_ids;
   str_ids.reserve(ids.count());
@@ -1085,8 +1155,17 @@ SongList CollectionBackend::GetSongsById(const QList<int> &ids) {
 
 SongList CollectionBackend::GetSongsById(const QStringList &ids) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  if (song_cache_.is_loaded()) {
+    SongList songs;
+    for (const QString &id : ids) {
+      Song song;
+      if (song_cache_.GetSongById(id.toInt(), &song) && song.is_valid()) songs << song;
+    }
+    return songs;
+  }
+
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   return GetSongsById(ids, db);
 
@@ -1094,8 +1173,8 @@ SongList CollectionBackend::GetSongsById(const QStringList &ids) {
 
 SongList CollectionBackend::GetSongsByForeignId(const QStringList &ids, const QString &table, const QString &column) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   QString in = ids.join(",");
 
@@ -1112,7 +1191,7 @@ SongList CollectionBackend::GetSongsByForeignId(const QStringList &ids, const QS
     const qint64 index = ids.indexOf(foreign_id);
     if (index == -1) continue;
 
-    ret[index].InitFromQuery(q, true);
+    ret[index].InitFromQuery(q, true, 0);
   }
   return ret.toList();
 
@@ -1140,7 +1219,7 @@ SongList CollectionBackend::GetSongsById(const QStringList &ids, QSqlDatabase &d
   SongList ret;
   while (q.next()) {
     Song song(source_);
-    song.InitFromQuery(q, true);
+    song.InitFromQuery(q, true, 0);
     ret << song;
   }
   return ret;
@@ -1149,8 +1228,16 @@ SongList CollectionBackend::GetSongsById(const QStringList &ids, QSqlDatabase &d
 
 Song CollectionBackend::GetSongByUrl(const QUrl &url, const qint64 beginning) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  SongList cached_songs;
+  if (song_cache_.GetSongsByUrl(url, &cached_songs)) {
+    for (const Song &song : cached_songs) {
+      if (song.beginning_nanosec() == beginning && !song.is_unavailable()) return song;
+    }
+    return Song();
+  }
+
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   SqlQuery q(db);
   q.prepare(QString("SELECT ROWID, " + Song::kColumnSpec + " FROM %1 WHERE (url = :url1 OR url = :url2 OR url = :url3 OR url = :url4) AND beginning = :beginning AND unavailable = 0").arg(songs_table_));
@@ -1171,7 +1258,7 @@ Song CollectionBackend::GetSongByUrl(const QUrl &url, const qint64 beginning) {
   }
 
   Song song(source_);
-  song.InitFromQuery(q, true);
+  song.InitFromQuery(q, true, 0);
 
   return song;
 
@@ -1179,8 +1266,17 @@ Song CollectionBackend::GetSongByUrl(const QUrl &url, const qint64 beginning) {
 
 SongList CollectionBackend::GetSongsByUrl(const QUrl &url, const bool unavailable) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  SongList cached_songs;
+  if (song_cache_.GetSongsByUrl(url, &cached_songs)) {
+    SongList songs;
+    for (const Song &song : cached_songs) {
+      if (song.is_unavailable() == unavailable) songs << song;
+    }
+    return songs;
+  }
+
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   SqlQuery q(db);
   q.prepare(QString("SELECT ROWID, " + Song::kColumnSpec + " FROM %1 WHERE (url = :url1 OR url = :url2 OR url = :url3 OR url = :url4) AND unavailable = :unavailable").arg(songs_table_));
@@ -1195,7 +1291,7 @@ SongList CollectionBackend::GetSongsByUrl(const QUrl &url, const bool unavailabl
   if (q.Exec()) {
     while (q.next()) {
       Song song(source_);
-      song.InitFromQuery(q, true);
+      song.InitFromQuery(q, true, 0);
       songs << song;
     }
   }
@@ -1210,16 +1306,29 @@ SongList CollectionBackend::GetSongsByUrl(const QUrl &url, const bool unavailabl
 
 Song CollectionBackend::GetSongBySongId(const QString &song_id) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  SongList cached_songs;
+  if (song_cache_.GetSongsBySongId(song_id, &cached_songs)) {
+    return cached_songs.isEmpty() ? Song() : cached_songs.first();
+  }
+
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
   return GetSongBySongId(song_id, db);
 
 }
 
 SongList CollectionBackend::GetSongsBySongId(const QStringList &song_ids) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  if (song_cache_.is_loaded()) {
+    SongList songs;
+    for (const QString &song_id : song_ids) {
+      song_cache_.GetSongsBySongId(song_id, &songs);
+    }
+    return songs;
+  }
+
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   return GetSongsBySongId(song_ids, db);
 
@@ -1235,25 +1344,32 @@ Song CollectionBackend::GetSongBySongId(const QString &song_id, QSqlDatabase &db
 
 SongList CollectionBackend::GetSongsBySongId(const QStringList &song_ids, QSqlDatabase &db) {
 
-  QStringList song_ids2;
-  song_ids2.reserve(song_ids.count());
-  for (const QString &song_id : song_ids) {
-    song_ids2 << "'" + song_id + "'";
-  }
-  QString in = song_ids2.join(",");
+  SongList ret;
 
-  SqlQuery q(db);
-  q.prepare(QString("SELECT ROWID, " + Song::kColumnSpec + " FROM %1 WHERE SONG_ID IN (%2)").arg(songs_table_, in));
-  if (!q.Exec()) {
-    db_->ReportErrors(q);
-    return SongList();
-  }
+  // Bind the song IDs, in statements of at most kMaxBindValues.
+  for (int i = 0; i < song_ids.count(); i += kMaxBindValues) {
+    const QStringList batch = song_ids.mid(i, kMaxBindValues);
+    QStringList placeholders;
+    placeholders.reserve(batch.count());
+    for (int j = 0; j < batch.count(); ++j) {
+      placeholders << QString(":song_id%1").arg(j);
+    }
 
-  SongList ret;
-  while (q.next()) {
-    Song song(source_);
-    song.InitFromQuery(q, true);
-    ret << song;
+    SqlQuery q(db);
+    q.prepare(QString("SELECT ROWID, " + Song::kColumnSpec + " FROM %1 WHERE SONG_ID IN (%2)").arg(songs_table_, placeholders.join(",")));
+    for (int j = 0; j < batch.count(); ++j) {
+      q.BindStringValue(placeholders[j], batch[j]);
+    }
+    if (!q.Exec()) {
+      db_->ReportErrors(q);
+      return SongList();
+    }
+
+    while (q.next()) {
+      Song song(source_);
+      song.InitFromQuery(q, true, 0);
+      ret << song;
+    }
   }
 
   return ret;
@@ -1262,8 +1378,8 @@ SongList CollectionBackend::GetSongsBySongId(const QStringList &song_ids, QSqlDa
 
 SongList CollectionBackend::GetSongsByFingerprint(const QString &fingerprint) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   SqlQuery q(db);
   q.prepare(QString("SELECT ROWID, " + Song::kColumnSpec + " FROM %1 WHERE fingerprint = :fingerprint").arg(songs_table_));
@@ -1276,7 +1392,7 @@ SongList CollectionBackend::GetSongsByFingerprint(const QString &fingerprint) {
   SongList songs;
   while (q.next()) {
     Song song(source_);
-    song.InitFromQuery(q, true);
+    song.InitFromQuery(q, true, 0);
     songs << song;
   }
 
@@ -1291,8 +1407,8 @@ CollectionBackend::AlbumList CollectionBackend::GetCompilationAlbums(const Query
 
 SongList CollectionBackend::GetCompilationSongs(const QString &album, const QueryOptions &opt) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   CollectionQuery query(db, songs_table_, fts_table_, opt);
   query.SetColumnSpec("%songs_table.ROWID, " + Song::kColumnSpec);
@@ -1307,7 +1423,7 @@ SongList CollectionBackend::GetCompilationSongs(const QString &album, const Quer
   SongList ret;
   while (query.Next()) {
     Song song(source_);
-    song.InitFromQuery(query, true);
+    song.InitFromQuery(query, true, 0);
     ret << song;
   }
   return ret;
@@ -1401,7 +1517,7 @@ bool CollectionBackend::UpdateCompilations(const QSqlDatabase &db, SongList &del
     if (q.Exec()) {
       while (q.next()) {
         Song song(source_);
-        song.InitFromQuery(q, true);
+        song.InitFromQuery(q, true, 0);
         deleted_songs << song;
         song.set_compilation_detected(compilation_detected);
         added_songs << song;
@@ -1432,8 +1548,8 @@ bool CollectionBackend::UpdateCompilations(const QSqlDatabase &db, SongList &del
 
 CollectionBackend::AlbumList CollectionBackend::GetAlbums(const QString &artist, const bool compilation_required, const QueryOptions &opt) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   CollectionQuery query(db, songs_table_, fts_table_, opt);
   query.SetColumnSpec("url, effective_albumartist, album, compilation_effective, art_automatic, art_manual, filetype, cue_path");
@@ -1513,8 +1629,8 @@ CollectionBackend::AlbumList CollectionBackend::GetAlbums(const QString &artist,
 
 CollectionBackend::Album CollectionBackend::GetAlbumArt(const QString &effective_albumartist, const QString &album) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   Album ret;
   ret.album = album;
@@ -1567,7 +1683,7 @@ void CollectionBackend::UpdateManualAlbumArt(const QString &effective_albumartis
   SongList deleted_songs;
   while (query.Next()) {
     Song song(source_);
-    song.InitFromQuery(query, true);
+    song.InitFromQuery(query, true, 0);
     deleted_songs << song;
   }
 
@@ -1598,7 +1714,7 @@ void CollectionBackend::UpdateManualAlbumArt(const QString &effective_albumartis
   SongList added_songs;
   while (query.Next()) {
     Song song(source_);
-    song.InitFromQuery(query, true);
+    song.InitFromQuery(query, true, 0);
     added_songs << song;
   }
 
@@ -1634,7 +1750,7 @@ void CollectionBackend::UpdateAutomaticAlbumArt(const QString &effective_albumar
   SongList deleted_songs;
   while (query.Next()) {
     Song song(source_);
-    song.InitFromQuery(query, true);
+    song.InitFromQuery(query, true, 0);
     deleted_songs << song;
   }
 
@@ -1665,7 +1781,7 @@ void CollectionBackend::UpdateAutomaticAlbumArt(const QString &effective_albumar
   SongList added_songs;
   while (query.Next()) {
     Song song(source_);
-    song.InitFromQuery(query, true);
+    song.InitFromQuery(query, true, 0);
     added_songs << song;
   }
 
@@ -1696,7 +1812,7 @@ void CollectionBackend::ForceCompilation(const QString &album, const QList<QStri
 
     while (query.Next()) {
       Song song(source_);
-      song.InitFromQuery(query, true);
+      song.InitFromQuery(query, true, 0);
       deleted_songs << song;
     }
 
@@ -1724,7 +1840,7 @@ void CollectionBackend::ForceCompilation(const QString &album, const QList<QStri
 
     while (query.Next()) {
       Song song(source_);
-      song.InitFromQuery(query, true);
+      song.InitFromQuery(query, true, 0);
       added_songs << song;
     }
   }
@@ -1833,14 +1949,16 @@ void CollectionBackend::DeleteAll() {
     t.Commit();
   }
 
+  if (song_cache_.is_loaded()) song_cache_.Load(SongList());
+
   emit DatabaseReset();
 
 }
 
 SongList CollectionBackend::SmartPlaylistsFindSongs(const SmartPlaylistSearch &search) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   // Build the query
   QString sql = search.ToSql(songs_table());
@@ -1854,10 +1972,12 @@ SongList CollectionBackend::SmartPlaylistsFindSongs(const SmartPlaylistSearch &s
     return ret;
   }
 
-  // Read the results
+  // Read the results, songs in the song cache are shared instead of read again.
   while (query.next()) {
     Song song;
-    song.InitFromQuery(query, true);
+    if (!song_cache_.GetSongById(query.value(0).toInt(), &song) || !song.is_valid()) {
+      song.InitFromQuery(query, true, 0);
+    }
     ret << song;
   }
   return ret;
@@ -1873,8 +1993,8 @@ SongList CollectionBackend::SmartPlaylistsGetAllSongs() {
 
 SongList CollectionBackend::GetSongsBy(const QString &artist, const QString &album, const QString &title) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   SongList songs;
   SqlQuery q(db);
@@ -1893,7 +2013,7 @@ SongList CollectionBackend::GetSongsBy(const QString &artist, const QString &alb
   }
   while (q.next()) {
     Song song(source_);
-    song.InitFromQuery(q, true);
+    song.InitFromQuery(q, true, 0);
     songs << song;
   }
 
@@ -1912,7 +2032,7 @@ void CollectionBackend::UpdateLastPlayed(const QString &artist, const QString &a
   QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
-  for (const Song &song : songs) {
+  for (Song &song : songs) {
     if (song.lastplayed() >= lastplayed) {
       continue;
     }
@@ -1924,6 +2044,7 @@ void CollectionBackend::UpdateLastPlayed(const QString &artist, const QString &a
       db_->ReportErrors(q);
       continue;
     }
+    song.set_lastplayed(lastplayed);
   }
 
   emit SongsStatisticsChanged(SongList() << songs);
@@ -1941,7 +2062,7 @@ void CollectionBackend::UpdatePlayCount(const QString &artist, const QString &ti
   QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
-  for (const Song &song : songs) {
+  for (Song &song : songs) {
     SqlQuery q(db);
     q.prepare(QString("UPDATE %1 SET playcount = :playcount WHERE ROWID = :id").arg(songs_table_));
     q.BindValue(":playcount", playcount);
@@ -1950,6 +2071,7 @@ void CollectionBackend::UpdatePlayCount(const QString &artist, const QString &ti
       db_->ReportErrors(q);
       return;
     }
+    song.set_playcount(playcount);
   }
 
   emit SongsStatisticsChanged(SongList() << songs);
@@ -2006,13 +2128,15 @@ void CollectionBackend::UpdateLastSeen(const int directory_id, const int expire_
     QSqlDatabase db(db_->Connect());
 
     SqlQuery q(db);
+    const qint64 lastseen = QDateTime::currentDateTime().toSecsSinceEpoch();
     q.prepare(QString("UPDATE %1 SET lastseen = :lastseen WHERE directory_id = :directory_id AND unavailable = 0").arg(songs_table_));
-    q.BindValue(":lastseen", QDateTime::currentDateTime().toSecsSinceEpoch());
+    q.BindValue(":lastseen", lastseen);
     q.BindValue(":directory_id", directory_id);
     if (!q.Exec()) {
       db_->ReportErrors(q);
       return;
     }
+    song_cache_.UpdateLastSeen(directory_id, lastseen);
   }
 
   if (expire_unavailable_songs_days > 0) ExpireSongs(directory_id, expire_unavailable_songs_days);
@@ -2023,8 +2147,8 @@ void CollectionBackend::ExpireSongs(const int directory_id, const int expire_una
 
   SongList songs;
   {
-    QMutexLocker l(db_->Mutex());
-    QSqlDatabase db(db_->Connect());
+    QMutexLocker l(db_->ReadMutex());
+    QSqlDatabase db(db_->ConnectReadOnly());
     SqlQuery q(db);
     q.prepare(QString("SELECT ROWID, " + Song::kColumnSpec + " FROM %1 WHERE directory_id = :directory_id AND unavailable = 1 AND lastseen > 0 AND lastseen < :time").arg(songs_table_));
     q.BindValue(":directory_id", directory_id);
@@ -2035,7 +2159,7 @@ void CollectionBackend::ExpireSongs(const int directory_id, const int expire_una
     }
     while (q.next()) {
       Song song(source_);
-      song.InitFromQuery(q, true);
+      song.InitFromQuery(q, true, 0);
       songs << song;
     }
   }
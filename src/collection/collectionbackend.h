@@ -39,6 +39,7 @@
 #include "core/song.h"
 #include "core/sqlquery.h"
 #include "collectionquery.h"
+#include "collectionsongcache.h"
 #include "directory.h"
 
 class QThread;
@@ -141,6 +142,10 @@ class CollectionBackend : public CollectionBackendInterface {
 
   Database *db() const override { return db_; }
 
+  // Songs of the collection in memory, used by the song lookups once LoadSongCache() has run.
+  const CollectionSongCache *song_cache() const { return &song_cache_; }
+  void LoadSongCacheAsync();
+
   QString songs_table() const override { return songs_table_; }
   QString fts_table() const override { return fts_table_; }
   QString dirs_table() const { return dirs_table_; }
@@ -218,6 +223,7 @@ class CollectionBackend : public CollectionBackendInterface {
  public slots:
   void Exit();
   void LoadDirectories();
+  void LoadSongCache();
   void UpdateTotalSongCount();
   void UpdateTotalArtistCount();
   void UpdateTotalAlbumCount();
@@ -289,6 +295,9 @@ class CollectionBackend : public CollectionBackendInterface {
   SongList GetSongsBySongId(const QStringList &song_ids, QSqlDatabase &db);
 
  private:
+  // Most values bound in one statement, the default limit of SQLite before 3.32.
+  static const int kMaxBindValues;
+
   Database *db_;
   TaskManager *task_manager_;
   Song::Source source_;
@@ -298,6 +307,8 @@ class CollectionBackend : public CollectionBackendInterface {
   QString fts_table_;
   QThread *original_thread_;
 
+  CollectionSongCache song_cache_;
+
 };
 
 #endif  // COLLECTIONBACKEND_H
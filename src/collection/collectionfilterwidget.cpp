@@ -65,6 +65,7 @@ CollectionFilterWidget::CollectionFilterWidget(QWidget *parent)
       group_by_menu_(nullptr),
       collection_menu_(nullptr),
       group_by_group_(nullptr),
+      top_results_(nullptr),
       filter_delay_(new QTimer(this)),
       filter_applies_to_model_(true),
       delay_behaviour_(DelayedOnLargeLibraries) {
@@ -122,6 +123,11 @@ CollectionFilterWidget::CollectionFilterWidget(QWidget *parent)
 
   group_by_menu_ = new QMenu(tr("Group by"), this);
 
+  // Show the best matches of the search as a flat list instead of grouping them.
+  top_results_ = new QAction(tr("Show top results when searching"), this);
+  top_results_->setCheckable(true);
+  QObject::connect(top_results_, &QAction::toggled, this, [this](const bool checked) { if (model_) model_->SetFilterTopResults(checked); });
+
   QObject::connect(ui_->save_grouping, &QAction::triggered, this, &CollectionFilterWidget::SaveGroupBy);
   QObject::connect(ui_->manage_groupings, &QAction::triggered, this, &CollectionFilterWidget::ShowGroupingManager);
 
@@ -130,6 +136,7 @@ CollectionFilterWidget::CollectionFilterWidget(QWidget *parent)
   collection_menu_->setIcon(ui_->options->icon());
   collection_menu_->addMenu(filter_age_menu_);
   collection_menu_->addMenu(group_by_menu_);
+  collection_menu_->addAction(top_results_);
   collection_menu_->addAction(ui_->save_grouping);
   collection_menu_->addAction(ui_->manage_groupings);
   collection_menu_->addSeparator();
@@ -163,6 +170,8 @@ void CollectionFilterWidget::Init(CollectionModel *model) {
   QObject::connect(model_, &CollectionModel::GroupingChanged, this, &CollectionFilterWidget::GroupingChanged);
   QObject::connect(group_by_dialog_, &GroupByDialog::Accepted, model_, &CollectionModel::SetGroupBy);
 
+  model_->SetFilterTopResults(top_results_->isChecked());
+
   QList<QAction*> filter_ages = filter_ages_.keys();
   for (QAction *action : filter_ages) {
     int age = filter_ages_[action];
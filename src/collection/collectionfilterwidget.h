@@ -124,6 +124,7 @@ class CollectionFilterWidget : public QWidget {
   QMenu *group_by_menu_;
   QMenu *collection_menu_;
   QActionGroup *group_by_group_;
+  QAction *top_results_;
   QHash<QAction*, int> filter_ages_;
 
   QTimer *filter_delay_;
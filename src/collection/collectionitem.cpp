@@ -0,0 +1,113 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <cstddef>
+#include <new>
+
+#include "core/memorypool.h"
+#include "core/simpletreeitem.h"
+#include "core/song.h"
+#include "collectionitem.h"
+
+namespace {
+
+// The pools are never deleted, items can still be freed while static objects are destroyed.
+MemoryPool *ItemPool() {
+  static MemoryPool *pool = new MemoryPool(sizeof(CollectionItem));
+  return pool;
+}
+
+MemoryPool *ContainerFieldsPool() {
+  static MemoryPool *pool = new MemoryPool(sizeof(CollectionItem::ContainerFields));
+  return pool;
+}
+
+// Shared by all items that are not songs, so they don't allocate song data of their own.
+const Song &EmptySong() {
+  static const Song *song = new Song();
+  return *song;
+}
+
+}  // namespace
+
+CollectionItem::ContainerFields::ContainerFields()
+    : disc(-1),
+      year(-1),
+      originalyear(-1),
+      samplerate(-1),
+      bitdepth(-1),
+      bitrate(-1),
+      filetype(Song::FileType_Unknown) {}
+
+CollectionItem::ContainerFields::ContainerFields(const Song &song)
+    : albumartist(song.albumartist()),
+      artist(song.artist()),
+      album(song.album()),
+      album_id(song.album_id()),
+      grouping(song.grouping()),
+      genre(song.genre()),
+      composer(song.composer()),
+      performer(song.performer()),
+      disc(song.disc()),
+      year(song.year()),
+      originalyear(song.originalyear()),
+      samplerate(song.samplerate()),
+      bitdepth(song.bitdepth()),
+      bitrate(song.bitrate()),
+      filetype(song.filetype()) {}
+
+void *CollectionItem::ContainerFields::operator new(const size_t size) {
+  return size == sizeof(ContainerFields) ? ContainerFieldsPool()->Allocate() : ::operator new(size);
+}
+
+void CollectionItem::ContainerFields::operator delete(void *p, const size_t size) {
+  if (size == sizeof(ContainerFields)) ContainerFieldsPool()->Free(p);
+  else ::operator delete(p);
+}
+
+CollectionItem::CollectionItem(SimpleTreeModel<CollectionItem> *_model)
+    : SimpleTreeItem<CollectionItem>(Type_Root, _model),
+      container_level(-1),
+      metadata(EmptySong()),
+      compilation_artist_node_(nullptr) {}
+
+CollectionItem::CollectionItem(Type _type, CollectionItem *_parent)
+    : SimpleTreeItem<CollectionItem>(_type, _parent),
+      container_level(-1),
+      metadata(EmptySong()),
+      compilation_artist_node_(nullptr) {}
+
+void *CollectionItem::operator new(const size_t size) {
+  return size == sizeof(CollectionItem) ? ItemPool()->Allocate() : ::operator new(size);
+}
+
+void CollectionItem::operator delete(void *p, const size_t size) {
+  if (size == sizeof(CollectionItem)) ItemPool()->Free(p);
+  else ::operator delete(p);
+}
+
+qint64 CollectionItem::allocated_items() {
+  return ItemPool()->blocks();
+}
+
+qint64 CollectionItem::allocated_bytes() {
+  return ItemPool()->bytes() + ContainerFieldsPool()->bytes();
+}
@@ -24,6 +24,11 @@
 
 #include "config.h"
 
+#include <cstddef>
+#include <memory>
+
+#include <QString>
+
 #include "core/simpletreeitem.h"
 #include "core/song.h"
 
@@ -37,18 +42,52 @@ class CollectionItem : public SimpleTreeItem<CollectionItem> {
     Type_LoadingIndicator,
   };
 
-  explicit CollectionItem(SimpleTreeModel<CollectionItem> *_model)
-      : SimpleTreeItem<CollectionItem>(Type_Root, _model),
-        container_level(-1),
-        compilation_artist_node_(nullptr) {}
+  // The song fields a container groups on, used to filter the query for its children.
+  // Containers keep these instead of a whole song.
+  struct ContainerFields {
+    ContainerFields();
+    explicit ContainerFields(const Song &song);
+
+    const QString &effective_albumartist() const { return albumartist.isEmpty() ? artist : albumartist; }
+    int effective_originalyear() const { return originalyear < 0 ? year : originalyear; }
+
+    QString albumartist;
+    QString artist;
+    QString album;
+    QString album_id;
+    QString grouping;
+    QString genre;
+    QString composer;
+    QString performer;
+    int disc;
+    int year;
+    int originalyear;
+    int samplerate;
+    int bitdepth;
+    int bitrate;
+    Song::FileType filetype;
+
+    static void *operator new(const size_t size);
+    static void operator delete(void *p, const size_t size);
+  };
+
+  explicit CollectionItem(SimpleTreeModel<CollectionItem> *_model);
+  explicit CollectionItem(Type _type, CollectionItem *_parent = nullptr);
+
+  // Items are allocated from a pool, so the items of a tree are stored in large chunks.
+  static void *operator new(const size_t size);
+  static void operator delete(void *p, const size_t size);
 
-  explicit CollectionItem(Type _type, CollectionItem *_parent = nullptr)
-      : SimpleTreeItem<CollectionItem>(_type, _parent),
-        container_level(-1),
-        compilation_artist_node_(nullptr) {}
+  // Number of items allocated, and the memory used by the pool for them.
+  static qint64 allocated_items();
+  static qint64 allocated_bytes();
 
   int container_level;
+  // The song of song items, it shares the data of the song it was created from.
+  // Other items share an empty song.
   Song metadata;
+  // Only set for containers.
+  std::unique_ptr<ContainerFields> fields;
   CollectionItem *compilation_artist_node_;
 
  private:
@@ -40,6 +40,7 @@
 #include <QList>
 #include <QSet>
 #include <QMap>
+#include <QHash>
 #include <QMetaType>
 #include <QVariant>
 #include <QByteArray>
@@ -73,6 +74,8 @@
 
 const int CollectionModel::kPrettyCoverSize = 32;
 const char *CollectionModel::kPixmapDiskCacheDir = "pixmapcache";
+const int CollectionModel::kTopResultsCount = 100;
+const int CollectionModel::kQueryCacheRows = 20000;
 
 QNetworkDiskCache *CollectionModel::sIconCache = nullptr;
 
@@ -81,24 +84,28 @@ CollectionModel::CollectionModel(CollectionBackend *backend, Application *app, Q
       backend_(backend),
       app_(app),
       dir_model_(new CollectionDirectoryModel(backend, this)),
-      show_various_artists_(true),
       total_song_count_(0),
       total_artist_count_(0),
       total_album_count_(0),
-      separate_albums_by_grouping_(false),
+      build_id_(0),
+      applied_build_id_(0),
       artist_icon_(IconLoader::Load("folder-sound")),
       album_icon_(IconLoader::Load("cdcase")),
       init_task_id_(-1),
       use_pretty_covers_(true),
-      show_dividers_(true),
       use_disk_cache_(false),
-      use_lazy_loading_(true) {
+      use_lazy_loading_(true),
+      query_cache_(kQueryCacheRows),
+      query_cache_generation_(0),
+      query_cache_hits_(0),
+      query_cache_misses_(0) {
 
   root_->lazy_loaded = true;
 
-  group_by_[0] = GroupBy_AlbumArtist;
-  group_by_[1] = GroupBy_AlbumDisc;
-  group_by_[2] = GroupBy_None;
+  options_.group_by[0] = GroupBy_AlbumArtist;
+  options_.group_by[1] = GroupBy_AlbumDisc;
+  options_.group_by[2] = GroupBy_None;
+  tree_.options = options_;
 
   cover_loader_options_.get_image_data_ = false;
   cover_loader_options_.get_image_ = true;
@@ -153,8 +160,8 @@ void CollectionModel::set_pretty_covers(const bool use_pretty_covers) {
 
 void CollectionModel::set_show_dividers(const bool show_dividers) {
 
-  if (show_dividers != show_dividers_) {
-    show_dividers_ = show_dividers;
+  if (show_dividers != options_.show_dividers) {
+    options_.show_dividers = show_dividers;
     Reset();
   }
 
@@ -207,13 +214,20 @@ void CollectionModel::Init(const bool async) {
 
 void CollectionModel::SongsDiscovered(const SongList &songs) {
 
+  ClearQueryCache();
+
+  if (is_building()) build_songs_discovered_ << songs;
+
+  // Top results are ranked by the database, new songs show up when the filter text changes.
+  if (IsTopResults(tree_.options)) return;
+
   for (const Song &song : songs) {
 
     // Sanity check to make sure we don't add songs that are outside the user's filter
-    if (!query_options_.Matches(song)) continue;
+    if (!tree_.options.query_options.Matches(song)) continue;
 
     // Hey, we've already got that one!
-    if (song_nodes_.contains(song.id())) continue;
+    if (tree_.song_nodes.contains(song.id())) continue;
 
     // Before we can add each song we need to make sure the required container items already exist in the tree.
     // These depend on which "group by" settings the user has on the collection.
@@ -223,7 +237,7 @@ void CollectionModel::SongsDiscovered(const SongList &songs) {
     CollectionItem *container = root_;
     QString key;
     for (int i = 0; i < 3; ++i) {
-      GroupBy group_by = group_by_[i];
+      GroupBy group_by = tree_.options.group_by[i];
       if (group_by == GroupBy_None) break;
 
       if (!key.isEmpty()) key.append("-");
@@ -238,16 +252,16 @@ void CollectionModel::SongsDiscovered(const SongList &songs) {
       }
       else {
         // Otherwise find the proper container at this level based on the item's key
-        key.append(ContainerKey(group_by, separate_albums_by_grouping_, song));
+        key.append(ContainerKey(group_by, tree_.options.separate_albums_by_grouping, song));
 
         // Does it exist already?
-        if (container_nodes_[i].contains(key)) {
-          container = container_nodes_[i][key];
+        if (tree_.container_nodes[i].contains(key)) {
+          container = tree_.container_nodes[i][key];
         }
         else {
           // Create the container
-          container = ItemFromSong(group_by, separate_albums_by_grouping_, true, i == 0, container, song, i);
-          container_nodes_[i].insert(key, container);
+          container = ItemFromSong(&tree_, group_by, true, i == 0, container, song, i);
+          tree_.container_nodes[i].insert(key, container);
         }
 
       }
@@ -258,7 +272,7 @@ void CollectionModel::SongsDiscovered(const SongList &songs) {
     if (!container->lazy_loaded && use_lazy_loading_) continue;
 
     // We've gone all the way down to the deepest level and everything was already lazy loaded, so now we have to create the song in the container.
-    song_nodes_.insert(song.id(), ItemFromSong(GroupBy_None, separate_albums_by_grouping_, true, false, container, song, -1));
+    tree_.song_nodes.insert(song.id(), ItemFromSong(&tree_, GroupBy_None, true, false, container, song, -1));
   }
 
 }
@@ -267,9 +281,13 @@ void CollectionModel::SongsSlightlyChanged(const SongList &songs) {
 
   // This is called if there was a minor change to the songs that will not normally require the collection to be restructured.
   // We can just update our internal cache of Song objects without worrying about resetting the model.
+  ClearQueryCache();
+
+  if (is_building()) build_songs_changed_ << songs;
+
   for (const Song &song : songs) {
-    if (song_nodes_.contains(song.id())) {
-      song_nodes_[song.id()]->metadata = song;
+    if (tree_.song_nodes.contains(song.id())) {
+      tree_.song_nodes[song.id()]->metadata = song;
     }
   }
 
@@ -283,7 +301,8 @@ CollectionItem *CollectionModel::CreateCompilationArtistNode(const bool signal,
 
   parent->compilation_artist_node_ = new CollectionItem(CollectionItem::Type_Container, parent);
   parent->compilation_artist_node_->compilation_artist_node_ = nullptr;
-  if (parent != root_ && !parent->key.isEmpty()) parent->compilation_artist_node_->key.append(parent->key);
+  parent->compilation_artist_node_->fields = std::make_unique<CollectionItem::ContainerFields>();
+  if (parent->type != CollectionItem::Type_Root && !parent->key.isEmpty()) parent->compilation_artist_node_->key.append(parent->key);
   parent->compilation_artist_node_->key.append(tr("Various artists"));
   parent->compilation_artist_node_->display_text = tr("Various artists");
   parent->compilation_artist_node_->sort_text = " various";
@@ -426,20 +445,20 @@ QString CollectionModel::DividerKey(const GroupBy group_by, CollectionItem *item
 
     case GroupBy_YearAlbum:
     case GroupBy_YearAlbumDisc:
-      return SortTextForNumber(item->metadata.year());
+      return SortTextForNumber(item->fields->year);
 
     case GroupBy_OriginalYearAlbum:
     case GroupBy_OriginalYearAlbumDisc:
-      return SortTextForNumber(item->metadata.effective_originalyear());
+      return SortTextForNumber(item->fields->effective_originalyear());
 
     case GroupBy_Samplerate:
-      return SortTextForNumber(item->metadata.samplerate());
+      return SortTextForNumber(item->fields->samplerate);
 
     case GroupBy_Bitdepth:
-      return SortTextForNumber(item->metadata.bitdepth());
+      return SortTextForNumber(item->fields->bitdepth);
 
     case GroupBy_Bitrate:
-      return SortTextForNumber(item->metadata.bitrate());
+      return SortTextForNumber(item->fields->bitrate);
 
     case GroupBy_None:
     case GroupByCount:
@@ -504,18 +523,22 @@ QString CollectionModel::DividerDisplayText(const GroupBy group_by, const QStrin
 
 void CollectionModel::SongsDeleted(const SongList &songs) {
 
+  ClearQueryCache();
+
+  if (is_building()) build_songs_deleted_ << songs;
+
   // Delete the actual song nodes first, keeping track of each parent so we might check to see if they're empty later.
   QSet<CollectionItem*> parents;
   for (const Song &song : songs) {
 
-    if (song_nodes_.contains(song.id())) {
-      CollectionItem *node = song_nodes_[song.id()];
+    if (tree_.song_nodes.contains(song.id())) {
+      CollectionItem *node = tree_.song_nodes[song.id()];
 
       if (node->parent != root_) parents << node->parent;
 
       beginRemoveRows(ItemToIndex(node->parent), node->row, node->row);
       node->parent->Delete(node->row);
-      song_nodes_.remove(song.id());
+      tree_.song_nodes.remove(song.id());
       endRemoveRows();
 
     }
@@ -543,15 +566,15 @@ void CollectionModel::SongsDeleted(const SongList &songs) {
 
       // Maybe consider its divider node
       if (node->container_level == 0) {
-        divider_keys << DividerKey(group_by_[0], node);
+        divider_keys << DividerKey(tree_.options.group_by[0], node);
       }
 
       // Special case the Various Artists node
       if (IsCompilationArtistNode(node)) {
         node->parent->compilation_artist_node_ = nullptr;
       }
-      else if (container_nodes_[node->container_level].contains(node->key)) {
-        container_nodes_[node->container_level].remove(node->key);
+      else if (tree_.container_nodes[node->container_level].contains(node->key)) {
+        tree_.container_nodes[node->container_level].remove(node->key);
       }
 
       // Remove from pixmap cache
@@ -581,20 +604,20 @@ void CollectionModel::SongsDeleted(const SongList &songs) {
 
   // Delete empty dividers
   for (const QString &divider_key : std::as_const(divider_keys)) {
-    if (!divider_nodes_.contains(divider_key)) continue;
+    if (!tree_.divider_nodes.contains(divider_key)) continue;
 
     // Look to see if there are any other items still under this divider
-    QList<CollectionItem*> container_nodes = container_nodes_[0].values();
-    if (std::any_of(container_nodes.begin(), container_nodes.end(), [this, divider_key](CollectionItem *node){ return DividerKey(group_by_[0], node) == divider_key; })) {
+    QList<CollectionItem*> container_nodes = tree_.container_nodes[0].values();
+    if (std::any_of(container_nodes.begin(), container_nodes.end(), [this, divider_key](CollectionItem *node){ return DividerKey(tree_.options.group_by[0], node) == divider_key; })) {
       continue;
     }
 
     // Remove the divider
-    int row = divider_nodes_[divider_key]->row;
+    int row = tree_.divider_nodes[divider_key]->row;
     beginRemoveRows(ItemToIndex(root_), row, row);
     root_->Delete(row);
     endRemoveRows();
-    divider_nodes_.remove(divider_key);
+    tree_.divider_nodes.remove(divider_key);
   }
 
 }
@@ -710,7 +733,7 @@ QVariant CollectionModel::data(const QModelIndex &idx, const int role) const {
   if (use_pretty_covers_) {
     bool is_album_node = false;
     if (role == Qt::DecorationRole && item->type == CollectionItem::Type_Container) {
-      GroupBy container_group_by = group_by_[item->container_level];
+      GroupBy container_group_by = tree_.options.group_by[item->container_level];
       is_album_node = IsAlbumGroupBy(container_group_by);
     }
     if (is_album_node) {
@@ -725,7 +748,7 @@ QVariant CollectionModel::data(const QModelIndex &idx, const int role) const {
 
 QVariant CollectionModel::data(const CollectionItem *item, const int role) const {
 
-  GroupBy container_group_by = item->type == CollectionItem::Type_Container ? group_by_[item->container_level] : GroupBy_None;
+  GroupBy container_group_by = item->type == CollectionItem::Type_Container ? tree_.options.group_by[item->container_level] : GroupBy_None;
 
   switch (role) {
     case Qt::DisplayRole:
@@ -768,7 +791,7 @@ QVariant CollectionModel::data(const CollectionItem *item, const int role) const
       return item->key;
 
     case Role_Artist:
-      return item->metadata.artist();
+      return item->fields ? item->fields->artist : item->metadata.artist();
 
     case Role_Editable:{
       if (!item->lazy_loaded) {
@@ -805,9 +828,9 @@ QVariant CollectionModel::data(const CollectionItem *item, const int role) const
 
 }
 
-bool CollectionModel::HasCompilations(const QSqlDatabase &db, const CollectionQuery &query) {
+bool CollectionModel::HasCompilations(const QSqlDatabase &db, const QueryOptions &query_options, const CollectionQuery &query) {
 
-  CollectionQuery q(db, backend_->songs_table(), backend_->fts_table(), query_options_);
+  CollectionQuery q(db, backend_->songs_table(), backend_->fts_table(), query_options);
 
   q.SetColumnSpec(query.column_spec());
   q.SetOrderBy(query.order_by());
@@ -827,34 +850,84 @@ bool CollectionModel::HasCompilations(const QSqlDatabase &db, const CollectionQu
 
 }
 
-CollectionModel::QueryResult CollectionModel::RunQuery(CollectionItem *parent) {
+CollectionModel::Options CollectionModel::TreeOptions() const {
+
+  Options options = options_;
+  if (IsTopResults(options)) {
+    options.group_by = Grouping(GroupBy_None, GroupBy_None, GroupBy_None);
+    options.show_dividers = false;
+  }
+
+  return options;
+
+}
+
+QString CollectionModel::QueryCacheKey(const Options &options, const CollectionItem *parent) {
+
+  // Container keys include the keys of their parents, so the parent's key identifies the query.
+  return (QStringList() << options.query_options.filter()
+                        << QString::number(options.query_options.query_mode())
+                        << QString::number(options.group_by.first)
+                        << QString::number(options.group_by.second)
+                        << QString::number(options.group_by.third)
+                        << QString::number(options.separate_albums_by_grouping)
+                        << QString::number(options.show_various_artists)
+                        << QString::number(IsTopResults(options))
+                        << QString::number(parent->type)
+                        << parent->key).join(QChar('\n'));
+
+}
+
+void CollectionModel::ClearQueryCache() {
+
+  QMutexLocker l(&query_cache_mutex_);
+  query_cache_.clear();
+  ++query_cache_generation_;
+
+}
+
+CollectionModel::QueryResult CollectionModel::RunQuery(const Options &options, CollectionItem *parent) {
 
   QueryResult result;
 
   // Information about what we want the children to be
-  int child_level = parent == root_ ? 0 : parent->container_level + 1;
-  GroupBy child_group_by = child_level >= 3 ? GroupBy_None : group_by_[child_level];
+  int child_level = parent->type == CollectionItem::Type_Root ? 0 : parent->container_level + 1;
+  GroupBy child_group_by = child_level >= 3 ? GroupBy_None : options.group_by[child_level];
+
+  // The songs matching a maximum age change with time, so those queries are not cached.
+  const bool use_cache = options.query_options.max_age() == -1;
+  const QString cache_key = QueryCacheKey(options, parent);
+  quint64 cache_generation = 0;
+  if (use_cache) {
+    QMutexLocker l(&query_cache_mutex_);
+    if (QueryResult *cached_result = query_cache_.object(cache_key)) {
+      ++query_cache_hits_;
+      return *cached_result;
+    }
+    ++query_cache_misses_;
+    cache_generation = query_cache_generation_;
+  }
 
   // Initialize the query.  child_group_by says what type of thing we want (artists, songs, etc.)
 
   {
-    QMutexLocker l(backend_->db()->Mutex());
-    QSqlDatabase db(backend_->db()->Connect());
+    QMutexLocker l(backend_->db()->ReadMutex());
+    QSqlDatabase db(backend_->db()->ConnectReadOnly());
 
-    CollectionQuery q(db, backend_->songs_table(), backend_->fts_table(), query_options_);
-    InitQuery(child_group_by, separate_albums_by_grouping_, &q);
+    CollectionQuery q(db, backend_->songs_table(), backend_->fts_table(), options.query_options);
+    InitQuery(child_group_by, options.separate_albums_by_grouping, &q);
 
     // Walk up through the item's parents adding filters as necessary
     CollectionItem *p = parent;
     while (p && p->type == CollectionItem::Type_Container) {
-      FilterQuery(group_by_[p->container_level], separate_albums_by_grouping_, p, &q);
+      FilterQuery(options.group_by[p->container_level], options.separate_albums_by_grouping, p, &q);
       p = p->parent;
     }
 
     // Artists GroupBy is special - we don't want compilation albums appearing
     if (IsArtistGroupBy(child_group_by)) {
       // Add the special Various artists node
-      if (show_various_artists_ && HasCompilations(db, q)) {
+      if (options.show_various_artists && HasCompilations(db, options.query_options, q)) {
         result.create_va = true;
       }
 
@@ -862,47 +935,62 @@ CollectionModel::QueryResult CollectionModel::RunQuery(CollectionItem *parent) {
       q.AddCompilationRequirement(false);
     }
 
+    if (IsTopResults(options) && parent->type == CollectionItem::Type_Root) {
+      q.SetOrderByRank(true);
+      q.SetLimit(kTopResultsCount);
+    }
+
     // Execute the query
     if (q.Exec()) {
+      const SqlRow::ColumnsPtr columns = SqlRow::ColumnsFromQuery(q);
       while (q.Next()) {
-        result.rows << SqlRow(q);
+        result.rows << SqlRow(q, columns);
       }
     }
     else {
       backend_->ReportErrors(q);
+      return result;
     }
 
   }
 
-  if (QThread::currentThread() != thread() && QThread::currentThread() != backend_->thread()) {
-    backend_->Close();
+  if (use_cache) {
+    QMutexLocker l(&query_cache_mutex_);
+    if (cache_generation == query_cache_generation_) {
+      query_cache_.insert(cache_key, new QueryResult(result), qMax(1, static_cast<int>(result.rows.count())));
+    }
   }
 
   return result;
 
 }
 
-void CollectionModel::PostQuery(CollectionItem *parent, const CollectionModel::QueryResult &result, const bool signal) {
+void CollectionModel::PostQuery(Tree *tree, CollectionItem *parent, const CollectionModel::QueryResult &result, const bool signal) {
 
   // Information about what we want the children to be
-  int child_level = parent == root_ ? 0 : parent->container_level + 1;
-  GroupBy child_group_by = child_level >= 3 ? GroupBy_None : group_by_[child_level];
+  int child_level = parent->type == CollectionItem::Type_Root ? 0 : parent->container_level + 1;
+  GroupBy child_group_by = child_level >= 3 ? GroupBy_None : tree->options.group_by[child_level];
 
   if (result.create_va && parent->compilation_artist_node_ == nullptr) {
     CreateCompilationArtistNode(signal, parent);
   }
 
+  // Top results are sorted by their rank instead of their title.
+  const bool ranked = IsTopResults(tree->options) && parent->type == CollectionItem::Type_Root;
+  int rank = 0;
+
   // Step through the results
   for (const SqlRow &row : result.rows) {
     // Create the item - it will get inserted into the model here
-    CollectionItem *item = ItemFromQuery(child_group_by, separate_albums_by_grouping_, signal, child_level == 0, parent, row, child_level);
+    CollectionItem *item = ItemFromQuery(tree, child_group_by, signal, child_level == 0, parent, row, child_level);
+    if (ranked) item->sort_text = SortTextForNumber(rank++);
 
     // Save a pointer to it for later
     if (child_group_by == GroupBy_None) {
-      song_nodes_.insert(item->metadata.id(), item);
+      tree->song_nodes.insert(item->metadata.id(), item);
     }
     else {
-      container_nodes_[child_level].insert(item->key, item);
+      tree->container_nodes[child_level].insert(item->key, item);
     }
   }
 
@@ -913,38 +1001,269 @@ void CollectionModel::LazyPopulate(CollectionItem *parent, const bool signal) {
   if (parent->lazy_loaded) return;
   parent->lazy_loaded = true;
 
-  QueryResult result = RunQuery(parent);
-  PostQuery(parent, result, signal);
+  QueryResult result = RunQuery(tree_.options, parent);
+  PostQuery(&tree_, parent, result, signal);
 
 }
 
 void CollectionModel::ResetAsync() {
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-  QFuture<CollectionModel::QueryResult> future = QtConcurrent::run(&CollectionModel::RunQuery, this, root_);
-#else
-  QFuture<CollectionModel::QueryResult> future = QtConcurrent::run(this, &CollectionModel::RunQuery, root_);
-#endif
-  QFutureWatcher<CollectionModel::QueryResult> *watcher = new QFutureWatcher<CollectionModel::QueryResult>();
-  QObject::connect(watcher, &QFutureWatcher<CollectionModel::QueryResult>::finished, this, &CollectionModel::ResetAsyncQueryFinished);
+  // Build the tree with a snapshot of the options, any build still running is discarded when it finishes.
+  const quint64 id = ++build_id_;
+  const Options options = TreeOptions();
+  build_songs_discovered_.clear();
+  build_songs_deleted_.clear();
+  build_songs_changed_.clear();
+
+  // Nothing is shown yet, so songs discovered while the tree is built can be added with the new options straight away.
+  if (std::all_of(root_->children.begin(), root_->children.end(), [](CollectionItem *item) { return item->type == CollectionItem::Type_LoadingIndicator; })) {
+    tree_.options = options;
+  }
+
+  // Containers expanded in the current tree are populated by the build too, so they stay expanded.
+  QSet<QString> loaded_keys;
+  LoadedContainerKeys(root_, &loaded_keys);
+
+  QFuture<BuildResult> future = QtConcurrent::run([this, id, options, loaded_keys]() { return BuildTree(id, options, loaded_keys); });
+  QFutureWatcher<BuildResult> *watcher = new QFutureWatcher<BuildResult>();
+  QObject::connect(watcher, &QFutureWatcher<BuildResult>::finished, this, &CollectionModel::BuildTreeFinished);
   watcher->setFuture(future);
 
 }
 
-void CollectionModel::ResetAsyncQueryFinished() {
+CollectionModel::BuildResult CollectionModel::BuildTree(const quint64 id, const Options &options, const QSet<QString> &loaded_keys) {
 
-  QFutureWatcher<CollectionModel::QueryResult> *watcher = static_cast<QFutureWatcher<CollectionModel::QueryResult>*>(sender());
-  const struct QueryResult result = watcher->result();
-  watcher->deleteLater();
+  BuildResult result;
+  result.id = id;
+  result.root = new CollectionItem(this);
+  result.root->lazy_loaded = true;
+  result.tree.options = options;
+
+  PopulateTree(&result.tree, result.root, loaded_keys);
 
   if (QThread::currentThread() != thread() && QThread::currentThread() != backend_->thread()) {
     backend_->Close();
   }
 
-  BeginReset();
+  return result;
+
+}
+
+void CollectionModel::PopulateTree(Tree *tree, CollectionItem *parent, const QSet<QString> &loaded_keys) {
+
+  QueryResult result = RunQuery(tree->options, parent);
+  PostQuery(tree, parent, result, false);
+
+  for (CollectionItem *child : parent->children) {
+    if (child->type != CollectionItem::Type_Container || child->lazy_loaded || !loaded_keys.contains(child->key)) continue;
+    child->lazy_loaded = true;
+    PopulateTree(tree, child, loaded_keys);
+  }
+
+}
+
+void CollectionModel::LoadedContainerKeys(const CollectionItem *parent, QSet<QString> *keys) {
+
+  for (const CollectionItem *child : parent->children) {
+    if (child->type != CollectionItem::Type_Container || !child->lazy_loaded) continue;
+    keys->insert(child->key);
+    LoadedContainerKeys(child, keys);
+  }
+
+}
+
+void CollectionModel::BuildTreeFinished() {
+
+  QFutureWatcher<BuildResult> *watcher = static_cast<QFutureWatcher<BuildResult>*>(sender());
+  BuildResult result = watcher->result();
+  watcher->deleteLater();
+
+  if (result.id != build_id_) {
+    // The options changed or the model was reset while this tree was built.
+    delete result.root;
+    return;
+  }
+
+  // Merge the new tree into the current one, so only the rows that changed are signalled and expanded items stay expanded.
+  MergeChildren(&result.tree, root_, result.root);
+  delete result.root;
+  tree_ = result.tree;
   root_->lazy_loaded = true;
+  applied_build_id_ = result.id;
+
+  FinishInitTask();
+
+  // Apply the changes made to the collection while the tree was built, the query might not have seen them.
+  const SongList songs_discovered = build_songs_discovered_;
+  const SongList songs_changed = build_songs_changed_;
+  SongList songs_deleted;
+  for (const Song &song : std::as_const(build_songs_deleted_)) {
+    if (tree_.song_nodes.contains(song.id())) songs_deleted << song;
+  }
+  build_songs_discovered_.clear();
+  build_songs_deleted_.clear();
+  build_songs_changed_.clear();
+
+  if (!songs_discovered.isEmpty()) SongsDiscovered(songs_discovered);
+  if (!songs_deleted.isEmpty()) SongsDeleted(songs_deleted);
+  if (!songs_changed.isEmpty()) SongsSlightlyChanged(songs_changed);
+
+  emit TreeBuilt();
+
+}
+
+QString CollectionModel::MergeKey(const CollectionItem *item) {
+
+  switch (item->type) {
+    case CollectionItem::Type_Song:
+      return "s" + QString::number(item->metadata.id());
+    case CollectionItem::Type_Divider:
+      return "d" + item->key;
+    case CollectionItem::Type_Container:
+      return "c" + item->key;
+    default:
+      // Loading indicators are never kept.
+      return QString();
+  }
+
+}
+
+void CollectionModel::MergeChildren(Tree *tree, CollectionItem *parent, CollectionItem *new_parent) {
+
+  QHash<QString, CollectionItem*> new_children;
+  new_children.reserve(new_parent->children.count());
+  for (CollectionItem *new_child : std::as_const(new_parent->children)) {
+    const QString key = MergeKey(new_child);
+    if (!key.isEmpty()) new_children.insert(key, new_child);
+  }
+
+  // Match the current children with the new ones.
+  QHash<CollectionItem*, CollectionItem*> matches;
+  QSet<CollectionItem*> kept;
+  for (CollectionItem *child : std::as_const(parent->children)) {
+    const QString key = MergeKey(child);
+    if (key.isEmpty()) continue;
+    CollectionItem *new_child = new_children.take(key);
+    if (new_child) {
+      matches.insert(new_child, child);
+      kept << child;
+    }
+  }
+
+  // Remove the children that are not in the new tree, in contiguous ranges starting from the end.
+  for (int last = static_cast<int>(parent->children.count()) - 1; last >= 0;) {
+    if (kept.contains(parent->children[last])) {
+      --last;
+      continue;
+    }
+    int first = last;
+    while (first > 0 && !kept.contains(parent->children[first - 1])) --first;
+    RemoveChildren(parent, first, last);
+    last = first - 1;
+  }
+
+  // Update the children that are kept, and move the new children that are not matched over.
+  QList<CollectionItem*> added;
+  for (CollectionItem *new_child : std::as_const(new_parent->children)) {
+    CollectionItem *child = matches.value(new_child);
+    if (!child) {
+      added << new_child;
+      continue;
+    }
+
+    const bool changed = child->display_text != new_child->display_text || child->sort_text != new_child->sort_text || !child->metadata.IsMetadataAndMoreEqual(new_child->metadata);
+    child->display_text = new_child->display_text;
+    child->sort_text = new_child->sort_text;
+    child->metadata = new_child->metadata;
+    if (new_child->fields) child->fields = std::move(new_child->fields);
+    child->container_level = new_child->container_level;
+    child->key = new_child->key;
+    if (changed) {
+      const QModelIndex idx = ItemToIndex(child);
+      emit dataChanged(idx, idx);
+    }
+
+    if (child->lazy_loaded && !new_child->lazy_loaded) {
+      // Loaded in the current tree after the build started, it is populated again when it's expanded.
+      if (!child->children.isEmpty()) RemoveChildren(child, 0, static_cast<int>(child->children.count()) - 1);
+      child->compilation_artist_node_ = nullptr;
+      child->lazy_loaded = false;
+    }
+    else if (new_child->lazy_loaded && child->type != CollectionItem::Type_Song) {
+      child->lazy_loaded = true;
+      MergeChildren(tree, child, new_child);
+    }
+
+    // Point the lookups of the new tree to the item that is kept.
+    if (child->type == CollectionItem::Type_Song) {
+      if (tree->song_nodes.value(child->metadata.id()) == new_child) tree->song_nodes[child->metadata.id()] = child;
+    }
+    else if (child->type == CollectionItem::Type_Divider) {
+      if (tree->divider_nodes.value(child->key) == new_child) tree->divider_nodes[child->key] = child;
+    }
+    else if (child->container_level >= 0 && child->container_level < 3 && tree->container_nodes[child->container_level].value(child->key) == new_child) {
+      tree->container_nodes[child->container_level][child->key] = child;
+    }
+  }
+
+  if (!added.isEmpty()) {
+    const int first = static_cast<int>(parent->children.count());
+    beginInsertRows(ItemToIndex(parent), first, first + static_cast<int>(added.count()) - 1);
+    for (CollectionItem *new_child : std::as_const(added)) {
+      new_child->parent = parent;
+      new_child->row = static_cast<int>(parent->children.count());
+      parent->children << new_child;
+      matches.insert(new_child, new_child);
+    }
+    endInsertRows();
+  }
+
+  parent->compilation_artist_node_ = new_parent->compilation_artist_node_ ? matches.value(new_parent->compilation_artist_node_) : nullptr;
+
+  // The matched new children are empty now, the added ones belong to the current tree.
+  for (CollectionItem *new_child : std::as_const(new_parent->children)) {
+    if (matches.value(new_child) != new_child) {
+      new_child->children.clear();
+      delete new_child;
+    }
+  }
+  new_parent->children.clear();
+
+}
+
+void CollectionModel::RemoveChildren(CollectionItem *parent, const int first, const int last) {
+
+  QSet<CollectionItem*> removed;
+  std::function<void(CollectionItem*)> add_removed = [&removed, &add_removed](CollectionItem *item) {
+    removed << item;
+    for (CollectionItem *child : std::as_const(item->children)) add_removed(child);
+  };
+  for (int i = first; i <= last; ++i) add_removed(parent->children[i]);
+
+  beginRemoveRows(ItemToIndex(parent), first, last);
+  for (int i = last; i >= first; --i) {
+    delete parent->children.takeAt(i);
+  }
+  for (int i = first; i < parent->children.count(); ++i) {
+    parent->children[i]->row = i;
+  }
+  endRemoveRows();
 
-  PostQuery(root_, result, false);
+  if (removed.contains(parent->compilation_artist_node_)) parent->compilation_artist_node_ = nullptr;
+
+  for (QMap<quint64, ItemAndCacheKey>::iterator it = pending_art_.begin(); it != pending_art_.end();) {
+    if (removed.contains(it.value().first)) {
+      pending_cache_keys_.remove(it.value().second);
+      it = pending_art_.erase(it);  // clazy:exclude=strict-iterators
+    }
+    else {
+      ++it;
+    }
+  }
+
+}
+
+void CollectionModel::FinishInitTask() {
 
   if (init_task_id_ != -1) {
     if (app_) {
@@ -953,19 +1272,17 @@ void CollectionModel::ResetAsyncQueryFinished() {
     init_task_id_ = -1;
   }
 
-  endResetModel();
-
 }
 
 void CollectionModel::BeginReset() {
 
   beginResetModel();
   delete root_;
-  song_nodes_.clear();
-  container_nodes_[0].clear();
-  container_nodes_[1].clear();
-  container_nodes_[2].clear();
-  divider_nodes_.clear();
+  tree_.song_nodes.clear();
+  tree_.container_nodes[0].clear();
+  tree_.container_nodes[1].clear();
+  tree_.container_nodes[2].clear();
+  tree_.divider_nodes.clear();
   pending_art_.clear();
   pending_cache_keys_.clear();
 
@@ -977,6 +1294,14 @@ void CollectionModel::BeginReset() {
 
 void CollectionModel::Reset() {
 
+  // A tree still being built in the background is discarded.
+  applied_build_id_ = ++build_id_;
+  build_songs_discovered_.clear();
+  build_songs_deleted_.clear();
+  build_songs_changed_.clear();
+  tree_.options = TreeOptions();
+  ClearQueryCache();
+
   BeginReset();
 
   // Populate top level
@@ -984,6 +1309,8 @@ void CollectionModel::Reset() {
 
   endResetModel();
 
+  FinishInitTask();
+
 }
 
 void CollectionModel::InitQuery(const GroupBy group_by, const bool separate_albums_by_grouping, CollectionQuery *q) {
@@ -1088,7 +1415,7 @@ void CollectionModel::FilterQuery(const GroupBy group_by, const bool separate_al
       else {
         // Don't duplicate compilations outside the Various artists node
         q->AddCompilationRequirement(false);
-        q->AddWhere("effective_albumartist", item->metadata.effective_albumartist());
+        q->AddWhere("effective_albumartist", item->fields->effective_albumartist());
       }
       break;
     case GroupBy_Artist:
@@ -1098,85 +1425,85 @@ void CollectionModel::FilterQuery(const GroupBy group_by, const bool separate_al
       else {
         // Don't duplicate compilations outside the Various artists node
         q->AddCompilationRequirement(false);
-        q->AddWhere("artist", item->metadata.artist());
+        q->AddWhere("artist", item->fields->artist);
       }
       break;
     case GroupBy_Album:
-      q->AddWhere("album", item->metadata.album());
-      q->AddWhere("album_id", item->metadata.album_id());
-      if (separate_albums_by_grouping) q->AddWhere("grouping", item->metadata.grouping());
+      q->AddWhere("album", item->fields->album);
+      q->AddWhere("album_id", item->fields->album_id);
+      if (separate_albums_by_grouping) q->AddWhere("grouping", item->fields->grouping);
       break;
     case GroupBy_AlbumDisc:
-      q->AddWhere("album", item->metadata.album());
-      q->AddWhere("album_id", item->metadata.album_id());
-      q->AddWhere("disc", item->metadata.disc());
-      if (separate_albums_by_grouping) q->AddWhere("grouping", item->metadata.grouping());
+      q->AddWhere("album", item->fields->album);
+      q->AddWhere("album_id", item->fields->album_id);
+      q->AddWhere("disc", item->fields->disc);
+      if (separate_albums_by_grouping) q->AddWhere("grouping", item->fields->grouping);
       break;
     case GroupBy_YearAlbum:
-      q->AddWhere("year", item->metadata.year());
-      q->AddWhere("album", item->metadata.album());
-      q->AddWhere("album_id", item->metadata.album_id());
-      if (separate_albums_by_grouping) q->AddWhere("grouping", item->metadata.grouping());
+      q->AddWhere("year", item->fields->year);
+      q->AddWhere("album", item->fields->album);
+      q->AddWhere("album_id", item->fields->album_id);
+      if (separate_albums_by_grouping) q->AddWhere("grouping", item->fields->grouping);
       break;
     case GroupBy_YearAlbumDisc:
-      q->AddWhere("year", item->metadata.year());
-      q->AddWhere("album", item->metadata.album());
-      q->AddWhere("album_id", item->metadata.album_id());
-      q->AddWhere("disc", item->metadata.disc());
-      if (separate_albums_by_grouping) q->AddWhere("grouping", item->metadata.grouping());
+      q->AddWhere("year", item->fields->year);
+      q->AddWhere("album", item->fields->album);
+      q->AddWhere("album_id", item->fields->album_id);
+      q->AddWhere("disc", item->fields->disc);
+      if (separate_albums_by_grouping) q->AddWhere("grouping", item->fields->grouping);
       break;
     case GroupBy_OriginalYearAlbum:
-      q->AddWhere("year", item->metadata.year());
-      q->AddWhere("originalyear", item->metadata.originalyear());
-      q->AddWhere("album", item->metadata.album());
-      q->AddWhere("album_id", item->metadata.album_id());
-      if (separate_albums_by_grouping) q->AddWhere("grouping", item->metadata.grouping());
+      q->AddWhere("year", item->fields->year);
+      q->AddWhere("originalyear", item->fields->originalyear);
+      q->AddWhere("album", item->fields->album);
+      q->AddWhere("album_id", item->fields->album_id);
+      if (separate_albums_by_grouping) q->AddWhere("grouping", item->fields->grouping);
       break;
     case GroupBy_OriginalYearAlbumDisc:
-      q->AddWhere("year", item->metadata.year());
-      q->AddWhere("originalyear", item->metadata.originalyear());
-      q->AddWhere("album", item->metadata.album());
-      q->AddWhere("album_id", item->metadata.album_id());
-      q->AddWhere("disc", item->metadata.disc());
-      if (separate_albums_by_grouping) q->AddWhere("grouping", item->metadata.grouping());
+      q->AddWhere("year", item->fields->year);
+      q->AddWhere("originalyear", item->fields->originalyear);
+      q->AddWhere("album", item->fields->album);
+      q->AddWhere("album_id", item->fields->album_id);
+      q->AddWhere("disc", item->fields->disc);
+      if (separate_albums_by_grouping) q->AddWhere("grouping", item->fields->grouping);
       break;
     case GroupBy_Disc:
-      q->AddWhere("disc", item->metadata.disc());
+      q->AddWhere("disc", item->fields->disc);
       break;
     case GroupBy_Year:
-      q->AddWhere("year", item->metadata.year());
+      q->AddWhere("year", item->fields->year);
       break;
     case GroupBy_OriginalYear:
-      q->AddWhere("effective_originalyear", item->metadata.effective_originalyear());
+      q->AddWhere("effective_originalyear", item->fields->effective_originalyear());
       break;
     case GroupBy_Genre:
-      q->AddWhere("genre", item->metadata.genre());
+      q->AddWhere("genre", item->fields->genre);
       break;
     case GroupBy_Composer:
-      q->AddWhere("composer", item->metadata.composer());
+      q->AddWhere("composer", item->fields->composer);
       break;
     case GroupBy_Performer:
-      q->AddWhere("performer", item->metadata.performer());
+      q->AddWhere("performer", item->fields->performer);
       break;
     case GroupBy_Grouping:
-      q->AddWhere("grouping", item->metadata.grouping());
+      q->AddWhere("grouping", item->fields->grouping);
       break;
     case GroupBy_FileType:
-      q->AddWhere("filetype", item->metadata.filetype());
+      q->AddWhere("filetype", item->fields->filetype);
       break;
     case GroupBy_Format:
-      q->AddWhere("filetype", item->metadata.filetype());
-      q->AddWhere("samplerate", item->metadata.samplerate());
-      q->AddWhere("bitdepth", item->metadata.bitdepth());
+      q->AddWhere("filetype", item->fields->filetype);
+      q->AddWhere("samplerate", item->fields->samplerate);
+      q->AddWhere("bitdepth", item->fields->bitdepth);
       break;
     case GroupBy_Samplerate:
-      q->AddWhere("samplerate", item->metadata.samplerate());
+      q->AddWhere("samplerate", item->fields->samplerate);
       break;
     case GroupBy_Bitdepth:
-      q->AddWhere("bitdepth", item->metadata.bitdepth());
+      q->AddWhere("bitdepth", item->fields->bitdepth);
       break;
     case GroupBy_Bitrate:
-      q->AddWhere("bitrate", item->metadata.bitrate());
+      q->AddWhere("bitrate", item->fields->bitrate);
       break;
     case GroupBy_None:
     case GroupByCount:
@@ -1201,293 +1528,309 @@ CollectionItem *CollectionModel::InitItem(const GroupBy group_by, const bool sig
 
 }
 
-CollectionItem *CollectionModel::ItemFromQuery(const GroupBy group_by, const bool separate_albums_by_grouping, const bool signal, const bool create_divider, CollectionItem *parent, const SqlRow &row, const int container_level) {
+CollectionItem *CollectionModel::ItemFromQuery(Tree *tree, const GroupBy group_by, const bool signal, const bool create_divider, CollectionItem *parent, const SqlRow &row, const int container_level) {
 
+  const bool separate_albums_by_grouping = tree->options.separate_albums_by_grouping;
   CollectionItem *item = InitItem(group_by, signal, parent, container_level);
+  Song metadata;
 
-  if (parent != root_ && !parent->key.isEmpty()) {
+  if (parent->type != CollectionItem::Type_Root && !parent->key.isEmpty()) {
     item->key = parent->key + "-";
   }
 
   switch (group_by) {
     case GroupBy_AlbumArtist:{
-      item->metadata.set_albumartist(row.value(0).toString());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      item->display_text = TextOrUnknown(item->metadata.albumartist());
-      item->sort_text = SortTextForArtist(item->metadata.albumartist());
+      metadata.set_albumartist(row.value(0).toString());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      item->display_text = TextOrUnknown(metadata.albumartist());
+      item->sort_text = SortTextForArtist(metadata.albumartist());
       break;
     }
     case GroupBy_Artist:{
-      item->metadata.set_artist(row.value(0).toString());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      item->display_text = TextOrUnknown(item->metadata.artist());
-      item->sort_text = SortTextForArtist(item->metadata.artist());
+      metadata.set_artist(row.value(0).toString());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      item->display_text = TextOrUnknown(metadata.artist());
+      item->sort_text = SortTextForArtist(metadata.artist());
       break;
     }
     case GroupBy_Album:{
-      item->metadata.set_album(row.value(0).toString());
-      item->metadata.set_album_id(row.value(1).toString());
-      item->metadata.set_grouping(row.value(2).toString());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      item->display_text = TextOrUnknown(item->metadata.album());
-      item->sort_text = SortTextForArtist(item->metadata.album());
+      metadata.set_album(row.value(0).toString());
+      metadata.set_album_id(row.value(1).toString());
+      metadata.set_grouping(row.value(2).toString());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      item->display_text = TextOrUnknown(metadata.album());
+      item->sort_text = SortTextForArtist(metadata.album());
       break;
     }
     case GroupBy_AlbumDisc:{
-      item->metadata.set_album(row.value(0).toString());
-      item->metadata.set_album_id(row.value(1).toString());
-      item->metadata.set_disc(row.value(2).toInt());
-      item->metadata.set_grouping(row.value(3).toString());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      item->display_text = PrettyAlbumDisc(item->metadata.album(), item->metadata.disc());
-      item->sort_text = item->metadata.album() + SortTextForNumber(qMax(0, item->metadata.disc()));
+      metadata.set_album(row.value(0).toString());
+      metadata.set_album_id(row.value(1).toString());
+      metadata.set_disc(row.value(2).toInt());
+      metadata.set_grouping(row.value(3).toString());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      item->display_text = PrettyAlbumDisc(metadata.album(), metadata.disc());
+      item->sort_text = metadata.album() + SortTextForNumber(qMax(0, metadata.disc()));
       break;
     }
     case GroupBy_YearAlbum:{
-      item->metadata.set_year(row.value(0).toInt());
-      item->metadata.set_album(row.value(1).toString());
-      item->metadata.set_album_id(row.value(2).toString());
-      item->metadata.set_grouping(row.value(3).toString());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      item->display_text = PrettyYearAlbum(item->metadata.year(), item->metadata.album());
-      item->sort_text = SortTextForNumber(qMax(0, item->metadata.year())) + item->metadata.grouping() + item->metadata.album();
+      metadata.set_year(row.value(0).toInt());
+      metadata.set_album(row.value(1).toString());
+      metadata.set_album_id(row.value(2).toString());
+      metadata.set_grouping(row.value(3).toString());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      item->display_text = PrettyYearAlbum(metadata.year(), metadata.album());
+      item->sort_text = SortTextForNumber(qMax(0, metadata.year())) + metadata.grouping() + metadata.album();
       break;
     }
     case GroupBy_YearAlbumDisc:{
-      item->metadata.set_year(row.value(0).toInt());
-      item->metadata.set_album(row.value(1).toString());
-      item->metadata.set_album_id(row.value(2).toString());
-      item->metadata.set_disc(row.value(3).toInt());
-      item->metadata.set_grouping(row.value(4).toString());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      item->display_text = PrettyYearAlbumDisc(item->metadata.year(), item->metadata.album(), item->metadata.disc());
-      item->sort_text = SortTextForNumber(qMax(0, item->metadata.year())) + item->metadata.album() + SortTextForNumber(qMax(0, item->metadata.disc()));
+      metadata.set_year(row.value(0).toInt());
+      metadata.set_album(row.value(1).toString());
+      metadata.set_album_id(row.value(2).toString());
+      metadata.set_disc(row.value(3).toInt());
+      metadata.set_grouping(row.value(4).toString());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      item->display_text = PrettyYearAlbumDisc(metadata.year(), metadata.album(), metadata.disc());
+      item->sort_text = SortTextForNumber(qMax(0, metadata.year())) + metadata.album() + SortTextForNumber(qMax(0, metadata.disc()));
       break;
     }
     case GroupBy_OriginalYearAlbum:{
-      item->metadata.set_year(row.value(0).toInt());
-      item->metadata.set_originalyear(row.value(1).toInt());
-      item->metadata.set_album(row.value(2).toString());
-      item->metadata.set_album_id(row.value(3).toString());
-      item->metadata.set_grouping(row.value(4).toString());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      item->display_text = PrettyYearAlbum(item->metadata.effective_originalyear(), item->metadata.album());
-      item->sort_text = SortTextForNumber(qMax(0, item->metadata.effective_originalyear())) + item->metadata.grouping() + item->metadata.album();
+      metadata.set_year(row.value(0).toInt());
+      metadata.set_originalyear(row.value(1).toInt());
+      metadata.set_album(row.value(2).toString());
+      metadata.set_album_id(row.value(3).toString());
+      metadata.set_grouping(row.value(4).toString());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      item->display_text = PrettyYearAlbum(metadata.effective_originalyear(), metadata.album());
+      item->sort_text = SortTextForNumber(qMax(0, metadata.effective_originalyear())) + metadata.grouping() + metadata.album();
       break;
     }
     case GroupBy_OriginalYearAlbumDisc:{
-      item->metadata.set_year(row.value(0).toInt());
-      item->metadata.set_originalyear(row.value(1).toInt());
-      item->metadata.set_album(row.value(2).toString());
-      item->metadata.set_album_id(row.value(3).toString());
-      item->metadata.set_disc(row.value(4).toInt());
-      item->metadata.set_grouping(row.value(5).toString());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      item->display_text = PrettyYearAlbumDisc(item->metadata.effective_originalyear(), item->metadata.album(), item->metadata.disc());
-      item->sort_text = SortTextForNumber(qMax(0, item->metadata.effective_originalyear())) + item->metadata.album() + SortTextForNumber(qMax(0, item->metadata.disc()));
+      metadata.set_year(row.value(0).toInt());
+      metadata.set_originalyear(row.value(1).toInt());
+      metadata.set_album(row.value(2).toString());
+      metadata.set_album_id(row.value(3).toString());
+      metadata.set_disc(row.value(4).toInt());
+      metadata.set_grouping(row.value(5).toString());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      item->display_text = PrettyYearAlbumDisc(metadata.effective_originalyear(), metadata.album(), metadata.disc());
+      item->sort_text = SortTextForNumber(qMax(0, metadata.effective_originalyear())) + metadata.album() + SortTextForNumber(qMax(0, metadata.disc()));
       break;
     }
     case GroupBy_Disc:{
-      item->metadata.set_disc(row.value(0).toInt());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
+      metadata.set_disc(row.value(0).toInt());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
       const int disc = qMax(0, row.value(0).toInt());
       item->display_text = PrettyDisc(disc);
       item->sort_text = SortTextForNumber(disc);
       break;
     }
     case GroupBy_Year:{
-      item->metadata.set_year(row.value(0).toInt());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      const int year = qMax(0, item->metadata.year());
+      metadata.set_year(row.value(0).toInt());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      const int year = qMax(0, metadata.year());
       item->display_text = QString::number(year);
       item->sort_text = SortTextForNumber(year) + " ";
       break;
     }
     case GroupBy_OriginalYear:{
-      item->metadata.set_originalyear(row.value(0).toInt());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      const int year = qMax(0, item->metadata.originalyear());
+      metadata.set_originalyear(row.value(0).toInt());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      const int year = qMax(0, metadata.originalyear());
       item->display_text = QString::number(year);
       item->sort_text = SortTextForNumber(year) + " ";
       break;
     }
     case GroupBy_Genre:{
-      item->metadata.set_genre(row.value(0).toString());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      item->display_text = TextOrUnknown(item->metadata.genre());
-      item->sort_text = SortTextForArtist(item->metadata.genre());
+      metadata.set_genre(row.value(0).toString());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      item->display_text = TextOrUnknown(metadata.genre());
+      item->sort_text = SortTextForArtist(metadata.genre());
       break;
     }
     case GroupBy_Composer:{
-      item->metadata.set_composer(row.value(0).toString());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      item->display_text = TextOrUnknown(item->metadata.composer());
-      item->sort_text = SortTextForArtist(item->metadata.composer());
+      metadata.set_composer(row.value(0).toString());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      item->display_text = TextOrUnknown(metadata.composer());
+      item->sort_text = SortTextForArtist(metadata.composer());
       break;
     }
     case GroupBy_Performer:{
-      item->metadata.set_performer(row.value(0).toString());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      item->display_text = TextOrUnknown(item->metadata.performer());
-      item->sort_text = SortTextForArtist(item->metadata.performer());
+      metadata.set_performer(row.value(0).toString());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      item->display_text = TextOrUnknown(metadata.performer());
+      item->sort_text = SortTextForArtist(metadata.performer());
       break;
     }
     case GroupBy_Grouping:{
-      item->metadata.set_grouping(row.value(0).toString());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      item->display_text = TextOrUnknown(item->metadata.grouping());
-      item->sort_text = SortTextForArtist(item->metadata.grouping());
+      metadata.set_grouping(row.value(0).toString());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      item->display_text = TextOrUnknown(metadata.grouping());
+      item->sort_text = SortTextForArtist(metadata.grouping());
       break;
     }
     case GroupBy_FileType:{
-      item->metadata.set_filetype(static_cast<Song::FileType>(row.value(0).toInt()));
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      item->display_text = item->metadata.TextForFiletype();
-      item->sort_text = item->metadata.TextForFiletype();
+      metadata.set_filetype(static_cast<Song::FileType>(row.value(0).toInt()));
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      item->display_text = metadata.TextForFiletype();
+      item->sort_text = metadata.TextForFiletype();
       break;
     }
     case GroupBy_Format:{
-      item->metadata.set_filetype(static_cast<Song::FileType>(row.value(0).toInt()));
-      item->metadata.set_samplerate(row.value(1).toInt());
-      item->metadata.set_bitdepth(row.value(2).toInt());
-      QString key = ContainerKey(group_by, separate_albums_by_grouping, item->metadata);
+      metadata.set_filetype(static_cast<Song::FileType>(row.value(0).toInt()));
+      metadata.set_samplerate(row.value(1).toInt());
+      metadata.set_bitdepth(row.value(2).toInt());
+      QString key = ContainerKey(group_by, separate_albums_by_grouping, metadata);
       item->key.append(key);
       item->display_text = key;
       item->sort_text = key;
       break;
     }
     case GroupBy_Samplerate:{
-      item->metadata.set_samplerate(row.value(0).toInt());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      const int samplerate = qMax(0, item->metadata.samplerate());
+      metadata.set_samplerate(row.value(0).toInt());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      const int samplerate = qMax(0, metadata.samplerate());
       item->display_text = QString::number(samplerate);
       item->sort_text = SortTextForNumber(samplerate) + " ";
       break;
     }
     case GroupBy_Bitdepth:{
-      item->metadata.set_bitdepth(row.value(0).toInt());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      const int bitdepth = qMax(0, item->metadata.bitdepth());
+      metadata.set_bitdepth(row.value(0).toInt());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      const int bitdepth = qMax(0, metadata.bitdepth());
       item->display_text = QString::number(bitdepth);
       item->sort_text = SortTextForNumber(bitdepth) + " ";
       break;
     }
     case GroupBy_Bitrate:{
-      item->metadata.set_bitrate(row.value(0).toInt());
-      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, item->metadata));
-      const int bitrate = qMax(0, item->metadata.bitrate());
+      metadata.set_bitrate(row.value(0).toInt());
+      item->key.append(ContainerKey(group_by, separate_albums_by_grouping, metadata));
+      const int bitrate = qMax(0, metadata.bitrate());
       item->display_text = QString::number(bitrate);
       item->sort_text = SortTextForNumber(bitrate) + " ";
       break;
     }
     case GroupBy_None:
     case GroupByCount:
-      item->metadata.InitFromQuery(row, true);
-      item->key.append(TextOrUnknown(item->metadata.title()));
-      item->display_text = item->metadata.TitleWithCompilationArtist();
-      if (item->container_level == 1 && !IsAlbumGroupBy(group_by_[0])) {
-        item->sort_text = SortText(item->metadata.title());
+      // Songs in the song cache are shared with the playlists instead of read again.
+      if (!backend_->song_cache()->GetSongById(row.value(0).toInt(), &metadata) || !metadata.is_valid()) {
+        metadata = Song();
+        metadata.InitFromQuery(row, true, 0);
+      }
+      item->key.append(TextOrUnknown(metadata.title()));
+      item->display_text = metadata.TitleWithCompilationArtist();
+      if (item->container_level == 1 && !IsAlbumGroupBy(tree->options.group_by[0])) {
+        item->sort_text = SortText(metadata.title());
       }
       else {
-        item->sort_text = SortTextForSong(item->metadata);
+        item->sort_text = SortTextForSong(metadata);
       }
       break;
   }
 
-  FinishItem(group_by, signal, create_divider, parent, item);
+  // Containers only keep the fields they filter their songs on.
+  if (item->type == CollectionItem::Type_Container) {
+    item->fields = std::make_unique<CollectionItem::ContainerFields>(metadata);
+  }
+  else {
+    item->metadata = metadata;
+  }
+
+  FinishItem(tree, group_by, signal, create_divider, parent, item);
 
   return item;
 
 }
 
-CollectionItem *CollectionModel::ItemFromSong(const GroupBy group_by, const bool separate_albums_by_grouping, const bool signal, const bool create_divider, CollectionItem *parent, const Song &s, const int container_level) {
+CollectionItem *CollectionModel::ItemFromSong(Tree *tree, const GroupBy group_by, const bool signal, const bool create_divider, CollectionItem *parent, const Song &s, const int container_level) {
 
+  const bool separate_albums_by_grouping = tree->options.separate_albums_by_grouping;
   CollectionItem *item = InitItem(group_by, signal, parent, container_level);
+  Song metadata;
 
-  if (parent != root_ && !parent->key.isEmpty()) {
+  if (parent->type != CollectionItem::Type_Root && !parent->key.isEmpty()) {
     item->key = parent->key + "-";
   }
 
   switch (group_by) {
     case GroupBy_AlbumArtist:{
-      item->metadata.set_albumartist(s.effective_albumartist());
+      metadata.set_albumartist(s.effective_albumartist());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       item->display_text = TextOrUnknown(s.effective_albumartist());
       item->sort_text = SortTextForArtist(s.effective_albumartist());
       break;
     }
     case GroupBy_Artist:{
-      item->metadata.set_artist(s.artist());
+      metadata.set_artist(s.artist());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       item->display_text = TextOrUnknown(s.artist());
       item->sort_text = SortTextForArtist(s.artist());
       break;
     }
     case GroupBy_Album:{
-      item->metadata.set_album(s.album());
-      item->metadata.set_album_id(s.album_id());
-      item->metadata.set_grouping(s.grouping());
+      metadata.set_album(s.album());
+      metadata.set_album_id(s.album_id());
+      metadata.set_grouping(s.grouping());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       item->display_text = TextOrUnknown(s.album());
       item->sort_text = SortTextForArtist(s.album());
       break;
     }
     case GroupBy_AlbumDisc:{
-      item->metadata.set_album(s.album());
-      item->metadata.set_album_id(s.album_id());
-      item->metadata.set_disc(s.disc());
-      item->metadata.set_grouping(s.grouping());
+      metadata.set_album(s.album());
+      metadata.set_album_id(s.album_id());
+      metadata.set_disc(s.disc());
+      metadata.set_grouping(s.grouping());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       item->display_text = PrettyAlbumDisc(s.album(), s.disc());
       item->sort_text = s.album() + SortTextForNumber(qMax(0, s.disc()));
       break;
     }
     case GroupBy_YearAlbum:{
-      item->metadata.set_year(s.year());
-      item->metadata.set_album(s.album());
-      item->metadata.set_album_id(s.album_id());
-      item->metadata.set_grouping(s.grouping());
+      metadata.set_year(s.year());
+      metadata.set_album(s.album());
+      metadata.set_album_id(s.album_id());
+      metadata.set_grouping(s.grouping());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       item->display_text = PrettyYearAlbum(s.year(), s.album());
       item->sort_text = SortTextForNumber(qMax(0, s.year())) + s.grouping() + s.album();
       break;
     }
     case GroupBy_YearAlbumDisc:{
-      item->metadata.set_year(s.year());
-      item->metadata.set_album(s.album());
-      item->metadata.set_album_id(s.album_id());
-      item->metadata.set_disc(s.disc());
-      item->metadata.set_grouping(s.grouping());
+      metadata.set_year(s.year());
+      metadata.set_album(s.album());
+      metadata.set_album_id(s.album_id());
+      metadata.set_disc(s.disc());
+      metadata.set_grouping(s.grouping());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       item->display_text = PrettyYearAlbumDisc(s.year(), s.album(), s.disc());
       item->sort_text = SortTextForNumber(qMax(0, s.year())) + s.album() + SortTextForNumber(qMax(0, s.disc()));
       break;
     }
     case GroupBy_OriginalYearAlbum:{
-      item->metadata.set_year(s.year());
-      item->metadata.set_originalyear(s.originalyear());
-      item->metadata.set_album(s.album());
-      item->metadata.set_album_id(s.album_id());
-      item->metadata.set_grouping(s.grouping());
+      metadata.set_year(s.year());
+      metadata.set_originalyear(s.originalyear());
+      metadata.set_album(s.album());
+      metadata.set_album_id(s.album_id());
+      metadata.set_grouping(s.grouping());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       item->display_text = PrettyYearAlbum(s.effective_originalyear(), s.album());
       item->sort_text = SortTextForNumber(qMax(0, s.effective_originalyear())) + s.grouping() + s.album();
       break;
     }
     case GroupBy_OriginalYearAlbumDisc:{
-      item->metadata.set_year(s.year());
-      item->metadata.set_originalyear(s.originalyear());
-      item->metadata.set_album(s.album());
-      item->metadata.set_album_id(s.album_id());
-      item->metadata.set_disc(s.disc());
-      item->metadata.set_grouping(s.grouping());
+      metadata.set_year(s.year());
+      metadata.set_originalyear(s.originalyear());
+      metadata.set_album(s.album());
+      metadata.set_album_id(s.album_id());
+      metadata.set_disc(s.disc());
+      metadata.set_grouping(s.grouping());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       item->display_text = PrettyYearAlbumDisc(s.effective_originalyear(), s.album(), s.disc());
       item->sort_text = SortTextForNumber(qMax(0, s.effective_originalyear())) + s.album() + SortTextForNumber(qMax(0, s.disc()));
       break;
     }
     case GroupBy_Disc:{
-      item->metadata.set_disc(s.disc());
+      metadata.set_disc(s.disc());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       const int disc = qMax(0, s.disc());
       item->display_text = PrettyDisc(disc);
@@ -1495,7 +1838,7 @@ CollectionItem *CollectionModel::ItemFromSong(const GroupBy group_by, const bool
       break;
     }
     case GroupBy_Year:{
-      item->metadata.set_year(s.year());
+      metadata.set_year(s.year());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       const int year = qMax(0, s.year());
       item->display_text = QString::number(year);
@@ -1503,7 +1846,7 @@ CollectionItem *CollectionModel::ItemFromSong(const GroupBy group_by, const bool
       break;
     }
     case GroupBy_OriginalYear:{
-      item->metadata.set_originalyear(s.effective_originalyear());
+      metadata.set_originalyear(s.effective_originalyear());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       const int year = qMax(0, s.effective_originalyear());
       item->display_text = QString::number(year);
@@ -1511,44 +1854,44 @@ CollectionItem *CollectionModel::ItemFromSong(const GroupBy group_by, const bool
       break;
     }
     case GroupBy_Genre:{
-      item->metadata.set_genre(s.genre());
+      metadata.set_genre(s.genre());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       item->display_text = TextOrUnknown(s.genre());
       item->sort_text = SortTextForArtist(s.genre());
       break;
     }
     case GroupBy_Composer:{
-      item->metadata.set_composer(s.composer());
+      metadata.set_composer(s.composer());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       item->display_text = TextOrUnknown(s.composer());
       item->sort_text = SortTextForArtist(s.composer());
       break;
     }
     case GroupBy_Performer:{
-      item->metadata.set_performer(s.performer());
+      metadata.set_performer(s.performer());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       item->display_text = TextOrUnknown(s.performer());
       item->sort_text = SortTextForArtist(s.performer());
       break;
     }
     case GroupBy_Grouping:{
-      item->metadata.set_grouping(s.grouping());
+      metadata.set_grouping(s.grouping());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       item->display_text = TextOrUnknown(s.grouping());
       item->sort_text = SortTextForArtist(s.grouping());
       break;
     }
     case GroupBy_FileType:{
-      item->metadata.set_filetype(s.filetype());
+      metadata.set_filetype(s.filetype());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       item->display_text = s.TextForFiletype();
       item->sort_text = s.TextForFiletype();
       break;
     }
     case GroupBy_Format:{
-      item->metadata.set_filetype(s.filetype());
-      item->metadata.set_samplerate(s.samplerate());
-      item->metadata.set_bitdepth(s.bitdepth());
+      metadata.set_filetype(s.filetype());
+      metadata.set_samplerate(s.samplerate());
+      metadata.set_bitdepth(s.bitdepth());
       QString key = ContainerKey(group_by, separate_albums_by_grouping, s);
       item->key.append(key);
       item->display_text = key;
@@ -1556,7 +1899,7 @@ CollectionItem *CollectionModel::ItemFromSong(const GroupBy group_by, const bool
       break;
     }
     case GroupBy_Samplerate:{
-      item->metadata.set_samplerate(s.samplerate());
+      metadata.set_samplerate(s.samplerate());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       const int samplerate = qMax(0, s.samplerate());
       item->display_text = QString::number(samplerate);
@@ -1564,7 +1907,7 @@ CollectionItem *CollectionModel::ItemFromSong(const GroupBy group_by, const bool
       break;
     }
     case GroupBy_Bitdepth:{
-      item->metadata.set_bitdepth(s.bitdepth());
+      metadata.set_bitdepth(s.bitdepth());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       const int bitdepth = qMax(0, s.bitdepth());
       item->display_text = QString::number(bitdepth);
@@ -1572,7 +1915,7 @@ CollectionItem *CollectionModel::ItemFromSong(const GroupBy group_by, const bool
       break;
     }
     case GroupBy_Bitrate:{
-      item->metadata.set_bitrate(s.bitrate());
+      metadata.set_bitrate(s.bitrate());
       item->key.append(ContainerKey(group_by, separate_albums_by_grouping, s));
       const int bitrate = qMax(0, s.bitrate());
       item->display_text = QString::number(bitrate);
@@ -1581,10 +1924,10 @@ CollectionItem *CollectionModel::ItemFromSong(const GroupBy group_by, const bool
     }
     case GroupBy_None:
     case GroupByCount:{
-      item->metadata = s;
+      metadata = s;
       item->key.append(TextOrUnknown(s.title()));
       item->display_text = s.TitleWithCompilationArtist();
-      if (item->container_level == 1 && !IsAlbumGroupBy(group_by_[0])) {
+      if (item->container_level == 1 && !IsAlbumGroupBy(tree->options.group_by[0])) {
         item->sort_text = SortText(s.title());
       }
       else {
@@ -1594,14 +1937,22 @@ CollectionItem *CollectionModel::ItemFromSong(const GroupBy group_by, const bool
     }
   }
 
-  FinishItem(group_by, signal, create_divider, parent, item);
+  // Containers only keep the fields they filter their songs on.
+  if (item->type == CollectionItem::Type_Container) {
+    item->fields = std::make_unique<CollectionItem::ContainerFields>(metadata);
+  }
+  else {
+    item->metadata = metadata;
+  }
+
+  FinishItem(tree, group_by, signal, create_divider, parent, item);
   if (s.url().scheme() == "cdda") item->lazy_loaded = true;
 
   return item;
 
 }
 
-void CollectionModel::FinishItem(const GroupBy group_by, const bool signal, const bool create_divider, CollectionItem *parent, CollectionItem *item) {
+void CollectionModel::FinishItem(Tree *tree, const GroupBy group_by, const bool signal, const bool create_divider, CollectionItem *parent, CollectionItem *item) {
 
   if (group_by == GroupBy_None) item->lazy_loaded = true;
 
@@ -1610,24 +1961,25 @@ void CollectionModel::FinishItem(const GroupBy group_by, const bool signal, cons
   }
 
   // Create the divider entry if we're supposed to
-  if (create_divider && show_dividers_) {
+  if (create_divider && tree->options.show_dividers) {
     QString divider_key = DividerKey(group_by, item);
     if (!divider_key.isEmpty()) {
       item->sort_text.prepend(divider_key + " ");
     }
 
-    if (!divider_key.isEmpty() && !divider_nodes_.contains(divider_key)) {
+    if (!divider_key.isEmpty() && !tree->divider_nodes.contains(divider_key)) {
       if (signal) {
         beginInsertRows(ItemToIndex(parent), static_cast<int>(parent->children.count()), static_cast<int>(parent->children.count()));
       }
 
-      CollectionItem *divider = new CollectionItem(CollectionItem::Type_Divider, root_);
+      // Dividers are only created for the top level, so the parent is the root.
+      CollectionItem *divider = new CollectionItem(CollectionItem::Type_Divider, parent);
       divider->key = divider_key;
       divider->display_text = DividerDisplayText(group_by, divider_key);
       divider->sort_text = divider_key + "  ";
       divider->lazy_loaded = true;
 
-      divider_nodes_[divider_key] = divider;
+      tree->divider_nodes[divider_key] = divider;
 
       if (signal) {
         endInsertRows();
@@ -1852,22 +2204,31 @@ SongList CollectionModel::GetChildSongs(const QModelIndex &idx) const {
 }
 
 void CollectionModel::SetFilterAge(const int age) {
-  query_options_.set_max_age(age);
+  options_.query_options.set_max_age(age);
   ResetAsync();
 }
 
 void CollectionModel::SetFilterText(const QString &text) {
-  query_options_.set_filter(text);
+  options_.query_options.set_filter(text);
   ResetAsync();
 
 }
 
 void CollectionModel::SetFilterQueryMode(QueryOptions::QueryMode query_mode) {
-  query_options_.set_query_mode(query_mode);
+  options_.query_options.set_query_mode(query_mode);
   ResetAsync();
 
 }
 
+void CollectionModel::SetFilterTopResults(const bool top_results) {
+
+  if (top_results == options_.top_results) return;
+
+  options_.top_results = top_results;
+  if (!options_.query_options.filter().isEmpty()) ResetAsync();
+
+}
+
 bool CollectionModel::canFetchMore(const QModelIndex &parent) const {
 
   if (!parent.isValid()) return false;
@@ -1879,13 +2240,13 @@ bool CollectionModel::canFetchMore(const QModelIndex &parent) const {
 
 void CollectionModel::SetGroupBy(const Grouping g, const std::optional<bool> separate_albums_by_grouping) {
 
-  group_by_ = g;
+  options_.group_by = g;
   if (separate_albums_by_grouping) {
-    separate_albums_by_grouping_ = separate_albums_by_grouping.value();
+    options_.separate_albums_by_grouping = separate_albums_by_grouping.value();
   }
 
   ResetAsync();
-  emit GroupingChanged(g, separate_albums_by_grouping_);
+  emit GroupingChanged(g, options_.separate_albums_by_grouping);
 
 }
 
@@ -25,11 +25,14 @@
 #include "config.h"
 
 #include <optional>
+#include <atomic>
 
 #include <QtGlobal>
 #include <QObject>
 #include <QAbstractItemModel>
 #include <QFuture>
+#include <QMutex>
+#include <QCache>
 #include <QDataStream>
 #include <QMetaType>
 #include <QPair>
@@ -68,6 +71,10 @@ class CollectionModel : public SimpleTreeModel<CollectionItem> {
 
   static const int kPrettyCoverSize;
   static const char *kPixmapDiskCacheDir;
+  // Maximum number of songs shown in top results mode.
+  static const int kTopResultsCount;
+  // Maximum number of rows kept in the query cache.
+  static const int kQueryCacheRows;
 
   enum Role {
     Role_Type = Qt::UserRole + 1,
@@ -130,11 +137,24 @@ class CollectionModel : public SimpleTreeModel<CollectionItem> {
     bool create_va;
   };
 
+  // The options the items are built with.
+  struct Options {
+    Options() : separate_albums_by_grouping(false), show_dividers(true), show_various_artists(true), top_results(false) {}
+
+    Grouping group_by;
+    bool separate_albums_by_grouping;
+    bool show_dividers;
+    bool show_various_artists;
+    // Show the songs best matching the filter text as a flat list, ranked by relevance, instead of grouping them.
+    bool top_results;
+    QueryOptions query_options;
+  };
+
   CollectionBackend *backend() const { return backend_; }
   CollectionDirectoryModel *directory_model() const { return dir_model_; }
 
   // Call before Init()
-  void set_show_various_artists(const bool show_various_artists) { show_various_artists_ = show_various_artists; }
+  void set_show_various_artists(const bool show_various_artists) { options_.show_various_artists = show_various_artists; tree_.options = TreeOptions(); }
 
   // Get information about the collection
   void GetChildSongs(CollectionItem *item, QList<QUrl> *urls, SongList *songs, QSet<int> *song_ids) const;
@@ -185,13 +205,22 @@ class CollectionModel : public SimpleTreeModel<CollectionItem> {
 
   void set_use_lazy_loading(const bool value) { use_lazy_loading_ = value; }
 
-  QMap<QString, CollectionItem*> container_nodes(const int i) { return container_nodes_[i]; }
-  QList<CollectionItem*> song_nodes() const { return song_nodes_.values(); }
-  int divider_nodes_count() const { return divider_nodes_.count(); }
+  QMap<QString, CollectionItem*> container_nodes(const int i) { return tree_.container_nodes[i]; }
+  QList<CollectionItem*> song_nodes() const { return tree_.song_nodes.values(); }
+  int divider_nodes_count() const { return tree_.divider_nodes.count(); }
 
   void ExpandAll(CollectionItem *item = nullptr) const;
 
-  const CollectionModel::Grouping GetGroupBy() const { return group_by_; }
+  // Returns true while a new tree is built in the background.
+  bool is_building() const { return build_id_ != applied_build_id_; }
+
+  bool filter_top_results() const { return options_.top_results; }
+
+  // Query cache statistics, for tests and benchmarks.
+  int query_cache_hits() const { return query_cache_hits_; }
+  int query_cache_misses() const { return query_cache_misses_; }
+
+  const CollectionModel::Grouping GetGroupBy() const { return options_.group_by; }
   void SetGroupBy(const CollectionModel::Grouping g, const std::optional<bool> separate_albums_by_grouping = std::optional<bool>());
 
   static QString ContainerKey(const GroupBy group_by, const bool separate_albums_by_grouping, const Song &song);
@@ -201,11 +230,13 @@ class CollectionModel : public SimpleTreeModel<CollectionItem> {
   void TotalArtistCountUpdated(int count);
   void TotalAlbumCountUpdated(int count);
   void GroupingChanged(CollectionModel::Grouping g, bool separate_albums_by_grouping);
+  void TreeBuilt();
 
  public slots:
   void SetFilterAge(const int age);
   void SetFilterText(const QString &text);
   void SetFilterQueryMode(QueryOptions::QueryMode query_mode);
+  void SetFilterTopResults(const bool top_results);
 
   void Init(const bool async = true);
   void Reset();
@@ -227,17 +258,60 @@ class CollectionModel : public SimpleTreeModel<CollectionItem> {
   static void ClearDiskCache();
 
   // Called after ResetAsync
-  void ResetAsyncQueryFinished();
+  void BuildTreeFinished();
 
   void AlbumCoverLoaded(const quint64 id, const AlbumCoverLoaderResult &result);
 
  private:
+  // Lookup maps for the items of a tree, and the options the tree was built with.
+  struct Tree {
+    Options options;
+
+    // Keyed on database ID
+    QMap<int, CollectionItem*> song_nodes;
+
+    // Keyed on whatever the key is for that level - artist, album, year, etc.
+    QMap<QString, CollectionItem*> container_nodes[3];
+
+    // Keyed on a letter, a year, a century, etc.
+    QMap<QString, CollectionItem*> divider_nodes;
+  };
+
+  // A tree built on a worker thread by ResetAsync, it is merged into the model's items when it is done.
+  struct BuildResult {
+    BuildResult() : id(0), root(nullptr) {}
+
+    quint64 id;
+    CollectionItem *root;
+    Tree tree;
+  };
+
+  // The options the tree is built with, the grouping is replaced by a flat list in top results mode.
+  Options TreeOptions() const;
+  static bool IsTopResults(const Options &options) { return options.top_results && !options.query_options.filter().isEmpty(); }
+
   // Provides some optimisations for loading the list of items in the root.
   // This gets called a lot when filtering the playlist, so it's nice to be able to do it in a background thread.
-  QueryResult RunQuery(CollectionItem *parent);
-  void PostQuery(CollectionItem *parent, const QueryResult &result, const bool signal);
-
-  bool HasCompilations(const QSqlDatabase &db, const CollectionQuery &query);
+  // The results are cached, so going back to a previous filter text doesn't query the database again.
+  QueryResult RunQuery(const Options &options, CollectionItem *parent);
+  static QString QueryCacheKey(const Options &options, const CollectionItem *parent);
+  void ClearQueryCache();
+  void PostQuery(Tree *tree, CollectionItem *parent, const QueryResult &result, const bool signal);
+
+  bool HasCompilations(const QSqlDatabase &db, const QueryOptions &query_options, const CollectionQuery &query);
+
+  // Builds a tree with the options, populating the containers with keys in loaded_keys like the model's items.
+  // The items are not added to the model, so this runs on a worker thread.
+  BuildResult BuildTree(const quint64 id, const Options &options, const QSet<QString> &loaded_keys);
+  void PopulateTree(Tree *tree, CollectionItem *parent, const QSet<QString> &loaded_keys);
+  static void LoadedContainerKeys(const CollectionItem *parent, QSet<QString> *keys);
+
+  // Merges the children of new_parent into the model's item parent with the fewest row insertions and removals.
+  // Matching items are kept, so views keep their expanded state. The tree's maps are updated to point to the model's items.
+  void MergeChildren(Tree *tree, CollectionItem *parent, CollectionItem *new_parent);
+  void RemoveChildren(CollectionItem *parent, const int first, const int last);
+  static QString MergeKey(const CollectionItem *item);
+  void FinishInitTask();
 
   void BeginReset();
 
@@ -248,15 +322,16 @@ class CollectionModel : public SimpleTreeModel<CollectionItem> {
   static void FilterQuery(const GroupBy group_by, const bool separate_albums_by_grouping, CollectionItem *item, CollectionQuery *q);
 
   // Items can be created either from a query that's been run to populate a node, or by a spontaneous SongsDiscovered emission from the backend.
-  CollectionItem *ItemFromQuery(const GroupBy group_by, const bool separate_albums_by_grouping, const bool signal, const bool create_divider, CollectionItem *parent, const SqlRow &row, const int container_level);
-  CollectionItem *ItemFromSong(const GroupBy group_by, const bool separate_albums_by_grouping, const bool signal, const bool create_divider, CollectionItem *parent, const Song &s, const int container_level);
+  // Items are only inserted with signals in the model's tree, trees without signals can be built on any thread.
+  CollectionItem *ItemFromQuery(Tree *tree, const GroupBy group_by, const bool signal, const bool create_divider, CollectionItem *parent, const SqlRow &row, const int container_level);
+  CollectionItem *ItemFromSong(Tree *tree, const GroupBy group_by, const bool signal, const bool create_divider, CollectionItem *parent, const Song &s, const int container_level);
 
   // The "Various Artists" node is an annoying special case.
   CollectionItem *CreateCompilationArtistNode(const bool signal, CollectionItem *parent);
 
   // Helpers for ItemFromQuery and ItemFromSong
   CollectionItem *InitItem(const GroupBy group_by, const bool signal, CollectionItem *parent, const int container_level);
-  void FinishItem(const GroupBy group_by, const bool signal, const bool create_divider, CollectionItem *parent, CollectionItem *item);
+  void FinishItem(Tree *tree, const GroupBy group_by, const bool signal, const bool create_divider, CollectionItem *parent, CollectionItem *item);
 
   static QString DividerKey(const GroupBy group_by, CollectionItem *item);
   static QString DividerDisplayText(const GroupBy group_by, const QString &key);
@@ -273,24 +348,22 @@ class CollectionModel : public SimpleTreeModel<CollectionItem> {
   CollectionBackend *backend_;
   Application *app_;
   CollectionDirectoryModel *dir_model_;
-  bool show_various_artists_;
 
   int total_song_count_;
   int total_artist_count_;
   int total_album_count_;
 
-  QueryOptions query_options_;
-  Grouping group_by_;
-  bool separate_albums_by_grouping_;
-
-  // Keyed on database ID
-  QMap<int, CollectionItem*> song_nodes_;
+  // The options set on the model, and the items shown, which are built with the options of the last tree that was merged.
+  Options options_;
+  Tree tree_;
 
-  // Keyed on whatever the key is for that level - artist, album, year, etc.
-  QMap<QString, CollectionItem*> container_nodes_[3];
-
-  // Keyed on a letter, a year, a century, etc.
-  QMap<QString, CollectionItem*> divider_nodes_;
+  // Trees are numbered, so only the tree built with the latest options is merged.
+  quint64 build_id_;
+  quint64 applied_build_id_;
+  // Changes from the backend while a tree is built, they are applied again after it is merged.
+  SongList build_songs_discovered_;
+  SongList build_songs_deleted_;
+  SongList build_songs_changed_;
 
   QIcon artist_icon_;
   QIcon album_icon_;
@@ -302,7 +375,6 @@ class CollectionModel : public SimpleTreeModel<CollectionItem> {
   int init_task_id_;
 
   bool use_pretty_covers_;
-  bool show_dividers_;
   bool use_disk_cache_;
   bool use_lazy_loading_;
 
@@ -311,6 +383,15 @@ class CollectionModel : public SimpleTreeModel<CollectionItem> {
   using ItemAndCacheKey = QPair<CollectionItem*, QString>;
   QMap<quint64, ItemAndCacheKey> pending_art_;
   QSet<QString> pending_cache_keys_;
+
+  // Results of RunQuery, keyed on the options and the parent item, with the number of rows as cost.
+  // RunQuery runs on worker threads too, so the cache is guarded by a mutex.
+  // The generation is increased when the cache is cleared, so results of queries running at the time are not cached.
+  QMutex query_cache_mutex_;
+  QCache<QString, QueryResult> query_cache_;
+  quint64 query_cache_generation_;
+  std::atomic<int> query_cache_hits_;
+  std::atomic<int> query_cache_misses_;
 };
 
 Q_DECLARE_METATYPE(CollectionModel::Grouping)
@@ -26,15 +26,16 @@
 
 #include "collectionplaylistitem.h"
 #include "core/tagreaderclient.h"
-
-class SqlRow;
+#include "core/sqlrow.h"
+#include "playlist/playlistbackend.h"
 
 CollectionPlaylistItem::CollectionPlaylistItem() : PlaylistItem(Song::Source_Collection) {
   song_.set_source(Song::Source_Collection);
 }
 
 CollectionPlaylistItem::CollectionPlaylistItem(const Song &song) : PlaylistItem(Song::Source_Collection), song_(song) {
-  song_.set_source(Song::Source_Collection);
+  // Only set the source when it differs, so the song is not detached from the copy it was made from.
+  if (song_.source() != Song::Source_Collection) song_.set_source(Song::Source_Collection);
 }
 
 QUrl CollectionPlaylistItem::Url() const { return song_.url(); }
@@ -48,8 +49,9 @@ void CollectionPlaylistItem::Reload() {
 
 bool CollectionPlaylistItem::InitFromQuery(const SqlRow &query) {
 
-  // Rows from the songs tables come first
-  song_.InitFromQuery(query, true);
+  // Rows from the songs tables come first.  For songs no longer in the collection the playlist_items columns are read instead,
+  // but collection items are saved there without metadata, so the song is not valid then.
+  song_.InitFromQuery(query, true, query.value(0).isNull() ? PlaylistBackend::PlaylistItemsColumn() : 0);
   song_.set_source(Song::Source_Collection);
   return song_.is_valid();
 
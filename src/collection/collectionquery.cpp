@@ -38,6 +38,9 @@
 
 #include "collectionquery.h"
 
+// In the order of Song::kFtsColumns: title, album, artist, albumartist, composer, performer, grouping, genre, comment.
+const char *CollectionQuery::kRankWeights = "10.0, 5.0, 8.0, 8.0, 2.0, 2.0, 1.0, 2.0, 0.5";
+
 QueryOptions::QueryOptions() : max_age_(-1), query_mode_(QueryMode_All) {}
 
 CollectionQuery::CollectionQuery(const QSqlDatabase &db, const QString &songs_table, const QString &fts_table, const QueryOptions &options)
@@ -47,6 +50,7 @@ CollectionQuery::CollectionQuery(const QSqlDatabase &db, const QString &songs_ta
       include_unavailable_(false),
       join_with_fts_(false),
       duplicates_only_(false),
+      order_by_rank_(false),
       limit_(-1) {
 
   if (!options.filter().isEmpty()) {
@@ -205,7 +209,13 @@ bool CollectionQuery::Exec() {
 
   if (!where_clauses.isEmpty()) sql += " WHERE " + where_clauses.join(" AND ");
 
-  if (!order_by_.isEmpty()) sql += " ORDER BY " + order_by_;
+  QStringList order_by;
+  if (order_by_rank_ && join_with_fts_) {
+    // bm25() returns lower values for better matches.
+    order_by << QString("bm25(fts.%fts_table_noprefix, %1)").arg(kRankWeights);
+  }
+  if (!order_by_.isEmpty()) order_by << order_by_;
+  if (!order_by.isEmpty()) sql += " ORDER BY " + order_by.join(", ");
 
   if (limit_ != -1) sql += " LIMIT " + QString::number(limit_);
 
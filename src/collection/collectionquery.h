@@ -82,6 +82,10 @@ class CollectionQuery : public QSqlQuery {
   // Sets an ORDER BY clause on the query.
   void SetOrderBy(const QString &order_by) { order_by_ = order_by; }
 
+  // Orders the rows by how well they match the filter text, the best matches first, before the ORDER BY clause.
+  // Only has an effect when the query has filter text.
+  void SetOrderByRank(const bool order_by_rank) { order_by_rank_ = order_by_rank; }
+
   // Adds a fragment of WHERE clause. When executed, this Query will connect all the fragments with AND operator.
   // Please note that IN operator expects a QStringList as value.
   void AddWhere(const QString &column, const QVariant &value, const QString &op = "=");
@@ -105,9 +109,13 @@ class CollectionQuery : public QSqlQuery {
   bool include_unavailable() const { return include_unavailable_; }
   bool join_with_fts() const { return join_with_fts_; }
   bool duplicates_only() const { return duplicates_only_; }
+  bool order_by_rank() const { return order_by_rank_; }
   int limit() const { return limit_; }
 
  private:
+  // Weights of the FTS columns when ranking with bm25(), matches in the title and artists count the most.
+  static const char *kRankWeights;
+
   QString GetInnerQuery() const;
 
   QSqlDatabase db_;
@@ -122,6 +130,7 @@ class CollectionQuery : public QSqlQuery {
   bool include_unavailable_;
   bool join_with_fts_;
   bool duplicates_only_;
+  bool order_by_rank_;
   int limit_;
 };
 
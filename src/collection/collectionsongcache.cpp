@@ -0,0 +1,193 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <QString>
+#include <QUrl>
+
+#include "core/song.h"
+#include "collectionsongcache.h"
+
+CollectionSongCache::CollectionSongCache() : loaded_(false), hits_(0), misses_(0) {}
+
+bool CollectionSongCache::is_loaded() const {
+
+  QReadLocker l(&lock_);
+  return loaded_;
+
+}
+
+void CollectionSongCache::Load(const SongList &songs) {
+
+  QWriteLocker l(&lock_);
+
+  songs_.clear();
+  ids_by_url_.clear();
+  ids_by_song_id_.clear();
+
+  songs_.reserve(static_cast<int>(songs.count()));
+  ids_by_url_.reserve(static_cast<int>(songs.count()));
+  for (const Song &song : songs) {
+    InsertSong(song);
+  }
+
+  loaded_ = true;
+
+}
+
+void CollectionSongCache::Clear() {
+
+  QWriteLocker l(&lock_);
+
+  songs_.clear();
+  ids_by_url_.clear();
+  ids_by_song_id_.clear();
+  loaded_ = false;
+
+}
+
+void CollectionSongCache::AddOrUpdateSongs(const SongList &songs) {
+
+  QWriteLocker l(&lock_);
+  if (!loaded_) return;
+
+  for (const Song &song : songs) {
+    RemoveSong(song.id());
+    InsertSong(song);
+  }
+
+}
+
+void CollectionSongCache::RemoveSongs(const SongList &songs) {
+
+  QWriteLocker l(&lock_);
+  if (!loaded_) return;
+
+  for (const Song &song : songs) {
+    RemoveSong(song.id());
+  }
+
+}
+
+void CollectionSongCache::UpdateMTimes(const SongList &songs) {
+
+  QWriteLocker l(&lock_);
+  if (!loaded_) return;
+
+  for (const Song &song : songs) {
+    QHash<int, Song>::iterator it = songs_.find(song.id());
+    if (it != songs_.end()) it->set_mtime(song.mtime());
+  }
+
+}
+
+void CollectionSongCache::UpdateLastSeen(const int directory_id, const qint64 lastseen) {
+
+  QWriteLocker l(&lock_);
+  if (!loaded_) return;
+
+  for (QHash<int, Song>::iterator it = songs_.begin(); it != songs_.end(); ++it) {
+    if (it->directory_id() == directory_id && !it->is_unavailable()) it->set_lastseen(lastseen);
+  }
+
+}
+
+bool CollectionSongCache::GetSongById(const int id, Song *song) const {
+
+  QReadLocker l(&lock_);
+  if (!CountLookup()) return false;
+
+  *song = songs_.value(id);
+  return true;
+
+}
+
+bool CollectionSongCache::GetSongsByUrl(const QUrl &url, SongList *songs) const {
+
+  QReadLocker l(&lock_);
+  if (!CountLookup()) return false;
+
+  for (QMultiHash<QUrl, int>::const_iterator it = ids_by_url_.find(url); it != ids_by_url_.end() && it.key() == url; ++it) {
+    *songs << songs_.value(it.value());
+  }
+  return true;
+
+}
+
+bool CollectionSongCache::GetSongsBySongId(const QString &song_id, SongList *songs) const {
+
+  QReadLocker l(&lock_);
+  if (!CountLookup()) return false;
+
+  for (QMultiHash<QString, int>::const_iterator it = ids_by_song_id_.find(song_id); it != ids_by_song_id_.end() && it.key() == song_id; ++it) {
+    *songs << songs_.value(it.value());
+  }
+  return true;
+
+}
+
+int CollectionSongCache::size() const {
+
+  QReadLocker l(&lock_);
+  return static_cast<int>(songs_.count());
+
+}
+
+void CollectionSongCache::ResetCounters() {
+
+  hits_ = 0;
+  misses_ = 0;
+
+}
+
+void CollectionSongCache::InsertSong(const Song &song) {
+
+  songs_.insert(song.id(), song);
+  ids_by_url_.insert(song.url(), song.id());
+  if (!song.song_id().isEmpty()) ids_by_song_id_.insert(song.song_id(), song.id());
+
+}
+
+void CollectionSongCache::RemoveSong(const int id) {
+
+  QHash<int, Song>::iterator it = songs_.find(id);
+  if (it == songs_.end()) return;
+
+  ids_by_url_.remove(it->url(), id);
+  if (!it->song_id().isEmpty()) ids_by_song_id_.remove(it->song_id(), id);
+  songs_.erase(it);
+
+}
+
+bool CollectionSongCache::CountLookup() const {
+
+  if (loaded_) {
+    ++hits_;
+  }
+  else {
+    ++misses_;
+  }
+
+  return loaded_;
+
+}
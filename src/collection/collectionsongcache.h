@@ -0,0 +1,86 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COLLECTIONSONGCACHE_H
+#define COLLECTIONSONGCACHE_H
+
+#include "config.h"
+
+#include <atomic>
+
+#include <QtGlobal>
+#include <QReadWriteLock>
+#include <QHash>
+#include <QMultiHash>
+#include <QString>
+#include <QUrl>
+
+#include "core/song.h"
+
+// Keeps every song of a collection in memory, indexed by database ID, URL and song ID.
+// The collection backend loads it with one scan of the songs table and updates it when songs are added, changed or removed,
+// so looking up a song doesn't query the database, and everyone looking up a song shares the same copy of its data.
+// Lookups return false until the cache is loaded, the caller then has to query the database. All functions are thread-safe.
+class CollectionSongCache {
+ public:
+  explicit CollectionSongCache();
+
+  bool is_loaded() const;
+
+  // Replaces the songs in the cache and marks it as loaded.
+  void Load(const SongList &songs);
+  // Removes all songs and marks the cache as not loaded.
+  void Clear();
+
+  // These do nothing until the cache is loaded.
+  void AddOrUpdateSongs(const SongList &songs);
+  void RemoveSongs(const SongList &songs);
+  void UpdateMTimes(const SongList &songs);
+  void UpdateLastSeen(const int directory_id, const qint64 lastseen);
+
+  bool GetSongById(const int id, Song *song) const;
+  bool GetSongsByUrl(const QUrl &url, SongList *songs) const;
+  bool GetSongsBySongId(const QString &song_id, SongList *songs) const;
+
+  // Number of songs in the cache.
+  int size() const;
+  // Lookups answered from the cache, and lookups made before it was loaded.
+  int hits() const { return hits_; }
+  int misses() const { return misses_; }
+  void ResetCounters();
+
+ private:
+  Q_DISABLE_COPY(CollectionSongCache)
+
+  void InsertSong(const Song &song);
+  void RemoveSong(const int id);
+  bool CountLookup() const;
+
+ private:
+  mutable QReadWriteLock lock_;
+  bool loaded_;
+  QHash<int, Song> songs_;
+  QMultiHash<QUrl, int> ids_by_url_;
+  QMultiHash<QString, int> ids_by_song_id_;
+
+  mutable std::atomic<int> hits_;
+  mutable std::atomic<int> misses_;
+};
+
+#endif  // COLLECTIONSONGCACHE_H
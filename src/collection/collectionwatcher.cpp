@@ -22,10 +22,15 @@
 #include "config.h"
 
 #include <utility>
+#include <algorithm>
+#include <memory>
 #include <chrono>
 
 #include <QObject>
 #include <QThread>
+#include <QThreadPool>
+#include <QFuture>
+#include <QtConcurrentRun>
 #include <QIODevice>
 #include <QDir>
 #include <QDirIterator>
@@ -33,9 +38,12 @@
 #include <QFileInfo>
 #include <QMetaObject>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QHash>
 #include <QMap>
 #include <QList>
+#include <QQueue>
+#include <QPair>
 #include <QSet>
 #include <QTimer>
 #include <QString>
@@ -56,7 +64,7 @@
 #include "playlistparsers/cueparser.h"
 #include "settings/collectionsettingspage.h"
 #ifdef HAVE_SONGFINGERPRINTING
-#  include "engine/chromaprinter.h"
+#  include "fingerprintcache.h"
 #endif
 
 // This is defined by one of the windows headers that is included by taglib.
@@ -68,6 +76,75 @@ using namespace std::chrono_literals;
 
 QStringList CollectionWatcher::sValidImages = QStringList() << "jpg" << "png" << "gif" << "jpeg";
 
+const int CollectionWatcher::kMaxScanJobs = 32;
+const int CollectionWatcher::kScanCommitBatchSize = 500;
+const int CollectionWatcher::kReadFilesBatchSize = 250;
+
+// A ReadFiles request shared by the files in a batch.  The results are taken from the partial replies as they arrive.
+class CollectionWatcher::ReadFilesBatch {
+ public:
+  explicit ReadFilesBatch(TagReaderReply *reply) : reply_(reply), finished_(false) {}
+  ~ReadFilesBatch();
+
+  // Waits for the metadata of the file at index in the request.  Returns false if the reply finished without it.
+  bool TakeResult(const int index, spb::tagreader::SongMetadata *metadata);
+
+ private:
+  void TakePartialReply();
+
+  TagReaderReply *reply_;
+  bool finished_;
+  QHash<int, spb::tagreader::SongMetadata> results_;
+};
+
+CollectionWatcher::ReadFilesBatch::~ReadFilesBatch() {
+
+  // The reply can only be deleted after it finished, also when the scan was stopped before all results were used.
+  while (!finished_) TakePartialReply();
+  QMetaObject::invokeMethod(reply_, "deleteLater", Qt::QueuedConnection);
+
+}
+
+bool CollectionWatcher::ReadFilesBatch::TakeResult(const int index, spb::tagreader::SongMetadata *metadata) {
+
+  while (!finished_ && !results_.contains(index)) TakePartialReply();
+
+  if (!results_.contains(index)) return false;
+
+  *metadata = results_.take(index);
+
+  return true;
+
+}
+
+void CollectionWatcher::ReadFilesBatch::TakePartialReply() {
+
+  const spb::tagreader::Message message = reply_->WaitForPartialReply(&finished_);
+  for (const spb::tagreader::ReadFilesResult &result : message.read_files_response().results()) {
+    results_.insert(result.index(), result.metadata());
+  }
+
+}
+
+struct CollectionWatcher::ScanFile {
+  ScanFile() : cue_mtime(0), missing(false), rescan(false), cue_deleted(false), read(false), read_index(0), fingerprinting(false) {}
+
+  QString file;
+  QString cue;  // Associated CUE (if any)
+  qint64 cue_mtime;
+  SongList matching_songs;  // Songs in the collection with the same path
+  QUrl image;
+  bool missing;  // The file was removed after it was listed
+  bool rescan;  // Metadata should be (re)read from the file
+  bool cue_deleted;
+  bool read;  // Metadata is read by the tagreader
+
+  std::shared_ptr<ReadFilesBatch> read_batch;  // ReadFiles request shared with other files
+  int read_index;
+  QFuture<QString> fingerprint;
+  bool fingerprinting;
+};
+
 CollectionWatcher::CollectionWatcher(Song::Source source, QObject *parent)
     : QObject(parent),
       source_(source),
@@ -82,6 +159,7 @@ CollectionWatcher::CollectionWatcher(Song::Source source, QObject *parent)
       expire_unavailable_songs_days_(60),
       overwrite_playcount_(false),
       overwrite_rating_(false),
+      scan_jobs_(qBound(1, QThread::idealThreadCount(), kMaxScanJobs)),
       stop_requested_(false),
       abort_requested_(false),
       rescan_in_progress_(false),
@@ -90,6 +168,8 @@ CollectionWatcher::CollectionWatcher(Song::Source source, QObject *parent)
       rescan_paused_(false),
       total_watches_(0),
       cue_parser_(new CueParser(backend_, this)),
+      fingerprint_pool_(new QThreadPool(this)),
+      fingerprint_backfill_pool_(new QThreadPool(this)),
       last_scan_time_(0) {
 
   original_thread_ = thread();
@@ -109,11 +189,32 @@ CollectionWatcher::CollectionWatcher(Song::Source source, QObject *parent)
 
   ReloadSettings();
 
+  if (source_ == Song::Source_Collection) {
+    QSettings s;
+    s.beginGroup(CollectionSettingsPage::kSettingsGroup);
+    rescan_journal_subdirs_ = s.value("rescan_journal_subdirs").toStringList();
+    rescan_journal_files_ = s.value("rescan_journal_files").toStringList();
+    s.remove("rescan_journal_subdirs");
+    s.remove("rescan_journal_files");
+    s.endGroup();
+  }
+
   QObject::connect(rescan_timer_, &QTimer::timeout, this, &CollectionWatcher::RescanPathsNow);
   QObject::connect(periodic_scan_timer_, &QTimer::timeout, this, &CollectionWatcher::IncrementalScanCheck);
 
 }
 
+CollectionWatcher::~CollectionWatcher() = default;
+
+void CollectionWatcher::set_backend(CollectionBackend *backend) {
+
+  backend_ = backend;
+#ifdef HAVE_SONGFINGERPRINTING
+  fingerprint_cache_ = std::make_unique<FingerprintCache>(backend_->db());
+#endif
+
+}
+
 void CollectionWatcher::ExitAsync() {
   QMetaObject::invokeMethod(this, "Exit", Qt::QueuedConnection);
 }
@@ -123,6 +224,7 @@ void CollectionWatcher::Exit() {
   Q_ASSERT(QThread::currentThread() == thread());
 
   Stop();
+  SaveRescanJournal();
   if (backend_) backend_->Close();
   moveToThread(original_thread_);
   emit ExitFinished();
@@ -154,8 +256,12 @@ void CollectionWatcher::ReloadSettings() {
   expire_unavailable_songs_days_ = s.value("expire_unavailable_songs", 60).toInt();
   overwrite_playcount_ = s.value("overwrite_playcount", false).toBool();
   overwrite_rating_ = s.value("overwrite_rating", false).toBool();
+  scan_jobs_ = qBound(1, s.value("scan_jobs", QThread::idealThreadCount()).toInt(), kMaxScanJobs);
   s.endGroup();
 
+  fingerprint_pool_->setMaxThreadCount(scan_jobs_);
+  fingerprint_backfill_pool_->setMaxThreadCount(scan_jobs_);
+
   best_image_filters_.clear();
   for (const QString &filter : filters) {
     QString str = filter.trimmed();
@@ -194,7 +300,6 @@ CollectionWatcher::ScanTransaction::ScanTransaction(CollectionWatcher *watcher,
       expire_unavailable_songs_days_(60),
       watcher_(watcher),
       cached_songs_dirty_(true),
-      cached_songs_missing_fingerprint_dirty_(true),
       known_subdirs_dirty_(true) {
 
   QString description;
@@ -248,20 +353,7 @@ void CollectionWatcher::ScanTransaction::CommitNewOrUpdatedSongs() {
     deleted_songs.clear();
   }
 
-  if (!new_songs.isEmpty()) {
-    emit watcher_->NewOrUpdatedSongs(new_songs);
-    new_songs.clear();
-  }
-
-  if (!touched_songs.isEmpty()) {
-    emit watcher_->SongsMTimeUpdated(touched_songs);
-    touched_songs.clear();
-  }
-
-  if (!readded_songs.isEmpty()) {
-    emit watcher_->SongsReadded(readded_songs);
-    readded_songs.clear();
-  }
+  CommitScannedSongs();
 
   if (!new_subdirs.isEmpty()) {
     emit watcher_->SubdirsDiscovered(new_subdirs);
@@ -295,6 +387,25 @@ void CollectionWatcher::ScanTransaction::CommitNewOrUpdatedSongs() {
 
 }
 
+void CollectionWatcher::ScanTransaction::CommitScannedSongs() {
+
+  if (!new_songs.isEmpty()) {
+    emit watcher_->NewOrUpdatedSongs(new_songs);
+    new_songs.clear();
+  }
+
+  if (!touched_songs.isEmpty()) {
+    emit watcher_->SongsMTimeUpdated(touched_songs);
+    touched_songs.clear();
+  }
+
+  if (!readded_songs.isEmpty()) {
+    emit watcher_->SongsReadded(readded_songs);
+    readded_songs.clear();
+  }
+
+}
+
 
 SongList CollectionWatcher::ScanTransaction::FindSongsInSubdirectory(const QString &path) {
 
@@ -314,21 +425,6 @@ SongList CollectionWatcher::ScanTransaction::FindSongsInSubdirectory(const QStri
 
 }
 
-bool CollectionWatcher::ScanTransaction::HasSongsWithMissingFingerprint(const QString &path) {
-
-  if (cached_songs_missing_fingerprint_dirty_) {
-    const SongList songs = watcher_->backend_->SongsWithMissingFingerprint(dir_);
-    for (const Song &song : songs) {
-      const QString p = song.url().toLocalFile().section('/', 0, -2);
-      cached_songs_missing_fingerprint_.insert(p, song);
-    }
-    cached_songs_missing_fingerprint_dirty_ = false;
-  }
-
-  return cached_songs_missing_fingerprint_.contains(path);
-
-}
-
 void CollectionWatcher::ScanTransaction::SetKnownSubdirs(const SubdirectoryList &subdirs) {
 
   known_subdirs_ = subdirs;
@@ -407,6 +503,9 @@ void CollectionWatcher::AddDirectory(const Directory &dir, const SubdirectoryLis
 
   }
 
+  // Queue the changes that were recorded but not scanned before the last exit.
+  RestoreRescanJournal(dir);
+
   emit CompilationsNeedUpdating();
 
 }
@@ -425,14 +524,8 @@ void CollectionWatcher::ScanSubdirectory(const QString &path, const Subdirectory
     }
   }
 
-  bool songs_missing_fingerprint = false;
-#ifdef HAVE_SONGFINGERPRINTING
-  if (song_tracking_) {
-    songs_missing_fingerprint = t->HasSongsWithMissingFingerprint(path);
-  }
-#endif
-
-  if (!t->ignores_mtime() && !force_noincremental && t->is_incremental() && subdir.mtime == path_info.lastModified().toSecsSinceEpoch() && !songs_missing_fingerprint) {
+  // Songs that are only missing a fingerprint are left for FingerprintMissingNow().
+  if (!t->ignores_mtime() && !force_noincremental && t->is_incremental() && subdir.mtime == path_info.lastModified().toSecsSinceEpoch()) {
     // The directory hasn't changed since last time
     t->AddToProgress(files_count);
     return;
@@ -452,10 +545,23 @@ void CollectionWatcher::ScanSubdirectory(const QString &path, const Subdirectory
   }
 
   // First we "quickly" get a list of the files in the directory that we think might be music.  While we're here, we also look for new subdirectories and possible album artwork.
+  // The tagreader checks if the remaining files are media files, with up to scan_jobs_ requests in flight.
+  QQueue<QPair<QString, TagReaderReply*>> media_file_checks;
+  auto finish_media_file_check = [&media_file_checks, &files_on_disk, t]() {
+    const QPair<QString, TagReaderReply*> check = media_file_checks.dequeue();
+    if (check.second->WaitForFinished() && check.second->message().is_media_file_response().success()) {
+      files_on_disk << check.first;
+    }
+    else {
+      t->AddToProgress(1);
+    }
+    QMetaObject::invokeMethod(check.second, "deleteLater", Qt::QueuedConnection);
+  };
+
   QDirIterator it(path, QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
   while (it.hasNext()) {
 
-    if (stop_requested_ || abort_requested_) return;
+    if (stop_requested_ || abort_requested_) break;
 
     QString child(it.next());
     QFileInfo child_info(child);
@@ -481,15 +587,15 @@ void CollectionWatcher::ScanSubdirectory(const QString &path, const Subdirectory
         album_art[dir_part] << child;
         t->AddToProgress(1);
       }
-      else if (TagReaderClient::Instance()->IsMediaFileBlocking(child)) {
-        files_on_disk << child;
-      }
       else {
-        t->AddToProgress(1);
+        media_file_checks.enqueue(qMakePair(child, TagReaderClient::Instance()->IsMediaFile(child)));
+        if (media_file_checks.count() >= scan_jobs_) finish_media_file_check();
       }
     }
   }
 
+  while (!media_file_checks.isEmpty()) finish_media_file_check();
+
   if (stop_requested_ || abort_requested_) return;
 
   // Ask the database for a list of files in this directory
@@ -497,208 +603,379 @@ void CollectionWatcher::ScanSubdirectory(const QString &path, const Subdirectory
 
   QSet<QString> cues_processed;
 
-  // Now compare the list from the database with the list of files on disk
-  QStringList files_on_disk_copy = files_on_disk;
-  for (const QString &file : files_on_disk_copy) {
+  // Now compare the list from the database with the list of files on disk.
+  // Fingerprints run concurrently in the fingerprint pool, and the files that need their metadata read are sent to the tagreader in up to scan_jobs_ ReadFiles requests.
+  // The results are processed in order.
+  QList<ScanFile> scan_files;
+  scan_files.reserve(files_on_disk.count());
+  for (const QString &file : std::as_const(files_on_disk)) {
+    if (stop_requested_ || abort_requested_) break;
+    scan_files << QueueScanFile(file, songs_in_db, album_art, t);
+  }
+  ReadScanFiles(&scan_files);
+
+  for (ScanFile &f : scan_files) {
+    if (stop_requested_ || abort_requested_) {
+      FinishScanFile(&f, nullptr, nullptr);
+      continue;
+    }
+    ProcessScanFile(&f, path, &files_on_disk, &cues_processed, t);
+    if (t->scanned_songs_count() >= kScanCommitBatchSize) {
+      t->CommitScannedSongs();
+    }
+  }
+
+  if (stop_requested_ || abort_requested_) return;
 
+  // Look for deleted songs
+  for (const Song &song : songs_in_db) {
+    QString file = song.url().toLocalFile();
+    if (!song.is_unavailable() && !files_on_disk.contains(file) && !t->files_changed_path_.contains(file)) {
+      qLog(Debug) << "Song deleted from disk:" << file;
+      t->deleted_songs << song;
+    }
+  }
+
+  // Add this subdir to the new or touched list
+  Subdirectory updated_subdir;
+  updated_subdir.directory_id = t->dir();
+  updated_subdir.mtime = path_info.exists() ? path_info.lastModified().toSecsSinceEpoch() : 0;
+  updated_subdir.path = path;
+
+  if (subdir.directory_id == -1) {
+    t->new_subdirs << updated_subdir;
+  }
+  else {
+    t->touched_subdirs << updated_subdir;
+  }
+
+  if (updated_subdir.mtime == 0) {  // Subdirectory deleted, mark it for removal from the watcher.
+    t->deleted_subdirs << updated_subdir;
+  }
+
+  // Recurse into the new subdirs that we found
+  for (const Subdirectory &my_new_subdir : my_new_subdirs) {
     if (stop_requested_ || abort_requested_) return;
+    ScanSubdirectory(my_new_subdir.path, my_new_subdir, 0, t, true);
+  }
 
-    // Associated CUE
-    QString new_cue = CueParser::FindCueFilename(file);
+}
 
-    SongList matching_songs;
-    if (FindSongsByPath(songs_in_db, file, &matching_songs)) {  // Found matching song in DB by path.
+void CollectionWatcher::ScanFiles(const QString &path, const QStringList &files, ScanTransaction *t) {
 
-      Song matching_song = matching_songs.first();
+  Subdirectory subdir;
+  subdir.directory_id = t->dir();
+  subdir.path = path;
 
-      // The song is in the database and still on disk.
-      // Check the mtime to see if it's been changed since it was added.
-      QFileInfo fileinfo(file);
+  // Album art and CUE sheets change the other songs in the directory, so scan the whole directory for those.
+  for (const QString &file : files) {
+    const QString ext_part(ExtensionPart(file));
+    if (sValidImages.contains(ext_part) || ext_part == "cue") {
+      const quint64 files_count = FilesCountForPath(t, path);
+      t->AddToProgressMax(files_count);
+      ScanSubdirectory(path, subdir, files_count, t, true);
+      return;
+    }
+  }
 
-      if (!fileinfo.exists()) {
-        // Partially fixes race condition - if file was removed between being added to the list and now.
-        files_on_disk.removeAll(file);
-        t->AddToProgress(1);
-        continue;
-      }
+  t->AddToProgressMax(files.count());
 
-      // CUE sheet's path from collection (if any).
-      qint64 matching_song_cue_mtime = static_cast<qint64>(GetMtimeForCue(matching_song.cue_path()));
+  // The album art is picked from the images in the directory, like in a full scan of it.
+  QMap<QString, QStringList> album_art;
+  const QFileInfoList entries = QDir(path).entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
+  for (const QFileInfo &entry : entries) {
+    if (sValidImages.contains(entry.suffix().toLower())) {
+      album_art[path] << entry.filePath();
+    }
+  }
 
-      // CUE sheet's path from this file (if any).
-      qint64 new_cue_mtime = 0;
-      if (!new_cue.isEmpty()) {
-        new_cue_mtime = static_cast<qint64>(GetMtimeForCue(new_cue));
-      }
+  QQueue<QPair<QString, TagReaderReply*>> media_file_checks;
+  for (const QString &file : files) {
+    if (QFile::exists(file)) {
+      media_file_checks.enqueue(qMakePair(file, TagReaderClient::Instance()->IsMediaFile(file)));
+    }
+  }
+
+  QStringList files_on_disk;
+  while (!media_file_checks.isEmpty()) {
+    const QPair<QString, TagReaderReply*> check = media_file_checks.dequeue();
+    if (check.second->WaitForFinished() && check.second->message().is_media_file_response().success()) {
+      files_on_disk << check.first;
+    }
+    QMetaObject::invokeMethod(check.second, "deleteLater", Qt::QueuedConnection);
+  }
 
-      const bool cue_added = new_cue_mtime != 0 && !matching_song.has_cue();
-      const bool cue_changed = new_cue_mtime != 0 && matching_song.has_cue() && new_cue != matching_song.cue_path();
-      const bool cue_deleted = matching_song.has_cue() && new_cue_mtime == 0;
+  t->AddToProgress(files.count() - files_on_disk.count());
 
-      // Watch out for CUE songs which have their mtime equal to qMax(media_file_mtime, cue_sheet_mtime)
-      bool changed = (matching_song.mtime() != qMax(fileinfo.lastModified().toSecsSinceEpoch(), matching_song_cue_mtime)) || cue_deleted || cue_added || cue_changed;
+  if (stop_requested_ || abort_requested_) return;
 
-      // Also want to look to see whether the album art has changed
-      QUrl image = ImageForSong(file, album_art);
-      if ((matching_song.art_automatic().isEmpty() && !image.isEmpty()) || (!matching_song.art_automatic().isEmpty() && !matching_song.has_embedded_cover() && !QFile::exists(matching_song.art_automatic().toLocalFile()))) {
-        changed = true;
-      }
+  const SongList songs_in_db = t->FindSongsInSubdirectory(path);
+
+  QSet<QString> cues_processed;
+  QList<ScanFile> scan_files;
+  scan_files.reserve(files_on_disk.count());
+  for (const QString &file : std::as_const(files_on_disk)) {
+    scan_files << QueueScanFile(file, songs_in_db, album_art, t);
+  }
+  ReadScanFiles(&scan_files);
 
-      bool missing_fingerprint = false;
+  for (ScanFile &f : scan_files) {
+    if (stop_requested_ || abort_requested_) {
+      FinishScanFile(&f, nullptr, nullptr);
+      continue;
+    }
+    ProcessScanFile(&f, path, &files_on_disk, &cues_processed, t);
+  }
+
+  if (stop_requested_ || abort_requested_) return;
+
+  // Look for deleted songs among the changed files
+  for (const Song &song : songs_in_db) {
+    const QString file = song.url().toLocalFile();
+    if (!song.is_unavailable() && files.contains(file) && !files_on_disk.contains(file) && !t->files_changed_path_.contains(file)) {
+      qLog(Debug) << "Song deleted from disk:" << file;
+      t->deleted_songs << song;
+    }
+  }
+
+  // Update the subdir's mtime, so the next incremental scan doesn't scan it again.
+  QFileInfo path_info(path);
+  if (path_info.exists()) {
+    subdir.mtime = path_info.lastModified().toSecsSinceEpoch();
+    t->touched_subdirs << subdir;
+  }
+
+}
+
+CollectionWatcher::ScanFile CollectionWatcher::QueueScanFile(const QString &file, const SongList &songs_in_db, QMap<QString, QStringList> &album_art, ScanTransaction *t) {
+
+  ScanFile f;
+  f.file = file;
+
+  // Associated CUE
+  f.cue = CueParser::FindCueFilename(file);
+
+  // CUE sheet's path from this file (if any).
+  if (!f.cue.isEmpty()) {
+    f.cue_mtime = static_cast<qint64>(GetMtimeForCue(f.cue));
+  }
+
+  // Album art for the song, picked while the album art map is still owned by this thread.
+  f.image = ImageForSong(file, album_art);
+
+  if (FindSongsByPath(songs_in_db, file, &f.matching_songs)) {  // Found matching song in DB by path.
+
+    const Song &matching_song = f.matching_songs.first();
+
+    // The song is in the database and still on disk.
+    // Check the mtime to see if it's been changed since it was added.
+    QFileInfo fileinfo(file);
+
+    if (!fileinfo.exists()) {
+      // Partially fixes race condition - if file was removed between being added to the list and now.
+      f.missing = true;
+      return f;
+    }
+
+    // CUE sheet's path from collection (if any).
+    qint64 matching_song_cue_mtime = static_cast<qint64>(GetMtimeForCue(matching_song.cue_path()));
+
+    const bool cue_added = f.cue_mtime != 0 && !matching_song.has_cue();
+    const bool cue_changed = f.cue_mtime != 0 && matching_song.has_cue() && f.cue != matching_song.cue_path();
+    f.cue_deleted = matching_song.has_cue() && f.cue_mtime == 0;
+
+    // Watch out for CUE songs which have their mtime equal to qMax(media_file_mtime, cue_sheet_mtime)
+    bool changed = (matching_song.mtime() != qMax(fileinfo.lastModified().toSecsSinceEpoch(), matching_song_cue_mtime)) || f.cue_deleted || cue_added || cue_changed;
+
+    // Also want to look to see whether the album art has changed
+    if ((matching_song.art_automatic().isEmpty() && !f.image.isEmpty()) || (!matching_song.art_automatic().isEmpty() && !matching_song.has_embedded_cover() && !QFile::exists(matching_song.art_automatic().toLocalFile()))) {
+      changed = true;
+    }
+
+    bool missing_fingerprint = false;
 #ifdef HAVE_SONGFINGERPRINTING
-      if (song_tracking_ && matching_song.fingerprint().isEmpty()) {
-        missing_fingerprint = true;
-      }
+    if (song_tracking_ && !t->is_incremental() && matching_song.fingerprint().isEmpty()) {
+      missing_fingerprint = true;
+    }
 #endif
 
-      if (changed) {
-        qLog(Debug) << file << "has changed.";
-      }
-      else if (missing_fingerprint) {
-        qLog(Debug) << file << "is missing fingerprint.";
-      }
+    if (changed) {
+      qLog(Debug) << file << "has changed.";
+    }
+    else if (missing_fingerprint) {
+      qLog(Debug) << file << "is missing fingerprint.";
+    }
 
-      // The song's changed or missing fingerprint - create fingerprint and reread the metadata from file.
-      if (t->ignores_mtime() || changed || missing_fingerprint) {
+    // The song's changed or missing fingerprint - create fingerprint and reread the metadata from file.
+    f.rescan = t->ignores_mtime() || changed || missing_fingerprint;
+
+  }
+  else {  // Search the DB by fingerprint, or add it as a new song.
+    f.rescan = true;
+  }
+
+  if (!f.rescan) return f;
 
-        QString fingerprint;
 #ifdef HAVE_SONGFINGERPRINTING
-        if (song_tracking_) {
-          Chromaprinter chromaprinter(file);
-          fingerprint = chromaprinter.CreateFingerprint();
-          if (fingerprint.isEmpty()) {
-            fingerprint = "NONE";
-          }
-        }
+  if (song_tracking_) {
+    f.fingerprint = QtConcurrent::run(fingerprint_pool_, [this, file]() { return CreateFingerprint(file); });
+    f.fingerprinting = true;
+  }
 #endif
 
-        if (new_cue.isEmpty() || new_cue_mtime == 0) {  // If no CUE or it's about to lose it.
-          UpdateNonCueAssociatedSong(file, fingerprint, matching_songs, image, cue_deleted, t);
-        }
-        else {  // If CUE associated.
-          UpdateCueAssociatedSongs(file, path, fingerprint, new_cue, image, matching_songs, t);
-        }
+  // Files with a CUE sheet get their metadata from the CUE.
+  f.read = f.cue_mtime == 0;
 
-      }
+  return f;
 
-      // Nothing has changed - mark the song available without re-scanning
-      else if (matching_song.is_unavailable()) {
-        t->readded_songs << matching_songs;
-      }
+}
 
+void CollectionWatcher::ReadScanFiles(QList<ScanFile> *scan_files) {
+
+  QList<ScanFile*> read_files;
+  for (ScanFile &f : *scan_files) {
+    if (f.read) read_files << &f;
+  }
+  if (read_files.isEmpty()) return;
+
+  // Split the files evenly over the requests so every tagreader worker gets its share.
+  const int batch_size = qBound(1, (static_cast<int>(read_files.count()) + scan_jobs_ - 1) / scan_jobs_, kReadFilesBatchSize);
+  for (int i = 0; i < read_files.count(); i += batch_size) {
+    const int count = qMin(batch_size, static_cast<int>(read_files.count()) - i);
+    QStringList filenames;
+    filenames.reserve(count);
+    for (int j = 0; j < count; ++j) {
+      filenames << read_files[i + j]->file;
     }
-    else {  // Search the DB by fingerprint.
-      QString fingerprint;
-#ifdef HAVE_SONGFINGERPRINTING
-      if (song_tracking_) {
-        Chromaprinter chromaprinter(file);
-        fingerprint = chromaprinter.CreateFingerprint();
-        if (fingerprint.isEmpty()) {
-          fingerprint = "NONE";
-        }
-      }
-#endif
-      if (song_tracking_ && !fingerprint.isEmpty() && fingerprint != "NONE" && FindSongsByFingerprint(file, fingerprint, &matching_songs)) {
-
-        // The song is in the database and still on disk.
-        // Check the mtime to see if it's been changed since it was added.
-        QFileInfo fileinfo(file);
-        if (!fileinfo.exists()) {
-          // Partially fixes race condition - if file was removed between being added to the list and now.
-          files_on_disk.removeAll(file);
-          t->AddToProgress(1);
-          continue;
-        }
+    std::shared_ptr<ReadFilesBatch> read_batch = std::make_shared<ReadFilesBatch>(TagReaderClient::Instance()->ReadFiles(filenames));
+    for (int j = 0; j < count; ++j) {
+      ScanFile *f = read_files[i + j];
+      f->read_batch = read_batch;
+      f->read_index = j;
+    }
+  }
 
-        // Make sure the songs aren't deleted, as they still exist elsewhere with a different file path.
-        bool matching_songs_has_cue = false;
-        for (const Song &matching_song : matching_songs) {
-          QString matching_filename = matching_song.url().toLocalFile();
-          if (!t->files_changed_path_.contains(matching_filename)) {
-            t->files_changed_path_ << matching_filename;
-            qLog(Debug) << matching_filename << "has changed path to" << file;
-          }
-          if (t->deleted_songs.contains(matching_song)) {
-            t->deleted_songs.removeAll(matching_song);
-          }
-          if (matching_song.has_cue()) {
-            matching_songs_has_cue = true;
-          }
-        }
+}
 
-        // CUE sheet's path from this file (if any).
-        qint64 new_cue_mtime = 0;
-        if (!new_cue.isEmpty()) {
-          new_cue_mtime = static_cast<qint64>(GetMtimeForCue(new_cue));
-        }
+void CollectionWatcher::FinishScanFile(ScanFile *f, QString *fingerprint, Song *song_on_disk) {
 
-        // Get new album art
-        QUrl image = ImageForSong(file, album_art);
+  if (f->fingerprinting) {
+    f->fingerprint.waitForFinished();
+    if (fingerprint) *fingerprint = f->fingerprint.result();
+    f->fingerprinting = false;
+  }
+
+  if (f->read_batch) {
+    // Only waits for this file's result, the rest of the request can still be in progress.
+    spb::tagreader::SongMetadata metadata;
+    if (song_on_disk && f->read_batch->TakeResult(f->read_index, &metadata)) {
+      song_on_disk->InitFromProtobuf(metadata);
+    }
+    f->read_batch.reset();
+  }
 
-        if (new_cue.isEmpty() || new_cue_mtime == 0) {  // If no CUE or it's about to lose it.
-          UpdateNonCueAssociatedSong(file, fingerprint, matching_songs, image, matching_songs_has_cue && new_cue_mtime == 0, t);
+}
+
+void CollectionWatcher::ProcessScanFile(ScanFile *f, const QString &path, QStringList *files_on_disk, QSet<QString> *cues_processed, ScanTransaction *t) {
+
+  QString fingerprint;
+  Song song_on_disk(source_);
+  FinishScanFile(f, &fingerprint, &song_on_disk);
+
+  if (f->missing) {
+    files_on_disk->removeAll(f->file);
+    t->AddToProgress(1);
+    return;
+  }
+
+  const QString &file = f->file;
+
+  if (!f->matching_songs.isEmpty()) {
+    if (f->rescan) {
+      if (f->cue.isEmpty() || f->cue_mtime == 0) {  // If no CUE or it's about to lose it.
+        UpdateNonCueAssociatedSong(file, fingerprint, f->matching_songs, song_on_disk, f->image, f->cue_deleted, t);
+      }
+      else {  // If CUE associated.
+        UpdateCueAssociatedSongs(file, path, fingerprint, f->cue, f->image, f->matching_songs, t);
+      }
+    }
+    // Nothing has changed - mark the song available without re-scanning
+    else if (f->matching_songs.first().is_unavailable()) {
+      t->readded_songs << f->matching_songs;
+    }
+  }
+  else {
+    SongList matching_songs;
+    if (song_tracking_ && !fingerprint.isEmpty() && fingerprint != "NONE" && FindSongsByFingerprint(file, fingerprint, &matching_songs)) {
+
+      // The song is in the database and still on disk.
+      // Check the mtime to see if it's been changed since it was added.
+      QFileInfo fileinfo(file);
+      if (!fileinfo.exists()) {
+        // Partially fixes race condition - if file was removed between being added to the list and now.
+        files_on_disk->removeAll(file);
+        t->AddToProgress(1);
+        return;
+      }
+
+      // Make sure the songs aren't deleted, as they still exist elsewhere with a different file path.
+      bool matching_songs_has_cue = false;
+      for (const Song &matching_song : matching_songs) {
+        QString matching_filename = matching_song.url().toLocalFile();
+        if (!t->files_changed_path_.contains(matching_filename)) {
+          t->files_changed_path_ << matching_filename;
+          qLog(Debug) << matching_filename << "has changed path to" << file;
+        }
+        if (t->deleted_songs.contains(matching_song)) {
+          t->deleted_songs.removeAll(matching_song);
         }
-        else {  // If CUE associated.
-          UpdateCueAssociatedSongs(file, path, fingerprint, new_cue, image, matching_songs, t);
+        if (matching_song.has_cue()) {
+          matching_songs_has_cue = true;
         }
+      }
 
+      if (f->cue.isEmpty() || f->cue_mtime == 0) {  // If no CUE or it's about to lose it.
+        UpdateNonCueAssociatedSong(file, fingerprint, matching_songs, song_on_disk, f->image, matching_songs_has_cue && f->cue_mtime == 0, t);
+      }
+      else {  // If CUE associated.
+        UpdateCueAssociatedSongs(file, path, fingerprint, f->cue, f->image, matching_songs, t);
       }
-      else {  // The song is on disk but not in the DB
 
-        SongList songs = ScanNewFile(file, path, fingerprint, new_cue, &cues_processed);
-        if (songs.isEmpty()) {
-          t->AddToProgress(1);
-          continue;
-        }
+    }
+    else {  // The song is on disk but not in the DB
 
-        qLog(Debug) << file << "is new.";
+      SongList songs = ScanNewFile(file, path, fingerprint, f->cue, song_on_disk, cues_processed);
+      if (songs.isEmpty()) {
+        t->AddToProgress(1);
+        return;
+      }
 
-        // Choose an image for the song(s)
-        QUrl image = ImageForSong(file, album_art);
+      qLog(Debug) << file << "is new.";
 
-        for (Song song : songs) {
-          song.set_directory_id(t->dir());
-          if (song.art_automatic().isEmpty()) song.set_art_automatic(image);
-          t->new_songs << song;
-        }
+      for (Song song : songs) {
+        song.set_directory_id(t->dir());
+        if (song.art_automatic().isEmpty()) song.set_art_automatic(f->image);
+        t->new_songs << song;
       }
     }
-    t->AddToProgress(1);
   }
 
-  // Look for deleted songs
-  for (const Song &song : songs_in_db) {
-    QString file = song.url().toLocalFile();
-    if (!song.is_unavailable() && !files_on_disk.contains(file) && !t->files_changed_path_.contains(file)) {
-      qLog(Debug) << "Song deleted from disk:" << file;
-      t->deleted_songs << song;
-    }
-  }
+  t->AddToProgress(1);
 
-  // Add this subdir to the new or touched list
-  Subdirectory updated_subdir;
-  updated_subdir.directory_id = t->dir();
-  updated_subdir.mtime = path_info.exists() ? path_info.lastModified().toSecsSinceEpoch() : 0;
-  updated_subdir.path = path;
+}
 
-  if (subdir.directory_id == -1) {
-    t->new_subdirs << updated_subdir;
-  }
-  else {
-    t->touched_subdirs << updated_subdir;
-  }
+#ifdef HAVE_SONGFINGERPRINTING
+QString CollectionWatcher::CreateFingerprint(const QString &file) {
 
-  if (updated_subdir.mtime == 0) {  // Subdirectory deleted, mark it for removal from the watcher.
-    t->deleted_subdirs << updated_subdir;
+  QString fingerprint = fingerprint_cache_->Fingerprint(file);
+  if (fingerprint.isEmpty()) {
+    fingerprint = "NONE";
   }
 
-  // Recurse into the new subdirs that we found
-  for (const Subdirectory &my_new_subdir : my_new_subdirs) {
-    if (stop_requested_ || abort_requested_) return;
-    ScanSubdirectory(my_new_subdir.path, my_new_subdir, 0, t, true);
-  }
+  return fingerprint;
 
 }
+#endif
 
 void CollectionWatcher::UpdateCueAssociatedSongs(const QString &file,
                                                  const QString &path,
@@ -755,6 +1032,7 @@ void CollectionWatcher::UpdateCueAssociatedSongs(const QString &file,
 void CollectionWatcher::UpdateNonCueAssociatedSong(const QString &file,
                                                    const QString &fingerprint,
                                                    const SongList &matching_songs,
+                                                   const Song &song_on_disk,
                                                    const QUrl &image,
                                                    const bool cue_deleted,
                                                    ScanTransaction *t) {
@@ -769,21 +1047,20 @@ void CollectionWatcher::UpdateNonCueAssociatedSong(const QString &file,
     }
   }
 
-  Song song_on_disk(source_);
-  TagReaderClient::Instance()->ReadFileBlocking(file, &song_on_disk);
   if (song_on_disk.is_valid()) {
-    song_on_disk.set_source(source_);
-    song_on_disk.set_directory_id(t->dir());
-    song_on_disk.set_id(matching_song.id());
-    song_on_disk.set_fingerprint(fingerprint);
-    if (!song_on_disk.has_embedded_cover()) song_on_disk.set_art_automatic(image);
-    song_on_disk.MergeUserSetData(matching_song, !overwrite_playcount_, !overwrite_rating_);
-    AddChangedSong(file, matching_song, song_on_disk, t);
+    Song song(song_on_disk);
+    song.set_source(source_);
+    song.set_directory_id(t->dir());
+    song.set_id(matching_song.id());
+    song.set_fingerprint(fingerprint);
+    if (!song.has_embedded_cover()) song.set_art_automatic(image);
+    song.MergeUserSetData(matching_song, !overwrite_playcount_, !overwrite_rating_);
+    AddChangedSong(file, matching_song, song, t);
   }
 
 }
 
-SongList CollectionWatcher::ScanNewFile(const QString &file, const QString &path, const QString &fingerprint, const QString &matching_cue, QSet<QString> *cues_processed) {
+SongList CollectionWatcher::ScanNewFile(const QString &file, const QString &path, const QString &fingerprint, const QString &matching_cue, const Song &song_on_disk, QSet<QString> *cues_processed) {
 
   SongList songs;
 
@@ -819,14 +1096,11 @@ SongList CollectionWatcher::ScanNewFile(const QString &file, const QString &path
       *cues_processed << matching_cue;
     }
   }
-  else {  // It's a normal media file
-    Song song(source_);
-    TagReaderClient::Instance()->ReadFileBlocking(file, &song);
-    if (song.is_valid()) {
-      song.set_source(source_);
-      song.set_fingerprint(fingerprint);
-      songs << song;
-    }
+  else if (song_on_disk.is_valid()) {  // It's a normal media file
+    Song song(song_on_disk);
+    song.set_source(source_);
+    song.set_fingerprint(fingerprint);
+    songs << song;
   }
 
   return songs;
@@ -902,6 +1176,8 @@ void CollectionWatcher::AddWatch(const Directory &dir, const QString &path) {
   if (!QFile::exists(path)) return;
 
   QObject::connect(fs_watcher_, &FileSystemWatcherInterface::PathChanged, this, &CollectionWatcher::DirectoryChanged, Qt::UniqueConnection);
+  QObject::connect(fs_watcher_, &FileSystemWatcherInterface::FileChanged, this, &CollectionWatcher::FileChanged, Qt::UniqueConnection);
+  QObject::connect(fs_watcher_, &FileSystemWatcherInterface::Overflow, this, &CollectionWatcher::FileSystemOverflow, Qt::UniqueConnection);
   fs_watcher_->AddPath(path);
   subdir_mapping_[path] = dir;
 
@@ -922,6 +1198,7 @@ void CollectionWatcher::RemoveWatch(const Directory &dir, const Subdirectory &su
 void CollectionWatcher::RemoveDirectory(const Directory &dir) {
 
   rescan_queue_.remove(dir.id);
+  rescan_files_queue_.remove(dir.id);
   watched_dirs_.remove(dir.id);
 
   // Stop watching the directory's subdirectories
@@ -987,13 +1264,116 @@ void CollectionWatcher::DirectoryChanged(const QString &subdir) {
 
   qLog(Debug) << "Subdir" << subdir << "changed under directory" << dir.path << "id" << dir.id;
 
-  // Queue the subdir for rescanning
-  if (!rescan_queue_[dir.id].contains(subdir)) rescan_queue_[dir.id] << subdir;
+  QueueSubdirRescan(dir, subdir);
+
+  if (!rescan_paused_) rescan_timer_->start();
+
+}
+
+void CollectionWatcher::FileChanged(const QString &file) {
+
+  const QString subdir = DirectoryPart(file);
+  QHash<QString, Directory>::const_iterator it = subdir_mapping_.constFind(subdir);
+  if (it == subdir_mapping_.constEnd()) {
+    return;
+  }
+  Directory dir = *it;
+
+  qLog(Debug) << "File" << file << "changed under directory" << dir.path << "id" << dir.id;
+
+  QueueFileRescan(dir, file);
 
   if (!rescan_paused_) rescan_timer_->start();
 
 }
 
+void CollectionWatcher::FileSystemOverflow() {
+
+  // We don't know what changed, so fall back to comparing the mtimes of all subdirectories.
+  qLog(Warning) << "File system changes were lost, rescanning the collection.";
+  IncrementalScanAsync();
+
+}
+
+void CollectionWatcher::QueueSubdirRescan(const Directory &dir, const QString &subdir) {
+
+  // The whole subdir is scanned, so the files queued for it are covered.
+  if (rescan_files_queue_.contains(dir.id)) rescan_files_queue_[dir.id].remove(subdir);
+
+  if (!rescan_queue_[dir.id].contains(subdir)) rescan_queue_[dir.id] << subdir;
+
+}
+
+void CollectionWatcher::QueueFileRescan(const Directory &dir, const QString &file) {
+
+  const QString subdir = DirectoryPart(file);
+  if (rescan_queue_.contains(dir.id) && rescan_queue_[dir.id].contains(subdir)) return;
+
+  QStringList &files = rescan_files_queue_[dir.id][subdir];
+  if (!files.contains(file)) files << file;
+
+}
+
+void CollectionWatcher::RestoreRescanJournal(const Directory &dir) {
+
+  if (rescan_journal_subdirs_.isEmpty() && rescan_journal_files_.isEmpty()) return;
+
+  bool queued = false;
+  const QString prefix = dir.path + QLatin1Char('/');
+
+  for (QStringList::iterator it = rescan_journal_subdirs_.begin(); it != rescan_journal_subdirs_.end();) {
+    if (*it == dir.path || it->startsWith(prefix)) {
+      QueueSubdirRescan(dir, *it);
+      it = rescan_journal_subdirs_.erase(it);
+      queued = true;
+    }
+    else {
+      ++it;
+    }
+  }
+
+  for (QStringList::iterator it = rescan_journal_files_.begin(); it != rescan_journal_files_.end();) {
+    if (it->startsWith(prefix)) {
+      QueueFileRescan(dir, *it);
+      it = rescan_journal_files_.erase(it);
+      queued = true;
+    }
+    else {
+      ++it;
+    }
+  }
+
+  if (queued) {
+    qLog(Debug) << "Rescanning changes recorded before the last exit in" << dir.path;
+    if (!rescan_paused_) rescan_timer_->start();
+  }
+
+}
+
+void CollectionWatcher::SaveRescanJournal() {
+
+  if (source_ != Song::Source_Collection) return;
+
+  QStringList subdirs;
+  for (const QStringList &paths : std::as_const(rescan_queue_)) {
+    subdirs << paths;
+  }
+
+  QStringList files;
+  for (const QMap<QString, QStringList> &dir_files : std::as_const(rescan_files_queue_)) {
+    for (const QStringList &paths : dir_files) {
+      files << paths;
+    }
+  }
+
+  QSettings s;
+  s.beginGroup(CollectionSettingsPage::kSettingsGroup);
+  s.setValue("rescan_journal_subdirs", subdirs);
+  s.setValue("rescan_journal_files", files);
+  s.endGroup();
+
+}
+
 void CollectionWatcher::RescanPathsNow() {
 
   QList<int> dirs = rescan_queue_.keys();
@@ -1020,6 +1400,20 @@ void CollectionWatcher::RescanPathsNow() {
 
   rescan_queue_.clear();
 
+  // Scan only the files that changed in the other subdirs.
+  const QList<int> file_dirs = rescan_files_queue_.keys();
+  for (const int dir : file_dirs) {
+    if (stop_requested_ || abort_requested_) break;
+    ScanTransaction transaction(this, dir, false, false, mark_songs_unavailable_);
+    const QMap<QString, QStringList> &subdirs = rescan_files_queue_[dir];
+    for (QMap<QString, QStringList>::const_iterator it = subdirs.constBegin(); it != subdirs.constEnd(); ++it) {
+      if (stop_requested_ || abort_requested_) break;
+      ScanFiles(it.key(), it.value(), &transaction);
+    }
+  }
+
+  rescan_files_queue_.clear();
+
   emit CompilationsNeedUpdating();
 
 }
@@ -1097,7 +1491,7 @@ void CollectionWatcher::SetRescanPausedAsync(bool pause) {
 void CollectionWatcher::SetRescanPaused(bool pause) {
 
   rescan_paused_ = pause;
-  if (!rescan_paused_ && !rescan_queue_.isEmpty()) RescanPathsNow();
+  if (!rescan_paused_ && (!rescan_queue_.isEmpty() || !rescan_files_queue_.isEmpty())) RescanPathsNow();
 
 }
 
@@ -1113,6 +1507,12 @@ void CollectionWatcher::FullScanAsync() {
 
 }
 
+void CollectionWatcher::FingerprintMissingAsync() {
+
+  QMetaObject::invokeMethod(this, "FingerprintMissingNow", Qt::QueuedConnection);
+
+}
+
 void CollectionWatcher::RescanTracksAsync(const SongList &songs) {
 
   // Is List thread safe? if not, this may crash.
@@ -1171,6 +1571,12 @@ void CollectionWatcher::PerformScan(const bool incremental, const bool ignore_mt
 
   stop_requested_ = false;
 
+#ifdef HAVE_SONGFINGERPRINTING
+  QElapsedTimer timer;
+  timer.start();
+  fingerprint_cache_->ResetCounters();
+#endif
+
   for (const Directory &dir : std::as_const(watched_dirs_)) {
 
     if (stop_requested_ || abort_requested_) break;
@@ -1201,8 +1607,97 @@ void CollectionWatcher::PerformScan(const bool incremental, const bool ignore_mt
 
   emit CompilationsNeedUpdating();
 
+#ifdef HAVE_SONGFINGERPRINTING
+  if (song_tracking_) {
+    ReportFingerprintStatistics(timer.elapsed());
+    // Incremental scans skip songs that are only missing a fingerprint.
+    if (incremental && !stop_requested_ && !abort_requested_) {
+      FingerprintMissingAsync();
+    }
+  }
+  // Only after a full scan, and not while a collection directory is unavailable, since the files might come back.
+  if (!incremental && !stop_requested_ && !abort_requested_ && std::all_of(watched_dirs_.begin(), watched_dirs_.end(), [](const Directory &dir) { return QFileInfo::exists(dir.path); })) {
+    fingerprint_cache_->Prune();
+  }
+#endif
+
 }
 
+void CollectionWatcher::FingerprintMissingNow() {
+
+#ifdef HAVE_SONGFINGERPRINTING
+
+  if (!song_tracking_) return;
+
+  stop_requested_ = false;
+
+  QElapsedTimer timer;
+  timer.start();
+  fingerprint_cache_->ResetCounters();
+
+  for (const Directory &dir : std::as_const(watched_dirs_)) {
+
+    if (stop_requested_ || abort_requested_) break;
+
+    const SongList songs = backend_->SongsWithMissingFingerprint(dir.id);
+    if (songs.isEmpty()) continue;
+
+    ScanTransaction transaction(this, dir.id, false, false, mark_songs_unavailable_);
+    transaction.AddToProgressMax(songs.count());
+
+    // Songs from a CUE sheet share the media file, so fingerprint each file once.
+    QStringList files;
+    QHash<QString, SongList> songs_by_file;
+    for (const Song &song : songs) {
+      const QString file = song.url().toLocalFile();
+      if (!songs_by_file.contains(file)) files << file;
+      songs_by_file[file] << song;
+    }
+
+    // Fingerprint the files in batches in a separate pool, since this only fills in fingerprints and its threads run at idle priority.
+    for (int i = 0; i < files.count() && !stop_requested_ && !abort_requested_; i += kScanCommitBatchSize) {
+      const QStringList batch = files.mid(i, kScanCommitBatchSize);
+      QList<QFuture<QString>> futures;
+      futures.reserve(batch.count());
+      for (const QString &file : batch) {
+        futures << QtConcurrent::run(fingerprint_backfill_pool_, [this, file]() {
+          if (!QFile::exists(file)) return QString();
+          QThread::currentThread()->setPriority(QThread::IdlePriority);
+          return CreateFingerprint(file);
+        });
+      }
+      for (int j = 0; j < batch.count(); ++j) {
+        futures[j].waitForFinished();
+        const QString fingerprint = futures[j].result();
+        for (Song song : songs_by_file[batch[j]]) {
+          if (!fingerprint.isEmpty()) {
+            song.set_fingerprint(fingerprint);
+            transaction.new_songs << song;
+          }
+          transaction.AddToProgress(1);
+        }
+      }
+      transaction.CommitScannedSongs();
+    }
+
+  }
+
+  ReportFingerprintStatistics(timer.elapsed());
+
+#endif
+
+}
+
+#ifdef HAVE_SONGFINGERPRINTING
+void CollectionWatcher::ReportFingerprintStatistics(const qint64 elapsed_msec) {
+
+  const int files = fingerprint_cache_->fingerprinted();
+  const double files_per_sec = elapsed_msec > 0 ? files * 1000.0 / static_cast<double>(elapsed_msec) : 0.0;
+  qLog(Debug) << "Fingerprint cache:" << fingerprint_cache_->hits() << "hits," << fingerprint_cache_->misses() << "misses," << files << "files fingerprinted in" << elapsed_msec << "ms" << "(" << files_per_sec << "files/s, decode time" << fingerprint_cache_->fingerprint_msec() << "ms).";
+
+}
+#endif
+
 quint64 CollectionWatcher::FilesCountForPath(ScanTransaction *t, const QString &path) {
 
   quint64 i = 0;
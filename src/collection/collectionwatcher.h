@@ -24,9 +24,12 @@
 
 #include "config.h"
 
+#include <memory>
+
 #include <QtGlobal>
 #include <QObject>
 #include <QHash>
+#include <QList>
 #include <QMap>
 #include <QMultiMap>
 #include <QSet>
@@ -38,27 +41,32 @@
 #include "core/song.h"
 
 class QThread;
+class QThreadPool;
 class QTimer;
 
 class CollectionBackend;
 class FileSystemWatcherInterface;
 class TaskManager;
 class CueParser;
+class FingerprintCache;
 
 class CollectionWatcher : public QObject {
   Q_OBJECT
 
  public:
   explicit CollectionWatcher(Song::Source source, QObject *parent = nullptr);
+  ~CollectionWatcher() override;
 
   Song::Source source() { return source_; }
 
-  void set_backend(CollectionBackend *backend) { backend_ = backend; }
+  void set_backend(CollectionBackend *backend);
   void set_task_manager(TaskManager *task_manager) { task_manager_ = task_manager; }
   void set_device_name(const QString &device_name) { device_name_ = device_name; }
 
   void IncrementalScanAsync();
   void FullScanAsync();
+  // Creates the fingerprints of songs that don't have one yet, at idle priority.  Only used with song tracking.
+  void FingerprintMissingAsync();
   void RescanTracksAsync(const SongList &songs);
   void SetRescanPausedAsync(const bool pause);
   void ReloadSettingsAsync();
@@ -100,7 +108,6 @@ class CollectionWatcher : public QObject {
     ~ScanTransaction();
 
     SongList FindSongsInSubdirectory(const QString &path);
-    bool HasSongsWithMissingFingerprint(const QString &path);
     bool HasSeenSubdir(const QString &path);
     void SetKnownSubdirs(const SubdirectoryList &subdirs);
     SubdirectoryList GetImmediateSubdirs(const QString &path);
@@ -111,6 +118,10 @@ class CollectionWatcher : public QObject {
 
     // Emits the signals for new & deleted songs etc and clears the lists. This causes the new stuff to be updated on UI.
     void CommitNewOrUpdatedSongs();
+    // Emits the new, touched and readded songs found so far, so the backend can write them while the scan continues.
+    // Deleted songs and subdirectories are left for CommitNewOrUpdatedSongs(), since a file scanned later can still claim a deleted song by fingerprint.
+    void CommitScannedSongs();
+    int scanned_songs_count() const { return new_songs.count() + touched_songs.count() + readded_songs.count(); }
 
     int dir() const { return dir_; }
     bool is_incremental() const { return incremental_; }
@@ -152,9 +163,6 @@ class CollectionWatcher : public QObject {
     QMultiMap<QString, Song> cached_songs_;
     bool cached_songs_dirty_;
 
-    QMultiMap<QString, Song> cached_songs_missing_fingerprint_;
-    bool cached_songs_missing_fingerprint_dirty_;
-
     SubdirectoryList known_subdirs_;
     bool known_subdirs_dirty_;
   };
@@ -163,14 +171,34 @@ class CollectionWatcher : public QObject {
   void ReloadSettings();
   void Exit();
   void DirectoryChanged(const QString &subdir);
+  void FileChanged(const QString &file);
+  void FileSystemOverflow();
   void IncrementalScanCheck();
   void IncrementalScanNow();
   void FullScanNow();
+  void FingerprintMissingNow();
   void RescanTracksNow();
   void RescanPathsNow();
   void ScanSubdirectory(const QString &path, const Subdirectory &subdir, const quint64 files_count, CollectionWatcher::ScanTransaction *t, const bool force_noincremental = false);
+  // Scans only the given files in the subdirectory at path, for file system listeners that report which files changed.
+  void ScanFiles(const QString &path, const QStringList &files, CollectionWatcher::ScanTransaction *t);
 
  private:
+  // A media file on its way through ScanSubdirectory().
+  // The fingerprint is started when the file is queued, the tag read is batched with the other files in the directory by ReadScanFiles().
+  struct ScanFile;
+  class ReadFilesBatch;
+
+  ScanFile QueueScanFile(const QString &file, const SongList &songs_in_db, QMap<QString, QStringList> &album_art, ScanTransaction *t);
+  void ReadScanFiles(QList<ScanFile> *scan_files);
+  void FinishScanFile(ScanFile *f, QString *fingerprint, Song *song_on_disk);
+  void ProcessScanFile(ScanFile *f, const QString &path, QStringList *files_on_disk, QSet<QString> *cues_processed, ScanTransaction *t);
+#ifdef HAVE_SONGFINGERPRINTING
+  QString CreateFingerprint(const QString &file);
+  // Logs the fingerprint cache hits and misses, and the fingerprinting throughput.
+  void ReportFingerprintStatistics(const qint64 elapsed_msec);
+#endif
+
   static bool FindSongsByPath(const SongList &songs, const QString &path, SongList *out);
   bool FindSongsByFingerprint(const QString &file, const QString &fingerprint, SongList *out);
   static bool FindSongsByFingerprint(const QString &file, const SongList &songs, const QString &fingerprint, SongList *out);
@@ -180,6 +208,11 @@ class CollectionWatcher : public QObject {
   QString PickBestImage(const QStringList &images);
   QUrl ImageForSong(const QString &path, QMap<QString, QStringList> &album_art);
   void AddWatch(const Directory &dir, const QString &path);
+  void QueueSubdirRescan(const Directory &dir, const QString &subdir);
+  void QueueFileRescan(const Directory &dir, const QString &file);
+  // The rescan queues are saved on exit and queued again when the directory is added, so changes recorded before an exit are not lost.
+  void RestoreRescanJournal(const Directory &dir);
+  void SaveRescanJournal();
   void RemoveWatch(const Directory &dir, const Subdirectory &subdir);
   static quint64 GetMtimeForCue(const QString &cue_path);
   void PerformScan(const bool incremental, const bool ignore_mtimes);
@@ -187,10 +220,10 @@ class CollectionWatcher : public QObject {
   // Updates the sections of a cue associated and altered (according to mtime) media file during a scan.
   void UpdateCueAssociatedSongs(const QString &file, const QString &path, const QString &fingerprint, const QString &matching_cue, const QUrl &image, const SongList &old_cue_songs, ScanTransaction *t);
   // Updates a single non-cue associated and altered (according to mtime) song during a scan.
-  void UpdateNonCueAssociatedSong(const QString &file, const QString &fingerprint, const SongList &matching_songs, const QUrl &image, const bool cue_deleted, ScanTransaction *t);
+  void UpdateNonCueAssociatedSong(const QString &file, const QString &fingerprint, const SongList &matching_songs, const Song &song_on_disk, const QUrl &image, const bool cue_deleted, ScanTransaction *t);
   // Scans a single media file that's present on the disk but not yet in the collection.
   // It may result in a multiple files added to the collection when the media file has many sections (like a CUE related media file).
-  SongList ScanNewFile(const QString &file, const QString &path, const QString &fingerprint, const QString &matching_cue, QSet<QString> *cues_processed);
+  SongList ScanNewFile(const QString &file, const QString &path, const QString &fingerprint, const QString &matching_cue, const Song &song_on_disk, QSet<QString> *cues_processed);
 
   static void AddChangedSong(const QString &file, const Song &matching_song, const Song &new_song, ScanTransaction *t);
 
@@ -200,6 +233,10 @@ class CollectionWatcher : public QObject {
   QString FindCueFilename(const QString &filename);
 
  private:
+  static const int kMaxScanJobs;
+  static const int kScanCommitBatchSize;
+  static const int kReadFilesBatchSize;
+
   Song::Source source_;
   CollectionBackend *backend_;
   TaskManager *task_manager_;
@@ -220,6 +257,7 @@ class CollectionWatcher : public QObject {
   int expire_unavailable_songs_days_;
   bool overwrite_playcount_;
   bool overwrite_rating_;
+  int scan_jobs_;  // Number of tagreader requests and fingerprints in flight during a scan.
 
   bool stop_requested_;
   bool abort_requested_;
@@ -229,11 +267,19 @@ class CollectionWatcher : public QObject {
   QTimer *rescan_timer_;
   QTimer *periodic_scan_timer_;
   QMap<int, QStringList> rescan_queue_;  // dir id -> list of subdirs to be scanned
+  QMap<int, QMap<QString, QStringList>> rescan_files_queue_;  // dir id -> subdir -> list of changed files to be scanned
+  QStringList rescan_journal_subdirs_;
+  QStringList rescan_journal_files_;
   bool rescan_paused_;
 
   int total_watches_;
 
   CueParser *cue_parser_;
+  QThreadPool *fingerprint_pool_;
+  QThreadPool *fingerprint_backfill_pool_;
+#ifdef HAVE_SONGFINGERPRINTING
+  std::unique_ptr<FingerprintCache> fingerprint_cache_;
+#endif
 
   static QStringList sValidImages;
 
@@ -0,0 +1,218 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <utility>
+
+#include <QtGlobal>
+
+#ifndef Q_OS_WIN32
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#endif
+
+#include <QMutexLocker>
+#include <QList>
+#include <QFile>
+#include <QFileInfo>
+#include <QByteArray>
+#include <QString>
+#include <QCryptographicHash>
+#include <QSqlDatabase>
+
+#include "core/logging.h"
+#include "core/database.h"
+#include "core/scopedtransaction.h"
+#include "core/sqlquery.h"
+#include "fingerprintcache.h"
+
+const qint64 FingerprintCache::kAudioHashBlockSize = 64 * 1024;
+const qint64 FingerprintCache::kAudioHashTailSkip = 64 * 1024;
+
+FingerprintCache::FingerprintCache(Database *db) : db_(db), hits_(0), misses_(0) {}
+
+void FingerprintCache::ResetCounters() {
+
+  hits_ = 0;
+  misses_ = 0;
+  chromaprinter_pool_.ResetCounters();
+
+}
+
+QString FingerprintCache::Fingerprint(const QString &filename) {
+
+  FileIdentity identity;
+  const bool have_identity = GetFileIdentity(filename, &identity);
+
+  if (have_identity) {
+    QString cached_filename;
+    const QString fingerprint = Lookup(identity, &cached_filename);
+    if (!fingerprint.isEmpty()) {
+      ++hits_;
+      // Point the entry at the file's current location, so it isn't pruned after the file was moved.
+      if (cached_filename != identity.filename) {
+        Store(identity, fingerprint);
+      }
+      return fingerprint;
+    }
+  }
+
+  ++misses_;
+
+  const QString fingerprint = chromaprinter_pool_.CreateFingerprint(filename);
+
+  // Failures are not stored, they can be caused by a missing GStreamer plugin.
+  if (have_identity && !fingerprint.isEmpty()) {
+    Store(identity, fingerprint);
+  }
+
+  return fingerprint;
+
+}
+
+bool FingerprintCache::GetFileIdentity(const QString &filename, FileIdentity *identity) {
+
+  identity->filename = filename;
+
+#ifndef Q_OS_WIN32
+  struct stat st {};
+  if (stat(QFile::encodeName(filename).constData(), &st) != 0) return false;
+  identity->device = static_cast<quint64>(st.st_dev);
+  identity->inode = static_cast<quint64>(st.st_ino);
+  identity->size = static_cast<qint64>(st.st_size);
+#else
+  identity->size = QFileInfo(filename).size();
+#endif
+
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly)) return false;
+
+  // Tags are mostly stored at the start of the file, so hash a block near the end, which only contains audio frames.
+  // Small files are hashed whole.
+  qint64 end = file.size();
+  if (end > kAudioHashBlockSize + kAudioHashTailSkip) end -= kAudioHashTailSkip;
+  const qint64 start = qMax(static_cast<qint64>(0), end - kAudioHashBlockSize);
+  if (!file.seek(start)) return false;
+  const QByteArray data = file.read(end - start);
+  file.close();
+  if (data.isEmpty()) return false;
+
+  identity->audio_hash = QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex();
+
+  return true;
+
+}
+
+QString FingerprintCache::Lookup(const FileIdentity &identity, QString *cached_filename) {
+
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
+
+  // The audio hash only covers one block, so the size must match too, except for the same file, which can change size when the tags are edited.
+  // Prefer the entry for the same file, but any file with the same audio has the same fingerprint.
+  SqlQuery q(db);
+  q.prepare("SELECT filename, fingerprint FROM fingerprint_cache WHERE audio_hash = :audio_hash AND (filesize = :filesize OR (inode != 0 AND device = :file_device AND inode = :file_inode)) ORDER BY (device = :device AND inode = :inode AND filesize = :same_filesize) DESC LIMIT 1");
+  q.BindStringValue(":audio_hash", QString::fromLatin1(identity.audio_hash));
+  q.BindLongLongValueOrZero(":filesize", identity.size);
+  q.BindLongLongValueOrZero(":file_device", static_cast<qint64>(identity.device));
+  q.BindLongLongValueOrZero(":file_inode", static_cast<qint64>(identity.inode));
+  q.BindLongLongValueOrZero(":device", static_cast<qint64>(identity.device));
+  q.BindLongLongValueOrZero(":inode", static_cast<qint64>(identity.inode));
+  q.BindLongLongValueOrZero(":same_filesize", identity.size);
+  if (!q.Exec()) {
+    db_->ReportErrors(q);
+    return QString();
+  }
+
+  if (!q.next()) return QString();
+
+  *cached_filename = q.value(0).toString();
+
+  return q.value(1).toString();
+
+}
+
+void FingerprintCache::Store(const FileIdentity &identity, const QString &fingerprint) {
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  // Remove the old entry if the audio of the file changed.
+  if (identity.inode != 0) {
+    SqlQuery q(db);
+    q.prepare("DELETE FROM fingerprint_cache WHERE device = :device AND inode = :inode");
+    q.BindLongLongValueOrZero(":device", static_cast<qint64>(identity.device));
+    q.BindLongLongValueOrZero(":inode", static_cast<qint64>(identity.inode));
+    if (!q.Exec()) {
+      db_->ReportErrors(q);
+      return;
+    }
+  }
+
+  // Replaces the entry of another file with the same audio hash and size.
+  SqlQuery q(db);
+  q.prepare("INSERT OR REPLACE INTO fingerprint_cache (filename, device, inode, filesize, audio_hash, fingerprint) VALUES (:filename, :device, :inode, :filesize, :audio_hash, :fingerprint)");
+  q.BindStringValue(":filename", identity.filename);
+  q.BindLongLongValueOrZero(":device", static_cast<qint64>(identity.device));
+  q.BindLongLongValueOrZero(":inode", static_cast<qint64>(identity.inode));
+  q.BindLongLongValueOrZero(":filesize", identity.size);
+  q.BindStringValue(":audio_hash", QString::fromLatin1(identity.audio_hash));
+  q.BindStringValue(":fingerprint", fingerprint);
+  if (!q.Exec()) {
+    db_->ReportErrors(q);
+  }
+
+}
+
+void FingerprintCache::Prune() {
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  QList<qint64> rowids;
+  {
+    SqlQuery q(db);
+    q.prepare("SELECT ROWID, filename FROM fingerprint_cache");
+    if (!q.Exec()) {
+      db_->ReportErrors(q);
+      return;
+    }
+    while (q.next()) {
+      if (!QFile::exists(q.value(1).toString())) rowids << q.value(0).toLongLong();
+    }
+  }
+
+  if (rowids.isEmpty()) return;
+
+  ScopedTransaction t(&db);
+  for (const qint64 rowid : std::as_const(rowids)) {
+    SqlQuery q(db);
+    q.prepare("DELETE FROM fingerprint_cache WHERE ROWID = :rowid");
+    q.BindValue(":rowid", rowid);
+    if (!q.Exec()) {
+      db_->ReportErrors(q);
+      return;
+    }
+  }
+  t.Commit();
+
+  qLog(Debug) << "Removed" << rowids.count() << "fingerprints of files that no longer exist from the fingerprint cache.";
+
+}
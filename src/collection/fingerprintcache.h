@@ -0,0 +1,82 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FINGERPRINTCACHE_H
+#define FINGERPRINTCACHE_H
+
+#include "config.h"
+
+#include <atomic>
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QString>
+
+#include "engine/chromaprinter.h"
+
+class Database;
+
+// Stores Chromaprint fingerprints in the fingerprint_cache table, keyed by a hash of a block of audio frames near the end of the file and the file size.
+// An entry for the same file (device and inode) also matches when the size changed, so editing the tags or moving the file
+// reuses the stored fingerprint instead of decoding the file again.
+// Fingerprint() is thread-safe and can be called from the collection watcher's fingerprint pool.
+class FingerprintCache {
+ public:
+  explicit FingerprintCache(Database *db);
+
+  // Returns the fingerprint for the file, creating it with a pooled Chromaprinter on a cache miss.
+  // Returns an empty string if no fingerprint could be created.
+  QString Fingerprint(const QString &filename);
+
+  int hits() const { return hits_; }
+  int misses() const { return misses_; }
+  // Files fingerprinted since the counters were reset, and the decode time summed over all threads.
+  int fingerprinted() const { return chromaprinter_pool_.files(); }
+  qint64 fingerprint_msec() const { return chromaprinter_pool_.total_msec(); }
+  void ResetCounters();
+
+  // Removes the fingerprints of files that no longer exist.
+  void Prune();
+
+ private:
+  struct FileIdentity {
+    FileIdentity() : device(0), inode(0), size(0) {}
+    QString filename;
+    quint64 device;
+    quint64 inode;
+    qint64 size;
+    QByteArray audio_hash;
+  };
+
+  static bool GetFileIdentity(const QString &filename, FileIdentity *identity);
+  QString Lookup(const FileIdentity &identity, QString *cached_filename);
+  void Store(const FileIdentity &identity, const QString &fingerprint);
+
+ private:
+  // Size of the block that is hashed, and how far from the end of the file it ends, to skip tags stored at the end.
+  static const qint64 kAudioHashBlockSize;
+  static const qint64 kAudioHashTailSkip;
+
+  Database *db_;
+  ChromaprinterPool chromaprinter_pool_;
+  std::atomic<int> hits_;
+  std::atomic<int> misses_;
+};
+
+#endif  // FINGERPRINTCACHE_H
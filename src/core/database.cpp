@@ -48,7 +48,7 @@
 #include "scopedtransaction.h"
 
 const char *Database::kDatabaseFilename = "strawberry.db";
-const int Database::kSchemaVersion = 15;
+const int Database::kSchemaVersion = 19;
 const int Database::kMinSupportedSchemaVersion = 10;
 const char *Database::kMagicAllSongsTables = "%allsongstables";
 
@@ -64,6 +64,7 @@ Database::Database(Application *app, QObject *parent, const QString &database_na
       injected_database_name_(database_name),
       query_hash_(0),
       startup_schema_version_(-1),
+      wal_enabled_(false),
       original_thread_(nullptr) {
 
   original_thread_ = thread();
@@ -114,7 +115,7 @@ QSqlDatabase Database::Connect() {
     }
   }
 
-  const QString connection_id = QString("%1_thread_%2").arg(connection_id_).arg(reinterpret_cast<quint64>(QThread::currentThread()));
+  const QString connection_id = ConnectionId(false);
 
   // Try to find an existing connection for this thread
   QSqlDatabase db;
@@ -130,12 +131,7 @@ QSqlDatabase Database::Connect() {
   db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=30000");
   //qLog(Debug) << "Opened database with connection id" << connection_id;
 
-  if (injected_database_name_.isNull()) {
-    db.setDatabaseName(directory_ + "/" + kDatabaseFilename);
-  }
-  else {
-    db.setDatabaseName(injected_database_name_);
-  }
+  db.setDatabaseName(DatabaseFilename());
 
   if (!db.open()) {
     app_->AddError("Database: " + db.lastError().text());
@@ -152,29 +148,15 @@ QSqlDatabase Database::Connect() {
     qFatal("Database schema too old.");
   }
 
-  // Attach external databases
-  QStringList keys = attached_databases_.keys();
-  for (const QString &key : keys) {
-    QString filename = attached_databases_[key].filename_;
-
-    if (!injected_database_name_.isNull()) filename = injected_database_name_;
-
-    // Attach the db
-    SqlQuery q(db);
-    q.prepare("ATTACH DATABASE :filename AS :alias");
-    q.BindValue(":filename", filename);
-    q.BindValue(":alias", key);
-    if (!q.Exec()) {
-      qFatal("Couldn't attach external database '%s'", key.toLatin1().constData());
-    }
-  }
+  AttachDatabases(db);
 
   if (startup_schema_version_ == -1) {
     UpdateMainSchema(&db);
+    wal_enabled_ = EnableWAL(db);
   }
 
   // We might have to initialize the schema in some attached databases now, if they were deleted and don't match up with the main schema version.
-  keys = attached_databases_.keys();
+  const QStringList keys = attached_databases_.keys();
   for (const QString &key : keys) {
     if (attached_databases_[key].is_temporary_ && attached_databases_[key].schema_.isEmpty()) {
       continue;
@@ -192,26 +174,127 @@ QSqlDatabase Database::Connect() {
 
 }
 
-void Database::Close() {
+QSqlDatabase Database::ConnectReadOnly() {
+
+  // wal_enabled_ is only written by the first connection made from the constructor.
+  if (!wal_enabled_) return Connect();
 
   QMutexLocker l(&connect_mutex_);
 
-  const QString connection_id = QString("%1_thread_%2").arg(connection_id_).arg(reinterpret_cast<quint64>(QThread::currentThread()));
+  const QString connection_id = ConnectionId(true);
 
-  // Try to find an existing connection for this thread
+  // Try to find an existing read-only connection for this thread
+  QSqlDatabase db;
   if (QSqlDatabase::connectionNames().contains(connection_id)) {
-    {
-      QSqlDatabase db = QSqlDatabase::database(connection_id);
-      if (db.isOpen()) {
-        db.close();
-        //qLog(Debug) << "Closed database with connection id" << connection_id;
+    db = QSqlDatabase::database(connection_id);
+  }
+  else {
+    db = QSqlDatabase::addDatabase("QSQLITE", connection_id);
+  }
+  if (db.isOpen()) {
+    return db;
+  }
+
+  // The schema was already set up by the writer connection, so all we need to do here is open the file and attach the external databases.
+  db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=30000");
+  db.setDatabaseName(DatabaseFilename());
+
+  if (!db.open()) {
+    app_->AddError("Database: " + db.lastError().text());
+    return db;
+  }
+
+  AttachDatabases(db);
+
+  return db;
+
+}
+
+void Database::Close() {
+
+  QMutexLocker l(&connect_mutex_);
+
+  // Close both the writer and the read-only connection for this thread
+  for (const bool read_only : { false, true }) {
+    const QString connection_id = ConnectionId(read_only);
+    if (QSqlDatabase::connectionNames().contains(connection_id)) {
+      {
+        QSqlDatabase db = QSqlDatabase::database(connection_id);
+        if (db.isOpen()) {
+          db.close();
+          //qLog(Debug) << "Closed database with connection id" << connection_id;
+        }
       }
+      QSqlDatabase::removeDatabase(connection_id);
+    }
+  }
+
+}
+
+QString Database::ConnectionId(const bool read_only) const {
+
+  QString connection_id = QString("%1_thread_%2").arg(connection_id_).arg(reinterpret_cast<quint64>(QThread::currentThread()));
+  if (read_only) connection_id.append("_ro");
+
+  return connection_id;
+
+}
+
+QString Database::DatabaseFilename() const {
+
+  if (injected_database_name_.isNull()) {
+    return directory_ + "/" + kDatabaseFilename;
+  }
+
+  return injected_database_name_;
+
+}
+
+void Database::AttachDatabases(QSqlDatabase &db) {
+
+  // Attach external databases
+  const QStringList keys = attached_databases_.keys();
+  for (const QString &key : keys) {
+    QString filename = attached_databases_[key].filename_;
+
+    if (!injected_database_name_.isNull()) filename = injected_database_name_;
+
+    // Attach the db
+    SqlQuery q(db);
+    q.prepare("ATTACH DATABASE :filename AS :alias");
+    q.BindValue(":filename", filename);
+    q.BindValue(":alias", key);
+    if (!q.Exec()) {
+      qFatal("Couldn't attach external database '%s'", key.toLatin1().constData());
     }
-    QSqlDatabase::removeDatabase(connection_id);
   }
 
 }
 
+bool Database::EnableWAL(QSqlDatabase &db) {
+
+  // An in-memory database is private to its connection, so there is nothing to share with readers.
+  if (db.databaseName() == ":memory:") return false;
+
+  // The journal mode is persistent, so this only rewrites the header the first time.
+  SqlQuery q(db);
+  q.prepare("PRAGMA journal_mode = WAL");
+  if (!q.Exec()) {
+    ReportErrors(q);
+    return false;
+  }
+
+  if (!q.next() || q.value(0).toString().compare("wal", Qt::CaseInsensitive) != 0) {
+    qLog(Warning) << "Could not switch database to WAL mode, readers will share the writer connection";
+    return false;
+  }
+
+  qLog(Debug) << "Database is in WAL mode, using read-only connections for queries";
+
+  return true;
+
+}
+
 int Database::SchemaVersion(QSqlDatabase *db) {
 
   // Get the database's schema version
@@ -67,15 +67,21 @@ class Database : public QObject {
 
   void ExitAsync();
   QSqlDatabase Connect();
+  QSqlDatabase ConnectReadOnly();
   void Close();
   void ReportErrors(const SqlQuery &query);
 
+  // Readers only need to hold the mutex when they share the writer connection, in WAL mode they get their own read-only connection.
 #if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
   QRecursiveMutex *Mutex() { return &mutex_; }
+  QRecursiveMutex *ReadMutex() { return wal_enabled_ ? nullptr : &mutex_; }
 #else
   QMutex *Mutex() { return &mutex_; }
+  QMutex *ReadMutex() { return wal_enabled_ ? nullptr : &mutex_; }
 #endif
 
+  bool wal_enabled() const { return wal_enabled_; }
+
   void RecreateAttachedDb(const QString &database_name);
   void ExecSchemaCommands(QSqlDatabase &db, const QString &schema, int schema_version, bool in_transaction = false);
 
@@ -99,6 +105,10 @@ class Database : public QObject {
 
  private:
   static int SchemaVersion(QSqlDatabase *db);
+  bool EnableWAL(QSqlDatabase &db);
+  QString ConnectionId(const bool read_only) const;
+  QString DatabaseFilename() const;
+  void AttachDatabases(QSqlDatabase &db);
   void UpdateMainSchema(QSqlDatabase *db);
 
   void ExecSchemaCommandsFromFile(QSqlDatabase &db, const QString &filename, int schema_version, bool in_transaction = false);
@@ -139,6 +149,9 @@ class Database : public QObject {
   // This is the schema version of Strawberry's DB from the app's last run.
   int startup_schema_version_;
 
+  // Set once by the first connection, readers then use separate read-only connections.
+  bool wal_enabled_;
+
   QThread *original_thread_;
 
 };
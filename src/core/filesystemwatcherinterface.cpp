@@ -28,14 +28,19 @@
 #ifdef Q_OS_MACOS
 #  include "macfslistener.h"
 #endif
+#ifdef Q_OS_LINUX
+#  include "inotifyfslistener.h"
+#endif
 
 FileSystemWatcherInterface::FileSystemWatcherInterface(QObject *parent)
     : QObject(parent) {}
 
 FileSystemWatcherInterface *FileSystemWatcherInterface::Create(QObject *parent) {
 
-#ifdef Q_OS_MACOS
+#if defined(Q_OS_MACOS)
   FileSystemWatcherInterface *ret = new MacFSListener(parent);
+#elif defined(Q_OS_LINUX)
+  FileSystemWatcherInterface *ret = new InotifyFSListener(parent);
 #else
   FileSystemWatcherInterface *ret = new QtFSListener(parent);
 #endif
@@ -40,7 +40,12 @@ class FileSystemWatcherInterface : public QObject {
   static FileSystemWatcherInterface *Create(QObject *parent = nullptr);
 
  signals:
+  // The directory at path changed and needs to be scanned.
   void PathChanged(QString path);
+  // The file at path in a watched directory was written, created, moved or deleted.  Only emitted by listeners that can tell which file changed.
+  void FileChanged(QString path);
+  // Changes were lost, the watched directories need to be scanned again.
+  void Overflow();
 };
 
 #endif
@@ -0,0 +1,152 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+#include <QObject>
+#include <QSocketNotifier>
+#include <QFile>
+#include <QByteArray>
+#include <QString>
+
+#include "core/logging.h"
+#include "inotifyfslistener.h"
+
+namespace {
+constexpr uint32_t kWatchMask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+constexpr int kReadBufferSize = 64 * 1024;
+}  // namespace
+
+InotifyFSListener::InotifyFSListener(QObject *parent)
+    : FileSystemWatcherInterface(parent),
+      fd_(-1),
+      notifier_(nullptr),
+      watch_limit_reached_(false) {}
+
+InotifyFSListener::~InotifyFSListener() {
+
+  if (fd_ != -1) close(fd_);
+
+}
+
+void InotifyFSListener::Init() {
+
+  fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd_ == -1) {
+    qLog(Error) << "Could not initialize inotify:" << strerror(errno);
+    return;
+  }
+
+  notifier_ = new QSocketNotifier(fd_, QSocketNotifier::Read, this);
+  QObject::connect(notifier_, &QSocketNotifier::activated, this, &InotifyFSListener::ReadEvents);
+
+}
+
+void InotifyFSListener::AddPath(const QString &path) {
+
+  if (fd_ == -1 || watches_.contains(path)) return;
+
+  const int wd = inotify_add_watch(fd_, QFile::encodeName(path).constData(), kWatchMask);
+  if (wd == -1) {
+    if (errno == ENOSPC) {
+      if (!watch_limit_reached_) {
+        qLog(Warning) << "The inotify watch limit is reached, some directories will not be monitored for changes. Increase fs.inotify.max_user_watches to monitor all of them.";
+        watch_limit_reached_ = true;
+      }
+    }
+    else {
+      qLog(Error) << "Could not watch" << path << ":" << strerror(errno);
+    }
+    return;
+  }
+
+  // Hard links to directories are not possible, but two paths can still resolve to the same watch through symlinks.
+  if (paths_.contains(wd)) watches_.remove(paths_[wd]);
+  paths_.insert(wd, path);
+  watches_.insert(path, wd);
+
+}
+
+void InotifyFSListener::RemovePath(const QString &path) {
+
+  if (!watches_.contains(path)) return;
+
+  const int wd = watches_.take(path);
+  paths_.remove(wd);
+  inotify_rm_watch(fd_, wd);
+
+}
+
+void InotifyFSListener::Clear() {
+
+  for (QHash<int, QString>::const_iterator it = paths_.constBegin(); it != paths_.constEnd(); ++it) {
+    inotify_rm_watch(fd_, it.key());
+  }
+  paths_.clear();
+  watches_.clear();
+  watch_limit_reached_ = false;
+
+}
+
+void InotifyFSListener::ReadEvents() {
+
+  QByteArray buffer(kReadBufferSize, Qt::Uninitialized);
+
+  forever {
+    const ssize_t len = read(fd_, buffer.data(), static_cast<size_t>(buffer.size()));
+    if (len <= 0) break;
+
+    for (ssize_t i = 0; i < len;) {
+      const inotify_event *event = reinterpret_cast<const inotify_event*>(buffer.constData() + i);
+      i += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        qLog(Warning) << "The inotify event queue overflowed, changes were lost.";
+        emit Overflow();
+        continue;
+      }
+
+      if (!paths_.contains(event->wd)) continue;
+      const QString path = paths_[event->wd];
+
+      if (event->mask & IN_IGNORED) {
+        // The directory was deleted or unmounted.
+        paths_.remove(event->wd);
+        watches_.remove(path);
+        continue;
+      }
+
+      if (event->len == 0) continue;
+
+      if (event->mask & IN_ISDIR) {
+        emit PathChanged(path);
+      }
+      else if (!(event->mask & IN_CREATE)) {
+        // New files are reported when they are closed after writing.
+        emit FileChanged(path + QLatin1Char('/') + QFile::decodeName(event->name));
+      }
+    }
+  }
+
+}
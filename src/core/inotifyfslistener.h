@@ -0,0 +1,59 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef INOTIFYFSLISTENER_H
+#define INOTIFYFSLISTENER_H
+
+#include "config.h"
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+
+#include "filesystemwatcherinterface.h"
+
+class QSocketNotifier;
+
+// Watches directories with one inotify descriptor, and reports the files that changed inside them instead of only the directory.
+// New subdirectories and moved or deleted subdirectories are reported with PathChanged(), since the whole directory needs to be scanned.
+// If the kernel's event queue overflows, Overflow() is emitted.
+class InotifyFSListener : public FileSystemWatcherInterface {
+  Q_OBJECT
+
+ public:
+  explicit InotifyFSListener(QObject *parent = nullptr);
+  ~InotifyFSListener() override;
+
+  void Init() override;
+  void AddPath(const QString &path) override;
+  void RemovePath(const QString &path) override;
+  void Clear() override;
+
+ private slots:
+  void ReadEvents();
+
+ private:
+  int fd_;
+  QSocketNotifier *notifier_;
+  QHash<int, QString> paths_;
+  QHash<QString, int> watches_;
+  bool watch_limit_reached_;
+};
+
+#endif  // INOTIFYFSLISTENER_H
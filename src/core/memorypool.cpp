@@ -0,0 +1,102 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <cstddef>
+#include <new>
+
+#include <QtGlobal>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QList>
+
+#include "memorypool.h"
+
+// The block size is rounded up, so every block is aligned like a block from the heap allocator.
+MemoryPool::MemoryPool(const size_t block_size, const int blocks_per_chunk)
+    : block_size_((qMax(block_size, sizeof(FreeBlock)) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t)),
+      blocks_per_chunk_(blocks_per_chunk),
+      free_blocks_(nullptr),
+      chunk_blocks_used_(blocks_per_chunk),
+      blocks_(0) {}
+
+MemoryPool::~MemoryPool() {
+  ReleaseChunks();
+}
+
+void *MemoryPool::Allocate() {
+
+  QMutexLocker l(&mutex_);
+
+  ++blocks_;
+
+  if (free_blocks_) {
+    FreeBlock *block = free_blocks_;
+    free_blocks_ = block->next;
+    return block;
+  }
+
+  if (chunk_blocks_used_ == blocks_per_chunk_) {
+    chunks_ << static_cast<char*>(::operator new(block_size_ * blocks_per_chunk_));
+    chunk_blocks_used_ = 0;
+  }
+
+  return chunks_.last() + block_size_ * chunk_blocks_used_++;
+
+}
+
+void MemoryPool::Free(void *block) {
+
+  if (!block) return;
+
+  QMutexLocker l(&mutex_);
+
+  FreeBlock *free_block = static_cast<FreeBlock*>(block);
+  free_block->next = free_blocks_;
+  free_blocks_ = free_block;
+
+  if (--blocks_ == 0) ReleaseChunks();
+
+}
+
+void MemoryPool::ReleaseChunks() {
+
+  for (char *chunk : chunks_) {
+    ::operator delete(chunk);
+  }
+  chunks_.clear();
+  free_blocks_ = nullptr;
+  chunk_blocks_used_ = blocks_per_chunk_;
+
+}
+
+qint64 MemoryPool::blocks() const {
+
+  QMutexLocker l(&mutex_);
+  return blocks_;
+
+}
+
+qint64 MemoryPool::bytes() const {
+
+  QMutexLocker l(&mutex_);
+  return static_cast<qint64>(chunks_.count()) * static_cast<qint64>(block_size_) * blocks_per_chunk_;
+
+}
@@ -0,0 +1,68 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MEMORYPOOL_H
+#define MEMORYPOOL_H
+
+#include "config.h"
+
+#include <cstddef>
+
+#include <QtGlobal>
+#include <QMutex>
+#include <QList>
+
+// Allocates blocks of one size from large chunks, so many small objects of a class are stored next to each other
+// instead of one heap allocation each.
+// Freed blocks are reused by the next allocation, the chunks are released when all blocks are freed.
+// Allocate() and Free() are thread-safe.
+class MemoryPool {
+ public:
+  explicit MemoryPool(const size_t block_size, const int blocks_per_chunk = 1024);
+  ~MemoryPool();
+
+  void *Allocate();
+  void Free(void *block);
+
+  size_t block_size() const { return block_size_; }
+  // Number of blocks allocated, and the size of the chunks holding them.
+  qint64 blocks() const;
+  qint64 bytes() const;
+
+ private:
+  Q_DISABLE_COPY(MemoryPool)
+
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  void ReleaseChunks();
+
+ private:
+  const size_t block_size_;
+  const int blocks_per_chunk_;
+
+  mutable QMutex mutex_;
+  QList<char*> chunks_;
+  FreeBlock *free_blocks_;
+  int chunk_blocks_used_;
+  qint64 blocks_;
+};
+
+#endif  // MEMORYPOOL_H
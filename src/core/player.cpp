@@ -340,6 +340,7 @@ void Player::HandleLoadResult(const UrlHandler::LoadResult &result) {
         engine_->Play(result.stream_url_, result.original_url_, stream_change_type_, song.has_cue(), song.beginning_nanosec(), song.end_nanosec(), play_offset_nanosec_);
         current_item_ = item;
         play_offset_nanosec_ = 0;
+        PrerollNextAndPrevious();
       }
       else if (is_next && !item->Metadata().is_module_music()) {
         qLog(Debug) << "Preloading next song" << next_item->Metadata().title() << result.stream_url_;
@@ -430,6 +431,17 @@ void Player::PlayPlaylistInternal(const Engine::TrackChangeFlags change, const P
     return;
   }
 
+  if (!playlist->is_restored() && playlist->rowCount() == 0) {
+    // Play the playlist when its first items are restored.
+    std::shared_ptr<QMetaObject::Connection> connection = std::make_shared<QMetaObject::Connection>();
+    *connection = QObject::connect(playlist, &Playlist::RestoreFinished, this, [this, connection, change, autoscroll, playlist_name]() {
+      QObject::disconnect(*connection);
+      PlayPlaylistInternal(change, autoscroll, playlist_name);
+    });
+    playlist->Restore();
+    return;
+  }
+
   app_->playlist_manager()->SetActivePlaylist(playlist->id());
   app_->playlist_manager()->SetCurrentPlaylist(playlist->id());
   if (playlist->rowCount() == 0) return;
@@ -715,6 +727,23 @@ void Player::PlayAt(const int index, const quint64 offset_nanosec, Engine::Track
   else {
     qLog(Debug) << "Playing song" << current_item_->Metadata().title() << url << "position" << offset_nanosec;
     engine_->Play(url, current_item_->Url(), change, current_item_->Metadata().has_cue(), current_item_->effective_beginning_nanosec(), current_item_->effective_end_nanosec(), offset_nanosec);
+    PrerollNextAndPrevious();
+  }
+
+}
+
+void Player::PrerollNextAndPrevious() {
+
+  Playlist *playlist = app_->playlist_manager()->active();
+  if (!playlist) return;
+
+  for (const int row : { playlist->next_row(true), playlist->previous_row(true) }) {
+    if (!playlist->has_item_at(row)) continue;
+    PlaylistItemPtr item = playlist->item_at(row);
+    const QUrl url = item->StreamUrl();
+    // Don't resolve URLs from URL handlers, that can start loading a stream.
+    if (url_handlers_.contains(url.scheme()) || item->Metadata().is_module_music()) continue;
+    engine_->Preroll(url, item->Url(), item->Metadata().has_cue(), item->effective_beginning_nanosec(), item->effective_end_nanosec());
   }
 
 }
@@ -214,6 +214,9 @@ class Player : public PlayerInterface {
   // Returns true if we were supposed to stop after this track.
   bool HandleStopAfter(const Playlist::AutoScroll autoscroll);
 
+  // Lets the engine prepare the songs the user is likely to skip to.
+  void PrerollNextAndPrevious();
+
   void UnPause();
 
  private:
@@ -47,6 +47,7 @@
 #include <QImage>
 #include <QIcon>
 #include <QStandardPaths>
+#include <QSqlQuery>
 
 #include "core/iconloader.h"
 
@@ -58,6 +59,7 @@
 #include "sqlquery.h"
 #include "mpris_common.h"
 #include "sqlrow.h"
+#include "stringpool.h"
 #include "tagreadermessages.pb.h"
 
 #define QStringFromStdString(x) QString::fromUtf8((x).data(), (x).size())
@@ -156,10 +158,22 @@ const QStringList Song::kAcceptedExtensions = QStringList() << "wav" << "flac" <
                                                             << "aif << aiff" << "mka" << "tta" << "dsf" << "dsd"
                                                             << "ac3" << "dts" << "spc" << "vgm";
 
+// Fields that are large or rarely used, kept out of Private so songs without them don't pay for them.
+struct SongRareFields : public QSharedData {
+  QString comment_;
+  QString lyrics_;
+  QImage image_;                // Album Cover image set by album cover loader.
+};
+
 struct Song::Private : public QSharedData {
 
   explicit Private(Source source = Source_Unknown);
 
+  SongRareFields *rare() {
+    if (!rare_) rare_ = new SongRareFields;
+    return rare_.data();
+  }
+
   bool valid_;
   int id_;
 
@@ -180,8 +194,6 @@ struct Song::Private : public QSharedData {
   QString composer_;
   QString performer_;
   QString grouping_;
-  QString comment_;
-  QString lyrics_;
 
   QString artist_id_;
   QString album_id_;
@@ -224,12 +236,27 @@ struct Song::Private : public QSharedData {
   float rating_;                // Database rating, initial rating read from tag.
 
   QUrl stream_url_;             // Temporary stream url set by url handler.
-  QImage image_;                // Album Cover image set by album cover loader.
   bool init_from_file_;         // Whether this song was loaded from a file using taglib.
   bool suspicious_tags_;        // Whether our encoding guesser thinks these tags might be incorrectly encoded.
 
+  QSharedDataPointer<SongRareFields> rare_;
+
 };
 
+namespace {
+
+const QString &EmptyString() {
+  static const QString empty;
+  return empty;
+}
+
+const QImage &EmptyImage() {
+  static const QImage empty;
+  return empty;
+}
+
+}  // namespace
+
 Song::Private::Private(Song::Source source)
     : valid_(false),
       id_(-1),
@@ -312,8 +339,8 @@ bool Song::compilation() const { return d->compilation_; }
 const QString &Song::composer() const { return d->composer_; }
 const QString &Song::performer() const { return d->performer_; }
 const QString &Song::grouping() const { return d->grouping_; }
-const QString &Song::comment() const { return d->comment_; }
-const QString &Song::lyrics() const { return d->lyrics_; }
+const QString &Song::comment() const { return d->rare_ ? d->rare_->comment_ : EmptyString(); }
+const QString &Song::lyrics() const { return d->rare_ ? d->rare_->lyrics_ : EmptyString(); }
 
 qint64 Song::beginning_nanosec() const { return d->beginning_; }
 qint64 Song::end_nanosec() const { return d->end_; }
@@ -365,7 +392,7 @@ bool Song::save_embedded_cover_supported(const FileType filetype) {
 
 const QUrl &Song::stream_url() const { return d->stream_url_; }
 const QUrl &Song::effective_stream_url() const { return !d->stream_url_.isEmpty() && d->stream_url_.isValid() ? d->stream_url_ : d->url_; }
-const QImage &Song::image() const { return d->image_; }
+const QImage &Song::image() const { return d->rare_ ? d->rare_->image_ : EmptyImage(); }
 bool Song::init_from_file() const { return d->init_from_file_; }
 
 const QString &Song::cue_path() const { return d->cue_path_; }
@@ -427,10 +454,18 @@ QString Song::sortable(const QString &v) {
   return copy;
 }
 
-void Song::set_title(const QString &v) { d->title_sortable_ = sortable(v); d->title_ = v; }
-void Song::set_album(const QString &v) { d->album_sortable_ = sortable(v); d->album_ = v; }
-void Song::set_artist(const QString &v) { d->artist_sortable_ = sortable(v); d->artist_ = v; }
-void Song::set_albumartist(const QString &v) { d->albumartist_sortable_ = sortable(v); d->albumartist_ = v; }
+QString Song::SharedSortable(const QString &v) {
+
+  // Share the text when sortable() doesn't change it, like empty or lowercase text.
+  const QString copy = sortable(v);
+  return copy == v ? v : copy;
+
+}
+
+void Song::set_title(const QString &v) { d->title_sortable_ = SharedSortable(v); d->title_ = v; }
+void Song::set_album(const QString &v) { d->album_sortable_ = SharedSortable(v); d->album_ = v; }
+void Song::set_artist(const QString &v) { d->artist_sortable_ = SharedSortable(v); d->artist_ = v; }
+void Song::set_albumartist(const QString &v) { d->albumartist_sortable_ = SharedSortable(v); d->albumartist_ = v; }
 void Song::set_track(const int v) { d->track_ = v; }
 void Song::set_disc(const int v) { d->disc_ = v; }
 void Song::set_year(const int v) { d->year_ = v; }
@@ -440,8 +475,14 @@ void Song::set_compilation(bool v) { d->compilation_ = v; }
 void Song::set_composer(const QString &v) { d->composer_ = v; }
 void Song::set_performer(const QString &v) { d->performer_ = v; }
 void Song::set_grouping(const QString &v) { d->grouping_ = v; }
-void Song::set_comment(const QString &v) { d->comment_ = v; }
-void Song::set_lyrics(const QString &v) { d->lyrics_ = v; }
+void Song::set_comment(const QString &v) {
+  if (v.isEmpty() && !d.constData()->rare_) return;
+  d->rare()->comment_ = v;
+}
+void Song::set_lyrics(const QString &v) {
+  if (v.isEmpty() && !d.constData()->rare_) return;
+  d->rare()->lyrics_ = v;
+}
 
 void Song::set_beginning_nanosec(const qint64 v) { d->beginning_ = qMax(0LL, v); }
 void Song::set_end_nanosec(const qint64 v) { d->end_ = v; }
@@ -479,7 +520,10 @@ void Song::set_cue_path(const QString &v) { d->cue_path_ = v; }
 void Song::set_rating(const float v) { d->rating_ = v; }
 
 void Song::set_stream_url(const QUrl &v) { d->stream_url_ = v; }
-void Song::set_image(const QImage &i) { d->image_ = i; }
+void Song::set_image(const QImage &i) {
+  if (i.isNull() && !d.constData()->rare_) return;
+  d->rare()->image_ = i;
+}
 
 QString Song::JoinSpec(const QString &table) {
   return Utilities::Prepend(table + ".", kColumns).join(", ");
@@ -852,8 +896,8 @@ void Song::InitFromProtobuf(const spb::tagreader::SongMetadata &pb) {
   d->composer_ = QStringFromStdString(pb.composer());
   d->performer_ = QStringFromStdString(pb.performer());
   d->grouping_ = QStringFromStdString(pb.grouping());
-  d->comment_ = QStringFromStdString(pb.comment());
-  d->lyrics_ = QStringFromStdString(pb.lyrics());
+  set_comment(QStringFromStdString(pb.comment()));
+  set_lyrics(QStringFromStdString(pb.lyrics()));
   set_length_nanosec(static_cast<qint64>(pb.length_nanosec()));
   d->bitrate_ = pb.bitrate();
   d->samplerate_ = pb.samplerate();
@@ -905,8 +949,8 @@ void Song::ToProtobuf(spb::tagreader::SongMetadata *pb) const {
   pb->set_composer(DataCommaSizeFromQString(d->composer_));
   pb->set_performer(DataCommaSizeFromQString(d->performer_));
   pb->set_grouping(DataCommaSizeFromQString(d->grouping_));
-  pb->set_comment(DataCommaSizeFromQString(d->comment_));
-  pb->set_lyrics(DataCommaSizeFromQString(d->lyrics_));
+  pb->set_comment(DataCommaSizeFromQString(comment()));
+  pb->set_lyrics(DataCommaSizeFromQString(lyrics()));
   pb->set_length_nanosec(length_nanosec());
   pb->set_bitrate(d->bitrate_);
   pb->set_samplerate(d->samplerate_);
@@ -944,8 +988,8 @@ void Song::InitFromQuery(const SqlRow &q, const bool reliable_metadata) {
   d->composer_ = q.ValueToString("composer");
   d->performer_ = q.ValueToString("performer");
   d->grouping_ = q.ValueToString("grouping");
-  d->comment_ = q.ValueToString("comment");
-  d->lyrics_ = q.ValueToString("lyrics");
+  set_comment(q.ValueToString("comment"));
+  set_lyrics(q.ValueToString("lyrics"));
   d->artist_id_ = q.ValueToString("artist_id");
   d->album_id_ = q.ValueToString("album_id");
   d->song_id_ = q.ValueToString("song_id");
@@ -1000,6 +1044,123 @@ void Song::InitFromQuery(const SqlRow &q, const bool reliable_metadata) {
 
 }
 
+namespace {
+
+QString ColumnToString(const QVariant &v) { return v.isNull() ? QString() : v.toString(); }
+int ColumnToInt(const QVariant &v) { return v.isNull() ? -1 : v.toInt(); }
+uint ColumnToUInt(const QVariant &v) { return v.isNull() || v.toInt() < 0 ? 0 : v.toInt(); }
+qint64 ColumnToLongLong(const QVariant &v) { return v.isNull() ? -1 : v.toLongLong(); }
+float ColumnToFloat(const QVariant &v) { return v.isNull() ? -1.0F : v.toFloat(); }
+bool ColumnToBool(const QVariant &v) { return !v.isNull() && v.toInt() == 1; }
+
+}  // namespace
+
+template<typename T>
+void Song::InitFromQueryColumns(const T &q, const bool reliable_metadata, const int col) {
+
+  // The positions have to match the order of kColumns, offset by one for the ROWID.
+  int x = col;
+
+  const QVariant rowid = q.value(x++);
+  d->id_ = rowid.isNull() ? -1 : rowid.toInt();
+
+  // Text repeated across many songs is interned, so the songs of a collection share one copy of each artist, album and genre.
+  // The pool never shrinks, so only songs from the collection tables (with reliable metadata) are interned, not playlist and internet items.
+  auto intern = [reliable_metadata](const QString &text) { return reliable_metadata ? StringPool::Intern(text) : text; };
+  set_title(ColumnToString(q.value(x++)));
+  d->album_ = intern(ColumnToString(q.value(x++)));
+  d->album_sortable_ = intern(SharedSortable(d->album_));
+  d->artist_ = intern(ColumnToString(q.value(x++)));
+  d->artist_sortable_ = intern(SharedSortable(d->artist_));
+  d->albumartist_ = intern(ColumnToString(q.value(x++)));
+  d->albumartist_sortable_ = intern(SharedSortable(d->albumartist_));
+  d->track_ = ColumnToInt(q.value(x++));
+  d->disc_ = ColumnToInt(q.value(x++));
+  d->year_ = ColumnToInt(q.value(x++));
+  d->originalyear_ = ColumnToInt(q.value(x++));
+  d->genre_ = intern(ColumnToString(q.value(x++)));
+  d->compilation_ = q.value(x++).toBool();
+  d->composer_ = intern(ColumnToString(q.value(x++)));
+  d->performer_ = intern(ColumnToString(q.value(x++)));
+  d->grouping_ = intern(ColumnToString(q.value(x++)));
+  set_comment(ColumnToString(q.value(x++)));
+  set_lyrics(ColumnToString(q.value(x++)));
+
+  d->artist_id_ = ColumnToString(q.value(x++));
+  d->album_id_ = ColumnToString(q.value(x++));
+  d->song_id_ = ColumnToString(q.value(x++));
+
+  const QVariant beginning = q.value(x++);
+  d->beginning_ = beginning.isNull() ? 0 : beginning.toLongLong();
+  set_length_nanosec(ColumnToLongLong(q.value(x++)));
+
+  d->bitrate_ = ColumnToInt(q.value(x++));
+  d->samplerate_ = ColumnToInt(q.value(x++));
+  d->bitdepth_ = ColumnToInt(q.value(x++));
+
+  const QVariant source = q.value(x++);
+  d->source_ = Source(source.isNull() ? 0 : source.toInt());
+  d->directory_id_ = ColumnToInt(q.value(x++));
+  set_url(QUrl::fromEncoded(ColumnToString(q.value(x++)).toUtf8()));
+  d->basefilename_ = QFileInfo(d->url_.toLocalFile()).fileName();
+  const QVariant filetype = q.value(x++);
+  d->filetype_ = FileType(filetype.isNull() ? 0 : filetype.toInt());
+  d->filesize_ = ColumnToLongLong(q.value(x++));
+  d->mtime_ = ColumnToLongLong(q.value(x++));
+  d->ctime_ = ColumnToLongLong(q.value(x++));
+  d->unavailable_ = q.value(x++).toBool();
+
+  d->fingerprint_ = ColumnToString(q.value(x++));
+
+  d->playcount_ = ColumnToUInt(q.value(x++));
+  d->skipcount_ = ColumnToUInt(q.value(x++));
+  d->lastplayed_ = ColumnToLongLong(q.value(x++));
+  d->lastseen_ = ColumnToLongLong(q.value(x++));
+
+  d->compilation_detected_ = ColumnToBool(q.value(x++));
+  d->compilation_on_ = ColumnToBool(q.value(x++));
+  d->compilation_off_ = ColumnToBool(q.value(x++));
+  ++x;  // compilation_effective
+
+  const QString art_automatic = ColumnToString(q.value(x++));
+  if (!art_automatic.isEmpty()) {
+    if (art_automatic.contains(QRegularExpression("..+:.*"))) {
+      set_art_automatic(QUrl::fromEncoded(art_automatic.toUtf8()));
+    }
+    else {
+      set_art_automatic(QUrl::fromLocalFile(art_automatic));
+    }
+  }
+  const QString art_manual = ColumnToString(q.value(x++));
+  if (!art_manual.isEmpty()) {
+    if (art_manual.contains(QRegularExpression("..+:.*"))) {
+      set_art_manual(QUrl::fromEncoded(art_manual.toUtf8()));
+    }
+    else {
+      set_art_manual(QUrl::fromLocalFile(art_manual));
+    }
+  }
+
+  x += 2;  // effective_albumartist, effective_originalyear
+
+  d->cue_path_ = ColumnToString(q.value(x++));
+  d->rating_ = ColumnToFloat(q.value(x++));
+
+  d->valid_ = true;
+  d->init_from_file_ = reliable_metadata;
+
+  InitArtManual();
+
+}
+
+void Song::InitFromQuery(const SqlRow &query, const bool reliable_metadata, const int col) {
+  InitFromQueryColumns(query, reliable_metadata, col);
+}
+
+void Song::InitFromQuery(const QSqlQuery &query, const bool reliable_metadata, const int col) {
+  InitFromQueryColumns(query, reliable_metadata, col);
+}
+
 void Song::InitFromFilePartial(const QString &filename, const QFileInfo &fileinfo) {
 
   set_url(QUrl::fromLocalFile(filename));
@@ -1058,7 +1219,7 @@ void Song::InitFromItdb(Itdb_Track *track, const QString &prefix) {
   d->compilation_ = track->compilation == 1;
   d->composer_ = QString::fromUtf8(track->composer);
   d->grouping_ = QString::fromUtf8(track->grouping);
-  d->comment_ = QString::fromUtf8(track->comment);
+  set_comment(QString::fromUtf8(track->comment));
 
   set_length_nanosec(track->tracklen * kNsecPerMsec);
 
@@ -1116,7 +1277,7 @@ void Song::ToItdb(Itdb_Track *track) const {
   track->compilation = d->compilation_;
   track->composer = strdup(d->composer_.toUtf8().constData());
   track->grouping = strdup(d->grouping_.toUtf8().constData());
-  track->comment = strdup(d->comment_.toUtf8().constData());
+  track->comment = strdup(comment().toUtf8().constData());
 
   track->tracklen = static_cast<int>(length_nanosec() / kNsecPerMsec);
 
@@ -1300,8 +1461,8 @@ void Song::BindToQuery(SqlQuery *query) const {
   query->BindStringValue(":composer", d->composer_);
   query->BindStringValue(":performer", d->performer_);
   query->BindStringValue(":grouping", d->grouping_);
-  query->BindStringValue(":comment", d->comment_);
-  query->BindStringValue(":lyrics", d->lyrics_);
+  query->BindStringValue(":comment", comment());
+  query->BindStringValue(":lyrics", lyrics());
 
   query->BindStringValue(":artist_id", d->artist_id_);
   query->BindStringValue(":album_id", d->album_id_);
@@ -1357,7 +1518,7 @@ void Song::BindToFtsQuery(SqlQuery *query) const {
   query->BindValue(":ftsperformer", d->performer_);
   query->BindValue(":ftsgrouping", d->grouping_);
   query->BindValue(":ftsgenre", d->genre_);
-  query->BindValue(":ftscomment", d->comment_);
+  query->BindValue(":ftscomment", comment());
 
 }
 
@@ -1452,8 +1613,8 @@ bool Song::IsMetadataEqual(const Song &other) const {
          d->composer_ == other.d->composer_ &&
          d->performer_ == other.d->performer_ &&
          d->grouping_ == other.d->grouping_ &&
-         d->comment_ == other.d->comment_ &&
-         d->lyrics_ == other.d->lyrics_ &&
+         comment() == other.comment() &&
+         lyrics() == other.lyrics() &&
          d->artist_id_ == other.d->artist_id_ &&
          d->album_id_ == other.d->album_id_ &&
          d->song_id_ == other.d->song_id_ &&
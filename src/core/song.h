@@ -40,6 +40,7 @@
 #include <QImage>
 #include <QIcon>
 
+class QSqlQuery;
 class SqlQuery;
 
 namespace Engine {
@@ -171,6 +172,9 @@ class Song {
   void Init(const QString &title, const QString &artist, const QString &album, qint64 beginning, qint64 end);
   void InitFromProtobuf(const spb::tagreader::SongMetadata &pb);
   void InitFromQuery(const SqlRow &query, const bool reliable_metadata);
+  // Reads the ROWID followed by kColumns starting at column col, without looking up columns by name.
+  void InitFromQuery(const SqlRow &query, const bool reliable_metadata, const int col);
+  void InitFromQuery(const QSqlQuery &query, const bool reliable_metadata, const int col);
   void InitFromFilePartial(const QString &filename, const QFileInfo &fileinfo);
   void InitArtManual();
   void InitArtAutomatic();
@@ -401,6 +405,11 @@ class Song {
   struct Private;
 
   static QString sortable(const QString &v);
+  // Returns sortable(v), or v itself when it is already sortable, so both share the same data.
+  static QString SharedSortable(const QString &v);
+
+  template<typename T>
+  void InitFromQueryColumns(const T &query, const bool reliable_metadata, const int col);
 
   QSharedDataPointer<Private> d;
 };
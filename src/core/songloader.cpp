@@ -233,8 +233,8 @@ SongLoader::Result SongLoader::LoadLocal(const QString &filename) {
   // Search in the database.
   QUrl url = QUrl::fromLocalFile(filename);
 
-  QMutexLocker l(collection_->db()->Mutex());
-  QSqlDatabase db(collection_->db()->Connect());
+  QMutexLocker l(collection_->db()->ReadMutex());
+  QSqlDatabase db(collection_->db()->ConnectReadOnly());
 
   CollectionQuery query(db, collection_->songs_table(), collection_->fts_table());
   query.SetColumnSpec("%songs_table.ROWID, " + Song::kColumnSpec);
@@ -244,7 +244,7 @@ SongLoader::Result SongLoader::LoadLocal(const QString &filename) {
     // We may have many results when the file has many sections
     do {
       Song song(Song::Source_Collection);
-      song.InitFromQuery(query, true);
+      song.InitFromQuery(query, true, 0);
 
       if (song.is_valid()) {
         songs_ << song;
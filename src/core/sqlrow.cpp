@@ -19,6 +19,10 @@
 
 #include "config.h"
 
+#include <memory>
+
+#include <QVector>
+#include <QHash>
 #include <QVariant>
 #include <QString>
 #include <QUrl>
@@ -27,25 +31,37 @@
 
 #include "sqlrow.h"
 
-SqlRow::SqlRow(const QSqlQuery &query) { Init(query); }
+SqlRow::Columns::Columns(const QSqlQuery &query) {
+
+  const QSqlRecord r = query.record();
+  count_ = r.count();
+  for (int i = 0; i < count_; ++i) {
+    positions_[r.fieldName(i)] << i;
+  }
+
+}
+
+SqlRow::ColumnsPtr SqlRow::ColumnsFromQuery(const QSqlQuery &query) {
+  return std::make_shared<Columns>(query);
+}
+
+SqlRow::SqlRow(const QSqlQuery &query) : columns_(ColumnsFromQuery(query)) { Init(query); }
+
+SqlRow::SqlRow(const QSqlQuery &query, const ColumnsPtr &columns) : columns_(columns) { Init(query); }
 
 void SqlRow::Init(const QSqlQuery &query) {
 
-  const QSqlRecord r = query.record();
-  for (int i = 0; i < r.count(); ++i) {
-    columns_by_number_.insert(i, query.value(i));
-    const QString field_name = r.fieldName(i);
-    if (!columns_by_name_.contains(field_name) || columns_by_name_[field_name].isNull()) {
-      columns_by_name_.insert(field_name, query.value(i));
-    }
+  values_.reserve(columns_->count());
+  for (int i = 0; i < columns_->count(); ++i) {
+    values_ << query.value(i);
   }
 
 }
 
 const QVariant SqlRow::value(const int number) const {
 
-  if (columns_by_number_.contains(number)) {
-    return columns_by_number_[number];
+  if (number >= 0 && number < values_.count()) {
+    return values_[number];
   }
   else {
     return QVariant();
@@ -55,39 +71,51 @@ const QVariant SqlRow::value(const int number) const {
 
 const QVariant SqlRow::value(const QString &name) const {
 
-  if (columns_by_name_.contains(name)) {
-    return columns_by_name_[name];
-  }
-  else {
+  // Joins can return the same column name more than once, the first non-null value wins.
+  const QVector<int> positions = columns_->positions(name);
+  if (positions.isEmpty()) {
     return QVariant();
   }
 
+  for (const int position : positions) {
+    if (!values_[position].isNull()) return values_[position];
+  }
+
+  return values_[positions.last()];
+
 }
 
 QString SqlRow::ValueToString(const QString &n) const {
-  return value(n).isNull() ? QString() : value(n).toString();
+  const QVariant v = value(n);
+  return v.isNull() ? QString() : v.toString();
 }
 
 QUrl SqlRow::ValueToUrl(const QString &n) const {
-  return value(n).isNull() ? QUrl() : QUrl(value(n).toString());
+  const QVariant v = value(n);
+  return v.isNull() ? QUrl() : QUrl(v.toString());
 }
 
 int SqlRow::ValueToInt(const QString &n) const {
-  return value(n).isNull() ? -1 : value(n).toInt();
+  const QVariant v = value(n);
+  return v.isNull() ? -1 : v.toInt();
 }
 
 uint SqlRow::ValueToUInt(const QString &n) const {
-  return value(n).isNull() || value(n).toInt() < 0 ? 0 : value(n).toInt();
+  const QVariant v = value(n);
+  return v.isNull() || v.toInt() < 0 ? 0 : v.toInt();
 }
 
 qint64 SqlRow::ValueToLongLong(const QString &n) const {
-  return value(n).isNull() ? -1 : value(n).toLongLong();
+  const QVariant v = value(n);
+  return v.isNull() ? -1 : v.toLongLong();
 }
 
 float SqlRow::ValueToFloat(const QString &n) const {
-  return value(n).isNull() ? -1.0F : value(n).toFloat();
+  const QVariant v = value(n);
+  return v.isNull() ? -1.0F : v.toFloat();
 }
 
 bool SqlRow::ValueToBool(const QString &n) const {
-  return !value(n).isNull() && value(n).toInt() == 1;
+  const QVariant v = value(n);
+  return !v.isNull() && v.toInt() == 1;
 }
@@ -22,15 +22,39 @@
 
 #include "config.h"
 
+#include <memory>
+
 #include <QList>
+#include <QVector>
+#include <QHash>
 #include <QVariant>
+#include <QString>
 #include <QUrl>
 #include <QSqlQuery>
 
 class SqlRow {
 
  public:
+  // Column positions by name, resolved once per query and shared by all rows read from it.
+  class Columns {
+   public:
+    explicit Columns(const QSqlQuery &query);
+
+    int count() const { return count_; }
+    QVector<int> positions(const QString &name) const { return positions_.value(name); }
+
+   private:
+    int count_;
+    QHash<QString, QVector<int>> positions_;
+  };
+  using ColumnsPtr = std::shared_ptr<const Columns>;
+
+  static ColumnsPtr ColumnsFromQuery(const QSqlQuery &query);
+
   SqlRow(const QSqlQuery &query);
+  SqlRow(const QSqlQuery &query, const ColumnsPtr &columns);
+
+  int count() const { return values_.count(); }
 
   const QVariant value(const int number) const;
   const QVariant value(const QString &name) const;
@@ -48,8 +72,8 @@ class SqlRow {
 
   void Init(const QSqlQuery &query);
 
-  QMap<int, QVariant> columns_by_number_;
-  QMap<QString, QVariant> columns_by_name_;
+  ColumnsPtr columns_;
+  QVector<QVariant> values_;
 
 };
 
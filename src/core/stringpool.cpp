@@ -0,0 +1,66 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QString>
+
+#include "stringpool.h"
+
+namespace {
+
+struct Pool {
+  QMutex mutex;
+  QSet<QString> strings;
+};
+
+// Leaked on purpose, songs holding pooled strings can outlive static destruction.
+Pool *GetPool() {
+  static Pool *pool = new Pool;
+  return pool;
+}
+
+}  // namespace
+
+QString StringPool::Intern(const QString &text) {
+
+  if (text.isEmpty()) return text;
+
+  Pool *pool = GetPool();
+  QMutexLocker l(&pool->mutex);
+
+  QSet<QString>::const_iterator it = pool->strings.constFind(text);
+  if (it != pool->strings.constEnd()) return *it;
+
+  pool->strings.insert(text);
+  return text;
+
+}
+
+int StringPool::size() {
+
+  Pool *pool = GetPool();
+  QMutexLocker l(&pool->mutex);
+  return static_cast<int>(pool->strings.count());
+
+}
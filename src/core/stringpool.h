@@ -0,0 +1,42 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QString>
+
+// Process-wide pool of interned strings.
+// Intern() returns a copy of an equal string already in the pool, so text repeated in many songs, like artist, album and genre names,
+// is stored once and shared by every song instead of once per song.
+// Strings are never removed, so only intern text of which there is a limited number of different values.
+// Song only interns the songs loaded from the collection tables, so the pool is bounded by the size of the collections.
+// All functions are thread-safe.
+class StringPool {
+ public:
+  static QString Intern(const QString &text);
+
+  // Number of strings in the pool.
+  static int size();
+};
+
+#endif  // STRINGPOOL_H
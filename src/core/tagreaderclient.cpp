@@ -30,14 +30,17 @@
 #include <QString>
 #include <QImage>
 #include <QSettings>
+#include <QSharedMemory>
 
 #include "core/logging.h"
 #include "core/workerpool.h"
+#include "core/sharedmemory.h"
 
 #include "song.h"
 #include "tagreaderclient.h"
 #include "settings/collectionsettingspage.h"
 
+#define QStringFromStdString(x) QString::fromUtf8((x).data(), (x).size())
 #define DataCommaSizeFromQString(x) (x).toUtf8().constData(), (x).toUtf8().length()
 
 const char *TagReaderClient::kWorkerExecutableName = "strawberry-tagreader";
@@ -51,12 +54,14 @@ TagReaderClient::TagReaderClient(QObject *parent) : QObject(parent), worker_pool
   QSettings s;
   s.beginGroup(CollectionSettingsPage::kSettingsGroup);
   int workers = s.value("tagreader_workers", qBound(1, QThread::idealThreadCount() / 2, 4)).toInt();
+  int max_workers = s.value("tagreader_max_workers", qMax(workers, QThread::idealThreadCount())).toInt();
   s.endGroup();
 
-  qLog(Debug) << "Using" << workers << "tagreader workers.";
+  qLog(Debug) << "Using" << workers << "to" << max_workers << "tagreader workers.";
 
   worker_pool_->SetExecutableName(kWorkerExecutableName);
   worker_pool_->SetWorkerCount(workers);
+  worker_pool_->SetMaxWorkerCount(max_workers);
   QObject::connect(worker_pool_, &WorkerPool<HandlerType>::WorkerFailedToStart, this, &TagReaderClient::WorkerFailedToStart);
 
 }
@@ -101,6 +106,19 @@ TagReaderReply *TagReaderClient::ReadFile(const QString &filename) {
 
 }
 
+TagReaderReply *TagReaderClient::ReadFiles(const QStringList &filenames) {
+
+  spb::tagreader::Message message;
+  spb::tagreader::ReadFilesRequest *req = message.mutable_read_files_request();
+
+  for (const QString &filename : filenames) {
+    req->add_filenames(DataCommaSizeFromQString(filename));
+  }
+
+  return worker_pool_->SendMessageWithReply(&message);
+
+}
+
 TagReaderReply *TagReaderClient::SaveFile(const QString &filename, const Song &metadata) {
 
   spb::tagreader::Message message;
@@ -128,6 +146,15 @@ TagReaderReply *TagReaderClient::LoadEmbeddedArt(const QString &filename) {
 
 TagReaderReply *TagReaderClient::SaveEmbeddedArt(const QString &filename, const QByteArray &data) {
 
+  if (data.size() >= SharedMemory::kThreshold) {
+    QSharedMemory *shared_memory = SharedMemory::Create(data);
+    if (shared_memory) {
+      TagReaderReply *reply = SaveEmbeddedArt(filename, shared_memory, data.size());
+      shared_memory->setParent(reply);
+      return reply;
+    }
+  }
+
   spb::tagreader::Message message;
   spb::tagreader::SaveEmbeddedArtRequest *req = message.mutable_save_embedded_art_request();
 
@@ -138,6 +165,19 @@ TagReaderReply *TagReaderClient::SaveEmbeddedArt(const QString &filename, const
 
 }
 
+TagReaderReply *TagReaderClient::SaveEmbeddedArt(const QString &filename, QSharedMemory *shared_memory, const qint64 data_size) {
+
+  spb::tagreader::Message message;
+  spb::tagreader::SaveEmbeddedArtRequest *req = message.mutable_save_embedded_art_request();
+
+  req->set_filename(DataCommaSizeFromQString(filename));
+  req->set_shared_memory_key(DataCommaSizeFromQString(shared_memory->key()));
+  req->set_shared_memory_data_size(data_size);
+
+  return worker_pool_->SendMessageWithReply(&message);
+
+}
+
 TagReaderReply *TagReaderClient::UpdateSongPlaycount(const Song &metadata) {
 
   spb::tagreader::Message message;
@@ -208,6 +248,26 @@ void TagReaderClient::ReadFileBlocking(const QString &filename, Song *song) {
 
 }
 
+void TagReaderClient::ReadFilesBlocking(const QStringList &filenames, SongList *songs) {
+
+  Q_ASSERT(QThread::currentThread() != thread());
+  Q_ASSERT(songs->count() == filenames.count());
+
+  if (filenames.isEmpty()) return;
+
+  TagReaderReply *reply = ReadFiles(filenames);
+  if (reply->WaitForFinished()) {
+    const spb::tagreader::ReadFilesResponse &response = reply->message().read_files_response();
+    for (const spb::tagreader::ReadFilesResult &result : response.results()) {
+      if (result.index() >= 0 && result.index() < songs->count()) {
+        (*songs)[result.index()].InitFromProtobuf(result.metadata());
+      }
+    }
+  }
+  QMetaObject::invokeMethod(reply, "deleteLater", Qt::QueuedConnection);
+
+}
+
 bool TagReaderClient::SaveFileBlocking(const QString &filename, const Song &metadata) {
 
   Q_ASSERT(QThread::currentThread() != thread());
@@ -224,16 +284,52 @@ bool TagReaderClient::SaveFileBlocking(const QString &filename, const Song &meta
 
 }
 
+TagReaderReply *TagReaderClient::LoadEmbeddedArtBlockingReply(const QString &filename) {
+
+  spb::tagreader::Message message;
+  spb::tagreader::LoadEmbeddedArtRequest *req = message.mutable_load_embedded_art_request();
+
+  req->set_filename(DataCommaSizeFromQString(filename));
+  req->set_use_shared_memory(true);
+
+  TagReaderReply *reply = worker_pool_->SendMessageWithReply(&message);
+  if (!reply->WaitForFinished() || !reply->message().load_embedded_art_response().has_shared_memory_key()) {
+    return reply;
+  }
+
+  const spb::tagreader::LoadEmbeddedArtResponse &response = reply->message().load_embedded_art_response();
+  QSharedMemory *shared_memory = new QSharedMemory(QStringFromStdString(response.shared_memory_key()), reply);
+  if (shared_memory->attach(QSharedMemory::ReadOnly) && shared_memory->size() >= response.shared_memory_data_size()) {
+    return reply;
+  }
+
+  // The worker has already released the segment, load the art again inline.
+  qLog(Warning) << "Could not attach to shared memory segment for" << filename << shared_memory->errorString();
+  QMetaObject::invokeMethod(reply, "deleteLater", Qt::QueuedConnection);
+
+  reply = LoadEmbeddedArt(filename);
+  reply->WaitForFinished();
+
+  return reply;
+
+}
+
 QByteArray TagReaderClient::LoadEmbeddedArtBlocking(const QString &filename) {
 
   Q_ASSERT(QThread::currentThread() != thread());
 
   QByteArray ret;
 
-  TagReaderReply *reply = LoadEmbeddedArt(filename);
-  if (reply->WaitForFinished()) {
-    const std::string &data_str = reply->message().load_embedded_art_response().data();
-    ret = QByteArray(data_str.data(), static_cast<qint64>(data_str.size()));
+  TagReaderReply *reply = LoadEmbeddedArtBlockingReply(filename);
+  if (reply->is_successful()) {
+    const spb::tagreader::LoadEmbeddedArtResponse &response = reply->message().load_embedded_art_response();
+    QSharedMemory *shared_memory = reply->findChild<QSharedMemory*>();
+    if (response.has_shared_memory_data_size() && shared_memory) {
+      ret = QByteArray(static_cast<const char*>(shared_memory->constData()), static_cast<qint64>(response.shared_memory_data_size()));
+    }
+    else {
+      ret = QByteArray(response.data().data(), static_cast<qint64>(response.data().size()));
+    }
   }
   QMetaObject::invokeMethod(reply, "deleteLater", Qt::QueuedConnection);
 
@@ -247,10 +343,16 @@ QImage TagReaderClient::LoadEmbeddedArtAsImageBlocking(const QString &filename)
 
   QImage ret;
 
-  TagReaderReply *reply = LoadEmbeddedArt(filename);
-  if (reply->WaitForFinished()) {
-    const std::string &data_str = reply->message().load_embedded_art_response().data();
-    ret.loadFromData(QByteArray(data_str.data(), static_cast<qint64>(data_str.size())));
+  TagReaderReply *reply = LoadEmbeddedArtBlockingReply(filename);
+  if (reply->is_successful()) {
+    const spb::tagreader::LoadEmbeddedArtResponse &response = reply->message().load_embedded_art_response();
+    QSharedMemory *shared_memory = reply->findChild<QSharedMemory*>();
+    if (response.has_shared_memory_data_size() && shared_memory) {
+      ret.loadFromData(static_cast<const uchar*>(shared_memory->constData()), static_cast<int>(response.shared_memory_data_size()));
+    }
+    else {
+      ret.loadFromData(reinterpret_cast<const uchar*>(response.data().data()), static_cast<int>(response.data().size()));
+    }
   }
   QMetaObject::invokeMethod(reply, "deleteLater", Qt::QueuedConnection);
 
@@ -27,6 +27,7 @@
 #include <QObject>
 #include <QList>
 #include <QString>
+#include <QStringList>
 #include <QImage>
 
 #include "core/messagehandler.h"
@@ -36,16 +37,29 @@
 #include "tagreadermessages.pb.h"
 
 class QThread;
+class QIODevice;
+class QSharedMemory;
 class Song;
 template<typename HandlerType> class WorkerPool;
 
+// Keeps ReadFiles requests pending until the reply with finished set arrives.
+class TagReaderMessageHandler : public AbstractMessageHandler<spb::tagreader::Message> {
+ public:
+  explicit TagReaderMessageHandler(QIODevice *device, QObject *parent) : AbstractMessageHandler<spb::tagreader::Message>(device, parent) {}
+
+ protected:
+  bool IsPartialReply(const spb::tagreader::Message &message) const override {
+    return message.has_read_files_response() && !message.read_files_response().finished();
+  }
+};
+
 class TagReaderClient : public QObject {
   Q_OBJECT
 
  public:
   explicit TagReaderClient(QObject *parent = nullptr);
 
-  using HandlerType = AbstractMessageHandler<spb::tagreader::Message>;
+  using HandlerType = TagReaderMessageHandler;
   using ReplyType = HandlerType::ReplyType;
 
   static const char *kWorkerExecutableName;
@@ -54,16 +68,24 @@ class TagReaderClient : public QObject {
   void ExitAsync();
 
   ReplyType *ReadFile(const QString &filename);
+  // Reads several files in one request.  The metadata is streamed back in partial replies, see MessageReply::WaitForPartialReply().
+  ReplyType *ReadFiles(const QStringList &filenames);
   ReplyType *SaveFile(const QString &filename, const Song &metadata);
   ReplyType *IsMediaFile(const QString &filename);
   ReplyType *LoadEmbeddedArt(const QString &filename);
+  // Art of SharedMemory::kThreshold bytes or more is passed to the worker in a shared memory segment owned by the reply.
   ReplyType *SaveEmbeddedArt(const QString &filename, const QByteArray &data);
+  // Saves data_size bytes from an existing segment, so the same art can be saved to several files without copying it again.
+  // The caller keeps ownership of shared_memory and must not delete it before the reply has finished.
+  ReplyType *SaveEmbeddedArt(const QString &filename, QSharedMemory *shared_memory, const qint64 data_size);
   ReplyType *UpdateSongPlaycount(const Song &metadata);
   ReplyType *UpdateSongRating(const Song &metadata);
 
   // Convenience functions that call the above functions and wait for a response.
   // These block the calling thread with a semaphore, and must NOT be called from the TagReaderClient's thread.
   void ReadFileBlocking(const QString &filename, Song *song);
+  // Reads the metadata for filenames into the songs at the same index, songs must have one entry per filename.
+  void ReadFilesBlocking(const QStringList &filenames, SongList *songs);
   bool SaveFileBlocking(const QString &filename, const Song &metadata);
   bool IsMediaFileBlocking(const QString &filename);
   QByteArray LoadEmbeddedArtBlocking(const QString &filename);
@@ -72,6 +94,9 @@ class TagReaderClient : public QObject {
   bool UpdateSongPlaycountBlocking(const Song &metadata);
   bool UpdateSongRatingBlocking(const Song &metadata);
 
+  // Request counters for each tagreader worker, for the debug console.
+  QList<_WorkerPoolBase::WorkerStats> worker_stats() const { return worker_pool_->worker_stats(); }
+
   // TODO: Make this not a singleton
   static TagReaderClient *Instance() { return sInstance; }
 
@@ -87,6 +112,9 @@ class TagReaderClient : public QObject {
   void UpdateSongsRating(const SongList &songs);
 
  private:
+  // Loads the art inline if it is small, otherwise through a shared memory segment created by the worker that the reply attaches to.
+  ReplyType *LoadEmbeddedArtBlockingReply(const QString &filename);
+
   static TagReaderClient *sInstance;
 
   WorkerPool<HandlerType> *worker_pool_;
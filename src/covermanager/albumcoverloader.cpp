@@ -42,12 +42,14 @@
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <QSettings>
+#include <QSharedMemory>
 
 #include "core/networkaccessmanager.h"
 #include "core/song.h"
 #include "core/tagreaderclient.h"
 #include "core/utilities.h"
 #include "core/imageutils.h"
+#include "core/sharedmemory.h"
 #include "settings/collectionsettingspage.h"
 #include "organize/organizeformat.h"
 #include "albumcoverloader.h"
@@ -684,6 +686,20 @@ void AlbumCoverLoader::SaveEmbeddedCover(const quint64 id, const QList<QUrl> &ur
 
 void AlbumCoverLoader::SaveEmbeddedCover(const quint64 id, const QList<QUrl> &urls, const QByteArray &image_data) {
 
+  // Copy large art into one shared memory segment that all the save requests read from.
+  if (urls.count() > 1 && image_data.size() >= SharedMemory::kThreshold) {
+    QSharedMemory *shared_memory = SharedMemory::Create(image_data, this);
+    if (shared_memory) {
+      tagreader_save_embedded_art_shared_memory_.insert(id, shared_memory);
+      for (const QUrl &url : urls) {
+        TagReaderReply *reply = TagReaderClient::Instance()->SaveEmbeddedArt(url.toLocalFile(), shared_memory, image_data.size());
+        tagreader_save_embedded_art_requests_.insert(id, reply);
+        QObject::connect(reply, &TagReaderReply::Finished, this, [this, id, reply]() { SaveEmbeddedArtFinished(id, reply, false); }, Qt::QueuedConnection);
+      }
+      return;
+    }
+  }
+
   for (const QUrl &url : urls) {
     SaveEmbeddedCover(id, url.toLocalFile(), image_data);
   }
@@ -697,6 +713,9 @@ void AlbumCoverLoader::SaveEmbeddedArtFinished(const quint64 id, TagReaderReply
   }
 
   if (!tagreader_save_embedded_art_requests_.contains(id)) {
+    if (tagreader_save_embedded_art_shared_memory_.contains(id)) {
+      delete tagreader_save_embedded_art_shared_memory_.take(id);
+    }
     emit SaveEmbeddedCoverAsyncFinished(id, reply->is_successful(), cleared);
   }
 
@@ -30,6 +30,7 @@
 #include <QPair>
 #include <QSet>
 #include <QHash>
+#include <QMap>
 #include <QMultiMap>
 #include <QQueue>
 #include <QByteArray>
@@ -46,6 +47,7 @@
 
 class QThread;
 class QNetworkReply;
+class QSharedMemory;
 class NetworkAccessManager;
 
 class AlbumCoverLoader : public QObject {
@@ -168,6 +170,7 @@ class AlbumCoverLoader : public QObject {
   QThread *original_thread_;
 
   QMultiMap<quint64, TagReaderReply*> tagreader_save_embedded_art_requests_;
+  QMap<quint64, QSharedMemory*> tagreader_save_embedded_art_shared_memory_;
 
 };
 
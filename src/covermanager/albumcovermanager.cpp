@@ -891,8 +891,8 @@ SongList AlbumCoverManager::GetSongsInAlbum(const QModelIndex &idx) const {
 
   SongList ret;
 
-  QMutexLocker l(collection_backend_->db()->Mutex());
-  QSqlDatabase db(collection_backend_->db()->Connect());
+  QMutexLocker l(collection_backend_->db()->ReadMutex());
+  QSqlDatabase db(collection_backend_->db()->ConnectReadOnly());
 
   CollectionQuery q(db, collection_backend_->songs_table(), collection_backend_->fts_table());
   q.SetColumnSpec("ROWID," + Song::kColumnSpec);
@@ -910,7 +910,7 @@ SongList AlbumCoverManager::GetSongsInAlbum(const QModelIndex &idx) const {
 
   while (q.Next()) {
     Song song;
-    song.InitFromQuery(q, true);
+    song.InitFromQuery(q, true, 0);
     ret << song;
   }
   return ret;
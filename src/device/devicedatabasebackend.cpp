@@ -27,15 +27,19 @@
 #include <QIODevice>
 #include <QFile>
 #include <QByteArray>
+#include <QList>
+#include <QPair>
 #include <QString>
 #include <QSqlDatabase>
 
+#include "core/logging.h"
 #include "core/database.h"
 #include "core/sqlquery.h"
 #include "core/scopedtransaction.h"
 #include "devicedatabasebackend.h"
 
-const int DeviceDatabaseBackend::kDeviceSchemaVersion = 3;
+const int DeviceDatabaseBackend::kDeviceSchemaVersion = 4;
+const int DeviceDatabaseBackend::kDeviceMinSchemaVersion = 3;
 
 DeviceDatabaseBackend::DeviceDatabaseBackend(QObject *parent)
     : QObject(parent),
@@ -74,6 +78,7 @@ DeviceDatabaseBackend::DeviceList DeviceDatabaseBackend::GetAllDevices() {
 
   DeviceList ret;
   DeviceList old_devices;
+  QList<QPair<int, int>> outdated_devices;
 
   {
     QMutexLocker l(db_->Mutex());
@@ -95,10 +100,13 @@ DeviceDatabaseBackend::DeviceList DeviceDatabaseBackend::GetAllDevices() {
       int schema_version = q.value(5).toInt();
       dev.transcode_mode_ = static_cast<MusicStorage::TranscodeMode>(q.value(6).toInt());
       dev.transcode_format_ = static_cast<Song::FileType>(q.value(7).toInt());
-      if (schema_version < kDeviceSchemaVersion) {  // Device is using old schema, drop it.
+      if (schema_version < kDeviceMinSchemaVersion) {  // Device is using old schema, drop it.
         old_devices << dev;
       }
       else {
+        if (schema_version < kDeviceSchemaVersion) {
+          outdated_devices << qMakePair(dev.id_, schema_version);
+        }
         ret << dev;
       }
     }
@@ -108,6 +116,10 @@ DeviceDatabaseBackend::DeviceList DeviceDatabaseBackend::GetAllDevices() {
     RemoveDevice(dev.id_);
   }
 
+  for (const QPair<int, int> &device : outdated_devices) {
+    UpdateDeviceSchema(device.first, device.second);
+  }
+
   Close();
 
   return ret;
@@ -153,6 +165,30 @@ int DeviceDatabaseBackend::AddDevice(const Device &device) {
 
 }
 
+void DeviceDatabaseBackend::UpdateDeviceSchema(const int id, const int schema_version) {
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  ScopedTransaction t(&db);
+
+  for (int version = schema_version + 1; version <= kDeviceSchemaVersion; ++version) {
+    qLog(Debug) << "Updating device" << id << "to schema version" << version;
+    QString filename(QString(":/schema/device-schema-%1.sql").arg(version));
+    QFile schema_file(filename);
+    if (!schema_file.open(QIODevice::ReadOnly)) {
+      qFatal("Couldn't open schema file %s: %s", filename.toUtf8().constData(), schema_file.errorString().toUtf8().constData());
+    }
+    QString schema = QString::fromUtf8(schema_file.readAll());
+    schema.replace("%deviceid", QString::number(id));
+
+    db_->ExecSchemaCommands(db, schema, version, true);
+  }
+
+  t.Commit();
+
+}
+
 void DeviceDatabaseBackend::RemoveDevice(const int id) {
 
   QMutexLocker l(db_->Mutex());
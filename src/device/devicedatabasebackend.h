@@ -56,6 +56,8 @@ class DeviceDatabaseBackend : public QObject {
   using DeviceList = QList<Device>;
 
   static const int kDeviceSchemaVersion;
+  // Devices with an older schema are removed, newer ones are updated in place.
+  static const int kDeviceMinSchemaVersion;
 
   void Init(Database *db);
   void Close();
@@ -69,6 +71,9 @@ class DeviceDatabaseBackend : public QObject {
 
   void SetDeviceOptions(const int id, const QString &friendly_name, const QString &icon_name, const MusicStorage::TranscodeMode mode, const Song::FileType format);
 
+ private:
+  void UpdateDeviceSchema(const int id, const int schema_version);
+
  private slots:
   void Exit();
 
@@ -23,6 +23,7 @@
 
 #include <QWidget>
 #include <QDialog>
+#include <QList>
 #include <QString>
 #include <QStringList>
 #include <QFont>
@@ -37,6 +38,7 @@
 #include "console.h"
 #include "core/application.h"
 #include "core/database.h"
+#include "core/tagreaderclient.h"
 
 Console::Console(Application *app, QWidget *parent) : QDialog(parent), ui_{}, app_(app) {
 
@@ -45,6 +47,7 @@ Console::Console(Application *app, QWidget *parent) : QDialog(parent), ui_{}, ap
   setWindowFlags(windowFlags() | Qt::WindowMaximizeButtonHint);
 
   QObject::connect(ui_.run, &QPushButton::clicked, this, &Console::RunQuery);
+  QObject::connect(ui_.workers, &QPushButton::clicked, this, &Console::ShowWorkers);
 
   QFont font("Monospace");
   font.setStyleHint(QFont::TypeWriter);
@@ -80,3 +83,21 @@ void Console::RunQuery() {
   ui_.output->verticalScrollBar()->setValue(ui_.output->verticalScrollBar()->maximum());
 
 }
+
+void Console::ShowWorkers() {
+
+  if (!TagReaderClient::Instance()) return;
+
+  ui_.output->append("<b>&gt; Tagreader workers</b>");
+  ui_.output->append("worker|pending|replies|average latency ms|max latency ms");
+
+  const QList<_WorkerPoolBase::WorkerStats> stats = TagReaderClient::Instance()->worker_stats();
+  for (int i = 0; i < stats.count(); ++i) {
+    const _WorkerPoolBase::WorkerStats &worker = stats[i];
+    const qint64 average_latency_msec = worker.replies > 0 ? worker.total_latency_msec / worker.replies : 0;
+    ui_.output->append(QString("%1|%2|%3|%4|%5").arg(i).arg(worker.pending).arg(worker.replies).arg(average_latency_msec).arg(worker.max_latency_msec));
+  }
+
+  ui_.output->verticalScrollBar()->setValue(ui_.output->verticalScrollBar()->maximum());
+
+}
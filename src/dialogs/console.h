@@ -41,6 +41,7 @@ class Console : public QDialog {
 
  private slots:
   void RunQuery();
+  void ShowWorkers();
 
  private:
   Ui::Console ui_;
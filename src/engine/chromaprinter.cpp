@@ -30,7 +30,7 @@
 #include <QtGlobal>
 #include <QCoreApplication>
 #include <QThread>
-#include <QIODevice>
+#include <QMutexLocker>
 #include <QByteArray>
 #include <QString>
 #include <QElapsedTimer>
@@ -50,7 +50,23 @@ static const int kTimeoutSecs = 10;
 
 Chromaprinter::Chromaprinter(const QString &filename)
     : filename_(filename),
-      convert_element_(nullptr) {}
+      pipeline_(nullptr),
+      src_element_(nullptr),
+      convert_element_(nullptr),
+      bus_(nullptr),
+      chromaprint_(nullptr),
+      samples_(0) {}
+
+Chromaprinter::~Chromaprinter() {
+
+  DestroyPipeline();
+
+  if (chromaprint_) {
+    chromaprint_free(chromaprint_);
+    chromaprint_ = nullptr;
+  }
+
+}
 
 GstElement *Chromaprinter::CreateElement(const QString &factory_name, GstElement *bin) {
 
@@ -66,30 +82,24 @@ GstElement *Chromaprinter::CreateElement(const QString &factory_name, GstElement
 
 }
 
-QString Chromaprinter::CreateFingerprint() {
+bool Chromaprinter::CreatePipeline() {
 
-  Q_ASSERT(QThread::currentThread() != qApp->thread());
+  pipeline_ = gst_pipeline_new("pipeline");
+  if (!pipeline_) return false;
 
-  if (!buffer_.open(QIODevice::WriteOnly)) return QString();
-
-  GstElement *pipeline = gst_pipeline_new("pipeline");
-  if (!pipeline) {
-    buffer_.close();
-    return QString();
-  }
-
-  GstElement *src = CreateElement("filesrc", pipeline);
-  GstElement *decode = CreateElement("decodebin", pipeline);
-  GstElement *convert = CreateElement("audioconvert", pipeline);
-  GstElement *resample = CreateElement("audioresample", pipeline);
-  GstElement *sink = CreateElement("appsink", pipeline);
+  GstElement *src = CreateElement("filesrc", pipeline_);
+  GstElement *decode = CreateElement("decodebin", pipeline_);
+  GstElement *convert = CreateElement("audioconvert", pipeline_);
+  GstElement *resample = CreateElement("audioresample", pipeline_);
+  GstElement *sink = CreateElement("appsink", pipeline_);
 
   if (!src || !decode || !convert || !resample || !sink) {
-    gst_object_unref(pipeline);
-    buffer_.close();
-    return QString();
+    gst_object_unref(pipeline_);
+    pipeline_ = nullptr;
+    return false;
   }
 
+  src_element_ = src;
   convert_element_ = convert;
 
   // Connect the elements
@@ -106,29 +116,71 @@ QString Chromaprinter::CreateFingerprint() {
   callbacks.new_sample = NewBufferCallback;
   gst_app_sink_set_callbacks(reinterpret_cast<GstAppSink*>(sink), &callbacks, this, nullptr);
   g_object_set(G_OBJECT(sink), "sync", FALSE, nullptr);
-  g_object_set(G_OBJECT(sink), "emit-signals", TRUE, nullptr);
-
-  // Set the filename
-  g_object_set(src, "location", filename_.toUtf8().constData(), nullptr);
 
   // Connect signals
-  GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline));
+  bus_ = gst_pipeline_get_bus(GST_PIPELINE(pipeline_));
   CHECKED_GCONNECT(decode, "pad-added", &NewPadCallback, this);
 
+  return true;
+
+}
+
+void Chromaprinter::DestroyPipeline() {
+
+  if (bus_) {
+    gst_object_unref(bus_);
+    bus_ = nullptr;
+  }
+
+  if (pipeline_) {
+    gst_element_set_state(pipeline_, GST_STATE_NULL);
+    gst_object_unref(pipeline_);
+    pipeline_ = nullptr;
+  }
+
+  src_element_ = nullptr;
+  convert_element_ = nullptr;
+
+}
+
+QString Chromaprinter::CreateFingerprint() {
+
+  return CreateFingerprint(filename_);
+
+}
+
+QString Chromaprinter::CreateFingerprint(const QString &filename) {
+
+  Q_ASSERT(QThread::currentThread() != qApp->thread());
+
+  if (!pipeline_ && !CreatePipeline()) return QString();
+
+  if (!chromaprint_) {
+    chromaprint_ = chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
+  }
+
+  // The decoded audio is fed to Chromaprint from the streaming thread as it arrives.
+  chromaprint_start(chromaprint_, kDecodeRate, kDecodeChannels);
+  samples_ = 0;
+
+  // Set the filename, the pipeline is in the NULL or READY state here, so the file is not open.
+  g_object_set(src_element_, "location", filename.toUtf8().constData(), nullptr);
+
   // Play only first x seconds
-  gst_element_set_state(pipeline, GST_STATE_PAUSED);
+  gst_element_set_state(pipeline_, GST_STATE_PAUSED);
   // wait for state change before seeking
-  gst_element_get_state(pipeline, nullptr, nullptr, kTimeoutSecs * GST_SECOND);
-  gst_element_seek(pipeline, 1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH, GST_SEEK_TYPE_SET, 0 * GST_SECOND, GST_SEEK_TYPE_SET, kPlayLengthSecs * GST_SECOND);
+  gst_element_get_state(pipeline_, nullptr, nullptr, kTimeoutSecs * GST_SECOND);
+  gst_element_seek(pipeline_, 1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH, GST_SEEK_TYPE_SET, 0 * GST_SECOND, GST_SEEK_TYPE_SET, kPlayLengthSecs * GST_SECOND);
 
   QElapsedTimer time;
   time.start();
 
   // Start playing
-  gst_element_set_state(pipeline, GST_STATE_PLAYING);
+  gst_element_set_state(pipeline_, GST_STATE_PLAYING);
 
   // Wait until EOS or error
-  GstMessage *msg = gst_bus_timed_pop_filtered(bus, kTimeoutSecs * GST_SECOND, static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+  bool reuse_pipeline = false;
+  GstMessage *msg = gst_bus_timed_pop_filtered(bus_, kTimeoutSecs * GST_SECOND, static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
   if (msg) {
     if (msg->type == GST_MESSAGE_ERROR) {
       // Report error
@@ -138,51 +190,50 @@ QString Chromaprinter::CreateFingerprint() {
       if (error) {
         QString message = QString::fromLocal8Bit(error->message);
         g_error_free(error);
-        qLog(Debug) << "Error processing" << filename_ << ":" << message;
+        qLog(Debug) << "Error processing" << filename << ":" << message;
       }
       if (debugs) free(debugs);
     }
+    else {
+      reuse_pipeline = true;
+    }
     gst_message_unref(msg);
   }
 
-  const qint64 decode_time = time.restart();
-
-  buffer_.close();
-
-  // Generate fingerprint from recorded buffer data
-  QByteArray data = buffer_.data();
+  // Going back to READY closes the file and lets decodebin drop the elements it plugged for this file.
+  // After an error or a timeout, the pipeline is rebuilt for the next file instead.
+  if (reuse_pipeline && gst_element_set_state(pipeline_, GST_STATE_READY) != GST_STATE_CHANGE_FAILURE) {
+    gst_bus_set_flushing(bus_, TRUE);
+    gst_bus_set_flushing(bus_, FALSE);
+  }
+  else {
+    DestroyPipeline();
+  }
 
-  ChromaprintContext *chromaprint = chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
-  chromaprint_start(chromaprint, kDecodeRate, kDecodeChannels);
-  chromaprint_feed(chromaprint, reinterpret_cast<int16_t*>(data.data()), static_cast<int>(data.size() / 2));
-  chromaprint_finish(chromaprint);
+  const qint64 decode_time = time.restart();
 
-  u_int32_t *fprint = nullptr;
-  int size = 0;
-  int ret = chromaprint_get_raw_fingerprint(chromaprint, &fprint, &size);
+  // Generate fingerprint from the audio fed so far
   QByteArray fingerprint;
-  if (ret == 1) {
-    char *encoded = nullptr;
-    int encoded_size = 0;
-    ret = chromaprint_encode_fingerprint(fprint, size, CHROMAPRINT_ALGORITHM_DEFAULT, &encoded, &encoded_size, 1);
+  if (samples_ > 0 && chromaprint_finish(chromaprint_) == 1) {
+    u_int32_t *fprint = nullptr;
+    int size = 0;
+    int ret = chromaprint_get_raw_fingerprint(chromaprint_, &fprint, &size);
     if (ret == 1) {
-      fingerprint.append(reinterpret_cast<char*>(encoded), encoded_size);
-      chromaprint_dealloc(encoded);
+      char *encoded = nullptr;
+      int encoded_size = 0;
+      ret = chromaprint_encode_fingerprint(fprint, size, CHROMAPRINT_ALGORITHM_DEFAULT, &encoded, &encoded_size, 1);
+      if (ret == 1) {
+        fingerprint.append(reinterpret_cast<char*>(encoded), encoded_size);
+        chromaprint_dealloc(encoded);
+      }
+      chromaprint_dealloc(fprint);
     }
-    chromaprint_dealloc(fprint);
   }
-  chromaprint_free(chromaprint);
 
   const qint64 codegen_time = time.elapsed();
 
   qLog(Debug) << "Decode time:" << decode_time << "Codegen time:" << codegen_time;
 
-  // Cleanup
-  callbacks.new_sample = nullptr;
-  gst_object_unref(bus);
-  gst_element_set_state(pipeline, GST_STATE_NULL);
-  gst_object_unref(pipeline);
-
   return fingerprint;
 
 }
@@ -212,7 +263,9 @@ GstFlowReturn Chromaprinter::NewBufferCallback(GstAppSink *app_sink, gpointer se
   if (buffer) {
     GstMapInfo map;
     if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
-      me->buffer_.write(reinterpret_cast<const char*>(map.data), static_cast<qint64>(map.size));
+      const int samples = static_cast<int>(map.size / sizeof(int16_t));
+      chromaprint_feed(me->chromaprint_, reinterpret_cast<const int16_t*>(map.data), samples);
+      me->samples_ += samples;
       gst_buffer_unmap(buffer, &map);
     }
   }
@@ -222,3 +275,44 @@ GstFlowReturn Chromaprinter::NewBufferCallback(GstAppSink *app_sink, gpointer se
 
 }
 
+ChromaprinterPool::ChromaprinterPool() : files_(0), total_msec_(0) {}
+
+ChromaprinterPool::~ChromaprinterPool() {
+
+  qDeleteAll(idle_);
+  idle_.clear();
+
+}
+
+void ChromaprinterPool::ResetCounters() {
+
+  files_ = 0;
+  total_msec_ = 0;
+
+}
+
+QString ChromaprinterPool::CreateFingerprint(const QString &filename) {
+
+  Chromaprinter *chromaprinter = nullptr;
+  {
+    QMutexLocker l(&mutex_);
+    if (!idle_.isEmpty()) chromaprinter = idle_.takeLast();
+  }
+  if (!chromaprinter) chromaprinter = new Chromaprinter;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  const QString fingerprint = chromaprinter->CreateFingerprint(filename);
+
+  ++files_;
+  total_msec_ += timer.elapsed();
+
+  {
+    QMutexLocker l(&mutex_);
+    idle_ << chromaprinter;
+  }
+
+  return fingerprint;
+
+}
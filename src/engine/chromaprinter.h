@@ -24,41 +24,81 @@
 
 #include "config.h"
 
+#include <atomic>
+
 #include <glib.h>
+#include <chromaprint.h>
 #include <gst/gst.h>
 #include <gst/app/gstappsink.h>
 
-#include <QBuffer>
+#include <QtGlobal>
+#include <QMutex>
+#include <QList>
 #include <QString>
 
 class Chromaprinter {
   // Creates a Chromaprint fingerprint from a song.
-  // Uses GStreamer to open and decode the file as PCM data and passes this to Chromaprint's code generator.
+  // Uses GStreamer to open and decode the file as PCM data and passes this to Chromaprint's code generator as it is decoded.
   // The generated code can be used to identify a song via Acoustid.
-  // You should create one Chromaprinter for each file you want to fingerprint.
+  // The decode pipeline is kept after a file is done, so one Chromaprinter can fingerprint many files, one at a time.
   // This class works well with QtConcurrentMap.
 
  public:
-  explicit Chromaprinter(const QString &filename);
+  explicit Chromaprinter(const QString &filename = QString());
+  ~Chromaprinter();
 
   // Creates a fingerprint from the song.
   // This method is blocking, so you want to call it in another thread.
   // Returns an empty string if no fingerprint could be created.
   QString CreateFingerprint();
+  QString CreateFingerprint(const QString &filename);
 
  private:
+  Q_DISABLE_COPY(Chromaprinter)
+
   static GstElement *CreateElement(const QString &factory_name, GstElement *bin = nullptr);
 
+  bool CreatePipeline();
+  void DestroyPipeline();
+
   static void NewPadCallback(GstElement*, GstPad *pad, gpointer data);
   static GstFlowReturn NewBufferCallback(GstAppSink *app_sink, gpointer self);
 
  private:
   QString filename_;
 
+  GstElement *pipeline_;
+  GstElement *src_element_;
   GstElement *convert_element_;
+  GstBus *bus_;
+
+  ChromaprintContext *chromaprint_;
+  qint64 samples_;
+
+};
+
+// Keeps idle Chromaprinters, so their decode pipelines are reused by the next file instead of being built for every file.
+// CreateFingerprint() is thread-safe, one Chromaprinter is used for each call running at the same time.
+class ChromaprinterPool {
+ public:
+  explicit ChromaprinterPool();
+  ~ChromaprinterPool();
+
+  QString CreateFingerprint(const QString &filename);
+
+  // Number of files fingerprinted, and the time spent on them summed over all threads.
+  int files() const { return files_; }
+  qint64 total_msec() const { return total_msec_; }
+  void ResetCounters();
+
+ private:
+  Q_DISABLE_COPY(ChromaprinterPool)
 
-  QBuffer buffer_;
+  QMutex mutex_;
+  QList<Chromaprinter*> idle_;
 
+  std::atomic<int> files_;
+  std::atomic<qint64> total_msec_;
 };
 
 #endif  // CHROMAPRINTER_H
@@ -68,6 +68,8 @@ class Base : public QObject {
   virtual bool Init() = 0;
   virtual State state() const = 0;
   virtual void StartPreloading(const QUrl&, const QUrl&, const bool, const qint64, const qint64) {}
+  // Prepares playback of a song the user is likely to skip to, so loading it later is faster.
+  virtual void Preroll(const QUrl&, const QUrl&, const bool, const qint64, const qint64) {}
   virtual bool Load(const QUrl &stream_url, const QUrl &original_url, const TrackChangeFlags change, const bool force_stop_at_end, const quint64 beginning_nanosec, const qint64 end_nanosec);
   virtual bool Play(const quint64 offset_nanosec) = 0;
   virtual void Stop(const bool stop_after = false) = 0;
@@ -27,7 +27,6 @@
 #include <memory>
 #include <algorithm>
 #include <vector>
-#include <cmath>
 
 #include <gst/gst.h>
 #include <gst/pbutils/pbutils.h>
@@ -55,6 +54,7 @@
 #include "enginetype.h"
 #include "gstengine.h"
 #include "gstenginepipeline.h"
+#include "gstenginemixer.h"
 #include "gstbufferconsumer.h"
 
 const char *GstEngine::kAutoSink = "autoaudiosink";
@@ -70,6 +70,7 @@ const char *GstEngine::InterAudiosink = "interaudiosink";
 const char *GstEngine::kDirectSoundSink = "directsoundsink";
 const char *GstEngine::kOSXAudioSink = "osxaudiosink";
 const int GstEngine::kDiscoveryTimeoutS = 10;
+const int GstEngine::kPrerolledPipelineCount = 2;
 
 GstEngine::GstEngine(TaskManager *task_manager, QObject *parent)
     : Engine::Base(Engine::GStreamer, parent),
@@ -77,7 +78,9 @@ GstEngine::GstEngine(TaskManager *task_manager, QObject *parent)
       gst_startup_(nullptr),
       discoverer_(nullptr),
       buffering_task_id_(-1),
-      latest_buffer_(nullptr),
+      mixer_unavailable_(false),
+      track_change_pipeline_id_(-1),
+      track_change_prerolled_(false),
       stereo_balancer_enabled_(false),
       stereo_balance_(0.0F),
       equalizer_enabled_(false),
@@ -88,9 +91,6 @@ GstEngine::GstEngine(TaskManager *task_manager, QObject *parent)
       timer_id_(-1),
       is_fading_out_to_pause_(false),
       has_faded_out_(false),
-      scope_chunk_(0),
-      have_new_buffer_(false),
-      scope_chunks_(0),
       discovery_finished_cb_id_(-1),
       discovery_discovered_cb_id_(-1) {
 
@@ -106,11 +106,7 @@ GstEngine::~GstEngine() {
 
   EnsureInitialized();
   current_pipeline_.reset();
-
-  if (latest_buffer_) {
-    gst_buffer_unref(latest_buffer_);
-    latest_buffer_ = nullptr;
-  }
+  prerolled_pipelines_.clear();
 
   if (discoverer_) {
 
@@ -173,6 +169,68 @@ void GstEngine::StartPreloading(const QUrl &stream_url, const QUrl &original_url
 
 }
 
+void GstEngine::Preroll(const QUrl &stream_url, const QUrl &original_url, const bool force_stop_at_end, const qint64 beginning_nanosec, const qint64 end_nanosec) {
+
+  Q_UNUSED(beginning_nanosec)
+
+  // Only files are prerolled, prerolling streams would open a connection for every song skipped past.
+  if (!stream_url.isLocalFile()) return;
+
+  // These sinks can open the device exclusively, so a second pipeline can't preroll.
+  if (output_ == kALSASink || output_ == kOSSSink || output_ == kOSS4Sink) return;
+
+  EnsureInitialized();
+
+  const QByteArray gst_url = FixupUrl(stream_url);
+  const qint64 pipeline_end_nanosec = force_stop_at_end ? end_nanosec : 0;
+
+  if (current_pipeline_ && current_pipeline_->stream_url() == gst_url) return;
+
+  for (int i = 0; i < prerolled_pipelines_.count(); ++i) {
+    if (prerolled_pipelines_[i].gst_url == gst_url && prerolled_pipelines_[i].end_nanosec == pipeline_end_nanosec) {
+      prerolled_pipelines_.move(i, prerolled_pipelines_.count() - 1);
+      return;
+    }
+  }
+
+  std::shared_ptr<GstEnginePipeline> pipeline = CreatePipeline();
+  QString error;
+  if (!pipeline->InitFromUrl(gst_url, original_url, pipeline_end_nanosec, error)) {
+    qLog(Warning) << "Failed to preroll" << gst_url << error;
+    return;
+  }
+  pipeline->SetState(GST_STATE_PAUSED);
+
+  PrerolledPipeline prerolled_pipeline;
+  prerolled_pipeline.gst_url = gst_url;
+  prerolled_pipeline.end_nanosec = pipeline_end_nanosec;
+  prerolled_pipeline.pipeline = pipeline;
+  prerolled_pipeline.has_metadata = false;
+  prerolled_pipelines_ << prerolled_pipeline;
+  while (prerolled_pipelines_.count() > kPrerolledPipelineCount) {
+    prerolled_pipelines_.removeFirst();
+  }
+
+  qLog(Debug) << "Prerolling" << gst_url;
+
+}
+
+std::shared_ptr<GstEnginePipeline> GstEngine::TakePrerolledPipeline(const QByteArray &gst_url, const qint64 end_nanosec) {
+
+  for (int i = 0; i < prerolled_pipelines_.count(); ++i) {
+    if (prerolled_pipelines_[i].gst_url == gst_url && prerolled_pipelines_[i].end_nanosec == end_nanosec) {
+      const PrerolledPipeline prerolled_pipeline = prerolled_pipelines_.takeAt(i);
+      // Prerolling failed, the pipeline would only report the error again.
+      if (prerolled_pipeline.pipeline->state() == GST_STATE_NULL) return nullptr;
+      if (prerolled_pipeline.has_metadata) emit MetaData(prerolled_pipeline.metadata);
+      return prerolled_pipeline.pipeline;
+    }
+  }
+
+  return nullptr;
+
+}
+
 bool GstEngine::Load(const QUrl &stream_url, const QUrl &original_url, Engine::TrackChangeFlags change, const bool force_stop_at_end, const quint64 beginning_nanosec, const qint64 end_nanosec) {
 
   EnsureInitialized();
@@ -191,8 +249,13 @@ bool GstEngine::Load(const QUrl &stream_url, const QUrl &original_url, Engine::T
     return true;
   }
 
-  std::shared_ptr<GstEnginePipeline> pipeline = CreatePipeline(gst_url, original_url, force_stop_at_end ? end_nanosec : 0);
+  track_change_timer_.start();
+
+  std::shared_ptr<GstEnginePipeline> pipeline = TakePrerolledPipeline(gst_url, force_stop_at_end ? end_nanosec : 0);
+  track_change_prerolled_ = static_cast<bool>(pipeline);
+  if (!pipeline) pipeline = CreatePipeline(gst_url, original_url, force_stop_at_end ? end_nanosec : 0);
   if (!pipeline) return false;
+  track_change_pipeline_id_ = pipeline->id();
 
   if (crossfade) StartFadeout();
 
@@ -273,6 +336,7 @@ void GstEngine::Stop(const bool stop_after) {
   if (fadeout_enabled_ && current_pipeline_ && !stop_after) StartFadeout();
 
   current_pipeline_.reset();
+  prerolled_pipelines_.clear();
   BufferingFinished();
   emit StateChanged(Engine::Empty);
 
@@ -370,23 +434,17 @@ qint64 GstEngine::length_nanosec() const {
 
 const Engine::Scope &GstEngine::scope(const int chunk_length) {
 
-  // The new buffer could have a different size
-  if (have_new_buffer_) {
-    if (latest_buffer_) {
-      scope_chunks_ = ceil((static_cast<double>(GST_BUFFER_DURATION(latest_buffer_) / static_cast<double>(chunk_length * kNsecPerMsec))));
-    }
+  Q_UNUSED(chunk_length)
 
-    // if the buffer is shorter than the chunk length
-    if (scope_chunks_ <= 0) {
-      scope_chunks_ = 1;
-    }
+  if (!current_pipeline_) return scope_;
 
-    scope_chunk_ = 0;
-    have_new_buffer_ = false;
-  }
+  // Read the audio that is playing now, the scope keeps the last audio if there is none.
+  const qint64 running_time = current_pipeline_->running_time();
+  if (running_time < 0) return scope_;
 
-  if (latest_buffer_) {
-    UpdateScope(chunk_length);
+  const int samples = current_pipeline_->analyzer_buffer()->Read(running_time, scope_.data(), static_cast<int>(scope_.size()));
+  if (samples > 0 && samples < static_cast<int>(scope_.size())) {
+    std::fill(scope_.begin() + samples, scope_.end(), 0);
   }
 
   return scope_;
@@ -440,15 +498,12 @@ void GstEngine::ReloadSettings() {
 
   if (output_.isEmpty()) output_ = kAutoSink;
 
-}
+  // Prerolled pipelines use the old settings.
+  prerolled_pipelines_.clear();
 
-void GstEngine::ConsumeBuffer(GstBuffer *buffer, const int pipeline_id, const QString &format) {
-
-  // Schedule this to run in the GUI thread.  The buffer gets added to the queue and unreffed by UpdateScope.
-  if (!QMetaObject::invokeMethod(this, "AddBufferToScope", Q_ARG(GstBuffer*, buffer), Q_ARG(int, pipeline_id), Q_ARG(QString, format))) {
-    qLog(Warning) << "Failed to invoke AddBufferToScope on GstEngine";
-    gst_buffer_unref(buffer);
-  }
+  // Playing pipelines keep the old mixer until they are finished, new pipelines get a mixer for the new output.
+  mixer_.reset();
+  mixer_unavailable_ = false;
 
 }
 
@@ -456,6 +511,9 @@ void GstEngine::SetStereoBalancerEnabled(const bool enabled) {
 
   stereo_balancer_enabled_ = enabled;
   if (current_pipeline_) current_pipeline_->set_stereo_balancer_enabled(enabled);
+  for (const PrerolledPipeline &prerolled_pipeline : prerolled_pipelines_) {
+    prerolled_pipeline.pipeline->set_stereo_balancer_enabled(enabled);
+  }
 
 }
 
@@ -470,6 +528,9 @@ void GstEngine::SetEqualizerEnabled(const bool enabled) {
 
   equalizer_enabled_ = enabled;
   if (current_pipeline_) current_pipeline_->set_equalizer_enabled(enabled);
+  for (const PrerolledPipeline &prerolled_pipeline : prerolled_pipelines_) {
+    prerolled_pipeline.pipeline->set_equalizer_enabled(enabled);
+  }
 
 }
 
@@ -562,28 +623,31 @@ void GstEngine::HandlePipelineError(const int pipeline_id, const int domain, con
 
 }
 
-void GstEngine::NewMetaData(const int pipeline_id, const Engine::SimpleMetaBundle &bundle) {
+void GstEngine::HandleMixerError(const int domain, const int error_code, const QString &message, const QString &debugstr) {
 
-  if (!current_pipeline_.get() || current_pipeline_->id() != pipeline_id) return;
-  emit MetaData(bundle);
+  // The mixer can't recover from an error, the next pipeline gets a new one.
+  if (sender() == mixer_.get()) mixer_.reset();
+
+  if (current_pipeline_) HandlePipelineError(current_pipeline_->id(), domain, error_code, message, debugstr);
 
 }
 
-void GstEngine::AddBufferToScope(GstBuffer *buf, const int pipeline_id, const QString &format) {
+void GstEngine::NewMetaData(const int pipeline_id, const Engine::SimpleMetaBundle &bundle) {
 
-  if (!current_pipeline_ || current_pipeline_->id() != pipeline_id) {
-    gst_buffer_unref(buf);
+  if (current_pipeline_ && current_pipeline_->id() == pipeline_id) {
+    emit MetaData(bundle);
     return;
   }
 
-  if (latest_buffer_) {
-    gst_buffer_unref(latest_buffer_);
+  // Keep the tags from a prerolled pipeline until it's played.
+  for (PrerolledPipeline &prerolled_pipeline : prerolled_pipelines_) {
+    if (prerolled_pipeline.pipeline->id() == pipeline_id) {
+      prerolled_pipeline.has_metadata = true;
+      prerolled_pipeline.metadata = bundle;
+      return;
+    }
   }
 
-  buffer_format_ = format;
-  latest_buffer_ = buf;
-  have_new_buffer_ = true;
-
 }
 
 void GstEngine::FadeoutFinished() {
@@ -656,6 +720,19 @@ void GstEngine::PlayDone(const GstStateChangeReturn ret, const quint64 offset_na
 
 }
 
+void GstEngine::PlaybackStarted(const int pipeline_id) {
+
+  if (pipeline_id != track_change_pipeline_id_ || !track_change_timer_.isValid()) return;
+
+  // The sink plays the first audio after the pipeline latency.
+  const qint64 latency_msec = current_pipeline_ && current_pipeline_->id() == pipeline_id ? current_pipeline_->latency_nanosec() / kNsecPerMsec : 0;
+  qLog(Debug) << "Track change took" << track_change_timer_.elapsed() + latency_msec << "ms until audible, including" << latency_msec << "ms latency," << (track_change_prerolled_ ? "using a prerolled pipeline" : "using a new pipeline");
+
+  track_change_timer_.invalidate();
+  track_change_pipeline_id_ = -1;
+
+}
+
 void GstEngine::BufferingStarted() {
 
   if (buffering_task_id_ != -1) {
@@ -750,6 +827,7 @@ void GstEngine::StartFadeout() {
 
   if (is_fading_out_to_pause_) return;
 
+  // The fades are sample accurate within each pipeline, the mixer plays the old and the new pipeline through one audio sink.
   fadeout_pipeline_ = current_pipeline_;
   QObject::disconnect(fadeout_pipeline_.get(), nullptr, nullptr, nullptr);
   fadeout_pipeline_->RemoveAllBufferConsumers();
@@ -785,12 +863,36 @@ void GstEngine::StopTimers() {
   }
 }
 
+std::shared_ptr<GstEngineMixer> GstEngine::GetMixer() {
+
+  if (!(crossfade_enabled_ || autocrossfade_enabled_) || mixer_unavailable_) return nullptr;
+
+  if (!mixer_) {
+    std::shared_ptr<GstEngineMixer> mixer = std::make_shared<GstEngineMixer>();
+    mixer->set_output_device(output_, device_);
+    QString error;
+    if (!mixer->Init(error)) {
+      // Without the mixer each pipeline plays to its own audio sink.
+      qLog(Warning) << "Not mixing crossfades into one audio sink:" << error;
+      mixer_unavailable_ = true;
+      return nullptr;
+    }
+    // Queued, because the mixer can be deleted by the error handling.
+    QObject::connect(mixer.get(), &GstEngineMixer::Error, this, &GstEngine::HandleMixerError, Qt::QueuedConnection);
+    mixer_ = mixer;
+  }
+
+  return mixer_;
+
+}
+
 std::shared_ptr<GstEnginePipeline> GstEngine::CreatePipeline() {
 
   EnsureInitialized();
 
   std::shared_ptr<GstEnginePipeline> ret = std::make_shared<GstEnginePipeline>();
   ret->set_output_device(output_, device_);
+  ret->set_mixer(GetMixer());
   ret->set_volume_enabled(volume_control_);
   ret->set_stereo_balancer_enabled(stereo_balancer_enabled_);
   ret->set_equalizer_enabled(equalizer_enabled_);
@@ -802,7 +904,6 @@ std::shared_ptr<GstEnginePipeline> GstEngine::CreatePipeline() {
   ret->set_channels(channels_enabled_, channels_);
   ret->set_bs2b_enabled(bs2b_enabled_);
 
-  ret->AddBufferConsumer(this);
   for (GstBufferConsumer *consumer : buffer_consumers_) {
     ret->AddBufferConsumer(consumer);
   }
@@ -813,6 +914,7 @@ std::shared_ptr<GstEnginePipeline> GstEngine::CreatePipeline() {
   QObject::connect(ret.get(), &GstEnginePipeline::BufferingStarted, this, &GstEngine::BufferingStarted);
   QObject::connect(ret.get(), &GstEnginePipeline::BufferingProgress, this, &GstEngine::BufferingProgress);
   QObject::connect(ret.get(), &GstEnginePipeline::BufferingFinished, this, &GstEngine::BufferingFinished);
+  QObject::connect(ret.get(), &GstEnginePipeline::PlaybackStarted, this, &GstEngine::PlaybackStarted);
 
   return ret;
 
@@ -833,68 +935,6 @@ std::shared_ptr<GstEnginePipeline> GstEngine::CreatePipeline(const QByteArray &g
 
 }
 
-void GstEngine::UpdateScope(const int chunk_length) {
-
-  using sample_type = Engine::Scope::value_type;
-
-  // Prevent dbz or invalid chunk size
-  if (!GST_CLOCK_TIME_IS_VALID(GST_BUFFER_DURATION(latest_buffer_))) return;
-  if (GST_BUFFER_DURATION(latest_buffer_) == 0) return;
-
-  GstMapInfo map;
-  gst_buffer_map(latest_buffer_, &map, GST_MAP_READ);
-
-  // Determine where to split the buffer
-  int chunk_density = static_cast<int>((map.size * kNsecPerMsec) / GST_BUFFER_DURATION(latest_buffer_));
-
-  int chunk_size = chunk_length * chunk_density;
-
-  // In case a buffer doesn't arrive in time
-  if (scope_chunk_ >= scope_chunks_) {
-    scope_chunk_ = 0;
-    gst_buffer_unmap(latest_buffer_, &map);
-    return;
-  }
-
-  const sample_type *source = reinterpret_cast<sample_type*>(map.data);
-  sample_type *dest = scope_.data();
-  source += (chunk_size / sizeof(sample_type)) * scope_chunk_;
-
-  size_t bytes = 0;
-
-  // Make sure we don't go beyond the end of the buffer
-  if (scope_chunk_ == scope_chunks_ - 1) {
-    bytes = qMin(static_cast<Engine::Scope::size_type>(map.size - (chunk_size * scope_chunk_)), scope_.size() * sizeof(sample_type));
-  }
-  else {
-    bytes = qMin(static_cast<Engine::Scope::size_type>(chunk_size), scope_.size() * sizeof(sample_type));
-  }
-
-  scope_chunk_++;
-
-  if (buffer_format_.startsWith("S16LE") ||
-      buffer_format_.startsWith("U16LE") ||
-      buffer_format_.startsWith("S24LE") ||
-      buffer_format_.startsWith("S24_32LE") ||
-      buffer_format_.startsWith("S32LE") ||
-      buffer_format_.startsWith("F32LE")
-  ) {
-    memcpy(dest, source, bytes);
-  }
-  else {
-    memset(dest, 0, bytes);
-  }
-
-  gst_buffer_unmap(latest_buffer_, &map);
-
-  if (scope_chunk_ == scope_chunks_) {
-    gst_buffer_unref(latest_buffer_);
-    latest_buffer_ = nullptr;
-    buffer_format_.clear();
-  }
-
-}
-
 void GstEngine::StreamDiscovered(GstDiscoverer*, GstDiscovererInfo *info, GError*, gpointer self) {
 
   GstEngine *instance = reinterpret_cast<GstEngine*>(self);
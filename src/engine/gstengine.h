@@ -33,6 +33,7 @@
 #include <QtGlobal>
 #include <QObject>
 #include <QFuture>
+#include <QElapsedTimer>
 #include <QByteArray>
 #include <QList>
 #include <QString>
@@ -42,19 +43,20 @@
 #include "engine_fwd.h"
 #include "enginebase.h"
 #include "gststartup.h"
-#include "gstbufferconsumer.h"
 
 class QTimer;
 class QTimerEvent;
 class TaskManager;
 class GstEnginePipeline;
+class GstEngineMixer;
+class GstBufferConsumer;
 
 /**
  * @class GstEngine
  * @short GStreamer engine plugin
  * @author Mark Kretschmann <markey@web.de>
  */
-class GstEngine : public Engine::Base, public GstBufferConsumer {
+class GstEngine : public Engine::Base {
   Q_OBJECT
 
  public:
@@ -64,6 +66,7 @@ class GstEngine : public Engine::Base, public GstBufferConsumer {
   bool Init() override;
   Engine::State state() const override;
   void StartPreloading(const QUrl &stream_url, const QUrl &original_url, const bool force_stop_at_end, const qint64 beginning_nanosec, const qint64 end_nanosec) override;
+  void Preroll(const QUrl &stream_url, const QUrl &original_url, const bool force_stop_at_end, const qint64 beginning_nanosec, const qint64 end_nanosec) override;
   bool Load(const QUrl &stream_url, const QUrl &original_url, const Engine::TrackChangeFlags change, const bool force_stop_at_end, const quint64 beginning_nanosec, const qint64 end_nanosec) override;
   bool Play(const quint64 offset_nanosec) override;
   void Stop(const bool stop_after = false) override;
@@ -88,8 +91,6 @@ class GstEngine : public Engine::Base, public GstBufferConsumer {
   void SetStartup(GstStartup *gst_startup) { gst_startup_ = gst_startup; }
   void EnsureInitialized() { gst_startup_->EnsureInitialized(); }
 
-  void ConsumeBuffer(GstBuffer *buffer, const int pipeline_id, const QString &format) override;
-
  public slots:
   void ReloadSettings() override;
 
@@ -114,12 +115,13 @@ class GstEngine : public Engine::Base, public GstBufferConsumer {
  private slots:
   void EndOfStreamReached(const int pipeline_id, const bool has_next_track);
   void HandlePipelineError(const int pipeline_id, const int domain, const int error_code, const QString &message, const QString &debugstr);
+  void HandleMixerError(const int domain, const int error_code, const QString &message, const QString &debugstr);
   void NewMetaData(const int pipeline_id, const Engine::SimpleMetaBundle &bundle);
-  void AddBufferToScope(GstBuffer *buf, const int pipeline_id, const QString &format);
   void FadeoutFinished();
   void FadeoutPauseFinished();
   void SeekNow();
   void PlayDone(const GstStateChangeReturn ret, const quint64, const int);
+  void PlaybackStarted(const int pipeline_id);
 
   void BufferingStarted();
   void BufferingProgress(int percent);
@@ -135,10 +137,12 @@ class GstEngine : public Engine::Base, public GstBufferConsumer {
   void StartTimers();
   void StopTimers();
 
+  // Returns the mixer the pipelines play to when crossfading, or nullptr if they use their own audio sink.
+  std::shared_ptr<GstEngineMixer> GetMixer();
   std::shared_ptr<GstEnginePipeline> CreatePipeline();
   std::shared_ptr<GstEnginePipeline> CreatePipeline(const QByteArray &gst_url, const QUrl &original_url, const qint64 end_nanosec);
-
-  void UpdateScope(int chunk_length);
+  // Returns the prerolled pipeline for the URL and removes it from the pool, or nullptr if there is none.
+  std::shared_ptr<GstEnginePipeline> TakePrerolledPipeline(const QByteArray &gst_url, const qint64 end_nanosec);
 
   static void StreamDiscovered(GstDiscoverer*, GstDiscovererInfo *info, GError*, gpointer self);
   static void StreamDiscoveryFinished(GstDiscoverer*, gpointer);
@@ -158,6 +162,7 @@ class GstEngine : public Engine::Base, public GstBufferConsumer {
   static const char *kDirectSoundSink;
   static const char *kOSXAudioSink;
   static const int kDiscoveryTimeoutS;
+  static const int kPrerolledPipelineCount;
   static const qint64 kTimerIntervalNanosec = 1000 * kNsecPerMsec;  // 1s
   static const qint64 kPreloadGapNanosec = 5000 * kNsecPerMsec;     // 5s
   static const qint64 kSeekDelayNanosec = 100 * kNsecPerMsec;       // 100msec
@@ -171,12 +176,30 @@ class GstEngine : public Engine::Base, public GstBufferConsumer {
   std::shared_ptr<GstEnginePipeline> current_pipeline_;
   std::shared_ptr<GstEnginePipeline> fadeout_pipeline_;
   std::shared_ptr<GstEnginePipeline> fadeout_pause_pipeline_;
+
+  // Mixes the pipelines into one audio sink, created for the current output when the first pipeline needs it.
+  std::shared_ptr<GstEngineMixer> mixer_;
+  bool mixer_unavailable_;
+
+  // Paused pipelines for the songs the user is likely to skip to, the oldest is removed when the pool is full.
+  struct PrerolledPipeline {
+    QByteArray gst_url;
+    qint64 end_nanosec;
+    std::shared_ptr<GstEnginePipeline> pipeline;
+    // The last tags found while prerolling, emitted when the pipeline is taken.
+    bool has_metadata;
+    Engine::SimpleMetaBundle metadata;
+  };
+  QList<PrerolledPipeline> prerolled_pipelines_;
+
+  // Measures the time from loading a song until it's audible.
+  QElapsedTimer track_change_timer_;
+  int track_change_pipeline_id_;
+  bool track_change_prerolled_;
   QUrl preloaded_url_;
 
   QList<GstBufferConsumer*> buffer_consumers_;
 
-  GstBuffer *latest_buffer_;
-
   bool stereo_balancer_enabled_;
   float stereo_balance_;
 
@@ -194,11 +217,6 @@ class GstEngine : public Engine::Base, public GstBufferConsumer {
   bool is_fading_out_to_pause_;
   bool has_faded_out_;
 
-  int scope_chunk_;
-  bool have_new_buffer_;
-  int scope_chunks_;
-  QString buffer_format_;
-
   int discovery_finished_cb_id_;
   int discovery_discovered_cb_id_;
 
@@ -0,0 +1,296 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib-object.h>
+#include <gst/gst.h>
+
+#include <QtGlobal>
+#include <QObject>
+#include <QtConcurrent>
+#include <QTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVariant>
+#include <QString>
+
+#include "core/logging.h"
+#include "core/timeconstants.h"
+#include "gstenginepipeline.h"
+#include "gstenginemixer.h"
+
+const qint64 GstEngineMixer::kDefaultLatencyNanosec = 100 * kNsecPerMsec;
+
+GstEngineMixer::GstEngineMixer(QObject *parent)
+    : QObject(parent),
+      pipeline_(nullptr),
+      audiomixer_(nullptr),
+      clock_(nullptr),
+      latency_nanosec_(kDefaultLatencyNanosec),
+      state_(GST_STATE_NULL) {
+
+  set_state_threadpool_.setMaxThreadCount(1);
+
+}
+
+GstEngineMixer::~GstEngineMixer() {
+
+  set_state_threadpool_.waitForDone();
+
+  if (pipeline_) {
+
+    GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline_));
+    if (bus) {
+      gst_bus_remove_watch(bus);
+      gst_object_unref(bus);
+    }
+
+    gst_element_set_state(pipeline_, GST_STATE_NULL);
+
+    for (const Input &input : inputs_) {
+      gst_element_release_request_pad(audiomixer_, input.pad);
+      gst_object_unref(input.pad);
+    }
+    inputs_.clear();
+
+    gst_object_unref(GST_OBJECT(pipeline_));
+    pipeline_ = nullptr;
+    audiomixer_ = nullptr;
+
+  }
+
+  if (clock_) {
+    gst_object_unref(clock_);
+    clock_ = nullptr;
+  }
+
+}
+
+void GstEngineMixer::set_output_device(const QString &output, const QVariant &device) {
+
+  output_ = output;
+  device_ = device;
+
+}
+
+bool GstEngineMixer::Init(QString &error) {
+
+  // The inputs are connected through the inter elements from gst-plugins-bad.
+  for (const char *factory_name : { "interaudiosink", "interaudiosrc", "audiomixer" }) {
+    GstElementFactory *factory = gst_element_factory_find(factory_name);
+    if (!factory) {
+      error = QString("GStreamer could not find the element %1.").arg(factory_name);
+      return false;
+    }
+    gst_object_unref(factory);
+  }
+
+  pipeline_ = gst_pipeline_new("mixer");
+  if (!pipeline_) {
+    error = "GStreamer could not create the mixer pipeline.";
+    return false;
+  }
+
+  audiomixer_ = gst_element_factory_make("audiomixer", "mixer-audiomixer");
+  GstElement *audioconverter = gst_element_factory_make("audioconvert", "mixer-audioconverter");
+  GstElement *audioresampler = gst_element_factory_make("audioresample", "mixer-audioresampler");
+  GstElement *audiosink = gst_element_factory_make(output_.toUtf8().constData(), "mixer-audiosink");
+  if (!audiomixer_ || !audioconverter || !audioresampler || !audiosink) {
+    if (audiomixer_) gst_object_unref(audiomixer_);
+    if (audioconverter) gst_object_unref(audioconverter);
+    if (audioresampler) gst_object_unref(audioresampler);
+    if (audiosink) gst_object_unref(audiosink);
+    audiomixer_ = nullptr;
+    gst_object_unref(GST_OBJECT(pipeline_));
+    pipeline_ = nullptr;
+    qLog(Error) << "GStreamer could not create the mixer for" << output_;
+    error = QString("GStreamer could not create the mixer for %1.").arg(output_);
+    return false;
+  }
+
+  GstEnginePipeline::SetAudioSinkDevice(audiosink, output_, device_);
+
+  gst_bin_add_many(GST_BIN(pipeline_), audiomixer_, audioconverter, audioresampler, audiosink, nullptr);
+  if (!gst_element_link_many(audiomixer_, audioconverter, audioresampler, audiosink, nullptr)) {
+    gst_object_unref(GST_OBJECT(pipeline_));
+    pipeline_ = nullptr;
+    audiomixer_ = nullptr;
+    error = "GStreamer could not link the mixer elements.";
+    return false;
+  }
+
+  // The inputs and the mixer run on the system clock, the audio sink is slaved to it.
+  // The clock of the audio sink only runs while the mixer is playing, which would stall the inputs starting before it.
+  clock_ = gst_system_clock_obtain();
+  gst_pipeline_use_clock(GST_PIPELINE(pipeline_), clock_);
+
+  GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline_));
+  if (bus) {
+    gst_bus_add_watch(bus, BusCallback, this);
+    gst_object_unref(bus);
+  }
+
+  return true;
+
+}
+
+void GstEngineMixer::SetInputState(const QString &channel, const GstState state) {
+
+  QMutexLocker l(&mutex_);
+
+  if (!pipeline_) return;
+
+  if (!inputs_.contains(channel)) {
+    if (state != GST_STATE_PLAYING) return;
+    Input input;
+    if (!AddInput(channel, &input)) return;
+    inputs_.insert(channel, input);
+  }
+
+  inputs_[channel].state = state;
+  UpdateState();
+
+}
+
+void GstEngineMixer::RemoveInput(const QString &channel) {
+
+  // Let the audio still in the channel play out before the input is released.
+  QTimer::singleShot(static_cast<int>(latency_nanosec_ / kNsecPerMsec), this, [this, channel]() {
+    QMutexLocker l(&mutex_);
+    if (!inputs_.contains(channel)) return;
+    ReleaseInput(inputs_.take(channel));
+    UpdateState();
+  });
+
+}
+
+bool GstEngineMixer::AddInput(const QString &channel, Input *input) {
+
+  const QString name = "mixer-" + channel;
+  GstElement *source = gst_element_factory_make("interaudiosrc", name.toUtf8().constData());
+  if (!source) {
+    qLog(Error) << "GStreamer could not create the mixer input" << channel;
+    return false;
+  }
+  g_object_set(G_OBJECT(source), "channel", channel.toUtf8().constData(), nullptr);
+  g_object_set(G_OBJECT(source), "latency-time", static_cast<guint64>(kDefaultLatencyNanosec), nullptr);
+  gst_bin_add(GST_BIN(pipeline_), source);
+
+#if GST_CHECK_VERSION(1, 20, 0)
+  GstPad *pad = gst_element_request_pad_simple(audiomixer_, "sink_%u");
+#else
+  GstPad *pad = gst_element_get_request_pad(audiomixer_, "sink_%u");
+#endif
+  GstPad *source_pad = gst_element_get_static_pad(source, "src");
+  const bool linked = pad && source_pad && gst_pad_link(source_pad, pad) == GST_PAD_LINK_OK;
+  if (source_pad) gst_object_unref(source_pad);
+
+  if (!linked) {
+    qLog(Error) << "GStreamer could not link the mixer input" << channel;
+    if (pad) {
+      gst_element_release_request_pad(audiomixer_, pad);
+      gst_object_unref(pad);
+    }
+    gst_element_set_state(source, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(pipeline_), source);
+    return false;
+  }
+
+  gst_element_sync_state_with_parent(source);
+
+  input->source = source;
+  input->pad = pad;
+  input->state = GST_STATE_NULL;
+
+  return true;
+
+}
+
+void GstEngineMixer::ReleaseInput(const Input &input) {
+
+  gst_element_set_state(input.source, GST_STATE_NULL);
+  gst_element_release_request_pad(audiomixer_, input.pad);
+  gst_object_unref(input.pad);
+  gst_bin_remove(GST_BIN(pipeline_), input.source);
+
+}
+
+void GstEngineMixer::UpdateState() {
+
+  GstState state = GST_STATE_NULL;
+  for (const Input &input : inputs_) {
+    if (input.state > state) state = input.state;
+  }
+
+  if (state == state_) return;
+  state_ = state;
+
+  (void)QtConcurrent::run(&set_state_threadpool_, &gst_element_set_state, pipeline_, state);
+
+}
+
+gboolean GstEngineMixer::BusCallback(GstBus*, GstMessage *msg, gpointer self) {
+
+  GstEngineMixer *instance = reinterpret_cast<GstEngineMixer*>(self);
+
+  switch (GST_MESSAGE_TYPE(msg)) {
+    case GST_MESSAGE_ERROR:{
+      GError *error = nullptr;
+      gchar *debugs = nullptr;
+      gst_message_parse_error(msg, &error, &debugs);
+      GQuark domain = error->domain;
+      int code = error->code;
+      QString message = QString::fromLocal8Bit(error->message);
+      QString debugstr = QString::fromLocal8Bit(debugs);
+      g_error_free(error);
+      g_free(debugs);
+
+      qLog(Error) << __FUNCTION__ << "Domain:" << domain << "Code:" << code << "Error:" << message;
+      qLog(Error) << __FUNCTION__ << "Domain:" << domain << "Code:" << code << "Debug:" << debugstr;
+
+      emit instance->Error(static_cast<int>(domain), code, message, debugstr);
+      break;
+    }
+
+    case GST_MESSAGE_STATE_CHANGED:{
+      if (msg->src != GST_OBJECT(instance->pipeline_)) break;
+      GstState old_state = GST_STATE_NULL, new_state = GST_STATE_NULL, pending = GST_STATE_NULL;
+      gst_message_parse_state_changed(msg, &old_state, &new_state, &pending);
+      if (new_state == GST_STATE_PLAYING) {
+        GstQuery *query = gst_query_new_latency();
+        if (gst_element_query(instance->pipeline_, query)) {
+          gboolean live = FALSE;
+          GstClockTime min_latency = 0;
+          gst_query_parse_latency(query, &live, &min_latency, nullptr);
+          if (GST_CLOCK_TIME_IS_VALID(min_latency)) instance->latency_nanosec_ = static_cast<qint64>(min_latency);
+        }
+        gst_query_unref(query);
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+
+  return TRUE;
+
+}
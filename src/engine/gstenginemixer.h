@@ -0,0 +1,102 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GSTENGINEMIXER_H
+#define GSTENGINEMIXER_H
+
+#include "config.h"
+
+#include <atomic>
+#include <glib.h>
+#include <gst/gst.h>
+
+#include <QtGlobal>
+#include <QObject>
+#include <QMutex>
+#include <QThreadPool>
+#include <QMap>
+#include <QVariant>
+#include <QString>
+
+// Mixes the audio of several pipelines into one audio sink, so the old and the new song of a crossfade play through the same output.
+// Each pipeline plays to an interaudiosink with its own channel, the mixer pipeline reads the channel with an interaudiosrc and mixes it with audiomixer.
+// All pipelines use the mixer's clock, and the mixer plays while any of its inputs is playing.
+class GstEngineMixer : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit GstEngineMixer(QObject *parent = nullptr);
+  ~GstEngineMixer() override;
+
+  // Call this before Init
+  void set_output_device(const QString &output, const QVariant &device);
+
+  // Creates the mixer pipeline, returns false on error
+  bool Init(QString &error);
+
+  // The clock the input pipelines must use.
+  GstClock *clock() const { return clock_; }
+
+  // Latency from the input pipelines' sinks to the audio sink.
+  qint64 latency_nanosec() const { return latency_nanosec_; }
+
+  // Starts mixing the channel when it first plays, and sets the mixer to the highest state of its inputs.  Thread-safe.
+  void SetInputState(const QString &channel, const GstState state);
+  // Stops mixing the channel after the audio still in the mixer has played.  Must be called from the mixer's thread.
+  void RemoveInput(const QString &channel);
+
+ signals:
+  void Error(int domain, int error_code, QString message, QString debug);
+
+ private:
+  struct Input {
+    Input() : source(nullptr), pad(nullptr), state(GST_STATE_NULL) {}
+    GstElement *source;
+    GstPad *pad;
+    GstState state;
+  };
+
+  static gboolean BusCallback(GstBus*, GstMessage *msg, gpointer self);
+
+  // These must be called with mutex_ locked.
+  bool AddInput(const QString &channel, Input *input);
+  void ReleaseInput(const Input &input);
+  void UpdateState();
+
+ private:
+  static const qint64 kDefaultLatencyNanosec;
+
+  QString output_;
+  QVariant device_;
+
+  GstElement *pipeline_;
+  GstElement *audiomixer_;
+  GstClock *clock_;
+  std::atomic<qint64> latency_nanosec_;
+
+  // Protects inputs_ and state_.
+  QMutex mutex_;
+  QMap<QString, Input> inputs_;
+  GstState state_;
+
+  // Runs the state changes in order, without blocking the caller while the audio sink opens the device.
+  QThreadPool set_state_threadpool_;
+};
+
+#endif  // GSTENGINEMIXER_H
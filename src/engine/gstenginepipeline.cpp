@@ -28,6 +28,8 @@
 #include <glib-object.h>
 #include <gst/gst.h>
 #include <gst/audio/audio.h>
+#include <gst/controller/gstinterpolationcontrolsource.h>
+#include <gst/controller/gstdirectcontrolbinding.h>
 
 #include <QtGlobal>
 #include <QObject>
@@ -42,6 +44,7 @@
 #include <QUrl>
 #include <QTimeLine>
 #include <QEasingCurve>
+#include <QElapsedTimer>
 #include <QMetaObject>
 #include <QUuid>
 
@@ -52,13 +55,19 @@
 #include "enginebase.h"
 #include "gstengine.h"
 #include "gstenginepipeline.h"
+#include "gstenginemixer.h"
 #include "gstbufferconsumer.h"
+#include "pcmconverter.h"
 
 const int GstEnginePipeline::kGstStateTimeoutNanosecs = 10000000;
 const int GstEnginePipeline::kFaderFudgeMsec = 2000;
+const int GstEnginePipeline::kFaderCurvePoints = 32;
+const int GstEnginePipeline::kFaderPollMsec = 100;
 
 const int GstEnginePipeline::kEqBandCount = 10;
 const int GstEnginePipeline::kEqBandFrequencies[] = { 60, 170, 310, 600, 1000, 3000, 6000, 12000, 14000, 16000 };
+const guint GstEnginePipeline::kBufferPoolMinBuffers = 4;
+const gsize GstEnginePipeline::kBufferPoolSizeAlignment = 4096;
 
 int GstEnginePipeline::sId = 1;
 
@@ -98,6 +107,17 @@ GstEnginePipeline::GstEnginePipeline(QObject *parent)
       next_uri_set_(false),
       volume_percent_(100),
       volume_modifier_(1.0F),
+      fader_control_source_(nullptr),
+      fader_control_binding_(nullptr),
+      fader_running_(false),
+      fader_update_(false),
+      fader_direction_(QTimeLine::Forward),
+      fader_shape_(QEasingCurve::Linear),
+      fader_duration_nanosec_(0),
+      fader_elapsed_nanosec_(0),
+      fader_start_nanosec_(-1),
+      fader_position_nanosec_(0),
+      fader_deadline_nanosec_(0),
       use_fudge_timer_(false),
       pipeline_(nullptr),
       audiobin_(nullptr),
@@ -109,7 +129,16 @@ GstEnginePipeline::GstEnginePipeline(QObject *parent)
       pad_added_cb_id_(-1),
       notify_source_cb_id_(-1),
       about_to_finish_cb_id_(-1),
-      logged_unsupported_analyzer_format_(false) {
+      logged_unsupported_analyzer_format_(false),
+      analyzer_format_(PCMConverter::Format::Unsupported),
+      analyzer_channels_(1),
+      analyzer_rate_(0),
+      analyzer_buffer_pool_(nullptr),
+      analyzer_buffer_size_(0),
+      latency_nanosec_(0) {
+
+  gst_segment_init(&analyzer_segment_, GST_FORMAT_TIME);
+  gst_segment_init(&fader_segment_, GST_FORMAT_TIME);
 
   eq_band_gains_.reserve(kEqBandCount);
   for (int i = 0; i < kEqBandCount; ++i) eq_band_gains_ << 0;
@@ -120,13 +149,6 @@ GstEnginePipeline::~GstEnginePipeline() {
 
   if (pipeline_) {
 
-    if (fader_) {
-      if (fader_->state() != QTimeLine::NotRunning) {
-        fader_->stop();
-      }
-      fader_.reset();
-    }
-
     if (pad_added_cb_id_ != -1) {
       g_signal_handler_disconnect(G_OBJECT(pipeline_), pad_added_cb_id_);
     }
@@ -154,6 +176,19 @@ GstEnginePipeline::~GstEnginePipeline() {
 
   }
 
+  if (mixer_) mixer_->RemoveInput(mixer_channel_);
+
+  if (analyzer_buffer_pool_) {
+    gst_buffer_pool_set_active(analyzer_buffer_pool_, FALSE);
+    gst_object_unref(analyzer_buffer_pool_);
+    analyzer_buffer_pool_ = nullptr;
+  }
+
+  if (fader_control_source_) {
+    gst_object_unref(fader_control_source_);
+    fader_control_source_ = nullptr;
+  }
+
 }
 
 void GstEnginePipeline::set_output_device(const QString &output, const QVariant &device) {
@@ -163,6 +198,13 @@ void GstEnginePipeline::set_output_device(const QString &output, const QVariant
 
 }
 
+void GstEnginePipeline::set_mixer(std::shared_ptr<GstEngineMixer> mixer) {
+
+  mixer_ = mixer;
+  mixer_channel_ = QString("pipeline-%1").arg(id_);
+
+}
+
 void GstEnginePipeline::set_volume_enabled(const bool enabled) {
   volume_enabled_ = enabled;
 }
@@ -249,6 +291,9 @@ bool GstEnginePipeline::InitFromUrl(const QByteArray &stream_url, const QUrl &or
 
   if (!InitAudioBin(error)) return false;
 
+  // The pipelines sync to the mixer's clock, so the audio of both songs in a crossfade is mixed at the right time.
+  if (mixer_) gst_pipeline_use_clock(GST_PIPELINE(pipeline_), mixer_->clock());
+
   // Set playbin's sink to be our custom audio-sink.
   g_object_set(GST_OBJECT(pipeline_), "audio-sink", audiobin_, nullptr);
 
@@ -280,118 +325,18 @@ bool GstEnginePipeline::InitAudioBin(QString &error) {
   audiobin_ = gst_bin_new("audiobin");
   if (!audiobin_) return false;
 
-  // Create the sink
-  GstElement *audiosink = CreateElement(output_, output_, audiobin_, error);
+  // Create the sink, with the mixer the audio is passed to it through an own channel.
+  GstElement *audiosink = mixer_ ? CreateElement("interaudiosink", "audiosink", audiobin_, error) : CreateElement(output_, output_, audiobin_, error);
   if (!audiosink) {
     gst_object_unref(GST_OBJECT(audiobin_));
     return false;
   }
 
-  if (device_.isValid()) {
-    if (g_object_class_find_property(G_OBJECT_GET_CLASS(audiosink), "device")) {
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-      switch (device_.metaType().id()) {
-#else
-      switch (device_.type()) {
-#endif
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-        case QMetaType::QString:{
-#else
-        case QVariant::String:{
-#endif
-          QString device = device_.toString();
-          if (!device.isEmpty()) {
-            qLog(Debug) << "Setting device" << device << "for" << output_;
-            g_object_set(G_OBJECT(audiosink), "device", device.toUtf8().constData(), nullptr);
-          }
-          break;
-        }
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-        case QMetaType::QByteArray:{
-#else
-        case QVariant::ByteArray:{
-#endif
-          QByteArray device = device_.toByteArray();
-          if (!device.isEmpty()) {
-            qLog(Debug) << "Setting device" << device_ << "for" << output_;
-            g_object_set(G_OBJECT(audiosink), "device", device.constData(), nullptr);
-          }
-          break;
-        }
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-        case QMetaType::LongLong:{
-#else
-        case QVariant::LongLong:{
-#endif
-          qint64 device = device_.toLongLong();
-          qLog(Debug) << "Setting device" << device << "for" << output_;
-          g_object_set(G_OBJECT(audiosink), "device", device, nullptr);
-          break;
-        }
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-        case QMetaType::Int:{
-#else
-        case QVariant::Int:{
-#endif
-          int device = device_.toInt();
-          qLog(Debug) << "Setting device" << device << "for" << output_;
-          g_object_set(G_OBJECT(audiosink), "device", device, nullptr);
-          break;
-        }
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-        case QMetaType::QUuid:{
-#else
-        case QVariant::Uuid:{
-#endif
-          QUuid device = device_.toUuid();
-          qLog(Debug) << "Setting device" << device << "for" << output_;
-          g_object_set(G_OBJECT(audiosink), "device", device, nullptr);
-          break;
-        }
-        default:
-          qLog(Warning) << "Unknown device type" << device_;
-          break;
-      }
-    }
-
-    else if (g_object_class_find_property(G_OBJECT_GET_CLASS(audiosink), "port-pattern")) {
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-      switch (device_.metaType().id()) {
-#else
-      switch (device_.type()) {
-#endif
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-        case QMetaType::QString:{
-#else
-        case QVariant::String:{
-#endif
-          QString port_pattern = device_.toString();
-          if (!port_pattern.isEmpty()) {
-            qLog(Debug) << "Setting port pattern" << port_pattern << "for" << output_;
-            g_object_set(G_OBJECT(audiosink), "port-pattern", port_pattern.toUtf8().constData(), nullptr);
-          }
-          break;
-        }
-
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-        case QMetaType::QByteArray:{
-#else
-        case QVariant::ByteArray:{
-#endif
-          QByteArray port_pattern = device_.toByteArray();
-          if (!port_pattern.isEmpty()) {
-            qLog(Debug) << "Setting port pattern" << port_pattern << "for" << output_;
-            g_object_set(G_OBJECT(audiosink), "port-pattern", port_pattern.constData(), nullptr);
-          }
-          break;
-        }
-
-        default:
-          break;
-
-      }
-    }
-
+  if (mixer_) {
+    g_object_set(G_OBJECT(audiosink), "channel", mixer_channel_.toUtf8().constData(), nullptr);
+  }
+  else {
+    SetAudioSinkDevice(audiosink, output_, device_);
   }
 
   // Create all the other elements
@@ -418,6 +363,12 @@ bool GstEnginePipeline::InitAudioBin(QString &error) {
       audiobin_ = nullptr;
       return false;
     }
+    // The fader controls the volume property, the binding is enabled by the streaming thread once it has placed the control points.
+    fader_control_source_ = gst_interpolation_control_source_new();
+    g_object_set(G_OBJECT(fader_control_source_), "mode", GST_INTERPOLATION_MODE_LINEAR, nullptr);
+    fader_control_binding_ = gst_direct_control_binding_new_absolute(GST_OBJECT(volume_), "volume", fader_control_source_);
+    gst_control_binding_set_disabled(fader_control_binding_, TRUE);
+    gst_object_add_control_binding(GST_OBJECT(volume_), fader_control_binding_);
   }
 
   // Create the stereo balancer elements if it's enabled.
@@ -645,11 +596,20 @@ bool GstEnginePipeline::InitAudioBin(QString &error) {
   {  // Add probes and handlers.
     GstPad *pad = gst_element_get_static_pad(audioqueue_, "src");
     if (pad) {
+      gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, AnalyzerEventCallback, this, nullptr);
       gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, HandoffCallback, this, nullptr);
       gst_object_unref(pad);
     }
   }
 
+  if (volume_) {
+    GstPad *pad = gst_element_get_static_pad(volume_, "sink");
+    if (pad) {
+      gst_pad_add_probe(pad, static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM), FaderProbeCallback, this, nullptr);
+      gst_object_unref(pad);
+    }
+  }
+
   {
     GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline_));
     if (bus) {
@@ -665,6 +625,117 @@ bool GstEnginePipeline::InitAudioBin(QString &error) {
 
 }
 
+void GstEnginePipeline::SetAudioSinkDevice(GstElement *audiosink, const QString &output, const QVariant &device) {
+
+  if (device.isValid()) {
+    if (g_object_class_find_property(G_OBJECT_GET_CLASS(audiosink), "device")) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+      switch (device.metaType().id()) {
+#else
+      switch (device.type()) {
+#endif
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        case QMetaType::QString:{
+#else
+        case QVariant::String:{
+#endif
+          QString device_string = device.toString();
+          if (!device_string.isEmpty()) {
+            qLog(Debug) << "Setting device" << device_string << "for" << output;
+            g_object_set(G_OBJECT(audiosink), "device", device_string.toUtf8().constData(), nullptr);
+          }
+          break;
+        }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        case QMetaType::QByteArray:{
+#else
+        case QVariant::ByteArray:{
+#endif
+          QByteArray device_bytes = device.toByteArray();
+          if (!device_bytes.isEmpty()) {
+            qLog(Debug) << "Setting device" << device << "for" << output;
+            g_object_set(G_OBJECT(audiosink), "device", device_bytes.constData(), nullptr);
+          }
+          break;
+        }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        case QMetaType::LongLong:{
+#else
+        case QVariant::LongLong:{
+#endif
+          qint64 device_id = device.toLongLong();
+          qLog(Debug) << "Setting device" << device_id << "for" << output;
+          g_object_set(G_OBJECT(audiosink), "device", device_id, nullptr);
+          break;
+        }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        case QMetaType::Int:{
+#else
+        case QVariant::Int:{
+#endif
+          int device_id = device.toInt();
+          qLog(Debug) << "Setting device" << device_id << "for" << output;
+          g_object_set(G_OBJECT(audiosink), "device", device_id, nullptr);
+          break;
+        }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        case QMetaType::QUuid:{
+#else
+        case QVariant::Uuid:{
+#endif
+          QUuid device_uuid = device.toUuid();
+          qLog(Debug) << "Setting device" << device_uuid << "for" << output;
+          g_object_set(G_OBJECT(audiosink), "device", device_uuid, nullptr);
+          break;
+        }
+        default:
+          qLog(Warning) << "Unknown device type" << device;
+          break;
+      }
+    }
+
+    else if (g_object_class_find_property(G_OBJECT_GET_CLASS(audiosink), "port-pattern")) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+      switch (device.metaType().id()) {
+#else
+      switch (device.type()) {
+#endif
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        case QMetaType::QString:{
+#else
+        case QVariant::String:{
+#endif
+          QString port_pattern = device.toString();
+          if (!port_pattern.isEmpty()) {
+            qLog(Debug) << "Setting port pattern" << port_pattern << "for" << output;
+            g_object_set(G_OBJECT(audiosink), "port-pattern", port_pattern.toUtf8().constData(), nullptr);
+          }
+          break;
+        }
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        case QMetaType::QByteArray:{
+#else
+        case QVariant::ByteArray:{
+#endif
+          QByteArray port_pattern = device.toByteArray();
+          if (!port_pattern.isEmpty()) {
+            qLog(Debug) << "Setting port pattern" << port_pattern << "for" << output;
+            g_object_set(G_OBJECT(audiosink), "port-pattern", port_pattern.constData(), nullptr);
+          }
+          break;
+        }
+
+        default:
+          break;
+
+      }
+    }
+
+  }
+
+}
+
 GstPadProbeReturn GstEnginePipeline::EventHandoffCallback(GstPad*, GstPadProbeInfo *info, gpointer self) {
 
   GstEnginePipeline *instance = reinterpret_cast<GstEnginePipeline*>(self);
@@ -808,15 +879,28 @@ GstPadProbeReturn GstEnginePipeline::PlaybinProbe(GstPad *pad, GstPadProbeInfo *
 
 }
 
-GstPadProbeReturn GstEnginePipeline::HandoffCallback(GstPad *pad, GstPadProbeInfo *info, gpointer self) {
+GstPadProbeReturn GstEnginePipeline::AnalyzerEventCallback(GstPad*, GstPadProbeInfo *info, gpointer self) {
 
   GstEnginePipeline *instance = reinterpret_cast<GstEnginePipeline*>(self);
 
+  GstEvent *e = gst_pad_probe_info_get_event(info);
+
+  if (GST_EVENT_TYPE(e) == GST_EVENT_SEGMENT) {
+    // The analyzer buffer is timestamped with the running time, which continues across gapless track changes.
+    const GstSegment *segment = nullptr;
+    gst_event_parse_segment(e, &segment);
+    gst_segment_copy_into(segment, &instance->analyzer_segment_);
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (GST_EVENT_TYPE(e) != GST_EVENT_CAPS) return GST_PAD_PROBE_OK;
+
+  GstCaps *caps = nullptr;
+  gst_event_parse_caps(e, &caps);
+
   QString format;
   int channels = 1;
   int rate = 0;
-
-  GstCaps *caps = gst_pad_get_current_caps(pad);
   if (caps) {
     GstStructure *structure = gst_caps_get_structure(caps, 0);
     if (structure) {
@@ -824,123 +908,166 @@ GstPadProbeReturn GstEnginePipeline::HandoffCallback(GstPad *pad, GstPadProbeInf
       gst_structure_get_int(structure, "channels", &channels);
       gst_structure_get_int(structure, "rate", &rate);
     }
-    gst_caps_unref(caps);
   }
 
-  GstBuffer *buf = gst_pad_probe_info_get_buffer(info);
-  GstBuffer *buf16 = nullptr;
-
-  quint64 start_time = GST_BUFFER_TIMESTAMP(buf) - instance->segment_start_;
-  quint64 duration = GST_BUFFER_DURATION(buf);
-  qint64 end_time = static_cast<qint64>(start_time + duration);
+  instance->analyzer_format_name_ = format;
+  instance->analyzer_format_ = PCMConverter::FormatFromString(format);
+  instance->analyzer_channels_ = channels;
+  instance->analyzer_rate_ = rate;
 
-  if (format.startsWith("S16LE")) {
+  if (instance->analyzer_format_ == PCMConverter::Format::Unsupported) {
+    if (!instance->logged_unsupported_analyzer_format_) {
+      instance->logged_unsupported_analyzer_format_ = true;
+      qLog(Error) << "Unsupported audio format for the analyzer" << format;
+    }
+  }
+  else {
     instance->logged_unsupported_analyzer_format_ = false;
   }
-  else if (format.startsWith("S32LE")) {
 
-    GstMapInfo map_info;
-    gst_buffer_map(buf, &map_info, GST_MAP_READ);
-
-    int32_t *s = reinterpret_cast<int32_t*>(map_info.data);
-    int samples = static_cast<int>((map_info.size / sizeof(int32_t)) / channels);
-    int buf16_size = samples * static_cast<int>(sizeof(int16_t)) * channels;
-    int16_t *d = static_cast<int16_t*>(g_malloc(buf16_size));
-    memset(d, 0, buf16_size);
-    for (int i = 0; i < (samples * channels); ++i) {
-      d[i] = static_cast<int16_t>((s[i] >> 16));
-    }
-    gst_buffer_unmap(buf, &map_info);
-    buf16 = gst_buffer_new_wrapped(d, buf16_size);
-    GST_BUFFER_DURATION(buf16) = GST_FRAMES_TO_CLOCK_TIME(samples * sizeof(int16_t) * channels, rate);
-    buf = buf16;
+  return GST_PAD_PROBE_OK;
 
-    instance->logged_unsupported_analyzer_format_ = false;
-  }
+}
 
-  else if (format.startsWith("F32LE")) {
+GstBuffer *GstEnginePipeline::AcquireAnalyzerBuffer(const gsize size) {
 
-    GstMapInfo map_info;
-    gst_buffer_map(buf, &map_info, GST_MAP_READ);
-
-    float *s = reinterpret_cast<float*>(map_info.data);
-    int samples = static_cast<int>((map_info.size / sizeof(float)) / channels);
-    int buf16_size = samples * static_cast<int>(sizeof(int16_t)) * channels;
-    int16_t *d = static_cast<int16_t*>(g_malloc(buf16_size));
-    memset(d, 0, buf16_size);
-    for (int i = 0; i < (samples * channels); ++i) {
-      float sample_float = (s[i] * static_cast<float>(32768.0));
-      d[i] = static_cast<int16_t>(sample_float);
+  // The pool is replaced when a larger buffer is needed, buffers of the old pool are freed when they are unreffed.
+  if (!analyzer_buffer_pool_ || size > analyzer_buffer_size_) {
+    if (analyzer_buffer_pool_) {
+      gst_buffer_pool_set_active(analyzer_buffer_pool_, FALSE);
+      gst_object_unref(analyzer_buffer_pool_);
     }
-    gst_buffer_unmap(buf, &map_info);
-    buf16 = gst_buffer_new_wrapped(d, buf16_size);
-    GST_BUFFER_DURATION(buf16) = GST_FRAMES_TO_CLOCK_TIME(samples * sizeof(int16_t) * channels, rate);
-    buf = buf16;
+    analyzer_buffer_size_ = ((size + kBufferPoolSizeAlignment - 1) / kBufferPoolSizeAlignment) * kBufferPoolSizeAlignment;
+    analyzer_buffer_pool_ = gst_buffer_pool_new();
+    GstStructure *config = gst_buffer_pool_get_config(analyzer_buffer_pool_);
+    gst_buffer_pool_config_set_params(config, nullptr, static_cast<guint>(analyzer_buffer_size_), kBufferPoolMinBuffers, 0);
+    if (!gst_buffer_pool_set_config(analyzer_buffer_pool_, config) || !gst_buffer_pool_set_active(analyzer_buffer_pool_, TRUE)) {
+      qLog(Error) << "Failed to create buffer pool for the analyzer";
+      gst_object_unref(analyzer_buffer_pool_);
+      analyzer_buffer_pool_ = nullptr;
+      analyzer_buffer_size_ = 0;
+      return nullptr;
+    }
+  }
 
-    instance->logged_unsupported_analyzer_format_ = false;
+  GstBuffer *buffer = nullptr;
+  if (gst_buffer_pool_acquire_buffer(analyzer_buffer_pool_, &buffer, nullptr) != GST_FLOW_OK) {
+    return nullptr;
   }
-  else if (format.startsWith("S24LE")) {
+  gst_buffer_resize(buffer, 0, static_cast<gssize>(size));
 
-    GstMapInfo map_info;
-    gst_buffer_map(buf, &map_info, GST_MAP_READ);
-
-    int8_t *s24 = reinterpret_cast<int8_t*>(map_info.data);
-    int8_t *s24e = s24 + map_info.size;
-    int samples = static_cast<int>((map_info.size / sizeof(int8_t)) / channels);
-    int buf16_size = samples * static_cast<int>(sizeof(int16_t)) * channels;
-    int16_t *s16 = static_cast<int16_t*>(g_malloc(buf16_size));
-    memset(s16, 0, buf16_size);
-    for (int i = 0; i < (samples * channels); ++i) {
-      s16[i] = *(reinterpret_cast<int16_t*>(s24 + 1));
-      s24 += 3;
-      if (s24 >= s24e) break;
-    }
-    gst_buffer_unmap(buf, &map_info);
-    buf16 = gst_buffer_new_wrapped(s16, buf16_size);
-    GST_BUFFER_DURATION(buf16) = GST_FRAMES_TO_CLOCK_TIME(samples * sizeof(int16_t) * channels, rate);
-    buf = buf16;
+  return buffer;
 
-    instance->logged_unsupported_analyzer_format_ = false;
-  }
-  else if (format.startsWith("S24_32LE")) {
+}
 
-    GstMapInfo map_info;
-    gst_buffer_map(buf, &map_info, GST_MAP_READ);
-
-    int32_t *s32 = reinterpret_cast<int32_t*>(map_info.data);
-    int32_t *s32e = s32 + map_info.size;
-    int32_t *s32p = s32;
-    int samples = static_cast<int>((map_info.size / sizeof(int32_t)) / channels);
-    int buf16_size = samples * static_cast<int>(sizeof(int16_t)) * channels;
-    int16_t *s16 = static_cast<int16_t*>(g_malloc(buf16_size));
-    memset(s16, 0, buf16_size);
-    for (int i = 0; i < (samples * channels); ++i) {
-      int8_t *s24 = reinterpret_cast<int8_t*>(s32p);
-      s16[i] = *(reinterpret_cast<int16_t*>(s24 + 1));
-      ++s32p;
-      if (s32p > s32e) break;
+GstPadProbeReturn GstEnginePipeline::FaderProbeCallback(GstPad*, GstPadProbeInfo *info, gpointer self) {
+
+  GstEnginePipeline *instance = reinterpret_cast<GstEnginePipeline*>(self);
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    GstEvent *e = gst_pad_probe_info_get_event(info);
+    if (GST_EVENT_TYPE(e) == GST_EVENT_SEGMENT) {
+      const GstSegment *segment = nullptr;
+      gst_event_parse_segment(e, &segment);
+      gst_segment_copy_into(segment, &instance->fader_segment_);
+      // The stream time jumps after a seek or a track change, so the rest of the fade is placed again at the next buffer.
+      if (instance->fader_running_) {
+        QMutexLocker l(&instance->fader_mutex_);
+        if (instance->fader_start_nanosec_ != -1) {
+          instance->fader_elapsed_nanosec_ = instance->FaderElapsedNanosec();
+          instance->fader_start_nanosec_ = -1;
+          instance->fader_update_ = true;
+        }
+      }
     }
-    gst_buffer_unmap(buf, &map_info);
-    buf16 = gst_buffer_new_wrapped(s16, buf16_size);
-    GST_BUFFER_DURATION(buf16) = GST_FRAMES_TO_CLOCK_TIME(samples * sizeof(int16_t) * channels, rate);
-    buf = buf16;
+    return GST_PAD_PROBE_OK;
+  }
 
-    instance->logged_unsupported_analyzer_format_ = false;
+  if (!instance->fader_running_) return GST_PAD_PROBE_OK;
+
+  GstBuffer *buf = gst_pad_probe_info_get_buffer(info);
+  if (!buf || !GST_BUFFER_PTS_IS_VALID(buf)) return GST_PAD_PROBE_OK;
+
+  // The volume element looks up the control points with the same stream time.
+  const guint64 stream_time = gst_segment_to_stream_time(&instance->fader_segment_, GST_FORMAT_TIME, GST_BUFFER_PTS(buf));
+  if (stream_time == GST_CLOCK_TIME_NONE) return GST_PAD_PROBE_OK;
+
+  QMutexLocker l(&instance->fader_mutex_);
+
+  if (instance->fader_update_) {
+    instance->fader_update_ = false;
+    if (instance->fader_start_nanosec_ == -1) {
+      instance->fader_start_nanosec_ = static_cast<qint64>(stream_time) - instance->fader_elapsed_nanosec_;
+    }
+    // This runs in the same thread as the volume element, so it never sees the control points half updated.
+    instance->SetFaderControlPoints(static_cast<qint64>(stream_time));
+    gst_control_binding_set_disabled(instance->fader_control_binding_, FALSE);
   }
-  else if (!instance->logged_unsupported_analyzer_format_) {
-    instance->logged_unsupported_analyzer_format_ = true;
-    qLog(Error) << "Unsupported audio format for the analyzer" << format;
+
+  instance->fader_position_nanosec_ = static_cast<qint64>(stream_time);
+  if (GST_BUFFER_DURATION_IS_VALID(buf)) {
+    instance->fader_position_nanosec_ += static_cast<qint64>(GST_BUFFER_DURATION(buf));
   }
 
+  return GST_PAD_PROBE_OK;
+
+}
+
+GstPadProbeReturn GstEnginePipeline::HandoffCallback(GstPad*, GstPadProbeInfo *info, gpointer self) {
+
+  GstEnginePipeline *instance = reinterpret_cast<GstEnginePipeline*>(self);
+
+  GstBuffer *buf = gst_pad_probe_info_get_buffer(info);
+  GstBuffer *buf16 = nullptr;
+
+  quint64 start_time = GST_BUFFER_TIMESTAMP(buf) - instance->segment_start_;
+  quint64 duration = GST_BUFFER_DURATION(buf);
+  qint64 end_time = static_cast<qint64>(start_time + duration);
+
+  const PCMConverter::Format format = instance->analyzer_format_;
+  const int channels = qMax(1, instance->analyzer_channels_);
+
   QList<GstBufferConsumer*> consumers;
   {
     QMutexLocker l(&instance->buffer_consumers_mutex_);
     consumers = instance->buffer_consumers_;
   }
 
+  if (format != PCMConverter::Format::Unsupported) {
+    GstMapInfo map_info;
+    if (gst_buffer_map(buf, &map_info, GST_MAP_READ)) {
+      const qint64 frames = static_cast<qint64>(map_info.size / PCMConverter::SampleSize(format)) / channels;
+      const qint64 samples = frames * channels;
+
+      const guint64 running_time = gst_segment_to_running_time(&instance->analyzer_segment_, GST_FORMAT_TIME, GST_BUFFER_PTS(buf));
+      if (GST_CLOCK_TIME_IS_VALID(running_time)) {
+        instance->analyzer_buffer_.Write(static_cast<qint64>(running_time), channels, instance->analyzer_rate_, format, map_info.data, samples);
+      }
+
+      // Consumers get the audio as S16LE.
+      if (!consumers.isEmpty() && format != PCMConverter::Format::S16LE) {
+        const gsize buf16_size = static_cast<gsize>(samples) * sizeof(qint16);
+        buf16 = instance->AcquireAnalyzerBuffer(buf16_size);
+        if (buf16) {
+          GstMapInfo map_info16;
+          if (gst_buffer_map(buf16, &map_info16, GST_MAP_WRITE)) {
+            PCMConverter::ConvertToS16(format, map_info.data, reinterpret_cast<qint16*>(map_info16.data), samples);
+            gst_buffer_unmap(buf16, &map_info16);
+          }
+        }
+      }
+      gst_buffer_unmap(buf, &map_info);
+      if (buf16) {
+        GST_BUFFER_PTS(buf16) = GST_BUFFER_PTS(buf);
+        GST_BUFFER_DURATION(buf16) = instance->analyzer_rate_ > 0 ? GST_FRAMES_TO_CLOCK_TIME(gst_buffer_get_size(buf16), instance->analyzer_rate_) : GST_CLOCK_TIME_NONE;
+        buf = buf16;
+      }
+    }
+  }
+
   for (GstBufferConsumer *consumer : consumers) {
     gst_buffer_ref(buf);
-    consumer->ConsumeBuffer(buf, instance->id(), format);
+    consumer->ConsumeBuffer(buf, instance->id(), instance->analyzer_format_name_);
   }
 
   if (buf16) {
@@ -1252,6 +1379,18 @@ void GstEnginePipeline::StateChangedMessageReceived(GstMessage *msg) {
     }
   }
 
+  if (new_state == GST_STATE_PLAYING) {
+    GstQuery *query = gst_query_new_latency();
+    if (gst_element_query(pipeline_, query)) {
+      gboolean live = FALSE;
+      GstClockTime min_latency = 0;
+      gst_query_parse_latency(query, &live, &min_latency, nullptr);
+      latency_nanosec_ = GST_CLOCK_TIME_IS_VALID(min_latency) ? static_cast<qint64>(min_latency) : 0;
+    }
+    gst_query_unref(query);
+    emit PlaybackStarted(id());
+  }
+
   if (pipeline_is_initialized_ && new_state != GST_STATE_PAUSED && new_state != GST_STATE_PLAYING) {
     pipeline_is_initialized_ = false;
 
@@ -1305,6 +1444,29 @@ qint64 GstEnginePipeline::position() const {
 
 }
 
+qint64 GstEnginePipeline::running_time() const {
+
+  if (!pipeline_ || !pipeline_is_initialized_) return -1;
+
+  GstClock *clock = gst_element_get_clock(pipeline_);
+  if (!clock) return -1;
+  const GstClockTime now = gst_clock_get_time(clock);
+  gst_object_unref(clock);
+
+  const GstClockTime base_time = gst_element_get_base_time(pipeline_);
+  const qint64 latency = latency_nanosec();
+  if (now < base_time + static_cast<GstClockTime>(latency)) return -1;
+
+  return static_cast<qint64>(now - base_time) - latency;
+
+}
+
+qint64 GstEnginePipeline::latency_nanosec() const {
+
+  return latency_nanosec_ + (mixer_ ? mixer_->latency_nanosec() : 0);
+
+}
+
 qint64 GstEnginePipeline::length() const {
 
   gint64 value = 0;
@@ -1326,7 +1488,11 @@ GstState GstEnginePipeline::state() const {
 }
 
 QFuture<GstStateChangeReturn> GstEnginePipeline::SetState(const GstState state) {
+
+  if (mixer_) mixer_->SetInputState(mixer_channel_, state);
+
   return QtConcurrent::run(&set_state_threadpool_, &gst_element_set_state, pipeline_, state);
+
 }
 
 bool GstEnginePipeline::Seek(const qint64 nanosec) {
@@ -1356,15 +1522,14 @@ bool GstEnginePipeline::Seek(const qint64 nanosec) {
 void GstEnginePipeline::SetVolume(const uint percent) {
 
   if (!volume_) return;
-  volume_percent_ = percent;
-  UpdateVolume();
-
-}
 
-void GstEnginePipeline::SetVolumeModifier(const qreal mod) {
+  {
+    QMutexLocker l(&fader_mutex_);
+    volume_percent_ = percent;
+    // The control points include the volume, so they're placed again at the next buffer.
+    if (fader_running_) fader_update_ = true;
+  }
 
-  if (!volume_) return;
-  volume_modifier_ = mod;
   UpdateVolume();
 
 }
@@ -1431,44 +1596,95 @@ void GstEnginePipeline::UpdateEqualizer() {
 
 void GstEnginePipeline::StartFader(const qint64 duration_nanosec, const QTimeLine::Direction direction, const QEasingCurve::Type shape, const bool use_fudge_timer) {
 
-  const qint64 duration_msec = duration_nanosec / kNsecPerMsec;
+  qint64 remaining_nanosec = 0;
+  {
+    QMutexLocker l(&fader_mutex_);
 
-  // If there's already another fader running then start from the same time that one was already at.
-  qint64 start_time = direction == QTimeLine::Forward ? 0 : duration_msec;
-  if (fader_ && fader_->state() == QTimeLine::Running) {
-    if (duration_msec == fader_->duration()) {
-      start_time = fader_->currentTime();
-    }
-    else {
-      // Calculate the position in the new fader with the same value from the old fader, so no volume jumps appear
-      qreal time = static_cast<qreal>(duration_msec) * (static_cast<qreal>(fader_->currentTime()) / static_cast<qreal>(fader_->duration()));
-      start_time = qRound(time);
+    // If there's already another fader running then start from the same point that one was already at, so no volume jumps appear.
+    qreal progress = direction == QTimeLine::Forward ? 0.0 : 1.0;
+    if (fader_running_ && fader_duration_nanosec_ > 0) {
+      progress = static_cast<qreal>(FaderElapsedNanosec()) / static_cast<qreal>(fader_duration_nanosec_);
+      if (fader_direction_ == QTimeLine::Backward) progress = 1.0 - progress;
     }
+
+    fader_direction_ = direction;
+    fader_shape_ = shape;
+    fader_duration_nanosec_ = duration_nanosec;
+    fader_elapsed_nanosec_ = static_cast<qint64>((direction == QTimeLine::Forward ? progress : 1.0 - progress) * static_cast<qreal>(duration_nanosec));
+    fader_start_nanosec_ = -1;
+    fader_update_ = true;
+    fader_running_ = true;
+    volume_modifier_ = FaderValue(fader_elapsed_nanosec_);
+    remaining_nanosec = duration_nanosec - fader_elapsed_nanosec_;
   }
 
-  fader_.reset(new QTimeLine(static_cast<int>(duration_msec)), [](QTimeLine *timeline) {
-    if (timeline->state() != QTimeLine::NotRunning) {
-      timeline->stop();
-    }
-    timeline->deleteLater();
-  });
-  QObject::connect(fader_.get(), &QTimeLine::valueChanged, this, &GstEnginePipeline::SetVolumeModifier);
-  QObject::connect(fader_.get(), &QTimeLine::finished, this, &GstEnginePipeline::FaderTimelineFinished);
-  fader_->setDirection(direction);
-  fader_->setEasingCurve(shape);
-  fader_->setCurrentTime(static_cast<int>(start_time));
-  fader_->resume();
+  UpdateVolume();
 
   fader_fudge_timer_.stop();
   use_fudge_timer_ = use_fudge_timer;
 
-  SetVolumeModifier(fader_->currentValue());
+  // Check for the end of the fade when the audio sink should have played it, and give up waiting if the audio stops before that.
+  fader_deadline_nanosec_ = remaining_nanosec + latency_nanosec() + kFaderFudgeMsec * kNsecPerMsec;
+  fader_wall_timer_.start();
+  fader_timer_.start(static_cast<int>((remaining_nanosec + latency_nanosec()) / kNsecPerMsec), this);
+
+}
+
+qint64 GstEnginePipeline::FaderElapsedNanosec() const {
+
+  if (fader_start_nanosec_ == -1) return fader_elapsed_nanosec_;
+
+  return qBound(static_cast<qint64>(0), fader_position_nanosec_ - fader_start_nanosec_, fader_duration_nanosec_);
+
+}
+
+qreal GstEnginePipeline::FaderValue(const qint64 elapsed_nanosec) const {
+
+  qreal progress = 1.0;
+  if (fader_duration_nanosec_ > 0) {
+    progress = qBound(0.0, static_cast<qreal>(elapsed_nanosec) / static_cast<qreal>(fader_duration_nanosec_), 1.0);
+  }
+  if (fader_direction_ == QTimeLine::Backward) progress = 1.0 - progress;
+
+  return QEasingCurve(fader_shape_).valueForProgress(progress);
 
 }
 
-void GstEnginePipeline::FaderTimelineFinished() {
+void GstEnginePipeline::SetFaderControlPoints(const qint64 stream_time_nanosec) {
+
+  GstTimedValueControlSource *control_source = GST_TIMED_VALUE_CONTROL_SOURCE(fader_control_source_);
+  gst_timed_value_control_source_unset_all(control_source);
 
-  fader_.reset();
+  const double volume = static_cast<double>(volume_percent_) * static_cast<double>(0.01);
+
+  // The first point is at the current buffer, so the volume element has a value for every sample from there.
+  // A linear fade needs only the end point, other curves are approximated with line segments.
+  const qint64 elapsed_nanosec = qBound(static_cast<qint64>(0), stream_time_nanosec - fader_start_nanosec_, fader_duration_nanosec_);
+  gst_timed_value_control_source_set(control_source, static_cast<GstClockTime>(stream_time_nanosec), volume * FaderValue(elapsed_nanosec));
+
+  const int points = fader_shape_ == QEasingCurve::Linear ? 1 : kFaderCurvePoints;
+  for (int i = 1; i <= points; ++i) {
+    const qint64 point_elapsed_nanosec = fader_duration_nanosec_ * i / points;
+    const qint64 timestamp = fader_start_nanosec_ + point_elapsed_nanosec;
+    if (timestamp <= stream_time_nanosec) continue;
+    gst_timed_value_control_source_set(control_source, static_cast<GstClockTime>(timestamp), volume * FaderValue(point_elapsed_nanosec));
+  }
+
+}
+
+void GstEnginePipeline::FinishFader() {
+
+  {
+    QMutexLocker l(&fader_mutex_);
+    fader_running_ = false;
+    fader_update_ = false;
+    volume_modifier_ = FaderValue(fader_duration_nanosec_);
+  }
+
+  if (fader_control_binding_) {
+    gst_control_binding_set_disabled(fader_control_binding_, TRUE);
+  }
+  UpdateVolume();
 
   // Wait a little while longer before emitting the finished signal (and probably destroying the pipeline) to account for delays in the audio server/driver.
   if (use_fudge_timer_) {
@@ -1485,6 +1701,22 @@ void GstEnginePipeline::FaderTimelineFinished() {
 
 void GstEnginePipeline::timerEvent(QTimerEvent *e) {
 
+  if (e->timerId() == fader_timer_.timerId()) {
+    fader_timer_.stop();
+    qint64 remaining_nanosec = 0;
+    if (volume_) {
+      QMutexLocker l(&fader_mutex_);
+      remaining_nanosec = fader_duration_nanosec_ - FaderElapsedNanosec();
+    }
+    if (remaining_nanosec > 0 && fader_wall_timer_.nsecsElapsed() < fader_deadline_nanosec_) {
+      fader_timer_.start(static_cast<int>(qMax(static_cast<qint64>(kFaderPollMsec), remaining_nanosec / kNsecPerMsec)), this);
+    }
+    else {
+      FinishFader();
+    }
+    return;
+  }
+
   if (e->timerId() == fader_fudge_timer_.timerId()) {
     fader_fudge_timer_.stop();
     emit FaderFinished();
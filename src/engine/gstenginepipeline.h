@@ -24,6 +24,7 @@
 
 #include "config.h"
 
+#include <atomic>
 #include <memory>
 #include <glib.h>
 #include <glib-object.h>
@@ -38,14 +39,19 @@
 #include <QTimeLine>
 #include <QEasingCurve>
 #include <QBasicTimer>
+#include <QElapsedTimer>
 #include <QList>
 #include <QByteArray>
 #include <QVariant>
 #include <QString>
 #include <QUrl>
 
+#include "pcmconverter.h"
+#include "pcmringbuffer.h"
+
 class QTimerEvent;
 class GstBufferConsumer;
+class GstEngineMixer;
 
 namespace Engine {
 struct SimpleMetaBundle;
@@ -74,6 +80,8 @@ class GstEnginePipeline : public QObject {
   void set_proxy_settings(const QString &address, const bool authentication, const QString &user, const QString &pass);
   void set_channels(const bool enabled, const int channels);
   void set_bs2b_enabled(const bool enabled);
+  // Plays to the mixer instead of an own audio sink.
+  void set_mixer(std::shared_ptr<GstEngineMixer> mixer);
 
   // Creates the pipeline, returns false on error
   bool InitFromUrl(const QByteArray &stream_url, const QUrl &original_url, const qint64 end_nanosec, QString &error);
@@ -90,6 +98,7 @@ class GstEnginePipeline : public QObject {
   void SetStereoBalance(const float value);
   void SetEqualizerParams(const int preamp, const QList<int> &band_gains);
 
+  // Fades the volume in or out, the volume element applies the fade to each sample from the first buffer after this is called.
   void StartFader(const qint64 duration_nanosec, const QTimeLine::Direction direction = QTimeLine::Forward, const QEasingCurve::Type shape = QEasingCurve::Linear, const bool use_fudge_timer = true);
 
   // If this is set then it will be loaded automatically when playback finishes for gapless playback
@@ -112,6 +121,16 @@ class GstEnginePipeline : public QObject {
   // Returns this pipeline's state. May return GST_STATE_NULL if the state check timed out. The timeout value is a reasonable default.
   GstState state() const;
   qint64 segment_start() const { return segment_start_; }
+  // Running time of the audio that is playing now, -1 if the pipeline is not playing.
+  qint64 running_time() const;
+  // Time from the running time until the audio is audible, including the mixer.
+  qint64 latency_nanosec() const;
+
+  // Decoded audio for the analyzer, timestamped with the running time. Only one thread may read it.
+  PCMRingBuffer *analyzer_buffer() { return &analyzer_buffer_; }
+
+  // Sets the device of the audio sink, the type of the device depends on the sink.
+  static void SetAudioSinkDevice(GstElement *audiosink, const QString &output, const QVariant &device);
 
   // Don't allow the user to change the playback state (playing/paused) while the pipeline is buffering.
   bool is_buffering() const { return buffering_; }
@@ -120,9 +139,6 @@ class GstEnginePipeline : public QObject {
 
   QString source_device() const { return source_device_; }
 
- public slots:
-  void SetVolumeModifier(qreal mod);
-
  signals:
   void Error(int pipeline_id, int domain, int error_code, QString message, QString debug);
 
@@ -131,6 +147,9 @@ class GstEnginePipeline : public QObject {
 
   void FaderFinished();
 
+  // Emitted when the whole pipeline changed to the PLAYING state.
+  void PlaybackStarted(int pipeline_id);
+
   void BufferingStarted();
   void BufferingProgress(int percent);
   void BufferingFinished();
@@ -148,6 +167,8 @@ class GstEnginePipeline : public QObject {
   static void NewPadCallback(GstElement*, GstPad*, gpointer);
   static GstPadProbeReturn PlaybinProbe(GstPad*, GstPadProbeInfo*, gpointer);
   static GstPadProbeReturn HandoffCallback(GstPad*, GstPadProbeInfo*, gpointer);
+  static GstPadProbeReturn AnalyzerEventCallback(GstPad*, GstPadProbeInfo*, gpointer);
+  static GstPadProbeReturn FaderProbeCallback(GstPad*, GstPadProbeInfo*, gpointer);
   static void AboutToFinishCallback(GstPlayBin*, gpointer);
   static GstBusSyncReply BusCallbackSync(GstBus*, GstMessage*, gpointer);
   static gboolean BusCallback(GstBus*, GstMessage*, gpointer);
@@ -168,14 +189,25 @@ class GstEnginePipeline : public QObject {
   void UpdateStereoBalance();
   void UpdateEqualizer();
 
- private slots:
-  void FaderTimelineFinished();
+  // Returns a buffer of size bytes from the buffer pool for the analyzer data.
+  GstBuffer *AcquireAnalyzerBuffer(const gsize size);
+
+  // These must be called with fader_mutex_ locked.
+  qint64 FaderElapsedNanosec() const;
+  qreal FaderValue(const qint64 elapsed_nanosec) const;
+  void SetFaderControlPoints(const qint64 stream_time_nanosec);
+
+  void FinishFader();
 
  private:
   static const int kGstStateTimeoutNanosecs;
   static const int kFaderFudgeMsec;
+  static const int kFaderCurvePoints;
+  static const int kFaderPollMsec;
   static const int kEqBandCount;
   static const int kEqBandFrequencies[];
+  static const guint kBufferPoolMinBuffers;
+  static const gsize kBufferPoolSizeAlignment;
 
   // Using == to compare two pipelines is a bad idea, because new ones often get created in the same address as old ones.  This ID will be unique for each pipeline.
   // Threading warning: access to the static ID field isn't protected by a mutex because all pipeline creation is currently done in the main thread.
@@ -186,6 +218,8 @@ class GstEnginePipeline : public QObject {
   bool valid_;
   QString output_;
   QVariant device_;
+  std::shared_ptr<GstEngineMixer> mixer_;
+  QString mixer_channel_;
   bool volume_enabled_;
   bool stereo_balancer_enabled_;
   bool eq_enabled_;
@@ -273,7 +307,26 @@ class GstEnginePipeline : public QObject {
   uint volume_percent_;
   qreal volume_modifier_;
 
-  std::shared_ptr<QTimeLine> fader_;
+  // The fade is applied by the volume element from control points in stream time.
+  // They are placed by the streaming thread when the next buffer reaches the volume element, so the fade starts at the first sample of that buffer.
+  // The fader state below is protected by fader_mutex_.
+  QMutex fader_mutex_;
+  GstControlSource *fader_control_source_;
+  GstControlBinding *fader_control_binding_;
+  std::atomic<bool> fader_running_;
+  bool fader_update_;
+  QTimeLine::Direction fader_direction_;
+  QEasingCurve::Type fader_shape_;
+  qint64 fader_duration_nanosec_;
+  // Part of the fade applied before the control points were placed, and the stream time where the fade started, -1 until they are placed.
+  qint64 fader_elapsed_nanosec_;
+  qint64 fader_start_nanosec_;
+  // Stream time of the end of the last buffer which reached the volume element.
+  qint64 fader_position_nanosec_;
+  GstSegment fader_segment_{};
+  QElapsedTimer fader_wall_timer_;
+  qint64 fader_deadline_nanosec_;
+  QBasicTimer fader_timer_;
   QBasicTimer fader_fudge_timer_;
   bool use_fudge_timer_;
 
@@ -295,6 +348,23 @@ class GstEnginePipeline : public QObject {
 
   bool logged_unsupported_analyzer_format_;
 
+  // Audio format of the buffers passed to the buffer consumers, only used in the streaming thread.
+  // It's parsed when the caps change, not for every buffer.
+  QString analyzer_format_name_;
+  PCMConverter::Format analyzer_format_;
+  int analyzer_channels_;
+  int analyzer_rate_;
+
+  // Buffers for the data converted to S16LE for the buffer consumers, they are returned to the pool when the consumers unref them.
+  GstBufferPool *analyzer_buffer_pool_;
+  gsize analyzer_buffer_size_;
+
+  GstSegment analyzer_segment_{};
+  PCMRingBuffer analyzer_buffer_;
+
+  // Latency of the pipeline, the audio sink plays the audio this long after its running time.
+  qint64 latency_nanosec_;
+
 };
 
 #endif  // GSTENGINEPIPELINE_H
@@ -0,0 +1,443 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <cstring>
+
+#include <QtGlobal>
+#include <QList>
+#include <QString>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define PCMCONVERTER_SSE2
+#  include <emmintrin.h>
+#  if defined(__GNUC__)
+#    define PCMCONVERTER_AVX2
+#    include <immintrin.h>
+#  endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  define PCMCONVERTER_NEON
+#  include <arm_neon.h>
+#endif
+
+#include "pcmconverter.h"
+
+namespace PCMConverter {
+
+namespace {
+
+using ConvertFunction = void (*)(const void*, qint16*, const qint64, qint64);
+
+// Each function converts the samples from offset to the end.
+// The vector kernels convert as many samples as they can and hand the rest to the scalar kernel.
+
+qint16 FloatToS16(const float sample) {
+
+  const float value = sample * 32768.0F;
+  // Written so NaN gives 32767, like the vector kernels.
+  if (!(value < 32767.0F)) return 32767;
+  if (value <= -32768.0F) return -32768;
+  return static_cast<qint16>(value);
+
+}
+
+void S24ToS16Scalar(const void *source, qint16 *dest, const qint64 samples, qint64 offset) {
+
+  const quint8 *s = static_cast<const quint8*>(source);
+  for (; offset < samples; ++offset) {
+    const quint8 *sample = s + offset * 3;
+    dest[offset] = static_cast<qint16>(static_cast<quint16>(sample[1] | (sample[2] << 8)));
+  }
+
+}
+
+void S24_32ToS16Scalar(const void *source, qint16 *dest, const qint64 samples, qint64 offset) {
+
+  const quint32 *s = static_cast<const quint32*>(source);
+  for (; offset < samples; ++offset) {
+    dest[offset] = static_cast<qint16>(static_cast<quint16>(s[offset] >> 8));
+  }
+
+}
+
+void S32ToS16Scalar(const void *source, qint16 *dest, const qint64 samples, qint64 offset) {
+
+  const qint32 *s = static_cast<const qint32*>(source);
+  for (; offset < samples; ++offset) {
+    dest[offset] = static_cast<qint16>(s[offset] >> 16);
+  }
+
+}
+
+void F32ToS16Scalar(const void *source, qint16 *dest, const qint64 samples, qint64 offset) {
+
+  const float *s = static_cast<const float*>(source);
+  for (; offset < samples; ++offset) {
+    dest[offset] = FloatToS16(s[offset]);
+  }
+
+}
+
+#ifdef PCMCONVERTER_SSE2
+
+// SSE2 has no byte shuffle, so packed 24 bit samples are converted by the scalar kernel.
+
+void S24_32ToS16SSE2(const void *source, qint16 *dest, const qint64 samples, qint64 offset) {
+
+  const qint32 *s = static_cast<const qint32*>(source);
+  for (; offset + 8 <= samples; offset += 8) {
+    const __m128i a = _mm_srai_epi32(_mm_slli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + offset)), 8), 16);
+    const __m128i b = _mm_srai_epi32(_mm_slli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + offset + 4)), 8), 16);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + offset), _mm_packs_epi32(a, b));
+  }
+  S24_32ToS16Scalar(source, dest, samples, offset);
+
+}
+
+void S32ToS16SSE2(const void *source, qint16 *dest, const qint64 samples, qint64 offset) {
+
+  const qint32 *s = static_cast<const qint32*>(source);
+  for (; offset + 8 <= samples; offset += 8) {
+    const __m128i a = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + offset)), 16);
+    const __m128i b = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + offset + 4)), 16);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + offset), _mm_packs_epi32(a, b));
+  }
+  S32ToS16Scalar(source, dest, samples, offset);
+
+}
+
+void F32ToS16SSE2(const void *source, qint16 *dest, const qint64 samples, qint64 offset) {
+
+  const float *s = static_cast<const float*>(source);
+  const __m128 scale = _mm_set1_ps(32768.0F);
+  const __m128 max = _mm_set1_ps(32767.0F);
+  const __m128 min = _mm_set1_ps(-32768.0F);
+  for (; offset + 8 <= samples; offset += 8) {
+    const __m128 a = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(s + offset), scale), max), min);
+    const __m128 b = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(s + offset + 4), scale), max), min);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + offset), _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)));
+  }
+  F32ToS16Scalar(source, dest, samples, offset);
+
+}
+
+#endif  // PCMCONVERTER_SSE2
+
+#ifdef PCMCONVERTER_AVX2
+
+// _mm256_packs_epi32 packs within each 128 bit lane, the permute puts the four 64 bit groups back in order.
+
+__attribute__((target("avx2"))) void S24ToS16AVX2(const void *source, qint16 *dest, const qint64 samples, qint64 offset) {
+
+  const quint8 *s = static_cast<const quint8*>(source);
+  // Picks the two high bytes of the first four 3 byte samples in each lane.
+  const __m256i shuffle = _mm256_setr_epi8(1, 2, 4, 5, 7, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1, 1, 2, 4, 5, 7, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1);
+  // Each iteration reads 28 bytes for 8 samples.
+  for (; offset + 10 <= samples; offset += 8) {
+    const quint8 *p = s + offset * 3;
+    const __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)), 1);
+    const __m256i r = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, shuffle), 0x08);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + offset), _mm256_castsi256_si128(r));
+  }
+  S24ToS16Scalar(source, dest, samples, offset);
+
+}
+
+__attribute__((target("avx2"))) void S24_32ToS16AVX2(const void *source, qint16 *dest, const qint64 samples, qint64 offset) {
+
+  const qint32 *s = static_cast<const qint32*>(source);
+  for (; offset + 16 <= samples; offset += 16) {
+    const __m256i a = _mm256_srai_epi32(_mm256_slli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + offset)), 8), 16);
+    const __m256i b = _mm256_srai_epi32(_mm256_slli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + offset + 8)), 8), 16);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + offset), _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8));
+  }
+  S24_32ToS16Scalar(source, dest, samples, offset);
+
+}
+
+__attribute__((target("avx2"))) void S32ToS16AVX2(const void *source, qint16 *dest, const qint64 samples, qint64 offset) {
+
+  const qint32 *s = static_cast<const qint32*>(source);
+  for (; offset + 16 <= samples; offset += 16) {
+    const __m256i a = _mm256_srai_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + offset)), 16);
+    const __m256i b = _mm256_srai_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + offset + 8)), 16);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + offset), _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8));
+  }
+  S32ToS16Scalar(source, dest, samples, offset);
+
+}
+
+__attribute__((target("avx2"))) void F32ToS16AVX2(const void *source, qint16 *dest, const qint64 samples, qint64 offset) {
+
+  const float *s = static_cast<const float*>(source);
+  const __m256 scale = _mm256_set1_ps(32768.0F);
+  const __m256 max = _mm256_set1_ps(32767.0F);
+  const __m256 min = _mm256_set1_ps(-32768.0F);
+  for (; offset + 16 <= samples; offset += 16) {
+    const __m256 a = _mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(s + offset), scale), max), min);
+    const __m256 b = _mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(s + offset + 8), scale), max), min);
+    const __m256i packed = _mm256_packs_epi32(_mm256_cvttps_epi32(a), _mm256_cvttps_epi32(b));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + offset), _mm256_permute4x64_epi64(packed, 0xD8));
+  }
+  F32ToS16Scalar(source, dest, samples, offset);
+
+}
+
+#endif  // PCMCONVERTER_AVX2
+
+#ifdef PCMCONVERTER_NEON
+
+void S24ToS16NEON(const void *source, qint16 *dest, const qint64 samples, qint64 offset) {
+
+  const quint8 *s = static_cast<const quint8*>(source);
+  for (; offset + 8 <= samples; offset += 8) {
+    // Deinterleaves the bytes of 8 samples, the second and third byte are the 16 bit sample.
+    const uint8x8x3_t v = vld3_u8(s + offset * 3);
+    const uint16x8_t r = vorrq_u16(vmovl_u8(v.val[1]), vshll_n_u8(v.val[2], 8));
+    vst1q_s16(dest + offset, vreinterpretq_s16_u16(r));
+  }
+  S24ToS16Scalar(source, dest, samples, offset);
+
+}
+
+void S24_32ToS16NEON(const void *source, qint16 *dest, const qint64 samples, qint64 offset) {
+
+  const qint32 *s = static_cast<const qint32*>(source);
+  for (; offset + 8 <= samples; offset += 8) {
+    const int16x4_t a = vshrn_n_s32(vld1q_s32(s + offset), 8);
+    const int16x4_t b = vshrn_n_s32(vld1q_s32(s + offset + 4), 8);
+    vst1q_s16(dest + offset, vcombine_s16(a, b));
+  }
+  S24_32ToS16Scalar(source, dest, samples, offset);
+
+}
+
+void S32ToS16NEON(const void *source, qint16 *dest, const qint64 samples, qint64 offset) {
+
+  const qint32 *s = static_cast<const qint32*>(source);
+  for (; offset + 8 <= samples; offset += 8) {
+    const int16x4_t a = vshrn_n_s32(vld1q_s32(s + offset), 16);
+    const int16x4_t b = vshrn_n_s32(vld1q_s32(s + offset + 4), 16);
+    vst1q_s16(dest + offset, vcombine_s16(a, b));
+  }
+  S32ToS16Scalar(source, dest, samples, offset);
+
+}
+
+void F32ToS16NEON(const void *source, qint16 *dest, const qint64 samples, qint64 offset) {
+
+  const float *s = static_cast<const float*>(source);
+  const float32x4_t max = vdupq_n_f32(32767.0F);
+  const float32x4_t min = vdupq_n_f32(-32768.0F);
+  // Unlike the SSE2 min, vminq_f32 returns NaN for NaN, which converts to 0, so replace NaN by the maximum first.
+  auto clamp = [max, min](const float32x4_t v) { return vmaxq_f32(vminq_f32(vbslq_f32(vceqq_f32(v, v), v, max), max), min); };
+  for (; offset + 8 <= samples; offset += 8) {
+    const float32x4_t a = clamp(vmulq_n_f32(vld1q_f32(s + offset), 32768.0F));
+    const float32x4_t b = clamp(vmulq_n_f32(vld1q_f32(s + offset + 4), 32768.0F));
+    vst1q_s16(dest + offset, vcombine_s16(vmovn_s32(vcvtq_s32_f32(a)), vmovn_s32(vcvtq_s32_f32(b))));
+  }
+  F32ToS16Scalar(source, dest, samples, offset);
+
+}
+
+#endif  // PCMCONVERTER_NEON
+
+ConvertFunction ScalarFunction(const Format format) {
+
+  switch (format) {
+    case Format::S24LE:
+      return &S24ToS16Scalar;
+    case Format::S24_32LE:
+      return &S24_32ToS16Scalar;
+    case Format::S32LE:
+      return &S32ToS16Scalar;
+    case Format::F32LE:
+      return &F32ToS16Scalar;
+    default:
+      return nullptr;
+  }
+
+}
+
+ConvertFunction KernelFunction(const Format format, const Kernel kernel) {
+
+  switch (kernel) {
+#ifdef PCMCONVERTER_SSE2
+    case Kernel::SSE2:
+      switch (format) {
+        case Format::S24_32LE:
+          return &S24_32ToS16SSE2;
+        case Format::S32LE:
+          return &S32ToS16SSE2;
+        case Format::F32LE:
+          return &F32ToS16SSE2;
+        default:
+          break;
+      }
+      break;
+#endif
+#ifdef PCMCONVERTER_AVX2
+    case Kernel::AVX2:
+      switch (format) {
+        case Format::S24LE:
+          return &S24ToS16AVX2;
+        case Format::S24_32LE:
+          return &S24_32ToS16AVX2;
+        case Format::S32LE:
+          return &S32ToS16AVX2;
+        case Format::F32LE:
+          return &F32ToS16AVX2;
+        default:
+          break;
+      }
+      break;
+#endif
+#ifdef PCMCONVERTER_NEON
+    case Kernel::NEON:
+      switch (format) {
+        case Format::S24LE:
+          return &S24ToS16NEON;
+        case Format::S24_32LE:
+          return &S24_32ToS16NEON;
+        case Format::S32LE:
+          return &S32ToS16NEON;
+        case Format::F32LE:
+          return &F32ToS16NEON;
+        default:
+          break;
+      }
+      break;
+#endif
+    default:
+      break;
+  }
+
+  return ScalarFunction(format);
+
+}
+
+QList<Kernel> DetectKernels() {
+
+  QList<Kernel> kernels = QList<Kernel>() << Kernel::Scalar;
+
+#ifdef PCMCONVERTER_SSE2
+  kernels << Kernel::SSE2;
+#endif
+#ifdef PCMCONVERTER_AVX2
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    kernels << Kernel::AVX2;
+  }
+#endif
+#ifdef PCMCONVERTER_NEON
+  kernels << Kernel::NEON;
+#endif
+
+  return kernels;
+
+}
+
+}  // namespace
+
+Format FormatFromString(const QString &format) {
+
+  if (format == "S16LE") return Format::S16LE;
+  if (format == "S24LE") return Format::S24LE;
+  if (format == "S24_32LE") return Format::S24_32LE;
+  if (format == "S32LE") return Format::S32LE;
+  if (format == "F32LE") return Format::F32LE;
+
+  return Format::Unsupported;
+
+}
+
+int SampleSize(const Format format) {
+
+  switch (format) {
+    case Format::S16LE:
+      return 2;
+    case Format::S24LE:
+      return 3;
+    case Format::S24_32LE:
+    case Format::S32LE:
+    case Format::F32LE:
+      return 4;
+    default:
+      return 0;
+  }
+
+}
+
+QList<Kernel> SupportedKernels() {
+
+  static const QList<Kernel> kernels = DetectKernels();
+  return kernels;
+
+}
+
+Kernel DefaultKernel() {
+
+  static const Kernel kernel = SupportedKernels().last();
+  return kernel;
+
+}
+
+QString KernelName(const Kernel kernel) {
+
+  switch (kernel) {
+    case Kernel::Scalar:
+      return "Scalar";
+    case Kernel::SSE2:
+      return "SSE2";
+    case Kernel::AVX2:
+      return "AVX2";
+    case Kernel::NEON:
+      return "NEON";
+  }
+
+  return QString();
+
+}
+
+void ConvertToS16(const Format format, const void *source, qint16 *dest, const qint64 samples) {
+
+  ConvertToS16(format, DefaultKernel(), source, dest, samples);
+
+}
+
+void ConvertToS16(const Format format, const Kernel kernel, const void *source, qint16 *dest, const qint64 samples) {
+
+  if (samples <= 0) return;
+
+  if (format == Format::S16LE) {
+    memcpy(dest, source, static_cast<size_t>(samples) * sizeof(qint16));
+    return;
+  }
+
+  if (!SupportedKernels().contains(kernel)) return;
+
+  ConvertFunction function = KernelFunction(format, kernel);
+  if (function) function(source, dest, samples, 0);
+
+}
+
+}  // namespace PCMConverter
@@ -0,0 +1,67 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PCMCONVERTER_H
+#define PCMCONVERTER_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QList>
+#include <QString>
+
+// Converts interleaved PCM samples to signed 16 bit for the analyzer.
+// The conversion uses the fastest kernel supported by the CPU, the scalar kernel converts the remaining samples.
+namespace PCMConverter {
+
+enum class Format {
+  Unsupported,
+  S16LE,
+  S24LE,
+  S24_32LE,
+  S32LE,
+  F32LE
+};
+
+enum class Kernel {
+  Scalar,
+  SSE2,
+  AVX2,
+  NEON
+};
+
+// Parses a GStreamer audio format name.
+Format FormatFromString(const QString &format);
+
+// Size of one sample in bytes, 0 if the format is unsupported.
+int SampleSize(const Format format);
+
+// Kernels supported by this CPU, the first is the scalar kernel, the last is the fastest.
+QList<Kernel> SupportedKernels();
+Kernel DefaultKernel();
+QString KernelName(const Kernel kernel);
+
+// Converts samples (the samples of all channels) from source to dest, which must have room for samples 16 bit samples.
+// Nothing is converted if the format is unsupported or the kernel is not supported by this CPU.
+void ConvertToS16(const Format format, const void *source, qint16 *dest, const qint64 samples);
+void ConvertToS16(const Format format, const Kernel kernel, const void *source, qint16 *dest, const qint64 samples);
+
+}  // namespace PCMConverter
+
+#endif  // PCMCONVERTER_H
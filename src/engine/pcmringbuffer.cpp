@@ -0,0 +1,125 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <cstring>
+
+#include <QtGlobal>
+
+#include "core/timeconstants.h"
+#include "pcmconverter.h"
+#include "pcmringbuffer.h"
+
+const int PCMRingBuffer::kSlotCount = 64;
+const int PCMRingBuffer::kSlotSamples = 4096;
+const qint64 PCMRingBuffer::kMaxLeadNanosec = 2000 * kNsecPerMsec;
+
+PCMRingBuffer::PCMRingBuffer()
+    : slots_(new Slot[kSlotCount]),
+      head_(0),
+      tail_(0),
+      written_samples_(0),
+      dropped_samples_(0) {
+
+  for (int i = 0; i < kSlotCount; ++i) {
+    slots_[i].data.reset(new qint16[kSlotSamples]);
+  }
+
+}
+
+bool PCMRingBuffer::Write(const qint64 timestamp_nanosec, const int channels, const int rate, const PCMConverter::Format format, const void *data, const qint64 samples) {
+
+  const int sample_size = PCMConverter::SampleSize(format);
+  if (channels <= 0 || channels > kSlotSamples || rate <= 0 || sample_size == 0) return true;
+
+  const quint8 *source = static_cast<const quint8*>(data);
+  const qint64 frames = samples / channels;
+  const qint64 slot_frames = kSlotSamples / channels;
+
+  quint64 head = head_.load(std::memory_order_relaxed);
+  for (qint64 frame = 0; frame < frames; frame += slot_frames) {
+    if (head - tail_.load(std::memory_order_acquire) >= static_cast<quint64>(kSlotCount)) {
+      dropped_samples_ += (frames - frame) * channels;
+      return false;
+    }
+
+    const qint64 count = qMin(slot_frames, frames - frame);
+    Slot &slot = slots_[head % kSlotCount];
+    slot.timestamp = timestamp_nanosec + frame * kNsecPerSec / rate;
+    slot.duration = count * kNsecPerSec / rate;
+    slot.channels = channels;
+    slot.rate = rate;
+    slot.samples = static_cast<int>(count * channels);
+    PCMConverter::ConvertToS16(format, source + frame * channels * sample_size, slot.data.get(), slot.samples);
+
+    // Publishes the slot to the reader.
+    head_.store(++head, std::memory_order_release);
+    written_samples_ += slot.samples;
+  }
+
+  return true;
+
+}
+
+int PCMRingBuffer::Read(const qint64 timestamp_nanosec, qint16 *dest, const int count) {
+
+  const quint64 head = head_.load(std::memory_order_acquire);
+  quint64 tail = tail_.load(std::memory_order_relaxed);
+
+  // Skip audio that was already played, and audio that is too far ahead to be from the current segment.
+  while (tail != head) {
+    const Slot &slot = slots_[tail % kSlotCount];
+    if (slot.timestamp + slot.duration > timestamp_nanosec && slot.timestamp < timestamp_nanosec + kMaxLeadNanosec) break;
+    ++tail;
+  }
+  // Hands the skipped slots back to the writer.
+  tail_.store(tail, std::memory_order_release);
+
+  int copied = 0;
+  const Slot *previous_slot = nullptr;
+  for (quint64 i = tail; i != head && copied < count; ++i) {
+    const Slot &slot = slots_[i % kSlotCount];
+    int offset = 0;
+    if (previous_slot) {
+      // Stop at a gap, where audio was dropped or the stream jumped, and where the format changes.
+      if (slot.channels != previous_slot->channels || slot.rate != previous_slot->rate) break;
+      if (qAbs(slot.timestamp - (previous_slot->timestamp + previous_slot->duration)) > kNsecPerSec / slot.rate) break;
+    }
+    else {
+      // The audio at the timestamp was dropped or has not been written yet.
+      if (slot.timestamp > timestamp_nanosec) break;
+      offset = static_cast<int>((timestamp_nanosec - slot.timestamp) * slot.rate / kNsecPerSec) * slot.channels;
+    }
+    if (offset >= slot.samples) break;
+    const int samples = qMin(slot.samples - offset, count - copied);
+    memcpy(dest + copied, slot.data.get() + offset, static_cast<size_t>(samples) * sizeof(qint16));
+    copied += samples;
+    previous_slot = &slot;
+  }
+
+  return copied;
+
+}
+
+void PCMRingBuffer::Clear() {
+
+  tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+
+}
@@ -0,0 +1,83 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PCMRINGBUFFER_H
+#define PCMRINGBUFFER_H
+
+#include "config.h"
+
+#include <memory>
+#include <atomic>
+
+#include <QtGlobal>
+
+#include "pcmconverter.h"
+
+// Lock-free ring of 16 bit PCM audio with timestamps, for one writer thread and one reader thread.
+// The streaming thread writes the decoded audio, the GUI thread reads the samples at the playback position for the analyzer.
+// Neither side blocks: when the ring is full, new audio is dropped until the reader catches up.
+class PCMRingBuffer {
+ public:
+  explicit PCMRingBuffer();
+
+  static const int kSlotCount;
+  static const int kSlotSamples;
+  // Audio starting more than this after the read position is left over from before a seek and is discarded.
+  static const qint64 kMaxLeadNanosec;
+
+  // Writer.
+  // Converts the interleaved samples to 16 bit and appends them, timestamp is the time of the first frame.
+  // Returns false if some of the audio was dropped because the ring is full.
+  bool Write(const qint64 timestamp_nanosec, const int channels, const int rate, const PCMConverter::Format format, const void *data, const qint64 samples);
+
+  // Reader.
+  // Copies up to count samples starting at the frame played at timestamp to dest, returns the number of samples copied.
+  // Nothing is copied if the audio at the timestamp is not in the ring, and copying stops where the following audio is not continuous.
+  // Audio that ended before the timestamp is discarded.
+  int Read(const qint64 timestamp_nanosec, qint16 *dest, const int count);
+  // Discards all audio.
+  void Clear();
+
+  // Number of samples written and dropped since the ring was created.
+  qint64 written_samples() const { return written_samples_; }
+  qint64 dropped_samples() const { return dropped_samples_; }
+
+ private:
+  Q_DISABLE_COPY(PCMRingBuffer)
+
+  struct Slot {
+    qint64 timestamp;
+    qint64 duration;
+    int channels;
+    int rate;
+    int samples;
+    std::unique_ptr<qint16[]> data;
+  };
+
+  std::unique_ptr<Slot[]> slots_;
+
+  // Number of slots written and read, the writer only changes head_ and the reader only changes tail_.
+  std::atomic<quint64> head_;
+  std::atomic<quint64> tail_;
+
+  std::atomic<qint64> written_samples_;
+  std::atomic<qint64> dropped_samples_;
+};
+
+#endif  // PCMRINGBUFFER_H
@@ -51,7 +51,7 @@ InternetPlaylistItem::InternetPlaylistItem(InternetService *service, const Song
 
 bool InternetPlaylistItem::InitFromQuery(const SqlRow &query) {
 
-  metadata_.InitFromQuery(query, false);
+  metadata_.InitFromQuery(query, false, PlaylistBackend::PlaylistItemsColumn());
   InitMetadata();
   return true;
 
@@ -25,6 +25,8 @@
 #include <memory>
 #include <utility>
 #include <algorithm>
+#include <numeric>
+#include <vector>
 #include <functional>
 #include <unordered_map>
 #include <random>
@@ -57,6 +59,9 @@
 #include <QFlags>
 #include <QSettings>
 #include <QTimer>
+#include <QCollator>
+#include <QMutex>
+#include <QMutexLocker>
 
 #include "core/application.h"
 #include "core/logging.h"
@@ -111,6 +116,8 @@ const int Playlist::kUndoItemLimit = 500;
 const qint64 Playlist::kMinScrobblePointNsecs = 31LL * kNsecPerSec;
 const qint64 Playlist::kMaxScrobblePointNsecs = 240LL * kNsecPerSec;
 
+const int Playlist::kRestorePageSize = 5000;
+
 Playlist::Playlist(PlaylistBackend *backend, TaskManager *task_manager, CollectionBackend *collection, const int id, const QString &special_type, const bool favorite, QObject *parent)
     : QAbstractListModel(parent),
       is_loading_(false),
@@ -122,6 +129,7 @@ Playlist::Playlist(PlaylistBackend *backend, TaskManager *task_manager, Collecti
       collection_(collection),
       id_(id),
       favorite_(favorite),
+      filter_text_generation_(0),
       current_is_paused_(false),
       current_virtual_index_(-1),
       is_shuffled_(false),
@@ -130,6 +138,11 @@ Playlist::Playlist(PlaylistBackend *backend, TaskManager *task_manager, Collecti
       undo_stack_(new QUndoStack(this)),
       special_type_(special_type),
       cancel_restore_(false),
+      restore_started_(false),
+      restored_(backend == nullptr),
+      save_after_restore_(false),
+      restore_offset_(0),
+      restore_limit_(0),
       scrobbled_(false),
       scrobble_point_(-1),
       editing_(-1),
@@ -141,8 +154,7 @@ Playlist::Playlist(PlaylistBackend *backend, TaskManager *task_manager, Collecti
 
   QObject::connect(this, &Playlist::rowsInserted, this, &Playlist::PlaylistChanged);
   QObject::connect(this, &Playlist::rowsRemoved, this, &Playlist::PlaylistChanged);
-
-  Restore();
+  QObject::connect(this, &Playlist::dataChanged, this, &Playlist::InvalidateFilterText);
 
   filter_->setSourceModel(this);
   queue_->setSourceModel(this);
@@ -164,6 +176,8 @@ Playlist::Playlist(PlaylistBackend *backend, TaskManager *task_manager, Collecti
 }
 
 Playlist::~Playlist() {
+  // The filter can be evaluating rows on a worker thread, it uses the filter text cache.
+  delete filter_;
   items_.clear();
   collection_items_by_id_.clear();
 }
@@ -264,6 +278,55 @@ bool Playlist::set_column_value(Song &song, Playlist::Column column, const QVari
 
 }
 
+QVariant Playlist::column_value(const Song &song, const int column, const int role) {
+
+  // Don't forget to change PlaylistSortColumn when adding new columns
+  switch (column) {
+    case Column_Title:              return song.PrettyTitle();
+    case Column_Artist:             return song.artist();
+    case Column_Album:              return song.album();
+    case Column_Length:             return song.length_nanosec();
+    case Column_Track:              return song.track();
+    case Column_Disc:               return song.disc();
+    case Column_Year:               return song.year();
+    case Column_OriginalYear:       return song.effective_originalyear();
+    case Column_Genre:              return song.genre();
+    case Column_AlbumArtist:        return song.playlist_albumartist();
+    case Column_Composer:           return song.composer();
+    case Column_Performer:          return song.performer();
+    case Column_Grouping:           return song.grouping();
+
+    case Column_PlayCount:          return song.playcount();
+    case Column_SkipCount:          return song.skipcount();
+    case Column_LastPlayed:         return song.lastplayed();
+
+    case Column_Samplerate:         return song.samplerate();
+    case Column_Bitdepth:           return song.bitdepth();
+    case Column_Bitrate:            return song.bitrate();
+
+    case Column_Filename:           return song.effective_stream_url();
+    case Column_BaseFilename:       return song.basefilename();
+    case Column_Filesize:           return song.filesize();
+    case Column_Filetype:           return song.filetype();
+    case Column_DateModified:       return song.mtime();
+    case Column_DateCreated:        return song.ctime();
+
+    case Column_Comment:
+      if (role == Qt::DisplayRole)  return song.comment().simplified();
+      return song.comment();
+
+    case Column_Source:             return song.source();
+
+    case Column_Rating:             return song.rating();
+
+    case Column_HasCUE:             return song.has_cue();
+
+  }
+
+  return QVariant();
+
+}
+
 QVariant Playlist::data(const QModelIndex &idx, int role) const {
 
   switch (role) {
@@ -284,55 +347,8 @@ QVariant Playlist::data(const QModelIndex &idx, int role) const {
 
     case Qt::EditRole:
     case Qt::ToolTipRole:
-    case Qt::DisplayRole: {
-      PlaylistItemPtr item = items_[idx.row()];
-      Song song = item->Metadata();
-
-      // Don't forget to change Playlist::CompareItems when adding new columns
-      switch (idx.column()) {
-        case Column_Title:              return song.PrettyTitle();
-        case Column_Artist:             return song.artist();
-        case Column_Album:              return song.album();
-        case Column_Length:             return song.length_nanosec();
-        case Column_Track:              return song.track();
-        case Column_Disc:               return song.disc();
-        case Column_Year:               return song.year();
-        case Column_OriginalYear:       return song.effective_originalyear();
-        case Column_Genre:              return song.genre();
-        case Column_AlbumArtist:        return song.playlist_albumartist();
-        case Column_Composer:           return song.composer();
-        case Column_Performer:          return song.performer();
-        case Column_Grouping:           return song.grouping();
-
-        case Column_PlayCount:          return song.playcount();
-        case Column_SkipCount:          return song.skipcount();
-        case Column_LastPlayed:         return song.lastplayed();
-
-        case Column_Samplerate:         return song.samplerate();
-        case Column_Bitdepth:           return song.bitdepth();
-        case Column_Bitrate:            return song.bitrate();
-
-        case Column_Filename:           return song.effective_stream_url();
-        case Column_BaseFilename:       return song.basefilename();
-        case Column_Filesize:           return song.filesize();
-        case Column_Filetype:           return song.filetype();
-        case Column_DateModified:       return song.mtime();
-        case Column_DateCreated:        return song.ctime();
-
-        case Column_Comment:
-          if (role == Qt::DisplayRole)  return song.comment().simplified();
-          return song.comment();
-
-        case Column_Source:             return song.source();
-
-        case Column_Rating:             return song.rating();
-
-        case Column_HasCUE:             return song.has_cue();
-
-      }
-
-      return QVariant();
-    }
+    case Qt::DisplayRole:
+      return column_value(items_[idx.row()]->Metadata(), idx.column(), role);
 
     case Qt::TextAlignmentRole:
       return QVariant(column_alignments_.value(idx.column(), (Qt::AlignLeft | Qt::AlignVCenter)));
@@ -1196,6 +1212,7 @@ void Playlist::UpdateItems(SongList songs) {
         else {
           new_item = std::make_shared<SongPlaylistItem>(song);
         }
+        RemoveFilterText(item.get());
         items_[i] = new_item;
         emit dataChanged(index(i, 0), index(i, ColumnCount - 1));
         // Also update undo actions
@@ -1259,71 +1276,173 @@ QMimeData *Playlist::mimeData(const QModelIndexList &indexes) const {
 
 }
 
-bool Playlist::CompareItems(const int column, const Qt::SortOrder order, std::shared_ptr<PlaylistItem> _a, std::shared_ptr<PlaylistItem> _b) {
+namespace {
 
-  std::shared_ptr<PlaylistItem> a = order == Qt::AscendingOrder ? _a : _b;
-  std::shared_ptr<PlaylistItem> b = order == Qt::AscendingOrder ? _b : _a;
+// Sorts by the number of directories in the path, for the breadth-first ordering of filenames.
+constexpr int kSortColumnPathDepth = -1;
+
+// The sort keys of one column for the items being sorted, indexed by the item's position before sorting.
+class PlaylistSortColumn {
+ public:
+  explicit PlaylistSortColumn(const int column, PlaylistItemList::const_iterator begin, PlaylistItemList::const_iterator end, const QCollator &collator);
+
+  // Returns a negative number, zero or a positive number if the key of a is less than, equal to or greater than the key of b.
+  int Compare(const int a, const int b) const {
+    switch (type_) {
+      case Type::Number:
+        return numbers_[a] < numbers_[b] ? -1 : (numbers_[b] < numbers_[a] ? 1 : 0);
+      case Type::Text:
+        return texts_[a].compare(texts_[b]);
+      case Type::CollatedText:
+        return collated_[a].compare(collated_[b]);
+    }
+    return 0;
+  }
+
+ private:
+  enum class Type {
+    Number,
+    Text,
+    CollatedText
+  };
+
+  Type type_;
+  std::vector<double> numbers_;
+  std::vector<QString> texts_;
+  std::vector<QCollatorSortKey> collated_;
+};
 
-#define cmp(field) return a->Metadata().field() < b->Metadata().field()
-#define strcmp(field) return QString::localeAwareCompare(a->Metadata().field().toLower(), b->Metadata().field().toLower()) < 0;
+PlaylistSortColumn::PlaylistSortColumn(const int column, PlaylistItemList::const_iterator begin, PlaylistItemList::const_iterator end, const QCollator &collator) : type_(Type::Number) {
 
   switch (column) {
+    case Playlist::Column_Title:
+    case Playlist::Column_Artist:
+    case Playlist::Column_Album:
+    case Playlist::Column_Genre:
+    case Playlist::Column_AlbumArtist:
+    case Playlist::Column_Composer:
+    case Playlist::Column_Performer:
+    case Playlist::Column_Grouping:
+    case Playlist::Column_Comment:
+    case Playlist::Column_Filename:
+      type_ = Type::CollatedText;
+      collated_.reserve(static_cast<size_t>(end - begin));
+      break;
+    case Playlist::Column_BaseFilename:
+      type_ = Type::Text;
+      texts_.reserve(static_cast<size_t>(end - begin));
+      break;
+    default:
+      numbers_.reserve(static_cast<size_t>(end - begin));
+      break;
+  }
 
-    case Column_Title:        strcmp(title_sortable);
-    case Column_Artist:       strcmp(artist_sortable);
-    case Column_Album:        strcmp(album_sortable);
-    case Column_Length:       cmp(length_nanosec);
-    case Column_Track:        cmp(track);
-    case Column_Disc:         cmp(disc);
-    case Column_Year:         cmp(year);
-    case Column_OriginalYear: cmp(originalyear);
-    case Column_Genre:        strcmp(genre);
-    case Column_AlbumArtist:  strcmp(playlist_albumartist_sortable);
-    case Column_Composer:     strcmp(composer);
-    case Column_Performer:    strcmp(performer);
-    case Column_Grouping:     strcmp(grouping);
+#define number(value) numbers_.push_back(static_cast<double>(value)); break
+#define collated(value) collated_.push_back(collator.sortKey(value.toLower())); break
+
+  for (PlaylistItemList::const_iterator it = begin; it != end; ++it) {
+    const PlaylistItemPtr &item = *it;
+    if (column == Playlist::Column_Filename) {
+      collated_.push_back(collator.sortKey(item->Url().path().toLower()));
+      continue;
+    }
+    if (column == kSortColumnPathDepth) {
+      numbers_.push_back(static_cast<double>(item->Url().path().count('/')));
+      continue;
+    }
+    const Song song = item->Metadata();
+    switch (column) {
+      case Playlist::Column_Title:        collated(song.title_sortable());
+      case Playlist::Column_Artist:       collated(song.artist_sortable());
+      case Playlist::Column_Album:        collated(song.album_sortable());
+      case Playlist::Column_Length:       number(song.length_nanosec());
+      case Playlist::Column_Track:        number(song.track());
+      case Playlist::Column_Disc:         number(song.disc());
+      case Playlist::Column_Year:         number(song.year());
+      case Playlist::Column_OriginalYear: number(song.originalyear());
+      case Playlist::Column_Genre:        collated(song.genre());
+      case Playlist::Column_AlbumArtist:  collated(song.playlist_albumartist_sortable());
+      case Playlist::Column_Composer:     collated(song.composer());
+      case Playlist::Column_Performer:    collated(song.performer());
+      case Playlist::Column_Grouping:     collated(song.grouping());
 
-    case Column_PlayCount:    cmp(playcount);
-    case Column_SkipCount:    cmp(skipcount);
-    case Column_LastPlayed:   cmp(lastplayed);
+      case Playlist::Column_PlayCount:    number(song.playcount());
+      case Playlist::Column_SkipCount:    number(song.skipcount());
+      case Playlist::Column_LastPlayed:   number(song.lastplayed());
 
-    case Column_Bitrate:      cmp(bitrate);
-    case Column_Samplerate:   cmp(samplerate);
-    case Column_Bitdepth:     cmp(bitdepth);
-    case Column_Filename:
-      return (QString::localeAwareCompare(a->Url().path().toLower(), b->Url().path().toLower()) < 0);
-    case Column_BaseFilename: cmp(basefilename);
-    case Column_Filesize:     cmp(filesize);
-    case Column_Filetype:     cmp(filetype);
-    case Column_DateModified: cmp(mtime);
-    case Column_DateCreated:  cmp(ctime);
+      case Playlist::Column_Bitrate:      number(song.bitrate());
+      case Playlist::Column_Samplerate:   number(song.samplerate());
+      case Playlist::Column_Bitdepth:     number(song.bitdepth());
+      case Playlist::Column_BaseFilename: texts_.push_back(song.basefilename()); break;
+      case Playlist::Column_Filesize:     number(song.filesize());
+      case Playlist::Column_Filetype:     number(song.filetype());
+      case Playlist::Column_DateModified: number(song.mtime());
+      case Playlist::Column_DateCreated:  number(song.ctime());
 
-    case Column_Comment:      strcmp(comment);
-    case Column_Source:       cmp(source);
+      case Playlist::Column_Comment:      collated(song.comment());
+      case Playlist::Column_Source:       number(song.source());
 
-    case Column_Rating:       cmp(rating);
+      case Playlist::Column_Rating:       number(song.rating());
 
-    case Column_HasCUE:       cmp(has_cue);
+      case Playlist::Column_HasCUE:       number(song.has_cue());
 
-    default: qLog(Error) << "No such column" << column;
+      default:                            number(0);
+    }
   }
 
-#undef cmp
-#undef strcmp
-
-  return false;
+#undef number
+#undef collated
 
 }
 
-bool Playlist::ComparePathDepths(const Qt::SortOrder order, std::shared_ptr<PlaylistItem> _a, std::shared_ptr<PlaylistItem> _b) {
+}  // namespace
+
+void Playlist::SortItems(PlaylistItemList::iterator begin, PlaylistItemList::iterator end, const int column, const Qt::SortOrder order) {
+
+  QList<int> columns;
+  if (column == Column_Album) {
+    // When sorting by album, also take into account discs and tracks.
+    columns << Column_Album << Column_Disc << Column_Track;
+  }
+  else if (column == Column_Filename) {
+    // When sorting by full paths we also expect a hierarchical order. This returns a breath-first ordering of paths.
+    columns << kSortColumnPathDepth << Column_Filename;
+  }
+  else if (column >= 0 && column < ColumnCount) {
+    columns << column;
+  }
+  else {
+    qLog(Error) << "No such column" << column;
+    return;
+  }
+
+  const int count = static_cast<int>(end - begin);
+  if (count < 2) return;
 
-  std::shared_ptr<PlaylistItem> a = order == Qt::AscendingOrder ? _a : _b;
-  std::shared_ptr<PlaylistItem> b = order == Qt::AscendingOrder ? _b : _a;
+  QCollator collator;
+  std::vector<PlaylistSortColumn> keys;
+  keys.reserve(static_cast<size_t>(columns.count()));
+  for (const int sort_column : columns) {
+    keys.emplace_back(sort_column, begin, end, collator);
+  }
 
-  qint64 a_dir_level = a->Url().path().count('/');
-  qint64 b_dir_level = b->Url().path().count('/');
+  // Sort the positions of the items instead of the items, so comparisons only look up keys.
+  std::vector<int> positions(static_cast<size_t>(count));
+  std::iota(positions.begin(), positions.end(), 0);
+  std::stable_sort(positions.begin(), positions.end(), [&keys, order](const int a, const int b) {
+    for (const PlaylistSortColumn &key : keys) {
+      const int result = key.Compare(a, b);
+      if (result != 0) return order == Qt::AscendingOrder ? result < 0 : result > 0;
+    }
+    return false;
+  });
 
-  return a_dir_level < b_dir_level;
+  PlaylistItemList sorted_items;
+  sorted_items.reserve(count);
+  for (const int position : positions) {
+    sorted_items << *(begin + position);
+  }
+  std::copy(sorted_items.begin(), sorted_items.end(), begin);
 
 }
 
@@ -1400,20 +1519,7 @@ void Playlist::sort(int column, Qt::SortOrder order) {
   if (dynamic_playlist_ && current_item_index_.isValid())
     begin += current_item_index_.row() + 1;
 
-  if (column == Column_Album) {
-    // When sorting by album, also take into account discs and tracks.
-    std::stable_sort(begin, new_items.end(), std::bind(&Playlist::CompareItems, Column_Track, order, std::placeholders::_1, std::placeholders::_2));
-    std::stable_sort(begin, new_items.end(), std::bind(&Playlist::CompareItems, Column_Disc, order, std::placeholders::_1, std::placeholders::_2));
-    std::stable_sort(begin, new_items.end(), std::bind(&Playlist::CompareItems, Column_Album, order, std::placeholders::_1, std::placeholders::_2));
-  }
-  else if (column == Column_Filename) {
-    // When sorting by full paths we also expect a hierarchical order. This returns a breath-first ordering of paths.
-    std::stable_sort(begin, new_items.end(), std::bind(&Playlist::CompareItems, Column_Filename, order, std::placeholders::_1, std::placeholders::_2));
-    std::stable_sort(begin, new_items.end(), std::bind(&Playlist::ComparePathDepths, order, std::placeholders::_1, std::placeholders::_2));
-  }
-  else {
-    std::stable_sort(begin, new_items.end(), std::bind(&Playlist::CompareItems, column, order, std::placeholders::_1, std::placeholders::_2));
-  }
+  SortItems(begin, new_items.end(), column, order);
 
   undo_stack_->push(new PlaylistUndoCommands::SortItems(this, column, order, new_items));
 
@@ -1479,13 +1585,20 @@ void Playlist::ScheduleSave() {
 
   if (!backend_ || is_loading_) return;
 
+  // The items were not loaded yet, saving now would drop them from the database.
+  if (!restored_) {
+    save_after_restore_ = true;
+    Restore();
+    return;
+  }
+
   timer_save_->start();
 
 }
 
 void Playlist::Save() {
 
-  if (!backend_ || is_loading_) return;
+  if (!backend_ || is_loading_ || !restored_) return;
 
   backend_->SavePlaylistAsync(id_, items_, last_played_row(), dynamic_playlist_);
 
@@ -1493,18 +1606,25 @@ void Playlist::Save() {
 
 void Playlist::Restore() {
 
-  if (!backend_) return;
+  if (!backend_ || restore_started_) return;
 
-  items_.clear();
-  virtual_items_.clear();
-  collection_items_by_id_.clear();
+  restore_started_ = true;
+  restore_info_ = backend_->GetPlaylist(id_);
+  restore_offset_ = 0;
+  restore_last_item_.reset();
 
-  cancel_restore_ = false;
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-  QFuture<PlaylistItemList> future = QtConcurrent::run(&PlaylistBackend::GetPlaylistItems, backend_, id_);
-#else
-  QFuture<PlaylistItemList> future = QtConcurrent::run(backend_, &PlaylistBackend::GetPlaylistItems, id_);
-#endif
+  // Load enough items in the first page to show the last played item.
+  RestorePage(0, qMax(kRestorePageSize, restore_info_.last_played + kRestorePageSize / 2));
+
+}
+
+void Playlist::RestorePage(const int offset, const int limit) {
+
+  restore_limit_ = limit;
+
+  PlaylistBackend *backend = backend_;
+  const int id = id_;
+  QFuture<PlaylistItemList> future = QtConcurrent::run([backend, id, offset, limit]() { return backend->GetPlaylistItems(id, offset, limit); });
   QFutureWatcher<PlaylistItemList> *watcher = new QFutureWatcher<PlaylistItemList>();
   QObject::connect(watcher, &QFutureWatcher<PlaylistItemList>::finished, this, &Playlist::ItemsLoaded);
   watcher->setFuture(future);
@@ -1517,7 +1637,14 @@ void Playlist::ItemsLoaded() {
   PlaylistItemList items = watcher->result();
   watcher->deleteLater();
 
-  if (cancel_restore_) return;
+  if (cancel_restore_) {
+    RestoreDone();
+    return;
+  }
+
+  const bool first_page = restore_offset_ == 0;
+  const bool last_page = items.count() < restore_limit_;
+  restore_offset_ += static_cast<int>(items.count());
 
   // Backend returns empty elements for collection items which it couldn't match (because they got deleted); we don't need those
   QMutableListIterator<PlaylistItemPtr> it(items);
@@ -1529,16 +1656,44 @@ void Playlist::ItemsLoaded() {
     }
   }
 
+  // Items added while the playlist is restored stay after the restored items.
+  int pos = 0;
+  if (restore_last_item_) {
+    pos = static_cast<int>(items_.indexOf(restore_last_item_)) + 1;
+    if (pos == 0) pos = static_cast<int>(items_.count());
+  }
+  if (!items.isEmpty()) restore_last_item_ = items.last();
+
+  // Restoring is not an undoable action.
   is_loading_ = true;
-  InsertItems(items, 0);
+  InsertItemsWithoutUndo(items, pos);
   is_loading_ = false;
 
-  PlaylistBackend::Playlist p = backend_->GetPlaylist(id_);
+  if (first_page) {
+    // The newly loaded list of items might be shorter than it was before so look out for a bad last_played index
+    last_played_item_index_ = restore_info_.last_played == -1 || restore_info_.last_played >= rowCount() ? QModelIndex() : index(restore_info_.last_played);
+
+    emit RestoreFinished();
+    emit PlaylistLoaded();
+  }
+
+  if (last_page) {
+    RestoreDone();
+  }
+  else {
+    RestorePage(restore_offset_, kRestorePageSize);
+  }
+
+}
+
+void Playlist::RestoreDone() {
 
-  // The newly loaded list of items might be shorter than it was before so look out for a bad last_played index
-  last_played_item_index_ = p.last_played == -1 || p.last_played >= rowCount() ? QModelIndex() : index(p.last_played);
+  restored_ = true;
+  restore_last_item_.reset();
 
-  if (p.dynamic_type == PlaylistGenerator::Type_Query) {
+  const PlaylistBackend::Playlist &p = restore_info_;
+
+  if (!cancel_restore_ && p.dynamic_type == PlaylistGenerator::Type_Query) {
     PlaylistGeneratorPtr gen = PlaylistGenerator::Create(p.dynamic_type);
     if (gen) {
 
@@ -1554,7 +1709,10 @@ void Playlist::ItemsLoaded() {
     }
   }
 
-  emit RestoreFinished();
+  if (save_after_restore_ || cancel_restore_) {
+    save_after_restore_ = false;
+    ScheduleSave();
+  }
 
   QSettings s;
   s.beginGroup(kSettingsGroup);
@@ -1570,8 +1728,6 @@ void Playlist::ItemsLoaded() {
 #endif
   }
 
-  emit PlaylistLoaded();
-
 }
 
 static bool DescendingIntLessThan(int a, int b) { return a > b; }
@@ -1660,6 +1816,7 @@ PlaylistItemList Playlist::RemoveItemsWithoutUndo(const int row, const int count
   for (int i = 0; i < count; ++i) {
     PlaylistItemPtr item(items_.takeAt(row));
     ret << item;
+    RemoveFilterText(item.get());
 
     if (item->source() == Song::Source_Collection) {
       int id = item->Metadata().id();
@@ -2072,6 +2229,70 @@ void Playlist::QueueLayoutChanged() {
 
 }
 
+QString Playlist::FilterText(const int row, const int column) const {
+
+  const PlaylistItemPtr &item = items_[row];
+  return FilterText(item.get(), item->Metadata(), column, filter_text_generation());
+
+}
+
+QString Playlist::FilterText(const PlaylistItem *item, const Song &song, const int column, const quint64 generation) const {
+
+  QMutexLocker l(&filter_text_mutex_);
+
+  QHash<const PlaylistItem*, QVector<QString>>::const_iterator it = filter_text_.constFind(item);
+  if (it != filter_text_.constEnd() && !it.value()[column].isNull()) {
+    return it.value()[column];
+  }
+
+  l.unlock();
+
+  // Use the same text as the view shows, the null string is reserved for columns that are not cached.
+  QString column_text = column_value(song, column).toString().toLower();
+  if (column_text.isNull()) column_text = QLatin1String("");
+
+  l.relock();
+
+  // The song is older than the cache if an item was changed or removed since the snapshot.
+  if (generation == filter_text_generation_) {
+    QVector<QString> &text = filter_text_[item];
+    if (text.isEmpty()) text.resize(ColumnCount);
+    text[column] = column_text;
+  }
+
+  return column_text;
+
+}
+
+quint64 Playlist::filter_text_generation() const {
+
+  QMutexLocker l(&filter_text_mutex_);
+  return filter_text_generation_;
+
+}
+
+void Playlist::RemoveFilterText(const PlaylistItem *item) {
+
+  QMutexLocker l(&filter_text_mutex_);
+
+  if (item) {
+    filter_text_.remove(item);
+  }
+  else {
+    filter_text_.clear();
+  }
+  ++filter_text_generation_;
+
+}
+
+void Playlist::InvalidateFilterText(const QModelIndex &top_left, const QModelIndex &bottom_right) {
+
+  for (int row = qMax(0, top_left.row()); row <= bottom_right.row() && row < items_.count(); ++row) {
+    RemoveFilterText(items_[row].get());
+  }
+
+}
+
 void Playlist::ItemChanged(const int row) {
 
   QModelIndex idx = index(row, ColumnCount - 1);
@@ -32,6 +32,9 @@
 #include <QFuture>
 #include <QList>
 #include <QMap>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
 #include <QMultiMap>
 #include <QMetaType>
 #include <QVariant>
@@ -45,6 +48,7 @@
 #include "core/tagreaderclient.h"
 #include "covermanager/albumcoverloaderresult.h"
 #include "playlistitem.h"
+#include "playlistbackend.h"
 #include "playlistsequence.h"
 #include "smartplaylists/playlistgenerator_fwd.h"
 
@@ -53,7 +57,6 @@ class QUndoStack;
 class QTimer;
 
 class CollectionBackend;
-class PlaylistBackend;
 class PlaylistFilter;
 class Queue;
 class TaskManager;
@@ -166,17 +169,26 @@ class Playlist : public QAbstractListModel {
   static const qint64 kMinScrobblePointNsecs;
   static const qint64 kMaxScrobblePointNsecs;
 
-  static bool CompareItems(const int column, const Qt::SortOrder order, PlaylistItemPtr a, PlaylistItemPtr b);
+  // Number of items restored in each page. The first page also covers the last played item.
+  static const int kRestorePageSize;
+
+  // Sorts the items in [begin, end) by column in one stable pass.
+  // The sort keys, QCollator keys for text columns, are computed once for each item before sorting.
+  static void SortItems(PlaylistItemList::iterator begin, PlaylistItemList::iterator end, const int column, const Qt::SortOrder order);
 
   static QString column_name(Column column);
   static QString abbreviated_column_name(Column column);
 
   static bool column_is_editable(Playlist::Column column);
   static bool set_column_value(Song &song, Column column, const QVariant &value);
+  static QVariant column_value(const Song &song, const int column, const int role = Qt::DisplayRole);
 
   // Persistence
+  // Loads the items from the database in pages, the first page is shown before the rest are loaded.
+  // Does nothing if the playlist was already restored.
   void Restore();
   void ScheduleSaveAsync();
+  bool is_restored() const { return restored_; }
 
   // Accessors
   PlaylistFilter *filter() const;
@@ -206,6 +218,14 @@ class Playlist : public QAbstractListModel {
   const PlaylistItemPtr &item_at(const int index) const { return items_[index]; }
   bool has_item_at(const int index) const { return index >= 0 && index < rowCount(); }
 
+  // Returns the lower-cased text of the column as searched by the playlist filter.
+  // The text is cached for each item until the item changes.
+  // The second version is thread-safe, it takes a snapshot of the item's song and the filter_text_generation() it was taken at,
+  // and does not cache text if the cache was invalidated after the snapshot.
+  QString FilterText(const int row, const int column) const;
+  QString FilterText(const PlaylistItem *item, const Song &song, const int column, const quint64 generation) const;
+  quint64 filter_text_generation() const;
+
   PlaylistItemPtr current_item() const;
 
   PlaylistItem::Options current_item_options() const;
@@ -279,8 +299,6 @@ class Playlist : public QAbstractListModel {
   void sort(int column, Qt::SortOrder order) override;
   bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
 
-  static bool ComparePathDepths(Qt::SortOrder, PlaylistItemPtr, PlaylistItemPtr);
-
   void ItemChanged(PlaylistItemPtr item);
   void ItemChanged(const int row);
 
@@ -365,6 +383,12 @@ class Playlist : public QAbstractListModel {
   void TurnOnDynamicPlaylist(PlaylistGeneratorPtr gen);
   void InsertDynamicItems(const int count);
 
+  void RestorePage(const int offset, const int limit);
+  void RestoreDone();
+
+  // Removes the filter text cached for the item, or for all items if item is null.
+  void RemoveFilterText(const PlaylistItem *item = nullptr);
+
  private slots:
   void TracksAboutToBeDequeued(const QModelIndex&, const int begin, const int end);
   void TracksDequeued();
@@ -374,6 +398,7 @@ class Playlist : public QAbstractListModel {
   void ItemReloadComplete(const QPersistentModelIndex &idx, const Song &old_metadata, const bool metadata_edit);
   void ItemsLoaded();
   void SongInsertVetoListenerDestroyed();
+  void InvalidateFilterText(const QModelIndex &top_left, const QModelIndex &bottom_right);
   void ScheduleSave();
   void Save();
 
@@ -400,6 +425,11 @@ class Playlist : public QAbstractListModel {
   // A map of collection ID to playlist item - for fast lookups when collection items change.
   QMultiMap<int, PlaylistItemPtr> collection_items_by_id_;
 
+  // Lower-cased column text for the playlist filter, indexed by column. Columns that are not cached yet are null strings.
+  mutable QHash<const PlaylistItem*, QVector<QString>> filter_text_;
+  mutable QMutex filter_text_mutex_;
+  quint64 filter_text_generation_;
+
   QPersistentModelIndex current_item_index_;
   QPersistentModelIndex last_played_item_index_;
   QPersistentModelIndex stop_after_;
@@ -423,6 +453,16 @@ class Playlist : public QAbstractListModel {
 
   // Cancel async restore if songs are already replaced
   bool cancel_restore_;
+  // Restore() was called, and all pages were loaded or the restore was cancelled.
+  bool restore_started_;
+  bool restored_;
+  // Changes made before the playlist was restored are saved when it is.
+  bool save_after_restore_;
+  PlaylistBackend::Playlist restore_info_;
+  // Number of items loaded from the database, and the last item restored, the next page is inserted after it.
+  int restore_offset_;
+  int restore_limit_;
+  PlaylistItemPtr restore_last_item_;
 
   bool scrobbled_;
   qint64 scrobble_point_;
@@ -27,6 +27,10 @@
 #include <QApplication>
 #include <QThread>
 #include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <QSet>
+#include <QVariant>
 #include <QIODevice>
 #include <QDir>
 #include <QFile>
@@ -45,6 +49,7 @@
 #include "core/sqlquery.h"
 #include "core/sqlrow.h"
 #include "collection/collectionbackend.h"
+#include "collection/collectionplaylistitem.h"
 #include "playlistitem.h"
 #include "songplaylistitem.h"
 #include "playlistbackend.h"
@@ -52,6 +57,7 @@
 #include "smartplaylists/playlistgenerator.h"
 
 const int PlaylistBackend::kSongTableJoins = 2;
+const qint64 PlaylistBackend::kPositionStep = 1024;
 
 PlaylistBackend::PlaylistBackend(Application *app, QObject *parent)
     : QObject(parent),
@@ -63,6 +69,16 @@ PlaylistBackend::PlaylistBackend(Application *app, QObject *parent)
 
 }
 
+PlaylistBackend::PlaylistBackend(Database *db, QObject *parent)
+    : QObject(parent),
+      app_(nullptr),
+      db_(db),
+      original_thread_(nullptr) {
+
+  original_thread_ = thread();
+
+}
+
 void PlaylistBackend::Close() {
 
   if (db_) {
@@ -99,8 +115,8 @@ PlaylistBackend::PlaylistList PlaylistBackend::GetAllFavoritePlaylists() {
 
 PlaylistBackend::PlaylistList PlaylistBackend::GetPlaylists(const GetPlaylistsFlags flags) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   PlaylistList ret;
 
@@ -143,8 +159,8 @@ PlaylistBackend::PlaylistList PlaylistBackend::GetPlaylists(const GetPlaylistsFl
 
 PlaylistBackend::Playlist PlaylistBackend::GetPlaylist(const int id) {
 
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
+  QMutexLocker l(db_->ReadMutex());
+  QSqlDatabase db(db_->ConnectReadOnly());
 
   SqlQuery q(db);
   q.prepare("SELECT ROWID, name, last_played, special_type, ui_path, is_favorite, dynamic_playlist_type, dynamic_playlist_data, dynamic_playlist_backend FROM playlists WHERE ROWID=:id");
@@ -172,36 +188,79 @@ PlaylistBackend::Playlist PlaylistBackend::GetPlaylist(const int id) {
 
 }
 
-PlaylistItemList PlaylistBackend::GetPlaylistItems(const int playlist) {
+PlaylistItemList PlaylistBackend::GetPlaylistItems(const int playlist, const int offset, const int limit) {
 
   PlaylistItemList playlistitems;
 
   {
 
-    QMutexLocker l(db_->Mutex());
-    QSqlDatabase db(db_->Connect());
+    QMutexLocker l(db_->ReadMutex());
+    QSqlDatabase db(db_->ConnectReadOnly());
 
-    QString query = "SELECT songs.ROWID, " + Song::JoinSpec("songs") + ", p.ROWID, " + Song::JoinSpec("p") + ", p.type FROM playlist_items AS p LEFT JOIN songs ON p.collection_id = songs.ROWID WHERE p.playlist = :playlist";
+    QString query = "SELECT songs.ROWID, " + Song::JoinSpec("songs") + ", p.ROWID, " + Song::JoinSpec("p") + ", p.type, p.position FROM playlist_items AS p LEFT JOIN songs ON p.collection_id = songs.ROWID WHERE p.playlist = :playlist ORDER BY p.position, p.ROWID LIMIT :limit OFFSET :offset";
     SqlQuery q(db);
     // Forward iterations only may be faster
     q.setForwardOnly(true);
     q.prepare(query);
     q.BindValue(":playlist", playlist);
+    q.BindValue(":limit", limit);
+    q.BindValue(":offset", offset);
     if (!q.Exec()) {
       db_->ReportErrors(q);
       return PlaylistItemList();
     }
 
+    // Remember which row each item was loaded from, so the next save only writes the changes.
+    SavedPlaylistItems saved_items;
+    const int type_column = static_cast<int>(Song::kColumns.count() + 1) * kSongTableJoins;
+    const int position_column = type_column + 1;
+
     // it's probable that we'll have a few songs associated with the same CUE, so we're caching results of parsing CUEs
     std::shared_ptr<NewSongFromQueryState> state_ptr = std::make_shared<NewSongFromQueryState>();
+    const SqlRow::ColumnsPtr columns = SqlRow::ColumnsFromQuery(q);
     while (q.next()) {
-      playlistitems << NewPlaylistItemFromQuery(SqlRow(q), state_ptr);
+      const SqlRow row(q, columns);
+      PlaylistItemPtr item;
+      // Songs still in the collection are joined from the songs table.
+      if (static_cast<Song::Source>(row.value(type_column).toInt()) == Song::Source_Collection && !row.value(0).isNull()) {
+        item = NewCollectionPlaylistItemFromQuery(row);
+      }
+      else {
+        item = NewPlaylistItemFromQuery(row, state_ptr);
+      }
+      playlistitems << item;
+
+      SavedPlaylistItem saved_item;
+      saved_item.item = item;
+      saved_item.rowid = row.value(PlaylistItemsColumn()).toLongLong();
+      saved_item.position = row.value(position_column).toLongLong();
+      saved_item.collection_id = item->DatabaseValue(PlaylistItem::Column_CollectionId);
+      // Songs with a CUE can be reloaded when restored, so they are written again on the next save.
+      if (!item->Metadata().has_cue()) saved_item.song = item->DatabaseSongMetadata();
+      saved_items.insert(item.get(), saved_item);
+    }
+
+    // The saved items are only complete when the last page is loaded, until then the next save rewrites the playlist.
+    QMutexLocker saved_playlists_locker(&saved_playlists_mutex_);
+    if (offset == 0) {
+      saved_playlists_.remove(playlist);
+      loading_playlists_[playlist] = saved_items;
+    }
+    else if (loading_playlists_.contains(playlist)) {
+      SavedPlaylistItems &loading_items = loading_playlists_[playlist];
+      for (SavedPlaylistItems::const_iterator it = saved_items.constBegin(); it != saved_items.constEnd(); ++it) {
+        loading_items.insert(it.key(), it.value());
+      }
+    }
+    if ((limit < 0 || playlistitems.count() < limit) && loading_playlists_.contains(playlist)) {
+      saved_playlists_[playlist] = loading_playlists_.take(playlist);
     }
 
   }
 
   if (QThread::currentThread() != thread() && QThread::currentThread() != qApp->thread()) {
-    Close();
+    // Only this thread's own connections are closed, so there is no need to wait for the writer mutex.
+    db_->Close();
   }
 
   return playlistitems;
@@ -213,10 +272,10 @@ SongList PlaylistBackend::GetPlaylistSongs(const int playlist) {
   SongList songs;
 
   {
-    QMutexLocker l(db_->Mutex());
-    QSqlDatabase db(db_->Connect());
+    QMutexLocker l(db_->ReadMutex());
+    QSqlDatabase db(db_->ConnectReadOnly());
 
-    QString query = "SELECT songs.ROWID, " + Song::JoinSpec("songs") + ", p.ROWID, " + Song::JoinSpec("p") + ", p.type FROM playlist_items AS p LEFT JOIN songs ON p.collection_id = songs.ROWID WHERE p.playlist = :playlist";
+    QString query = "SELECT songs.ROWID, " + Song::JoinSpec("songs") + ", p.ROWID, " + Song::JoinSpec("p") + ", p.type FROM playlist_items AS p LEFT JOIN songs ON p.collection_id = songs.ROWID WHERE p.playlist = :playlist ORDER BY p.position, p.ROWID";
     SqlQuery q(db);
     // Forward iterations only may be faster
     q.setForwardOnly(true);
@@ -229,20 +288,26 @@ SongList PlaylistBackend::GetPlaylistSongs(const int playlist) {
 
     // it's probable that we'll have a few songs associated with the same CUE, so we're caching results of parsing CUEs
     std::shared_ptr<NewSongFromQueryState> state_ptr = std::make_shared<NewSongFromQueryState>();
+    const SqlRow::ColumnsPtr columns = SqlRow::ColumnsFromQuery(q);
     while (q.next()) {
-      songs << NewSongFromQuery(SqlRow(q), state_ptr);
+      songs << NewSongFromQuery(SqlRow(q, columns), state_ptr);
     }
 
   }
 
   if (QThread::currentThread() != thread() && QThread::currentThread() != qApp->thread()) {
-    Close();
+    // Only this thread's own connections are closed, so there is no need to wait for the writer mutex.
+    db_->Close();
   }
 
   return songs;
 
 }
 
+int PlaylistBackend::PlaylistItemsColumn() {
+  return static_cast<int>(Song::kColumns.count() + 1) * (kSongTableJoins - 1);
+}
+
 PlaylistItemPtr PlaylistBackend::NewPlaylistItemFromQuery(const SqlRow &row, std::shared_ptr<NewSongFromQueryState> state) {
 
   // The song tables get joined first, plus one each for the song ROWIDs
@@ -259,6 +324,62 @@ PlaylistItemPtr PlaylistBackend::NewPlaylistItemFromQuery(const SqlRow &row, std
 
 }
 
+PlaylistItemPtr PlaylistBackend::NewCollectionPlaylistItemFromQuery(const SqlRow &row) {
+
+  const int collection_id = row.value(0).toInt();
+
+  // Share the song with the collection's song cache when it is loaded.
+  if (app_ && app_->collection_backend()) {
+    Song song;
+    if (app_->collection_backend()->song_cache()->GetSongById(collection_id, &song) && song.is_valid()) {
+      return std::make_shared<CollectionPlaylistItem>(song);
+    }
+  }
+
+  {
+    QMutexLocker l(&collection_songs_mutex_);
+    if (collection_songs_.contains(collection_id)) {
+      return std::make_shared<CollectionPlaylistItem>(collection_songs_.value(collection_id));
+    }
+  }
+
+  PlaylistItemPtr item = std::make_shared<CollectionPlaylistItem>();
+  item->InitFromQuery(row);
+
+  QMutexLocker l(&collection_songs_mutex_);
+  collection_songs_.insert(collection_id, item->Metadata());
+
+  return item;
+
+}
+
+void PlaylistBackend::CollectionSongsChanged(const SongList &songs) {
+
+  QMutexLocker l(&collection_songs_mutex_);
+  for (const Song &song : songs) {
+    if (collection_songs_.contains(song.id())) {
+      collection_songs_[song.id()] = song;
+    }
+  }
+
+}
+
+void PlaylistBackend::CollectionSongsDeleted(const SongList &songs) {
+
+  QMutexLocker l(&collection_songs_mutex_);
+  for (const Song &song : songs) {
+    collection_songs_.remove(song.id());
+  }
+
+}
+
+void PlaylistBackend::CollectionReset() {
+
+  QMutexLocker l(&collection_songs_mutex_);
+  collection_songs_.clear();
+
+}
+
 Song PlaylistBackend::NewSongFromQuery(const SqlRow &row, std::shared_ptr<NewSongFromQueryState> state) {
 
   return NewPlaylistItemFromQuery(row, state)->Metadata();
@@ -272,7 +393,7 @@ PlaylistItemPtr PlaylistBackend::RestoreCueData(PlaylistItemPtr item, std::share
   // We need collection to run a CueParser; also, this method applies only to file-type PlaylistItems
   if (item->source() != Song::Source_LocalFile) return item;
 
-  CueParser cue_parser(app_->collection_backend());
+  CueParser cue_parser(app_ ? app_->collection_backend() : nullptr);
 
   Song song = item->Metadata();
   // We're only interested in .cue songs here
@@ -329,30 +450,23 @@ void PlaylistBackend::SavePlaylist(int playlist, const PlaylistItemList &items,
 
   qLog(Debug) << "Saving playlist" << playlist;
 
-  ScopedTransaction transaction(&db);
-
-  // Clear the existing items in the playlist
+  // The saved items are put back when the transaction is committed, if it fails the next save replaces all items.
+  bool have_saved_items = false;
+  SavedPlaylistItems saved_items;
   {
-    SqlQuery q(db);
-    q.prepare("DELETE FROM playlist_items WHERE playlist = :playlist");
-    q.BindValue(":playlist", playlist);
-    if (!q.Exec()) {
-      db_->ReportErrors(q);
-      return;
-    }
+    QMutexLocker saved_playlists_locker(&saved_playlists_mutex_);
+    have_saved_items = saved_playlists_.contains(playlist);
+    saved_items = saved_playlists_.take(playlist);
   }
 
-  // Save the new ones
-  for (PlaylistItemPtr item : items) {  // clazy:exclude=range-loop-reference
-    SqlQuery q(db);
-    q.prepare("INSERT INTO playlist_items (playlist, type, collection_id, " + Song::kColumnSpec + ") VALUES (:playlist, :type, :collection_id, " + Song::kBindSpec + ")");
-    q.BindValue(":playlist", playlist);
-    item->BindToQuery(&q);
+  ScopedTransaction transaction(&db);
 
-    if (!q.Exec()) {
-      db_->ReportErrors(q);
-      return;
-    }
+  SavedPlaylistItems new_saved_items;
+  if (have_saved_items) {
+    if (!SavePlaylistChanges(db, playlist, items, saved_items, &new_saved_items)) return;
+  }
+  else {
+    if (!SaveAllPlaylistItems(db, playlist, items, &new_saved_items)) return;
   }
 
   // Update the last played track number
@@ -379,6 +493,227 @@ void PlaylistBackend::SavePlaylist(int playlist, const PlaylistItemList &items,
 
   transaction.Commit();
 
+  // An item that is in the playlist twice can't be told apart, so the playlist is saved in full until it's gone.
+  if (new_saved_items.count() == items.count()) {
+    QMutexLocker saved_playlists_locker(&saved_playlists_mutex_);
+    saved_playlists_[playlist] = new_saved_items;
+  }
+
+}
+
+bool PlaylistBackend::SavePlaylistChanges(QSqlDatabase &db, const int playlist, const PlaylistItemList &items, const SavedPlaylistItems &saved_items, SavedPlaylistItems *new_saved_items) {
+
+  const int count = static_cast<int>(items.count());
+
+  // Find the items that are still in the playlist, an item that is in the playlist twice is inserted again.
+  QVector<bool> kept(count, false);
+  QVector<qint64> saved_positions(count, 0);
+  QSet<const PlaylistItem*> kept_items;
+  for (int i = 0; i < count; ++i) {
+    const PlaylistItem *item = items[i].get();
+    SavedPlaylistItems::const_iterator it = saved_items.constFind(item);
+    if (it != saved_items.constEnd() && !kept_items.contains(item)) {
+      kept[i] = true;
+      saved_positions[i] = it.value().position;
+      kept_items << item;
+    }
+  }
+
+  // The longest run of kept items that are still in the same order keep their positions, the other kept items were moved.
+  QVector<bool> anchored(count, false);
+  {
+    QVector<int> tails;
+    QVector<int> previous(count, -1);
+    for (int i = 0; i < count; ++i) {
+      if (!kept[i]) continue;
+      const qint64 position = saved_positions[i];
+      int low = 0;
+      int high = static_cast<int>(tails.count());
+      while (low < high) {
+        const int middle = (low + high) / 2;
+        if (saved_positions[tails[middle]] < position) low = middle + 1;
+        else high = middle;
+      }
+      if (low > 0) previous[i] = tails[low - 1];
+      if (low == static_cast<int>(tails.count())) tails << i;
+      else tails[low] = i;
+    }
+    for (int i = tails.isEmpty() ? -1 : tails.last(); i != -1; i = previous[i]) {
+      anchored[i] = true;
+    }
+  }
+
+  // Give the moved and inserted items positions between their anchored neighbours.
+  QVector<qint64> positions(count, 0);
+  bool renumber = false;
+  bool have_previous = false;
+  qint64 previous_position = 0;
+  for (int i = 0; i < count && !renumber;) {
+    if (anchored[i]) {
+      previous_position = saved_positions[i];
+      positions[i] = previous_position;
+      have_previous = true;
+      ++i;
+      continue;
+    }
+    int next = i;
+    while (next < count && !anchored[next]) ++next;
+    const int run = next - i;
+    if (next == count) {
+      for (int j = 0; j < run; ++j) {
+        positions[i + j] = previous_position + (j + 1) * kPositionStep;
+      }
+    }
+    else {
+      const qint64 next_position = saved_positions[next];
+      if (!have_previous) {
+        for (int j = 0; j < run; ++j) {
+          positions[i + j] = next_position - (run - j) * kPositionStep;
+        }
+      }
+      else if (next_position - previous_position > run) {
+        for (int j = 0; j < run; ++j) {
+          positions[i + j] = previous_position + (next_position - previous_position) * (j + 1) / (run + 1);
+        }
+      }
+      else {
+        renumber = true;
+      }
+    }
+    i = next;
+  }
+  if (renumber) {
+    for (int i = 0; i < count; ++i) {
+      positions[i] = (i + 1) * kPositionStep;
+    }
+  }
+
+  int removed = 0;
+  int inserted = 0;
+  int updated = 0;
+
+  // Remove the items that are not in the playlist anymore.
+  {
+    SqlQuery q(db);
+    q.prepare("DELETE FROM playlist_items WHERE ROWID = :rowid");
+    for (SavedPlaylistItems::const_iterator it = saved_items.constBegin(); it != saved_items.constEnd(); ++it) {
+      if (kept_items.contains(it.key())) continue;
+      q.BindValue(":rowid", it.value().rowid);
+      if (!q.Exec()) {
+        db_->ReportErrors(q);
+        return false;
+      }
+      ++removed;
+    }
+  }
+
+  SqlQuery q_insert_collection(db);
+  q_insert_collection.prepare("INSERT INTO playlist_items (playlist, type, collection_id, url, position) VALUES (:playlist, :type, :collection_id, '', :position)");
+  SqlQuery q_insert(db);
+  q_insert.prepare("INSERT INTO playlist_items (playlist, type, collection_id, position, " + Song::kColumnSpec + ") VALUES (:playlist, :type, :collection_id, :position, " + Song::kBindSpec + ")");
+  SqlQuery q_update(db);
+  q_update.prepare("UPDATE playlist_items SET collection_id = :collection_id, position = :position, " + Song::kUpdateSpec + " WHERE ROWID = :rowid");
+  SqlQuery q_update_position(db);
+  q_update_position.prepare("UPDATE playlist_items SET position = :position WHERE ROWID = :rowid");
+
+  for (int i = 0; i < count; ++i) {
+    PlaylistItemPtr item = items[i];
+    if (!kept[i]) {
+      if (!InsertPlaylistItem(&q_insert_collection, &q_insert, playlist, item, positions[i], new_saved_items)) return false;
+      ++inserted;
+      continue;
+    }
+
+    SavedPlaylistItem saved_item = saved_items.value(item.get());
+    const QVariant collection_id = item->DatabaseValue(PlaylistItem::Column_CollectionId);
+    const Song song = item->DatabaseSongMetadata();
+    if (collection_id != saved_item.collection_id || song != saved_item.song || !song.IsMetadataAndMoreEqual(saved_item.song)) {
+      q_update.BindValue(":collection_id", collection_id);
+      q_update.BindValue(":position", positions[i]);
+      song.BindToQuery(&q_update);
+      q_update.BindValue(":rowid", saved_item.rowid);
+      if (!q_update.Exec()) {
+        db_->ReportErrors(q_update);
+        return false;
+      }
+      saved_item.collection_id = collection_id;
+      saved_item.song = song;
+      ++updated;
+    }
+    else if (positions[i] != saved_item.position) {
+      q_update_position.BindValue(":position", positions[i]);
+      q_update_position.BindValue(":rowid", saved_item.rowid);
+      if (!q_update_position.Exec()) {
+        db_->ReportErrors(q_update_position);
+        return false;
+      }
+      ++updated;
+    }
+    saved_item.position = positions[i];
+    new_saved_items->insert(item.get(), saved_item);
+  }
+
+  qLog(Debug) << "Saved playlist" << playlist << "with" << inserted << "inserted," << removed << "removed and" << updated << "updated items";
+
+  return true;
+
+}
+
+bool PlaylistBackend::SaveAllPlaylistItems(QSqlDatabase &db, const int playlist, const PlaylistItemList &items, SavedPlaylistItems *new_saved_items) {
+
+  // Clear the existing items in the playlist
+  {
+    SqlQuery q(db);
+    q.prepare("DELETE FROM playlist_items WHERE playlist = :playlist");
+    q.BindValue(":playlist", playlist);
+    if (!q.Exec()) {
+      db_->ReportErrors(q);
+      return false;
+    }
+  }
+
+  // Save the new ones
+  SqlQuery q_insert_collection(db);
+  q_insert_collection.prepare("INSERT INTO playlist_items (playlist, type, collection_id, url, position) VALUES (:playlist, :type, :collection_id, '', :position)");
+  SqlQuery q_insert(db);
+  q_insert.prepare("INSERT INTO playlist_items (playlist, type, collection_id, position, " + Song::kColumnSpec + ") VALUES (:playlist, :type, :collection_id, :position, " + Song::kBindSpec + ")");
+  for (int i = 0; i < items.count(); ++i) {
+    if (!InsertPlaylistItem(&q_insert_collection, &q_insert, playlist, items[i], (i + 1) * kPositionStep, new_saved_items)) return false;
+  }
+
+  return true;
+
+}
+
+bool PlaylistBackend::InsertPlaylistItem(SqlQuery *q_collection, SqlQuery *q, const int playlist, PlaylistItemPtr item, const qint64 position, SavedPlaylistItems *new_saved_items) {
+
+  SavedPlaylistItem saved_item;
+  saved_item.item = item;
+  saved_item.position = position;
+  saved_item.collection_id = item->DatabaseValue(PlaylistItem::Column_CollectionId);
+
+  // Collection items are restored from the songs table, so only the collection ID is stored for them.
+  SqlQuery *query = item->source() == Song::Source_Collection ? q_collection : q;
+  query->BindValue(":playlist", playlist);
+  query->BindValue(":position", position);
+  if (query == q_collection) {
+    query->BindValue(":type", item->source());
+    query->BindValue(":collection_id", saved_item.collection_id);
+  }
+  else {
+    item->BindToQuery(query);
+    saved_item.song = item->DatabaseSongMetadata();
+  }
+  if (!query->Exec()) {
+    db_->ReportErrors(*query);
+    return false;
+  }
+
+  saved_item.rowid = query->lastInsertId().toLongLong();
+  new_saved_items->insert(item.get(), saved_item);
+
+  return true;
+
 }
 
 int PlaylistBackend::CreatePlaylist(const QString &name, const QString &special_type) {
@@ -428,6 +763,10 @@ void PlaylistBackend::RemovePlaylist(int id) {
 
   transaction.Commit();
 
+  QMutexLocker saved_playlists_locker(&saved_playlists_mutex_);
+  saved_playlists_.remove(id);
+  loading_playlists_.remove(id);
+
 }
 
 void PlaylistBackend::RenamePlaylist(const int id, const QString &new_name) {
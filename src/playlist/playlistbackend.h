@@ -31,6 +31,7 @@
 #include <QHash>
 #include <QList>
 #include <QSet>
+#include <QVariant>
 #include <QString>
 #include <QSqlQuery>
 
@@ -49,6 +50,7 @@ class PlaylistBackend : public QObject {
 
  public:
   Q_INVOKABLE explicit PlaylistBackend(Application *app, QObject *parent = nullptr);
+  explicit PlaylistBackend(Database *db, QObject *parent = nullptr);
 
   struct Playlist {
     Playlist() : id(-1), favorite(false), last_played(0) {}
@@ -66,6 +68,12 @@ class PlaylistBackend : public QObject {
   using PlaylistList = QList<Playlist>;
 
   static const int kSongTableJoins;
+  // Distance between the positions of consecutive items when a playlist is saved in full,
+  // so items can be inserted or moved between them later without renumbering the playlist.
+  static const qint64 kPositionStep;
+
+  // First column of the playlist_items table in rows from GetPlaylistItems, after the joined songs table.
+  static int PlaylistItemsColumn();
 
   void Close();
   void ExitAsync();
@@ -75,7 +83,9 @@ class PlaylistBackend : public QObject {
   PlaylistList GetAllFavoritePlaylists();
   PlaylistBackend::Playlist GetPlaylist(const int id);
 
-  PlaylistItemList GetPlaylistItems(const int playlist);
+  // Returns limit items of the playlist starting at offset, or all items if limit is negative.
+  // Collection items share the song of the collection song cache.
+  PlaylistItemList GetPlaylistItems(const int playlist, const int offset = 0, const int limit = -1);
   SongList GetPlaylistSongs(const int playlist);
 
   void SetPlaylistOrder(const QList<int> &ids);
@@ -91,6 +101,9 @@ class PlaylistBackend : public QObject {
 
  public slots:
   void Exit();
+  void CollectionSongsChanged(const SongList &songs);
+  void CollectionSongsDeleted(const SongList &songs);
+  void CollectionReset();
   void SavePlaylist(const int playlist, const PlaylistItemList &items, const int last_played, PlaylistGeneratorPtr dynamic);
 
  signals:
@@ -104,6 +117,7 @@ class PlaylistBackend : public QObject {
 
   Song NewSongFromQuery(const SqlRow &row, std::shared_ptr<NewSongFromQueryState> state);
   PlaylistItemPtr NewPlaylistItemFromQuery(const SqlRow &row, std::shared_ptr<NewSongFromQueryState> state);
+  PlaylistItemPtr NewCollectionPlaylistItemFromQuery(const SqlRow &row);
   PlaylistItemPtr RestoreCueData(PlaylistItemPtr item, std::shared_ptr<NewSongFromQueryState> state);
 
   enum GetPlaylistsFlags {
@@ -113,9 +127,37 @@ class PlaylistBackend : public QObject {
   };
   PlaylistList GetPlaylists(const GetPlaylistsFlags flags);
 
+  // An item as it was last saved to, or loaded from the playlist_items table.
+  struct SavedPlaylistItem {
+    SavedPlaylistItem() : rowid(-1), position(0) {}
+    PlaylistItemPtr item;
+    qint64 rowid;
+    qint64 position;
+    QVariant collection_id;
+    Song song;
+  };
+  using SavedPlaylistItems = QHash<const PlaylistItem*, SavedPlaylistItem>;
+
+  // Writes only the items that were inserted, removed, moved or changed since the playlist was last saved or loaded.
+  bool SavePlaylistChanges(QSqlDatabase &db, const int playlist, const PlaylistItemList &items, const SavedPlaylistItems &saved_items, SavedPlaylistItems *new_saved_items);
+  // Replaces all items of the playlist, used when the saved items are not known.
+  bool SaveAllPlaylistItems(QSqlDatabase &db, const int playlist, const PlaylistItemList &items, SavedPlaylistItems *new_saved_items);
+  bool InsertPlaylistItem(SqlQuery *q_collection, SqlQuery *q, const int playlist, PlaylistItemPtr item, const qint64 position, SavedPlaylistItems *new_saved_items);
+
   Application *app_;
   Database *db_;
   QThread *original_thread_;
+
+  // The items of each loaded playlist as they are in the database, by playlist id.
+  // Playlists restored in pages are kept in loading_playlists_ until the last page is loaded.
+  QMutex saved_playlists_mutex_;
+  QHash<int, SavedPlaylistItems> saved_playlists_;
+  QHash<int, SavedPlaylistItems> loading_playlists_;
+
+  // Songs of collection items in restored playlists by collection id, so items of the same song share one copy.
+  // Only used until the collection's song cache is loaded.
+  QMutex collection_songs_mutex_;
+  QHash<int, Song> collection_songs_;
 };
 
 #endif  // PLAYLISTBACKEND_H
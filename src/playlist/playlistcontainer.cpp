@@ -179,6 +179,7 @@ void PlaylistContainer::SetViewModel(Playlist *playlist, const int scroll_positi
     QObject::disconnect(playlist_->filter(), &QSortFilterProxyModel::modelReset, this, &PlaylistContainer::UpdateNoMatchesLabel);
     QObject::disconnect(playlist_->filter(), &QSortFilterProxyModel::rowsInserted, this, &PlaylistContainer::UpdateNoMatchesLabel);
     QObject::disconnect(playlist_->filter(), &QSortFilterProxyModel::rowsRemoved, this, &PlaylistContainer::UpdateNoMatchesLabel);
+    QObject::disconnect(playlist_->filter(), &PlaylistFilter::FilterApplied, this, &PlaylistContainer::FilterApplied);
   }
   if (playlist_) {
     QObject::disconnect(playlist_, &Playlist::modelReset, this, &PlaylistContainer::UpdateNoMatchesLabel);
@@ -206,6 +207,7 @@ void PlaylistContainer::SetViewModel(Playlist *playlist, const int scroll_positi
   QObject::connect(playlist_->filter(), &QSortFilterProxyModel::modelReset, this, &PlaylistContainer::UpdateNoMatchesLabel);
   QObject::connect(playlist_->filter(), &QSortFilterProxyModel::rowsInserted, this, &PlaylistContainer::UpdateNoMatchesLabel);
   QObject::connect(playlist_->filter(), &QSortFilterProxyModel::rowsRemoved, this, &PlaylistContainer::UpdateNoMatchesLabel);
+  QObject::connect(playlist_->filter(), &PlaylistFilter::FilterApplied, this, &PlaylistContainer::FilterApplied);
   QObject::connect(playlist_, &Playlist::modelReset, this, &PlaylistContainer::UpdateNoMatchesLabel);
   QObject::connect(playlist_, &Playlist::rowsInserted, this, &PlaylistContainer::UpdateNoMatchesLabel);
   QObject::connect(playlist_, &Playlist::rowsRemoved, this, &PlaylistContainer::UpdateNoMatchesLabel);
@@ -418,7 +420,13 @@ void PlaylistContainer::UpdateFilter() {
 
   if (!ui_->toolbar->isVisible()) return;
 
+  // Large playlists are filtered in the background, FilterApplied() is called when the view is updated.
   manager_->current()->filter()->SetFilterText(ui_->search_field->text());
+
+}
+
+void PlaylistContainer::FilterApplied() {
+
   ui_->playlist->JumpToCurrentlyPlayingTrack();
 
   UpdateNoMatchesLabel();
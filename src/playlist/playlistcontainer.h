@@ -99,6 +99,7 @@ class PlaylistContainer : public QWidget {
   void SelectionChanged();
   void MaybeUpdateFilter();
   void UpdateFilter();
+  void FilterApplied();
   void FocusOnFilter(QKeyEvent *event);
 
   void UpdateNoMatchesLabel();
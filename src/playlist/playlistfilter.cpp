@@ -21,19 +21,29 @@
 
 #include "config.h"
 
+#include <memory>
+#include <atomic>
+
 #include <QObject>
+#include <QtConcurrent>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QBitArray>
 #include <QString>
-#include <QAbstractItemModel>
+#include <QStringList>
 #include <QSortFilterProxyModel>
 
 #include "playlist/playlist.h"
 #include "playlistfilter.h"
 #include "playlistfilterparser.h"
 
+const int PlaylistFilter::kAsyncFilterRows = 20000;
+const int PlaylistFilter::kFilterChunkSize = 5000;
+
 PlaylistFilter::PlaylistFilter(QObject *parent)
     : QSortFilterProxyModel(parent),
       filter_tree_(new NopFilter),
-      query_hash_(0) {
+      restart_filter_(false) {
 
   setDynamicSortFilter(true);
 
@@ -68,36 +78,232 @@ PlaylistFilter::PlaylistFilter(QObject *parent)
 
 }
 
-PlaylistFilter::~PlaylistFilter() = default;
+PlaylistFilter::~PlaylistFilter() {
+  CancelFiltering();
+}
 
 void PlaylistFilter::sort(int column, Qt::SortOrder order) {
   // Pass this through to the Playlist, it does sorting itself
   sourceModel()->sort(column, order);
 }
 
-bool PlaylistFilter::filterAcceptsRow(int row, const QModelIndex &parent) const {
+void PlaylistFilter::setSourceModel(QAbstractItemModel *source_model) {
+
+  if (sourceModel()) {
+    QObject::disconnect(sourceModel(), nullptr, this, nullptr);
+  }
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-  size_t hash = qHash(filter_text_);
-#else
-  uint hash = qHash(filter_text_);
-#endif
-  if (hash != query_hash_) {
-    // Parse the query
-    FilterParser p(filter_text_, column_names_, numerical_columns_);
-    filter_tree_.reset(p.parse());
-
-    query_hash_ = hash;
+  // Connect before QSortFilterProxyModel, so the matches are updated before the proxy tests the rows.
+  if (source_model) {
+    QObject::connect(source_model, &QAbstractItemModel::rowsAboutToBeInserted, this, &PlaylistFilter::SourceRowsAboutToChange);
+    QObject::connect(source_model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &PlaylistFilter::SourceRowsAboutToChange);
+    QObject::connect(source_model, &QAbstractItemModel::rowsAboutToBeMoved, this, &PlaylistFilter::SourceRowsAboutToChange);
+    QObject::connect(source_model, &QAbstractItemModel::layoutAboutToBeChanged, this, &PlaylistFilter::SourceRowsAboutToChange);
+    QObject::connect(source_model, &QAbstractItemModel::modelAboutToBeReset, this, &PlaylistFilter::SourceRowsAboutToChange);
+    QObject::connect(source_model, &QAbstractItemModel::rowsInserted, this, &PlaylistFilter::SourceRowsChanged);
+    QObject::connect(source_model, &QAbstractItemModel::rowsRemoved, this, &PlaylistFilter::SourceRowsChanged);
+    QObject::connect(source_model, &QAbstractItemModel::rowsMoved, this, &PlaylistFilter::SourceRowsChanged);
+    QObject::connect(source_model, &QAbstractItemModel::layoutChanged, this, &PlaylistFilter::SourceRowsChanged);
+    QObject::connect(source_model, &QAbstractItemModel::modelReset, this, &PlaylistFilter::SourceRowsChanged);
+    QObject::connect(source_model, &QAbstractItemModel::dataChanged, this, &PlaylistFilter::SourceDataChanged);
   }
 
+  QSortFilterProxyModel::setSourceModel(source_model);
+
+}
+
+PlaylistFilterRow PlaylistFilter::FilterRow(const int row) const {
+
+  const Playlist *playlist = static_cast<const Playlist*>(sourceModel());
+  return PlaylistFilterRow(playlist, row, playlist->item_at(row), playlist->filter_text_generation());
+
+}
+
+bool PlaylistFilter::filterAcceptsRow(int row, const QModelIndex &parent) const {
+
+  Q_UNUSED(parent);
+
+  if (filter_tree_->type() == FilterTree::Nop) return true;
+
+  if (row < matches_.size()) return matches_.testBit(row);
+
   // Test the row
-  return filter_tree_->accept(row, parent, sourceModel());
+  const Playlist *playlist = static_cast<const Playlist*>(sourceModel());
+  if (!playlist || !playlist->has_item_at(row)) return false;
+
+  return filter_tree_->accept(FilterRow(row));
 
 }
 
 void PlaylistFilter::SetFilterText(const QString &filter_text) {
 
   filter_text_ = filter_text;
-  setFilterFixedString(filter_text);
+
+  CancelFiltering();
+  restart_filter_ = false;
+
+  // Parse the query
+  FilterParser p(filter_text, column_names_, numerical_columns_);
+  FilterTreePtr filter_tree(p.parse());
+
+  const Playlist *playlist = static_cast<const Playlist*>(sourceModel());
+  if (!playlist || filter_tree->type() == FilterTree::Nop) {
+    ApplyFilter(filter_text, filter_tree, QBitArray());
+    return;
+  }
+
+  // If the new text narrows the filter, only the rows that matched the old text need to be tested.
+  const int row_count = playlist->rowCount();
+  const bool narrows = matches_.size() == row_count && FilterTextNarrows(matches_filter_text_, filter_text);
+
+  // Take a snapshot of the songs, so the rows can be tested on a worker thread.
+  const quint64 generation = playlist->filter_text_generation();
+  PlaylistFilterRowList rows;
+  rows.reserve(narrows ? matches_.count(true) : row_count);
+  for (int row = 0; row < row_count; ++row) {
+    if (narrows && !matches_.testBit(row)) continue;
+    rows << PlaylistFilterRow(playlist, row, playlist->item_at(row), generation);
+  }
+  changed_rows_.clear();
+
+  if (rows.count() <= kAsyncFilterRows) {
+    ApplyFilter(filter_text, filter_tree, FilterRows(filter_tree, rows, row_count, CancelFlag()));
+    return;
+  }
+
+  pending_filter_text_ = filter_text;
+  pending_filter_tree_ = filter_tree;
+  CancelFlag cancel = std::make_shared<std::atomic<bool>>(false);
+  cancel_filter_ = cancel;
+
+  filter_future_ = QtConcurrent::run(&PlaylistFilter::FilterRows, filter_tree, rows, row_count, cancel);
+  QFutureWatcher<QBitArray> *watcher = new QFutureWatcher<QBitArray>(this);
+  QObject::connect(watcher, &QFutureWatcher<QBitArray>::finished, this, [this, watcher, cancel]() {
+    const QBitArray matches = watcher->result();
+    watcher->deleteLater();
+    if (*cancel) return;
+    const QString filter_text = pending_filter_text_;
+    FilterTreePtr filter_tree = pending_filter_tree_;
+    pending_filter_text_.clear();
+    pending_filter_tree_.reset();
+    cancel_filter_.reset();
+    ApplyFilter(filter_text, filter_tree, matches);
+  });
+  watcher->setFuture(filter_future_);
+
+}
+
+QBitArray PlaylistFilter::FilterRows(FilterTreePtr filter_tree, const PlaylistFilterRowList &rows, const int row_count, CancelFlag cancel) {
+
+  QBitArray matches(row_count);
+  for (int i = 0; i < rows.count(); ++i) {
+    if (cancel && i % kFilterChunkSize == 0 && *cancel) return QBitArray();
+    const PlaylistFilterRow &row = rows[i];
+    if (filter_tree->accept(row)) matches.setBit(row.row);
+  }
+
+  return matches;
+
+}
+
+bool PlaylistFilter::FilterTextNarrows(const QString &old_text, const QString &new_text) {
+
+  if (old_text.trimmed().isEmpty() || !new_text.startsWith(old_text)) return false;
+
+  // Column names, comparisons, negations, groups and quotes can change the meaning of the text before them.
+  for (const QChar &c : new_text) {
+    if (c == ':' || c == '-' || c == '(' || c == ')' || c == '"' || c == '<' || c == '>' || c == '=' || c == '!') return false;
+  }
+
+  // The words of the old text can become operators, "OR" makes the filter wider.
+  const QStringList words = new_text.simplified().split(' ');
+  return !words.contains("OR") && !words.contains("AND");
+
+}
+
+void PlaylistFilter::CancelFiltering() {
+
+  if (cancel_filter_) {
+    *cancel_filter_ = true;
+    cancel_filter_.reset();
+  }
+
+  // The worker checks for cancellation between chunks, and uses the playlist's filter text cache.
+  if (filter_future_.isRunning()) {
+    filter_future_.waitForFinished();
+  }
+
+  pending_filter_text_.clear();
+  pending_filter_tree_.reset();
+
+}
+
+void PlaylistFilter::ApplyFilter(const QString &filter_text, FilterTreePtr filter_tree, const QBitArray &matches) {
+
+  filter_tree_ = filter_tree;
+  matches_filter_text_ = filter_text;
+  matches_ = matches;
+
+  const Playlist *playlist = static_cast<const Playlist*>(sourceModel());
+  if (playlist && filter_tree_->type() != FilterTree::Nop) {
+    for (const int row : changed_rows_) {
+      if (row < matches_.size() && playlist->has_item_at(row)) {
+        matches_.setBit(row, filter_tree_->accept(FilterRow(row)));
+      }
+    }
+  }
+  changed_rows_.clear();
+
+  // The proxy tests all rows again, which only looks up the matches.
+  invalidateFilter();
+
+  emit FilterApplied();
+
+}
+
+void PlaylistFilter::SourceRowsAboutToChange() {
+
+  // The rows of the matches are not valid after this.
+  matches_.clear();
+  changed_rows_.clear();
+
+  if (is_filtering()) {
+    CancelFiltering();
+    restart_filter_ = true;
+  }
+
+}
+
+void PlaylistFilter::SourceRowsChanged() {
+
+  if (restart_filter_) {
+    restart_filter_ = false;
+    SetFilterText(filter_text_);
+  }
+
+}
+
+void PlaylistFilter::SourceDataChanged(const QModelIndex &top_left, const QModelIndex &bottom_right) {
+
+  if (is_filtering()) {
+    for (int row = top_left.row(); row <= bottom_right.row(); ++row) {
+      changed_rows_ << row;
+    }
+  }
+
+  if (matches_.isEmpty() || filter_tree_->type() == FilterTree::Nop) return;
+
+  // Test large changes one row at a time in filterAcceptsRow() instead.
+  if (bottom_right.row() - top_left.row() >= kFilterChunkSize) {
+    matches_.clear();
+    return;
+  }
+
+  const Playlist *playlist = static_cast<const Playlist*>(sourceModel());
+  for (int row = qMax(0, top_left.row()); row <= bottom_right.row() && row < matches_.size(); ++row) {
+    if (playlist->has_item_at(row)) {
+      matches_.setBit(row, filter_tree_->accept(FilterRow(row)));
+    }
+  }
 
 }
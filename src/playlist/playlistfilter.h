@@ -24,15 +24,19 @@
 
 #include "config.h"
 
+#include <memory>
+#include <atomic>
+
 #include <QtGlobal>
 #include <QObject>
 #include <QMap>
 #include <QSet>
-#include <QScopedPointer>
+#include <QBitArray>
+#include <QFuture>
 #include <QString>
 #include <QSortFilterProxyModel>
 
-class FilterTree;
+#include "playlistfilterparser.h"
 
 class PlaylistFilter : public QSortFilterProxyModel {
   Q_OBJECT
@@ -41,29 +45,68 @@ class PlaylistFilter : public QSortFilterProxyModel {
   explicit PlaylistFilter(QObject *parent = nullptr);
   ~PlaylistFilter() override;
 
+  // Playlists with more rows than this to test are filtered on a worker thread.
+  static const int kAsyncFilterRows;
+  // Number of rows the worker tests between checks for cancellation.
+  static const int kFilterChunkSize;
+
   // QAbstractItemModel
   void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
 
   // QSortFilterProxyModel
+  void setSourceModel(QAbstractItemModel *source_model) override;
   // public so Playlist::NextVirtualIndex and friends can get at it
   bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const override;
 
+  // Filters the playlist with the text.
+  // Large playlists are filtered in the background, FilterApplied() is emitted when the rows are updated.
+  // If the text only narrows the previous filter text, only the rows that matched before are tested.
   void SetFilterText(const QString &filter_text);
 
   QString filter_text() const { return filter_text_; }
 
+  // Returns true while the filter text is being evaluated in the background.
+  bool is_filtering() const { return static_cast<bool>(pending_filter_tree_); }
+
+ signals:
+  void FilterApplied();
+
  private:
-  // Mutable because they're modified from filterAcceptsRow() const
-  mutable QScopedPointer<FilterTree> filter_tree_;
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-  mutable size_t query_hash_;
-#else
-  mutable uint query_hash_;
-#endif
+  using FilterTreePtr = std::shared_ptr<FilterTree>;
+  using CancelFlag = std::shared_ptr<std::atomic<bool>>;
+
+  // Returns true if every row matching new_text also matches old_text.
+  static bool FilterTextNarrows(const QString &old_text, const QString &new_text);
+  static QBitArray FilterRows(FilterTreePtr filter_tree, const PlaylistFilterRowList &rows, const int row_count, CancelFlag cancel);
 
+  void CancelFiltering();
+  void ApplyFilter(const QString &filter_text, FilterTreePtr filter_tree, const QBitArray &matches);
+  PlaylistFilterRow FilterRow(const int row) const;
+
+ private slots:
+  void SourceRowsAboutToChange();
+  void SourceRowsChanged();
+  void SourceDataChanged(const QModelIndex &top_left, const QModelIndex &bottom_right);
+
+ private:
   QMap<QString, int> column_names_;
   QSet<int> numerical_columns_;
   QString filter_text_;
+
+  // The filter tree of the rows shown, and the rows of the source model that matched it.
+  // The matches are cleared when rows are inserted, removed or moved, then rows are tested one by one in filterAcceptsRow().
+  FilterTreePtr filter_tree_;
+  QString matches_filter_text_;
+  QBitArray matches_;
+
+  // The filter text being evaluated in the background.
+  QString pending_filter_text_;
+  FilterTreePtr pending_filter_tree_;
+  QFuture<QBitArray> filter_future_;
+  CancelFlag cancel_filter_;
+  // Rows changed while the filter text is evaluated, they are tested again when the result is applied.
+  QSet<int> changed_rows_;
+  bool restart_filter_;
 };
 
 #endif  // PLAYLISTFILTER_H
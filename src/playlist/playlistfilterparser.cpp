@@ -21,7 +21,6 @@
 #include "config.h"
 
 #include <algorithm>
-#include <cmath>
 
 #include <QList>
 #include <QMap>
@@ -30,11 +29,23 @@
 #include <QScopedPointer>
 #include <QString>
 #include <QtAlgorithms>
-#include <QAbstractItemModel>
 
+#include "core/song.h"
+#include "core/timeconstants.h"
 #include "playlist.h"
 #include "playlistfilterparser.h"
 
+PlaylistFilterRow::PlaylistFilterRow(const Playlist *_playlist, const int _row, PlaylistItemPtr _item, const quint64 _generation)
+    : playlist(_playlist),
+      row(_row),
+      item(_item),
+      song(_item->Metadata()),
+      generation(_generation) {}
+
+QString PlaylistFilterRow::text(const int column) const {
+  return playlist->FilterText(item.get(), song, column, generation);
+}
+
 class SearchTermComparator {
  public:
   SearchTermComparator() = default;
@@ -117,86 +128,82 @@ class LexicalLeComparator : public SearchTermComparator {
   QString search_term_;
 };
 
-class GtComparator : public SearchTermComparator {
+class NumericalComparator {
  public:
-  explicit GtComparator(const int value) : search_term_(value) {}
-  bool Matches(const QString &element) const override {
-    return element.toInt() > search_term_;
+  NumericalComparator() = default;
+  virtual ~NumericalComparator() = default;
+  virtual bool Matches(const int element) const = 0;
+ private:
+  Q_DISABLE_COPY(NumericalComparator)
+};
+
+class NumericalEqComparator : public NumericalComparator {
+ public:
+  explicit NumericalEqComparator(const int value) : search_term_(value) {}
+  bool Matches(const int element) const override {
+    return element == search_term_;
   }
  private:
   int search_term_;
 };
 
-class GeComparator : public SearchTermComparator {
+class NumericalNeComparator : public NumericalComparator {
  public:
-  explicit GeComparator(const int value) : search_term_(value) {}
-  bool Matches(const QString &element) const override {
-    return element.toInt() >= search_term_;
+  explicit NumericalNeComparator(const int value) : search_term_(value) {}
+  bool Matches(const int element) const override {
+    return element != search_term_;
   }
  private:
   int search_term_;
 };
 
-class LtComparator : public SearchTermComparator {
+class GtComparator : public NumericalComparator {
  public:
-  explicit LtComparator(const int value) : search_term_(value) {}
-  bool Matches(const QString &element) const override {
-    return element.toInt() < search_term_;
+  explicit GtComparator(const int value) : search_term_(value) {}
+  bool Matches(const int element) const override {
+    return element > search_term_;
   }
  private:
   int search_term_;
 };
 
-class LeComparator : public SearchTermComparator {
+class GeComparator : public NumericalComparator {
  public:
-  explicit LeComparator(const int value) : search_term_(value) {}
-  bool Matches(const QString &element) const override {
-    return element.toInt() <= search_term_;
+  explicit GeComparator(const int value) : search_term_(value) {}
+  bool Matches(const int element) const override {
+    return element >= search_term_;
   }
  private:
   int search_term_;
 };
 
-// The length field of the playlist (entries) contains a song's running time in nanoseconds.
-// However, We don't really care about nanoseconds, just seconds.
-// Thus, with this decorator we drop the last 9 digits, if that many are present.
-class DropTailComparatorDecorator : public SearchTermComparator {
+class LtComparator : public NumericalComparator {
  public:
-  explicit DropTailComparatorDecorator(SearchTermComparator *cmp) : cmp_(cmp) {}
-
-  bool Matches(const QString &element) const override {
-    if (element.length() > 9) {
-      return cmp_->Matches(element.left(element.length() - 9));
-    }
-    else {
-      return cmp_->Matches(element);
-    }
+  explicit LtComparator(const int value) : search_term_(value) {}
+  bool Matches(const int element) const override {
+    return element < search_term_;
   }
  private:
-  QScopedPointer<SearchTermComparator> cmp_;
+  int search_term_;
 };
 
-class RatingComparatorDecorator : public SearchTermComparator {
+class LeComparator : public NumericalComparator {
  public:
-  explicit RatingComparatorDecorator(SearchTermComparator *cmp) : cmp_(cmp) {}
-  bool Matches(const QString &element) const override {
-    return cmp_->Matches(QString::number(lround(element.toDouble() * 10.0)));
+  explicit LeComparator(const int value) : search_term_(value) {}
+  bool Matches(const int element) const override {
+    return element <= search_term_;
   }
  private:
-  QScopedPointer<SearchTermComparator> cmp_;
+  int search_term_;
 };
 
-// filter that applies a SearchTermComparator to all fields of a playlist entry
+// filter that applies a SearchTermComparator to the text of all fields of a playlist entry
 class FilterTerm : public FilterTree {
  public:
   explicit FilterTerm(SearchTermComparator *comparator, const QList<int> &columns) : cmp_(comparator), columns_(columns) {}
 
-  bool accept(int row, const QModelIndex &parent, const QAbstractItemModel *const model) const override {
-    for (int i : columns_) {
-      QModelIndex idx(model->index(row, i, parent));
-      if (cmp_->Matches(idx.data().toString().toLower())) return true;
-    }
-    return false;
+  bool accept(const PlaylistFilterRow &row) const override {
+    return std::any_of(columns_.begin(), columns_.end(), [this, &row](const int column) { return cmp_->Matches(row.text(column)); });
   }
   FilterType type() override { return Term; }
  private:
@@ -204,14 +211,13 @@ class FilterTerm : public FilterTree {
   QList<int> columns_;
 };
 
-// filter that applies a SearchTermComparator to one specific field of a playlist entry
+// filter that applies a SearchTermComparator to the text of one specific field of a playlist entry
 class FilterColumnTerm : public FilterTree {
  public:
   FilterColumnTerm(const int column, SearchTermComparator *comparator) : col(column), cmp_(comparator) {}
 
-  bool accept(int row, const QModelIndex &parent, const QAbstractItemModel *const model) const override {
-    QModelIndex idx(model->index(row, col, parent));
-    return cmp_->Matches(idx.data().toString().toLower());
+  bool accept(const PlaylistFilterRow &row) const override {
+    return cmp_->Matches(row.text(col));
   }
   FilterType type() override { return Column; }
  private:
@@ -219,12 +225,41 @@ class FilterColumnTerm : public FilterTree {
   QScopedPointer<SearchTermComparator> cmp_;
 };
 
+// filter that applies a NumericalComparator to the value of one numerical field of a playlist entry
+class FilterNumericalColumnTerm : public FilterTree {
+ public:
+  FilterNumericalColumnTerm(const int column, NumericalComparator *comparator) : col(column), cmp_(comparator) {}
+
+  bool accept(const PlaylistFilterRow &row) const override {
+    return cmp_->Matches(value(row.song));
+  }
+  FilterType type() override { return Column; }
+ private:
+  int value(const Song &song) const {
+    switch (col) {
+      case Playlist::Column_Year:         return song.year();
+      case Playlist::Column_OriginalYear: return song.effective_originalyear();
+      case Playlist::Column_Track:        return song.track();
+      case Playlist::Column_Disc:         return song.disc();
+      // We don't really care about nanoseconds, just seconds.
+      case Playlist::Column_Length:       return static_cast<int>(song.length_nanosec() / kNsecPerSec);
+      case Playlist::Column_Samplerate:   return song.samplerate();
+      case Playlist::Column_Bitdepth:     return song.bitdepth();
+      case Playlist::Column_Bitrate:      return song.bitrate();
+      default:                            return 0;
+    }
+  }
+
+  int col;
+  QScopedPointer<NumericalComparator> cmp_;
+};
+
 class NotFilter : public FilterTree {
  public:
   explicit NotFilter(const FilterTree *inv) : child_(inv) {}
 
-  bool accept(int row, const QModelIndex &parent, const QAbstractItemModel *const model) const override {
-    return !child_->accept(row, parent, model);
+  bool accept(const PlaylistFilterRow &row) const override {
+    return !child_->accept(row);
   }
   FilterType type() override { return Not; }
  private:
@@ -235,8 +270,8 @@ class OrFilter : public FilterTree {
  public:
   ~OrFilter() override { qDeleteAll(children_); }
   virtual void add(FilterTree *child) { children_.append(child); }
-  bool accept(int row, const QModelIndex &parent, const QAbstractItemModel *const model) const override {
-    return std::any_of(children_.begin(), children_.end(), [row, parent, model](FilterTree *child) { return child->accept(row, parent, model); });
+  bool accept(const PlaylistFilterRow &row) const override {
+    return std::any_of(children_.begin(), children_.end(), [&row](FilterTree *child) { return child->accept(row); });
   }
   FilterType type() override { return Or; }
  private:
@@ -247,8 +282,8 @@ class AndFilter : public FilterTree {
  public:
   ~AndFilter() override { qDeleteAll(children_); }
   virtual void add(FilterTree *child) { children_.append(child); }
-  bool accept(int row, const QModelIndex &parent, const QAbstractItemModel *const model) const override {
-    return !std::any_of(children_.begin(), children_.end(), [row, parent, model](FilterTree *child) { return !child->accept(row, parent, model); });
+  bool accept(const PlaylistFilterRow &row) const override {
+    return !std::any_of(children_.begin(), children_.end(), [&row](FilterTree *child) { return !child->accept(row); });
   }
   FilterType type() override { return And; }
  private:
@@ -451,14 +486,9 @@ FilterTree *FilterParser::createSearchTermTreeNode(const QString &col, const QSt
   if (search.isEmpty() && prefix != "=") {
     return new NopFilter;
   }
-  // here comes a mess :/
-  // well, not that much of a mess, but so many options -_-
-  SearchTermComparator *cmp = nullptr;
-  if (prefix == "!=" || prefix == "<>") {
-    cmp = new NeComparator(search);
-  }
-  else if (!col.isEmpty() && columns_.contains(col) && numerical_columns_.contains(columns_[col])) {
-    // the length column contains the time in seconds (nanoseconds, actually - the "nano" part is handled by the DropTailComparatorDecorator,  though).
+
+  if (!col.isEmpty() && columns_.contains(col) && numerical_columns_.contains(columns_[col])) {
+    // the length column is compared in seconds.
     int search_value = 0;
     if (columns_[col] == Playlist::Column_Length) {
       search_value = parseTime(search);
@@ -467,7 +497,11 @@ FilterTree *FilterParser::createSearchTermTreeNode(const QString &col, const QSt
       search_value = search.toInt();
     }
     // alright, back to deciding which comparator we'll use
-    if (prefix == ">") {
+    NumericalComparator *cmp = nullptr;
+    if (prefix == "!=" || prefix == "<>") {
+      cmp = new NumericalNeComparator(search_value);
+    }
+    else if (prefix == ">") {
       cmp = new GtComparator(search_value);
     }
     else if (prefix == ">=") {
@@ -480,39 +514,41 @@ FilterTree *FilterParser::createSearchTermTreeNode(const QString &col, const QSt
       cmp = new LeComparator(search_value);
     }
     else {
-      // convert back because for time/rating
-      cmp = new EqComparator(QString::number(search_value));
+      cmp = new NumericalEqComparator(search_value);
     }
+    return new FilterNumericalColumnTerm(columns_[col], cmp);
+  }
+
+  SearchTermComparator *cmp = nullptr;
+  if (prefix == "!=" || prefix == "<>") {
+    cmp = new NeComparator(search);
+  }
+  else if (prefix == "=") {
+    cmp = new EqComparator(search);
+  }
+  else if (prefix == ">") {
+    cmp = new LexicalGtComparator(search);
+  }
+  else if (prefix == ">=") {
+    cmp = new LexicalGeComparator(search);
+  }
+  else if (prefix == "<") {
+    cmp = new LexicalLtComparator(search);
+  }
+  else if (prefix == "<=") {
+    cmp = new LexicalLeComparator(search);
   }
   else {
-    if (prefix == "=") {
-      cmp = new EqComparator(search);
-    }
-    else if (prefix == ">") {
-      cmp = new LexicalGtComparator(search);
-    }
-    else if (prefix == ">=") {
-      cmp = new LexicalGeComparator(search);
-    }
-    else if (prefix == "<") {
-      cmp = new LexicalLtComparator(search);
-    }
-    else if (prefix == "<=") {
-      cmp = new LexicalLeComparator(search);
-    }
-    else {
-      cmp = new DefaultComparator(search);
-    }
+    cmp = new DefaultComparator(search);
   }
+
   if (columns_.contains(col)) {
-    if (columns_[col] == Playlist::Column_Length) {
-      cmp = new DropTailComparatorDecorator(cmp);
-    }
     return new FilterColumnTerm(columns_[col], cmp);
   }
   else {
     return new FilterTerm(cmp, columns_.values());
   }
+
 }
 
 // Try and parse the string as '[[h:]m:]s' (ignoring all spaces),
@@ -23,19 +23,43 @@
 
 #include "config.h"
 
+#include <QtGlobal>
+#include <QList>
 #include <QSet>
 #include <QMap>
 #include <QString>
 
-class QAbstractItemModel;
-class QModelIndex;
+#include "core/song.h"
+#include "playlistitem.h"
+
+class Playlist;
+
+// A playlist row as evaluated by the filter tree.
+// The song is a snapshot of the item's metadata taken on the GUI thread, so rows can be evaluated on a worker thread.
+struct PlaylistFilterRow {
+  PlaylistFilterRow() : playlist(nullptr), row(-1), generation(0) {}
+  PlaylistFilterRow(const Playlist *_playlist, const int _row, PlaylistItemPtr _item, const quint64 _generation);
+
+  // Returns the lower-cased text of the column, from the playlist's filter text cache.
+  QString text(const int column) const;
+
+  const Playlist *playlist;
+  int row;
+  PlaylistItemPtr item;
+  Song song;
+  // Generation of the playlist's filter text cache when the snapshot was taken.
+  quint64 generation;
+};
+using PlaylistFilterRowList = QList<PlaylistFilterRow>;
 
 // Structure for filter parse tree
+// The tree is evaluated on the song of a playlist row, numerical columns are compared on the song's fields
+// and text is read from the playlist's cache of lower-cased column text.
 class FilterTree {
  public:
   FilterTree() = default;
   virtual ~FilterTree() {}
-  virtual bool accept(int row, const QModelIndex &parent, const QAbstractItemModel *const model) const = 0;
+  virtual bool accept(const PlaylistFilterRow &row) const = 0;
   enum FilterType {
     Nop = 0,
     Or,
@@ -52,7 +76,7 @@ class FilterTree {
 // Trivial filter that accepts *anything*
 class NopFilter : public FilterTree {
  public:
-  bool accept(int row, const QModelIndex &parent, const QAbstractItemModel *const model) const override { Q_UNUSED(row); Q_UNUSED(parent); Q_UNUSED(model); return true; }
+  bool accept(const PlaylistFilterRow &row) const override { Q_UNUSED(row); return true; }
   FilterType type() override { return Nop; }
 };
 
@@ -70,6 +70,13 @@ class PlaylistItem : public std::enable_shared_from_this<PlaylistItem> {
 
   virtual bool InitFromQuery(const SqlRow &query) = 0;
   void BindToQuery(SqlQuery *query) const;
+
+  // The values stored in the playlist_items table.
+  enum DatabaseColumn { Column_CollectionId };
+  virtual QVariant DatabaseValue(DatabaseColumn) const {
+    return QVariant(QString());
+  }
+  virtual Song DatabaseSongMetadata() const { return Song(); }
   virtual void Reload() {}
   QFuture<void> BackgroundReload();
 
@@ -115,13 +122,6 @@ class PlaylistItem : public std::enable_shared_from_this<PlaylistItem> {
  protected:
   bool should_skip_;
 
-  enum DatabaseColumn { Column_CollectionId };
-
-  virtual QVariant DatabaseValue(DatabaseColumn) const {
-    return QVariant(QString());
-  }
-  virtual Song DatabaseSongMetadata() const { return Song(); }
-
   Song::Source source_;
 
   Song temp_metadata_;
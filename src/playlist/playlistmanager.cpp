@@ -98,10 +98,23 @@ void PlaylistManager::Init(CollectionBackend *collection_backend, PlaylistBacken
   QObject::connect(collection_backend_, &CollectionBackend::SongsStatisticsChanged, this, &PlaylistManager::SongsDiscovered);
   QObject::connect(collection_backend_, &CollectionBackend::SongsRatingChanged, this, &PlaylistManager::SongsDiscovered);
 
+  // Keep the songs restored playlists share up to date, the playlist items are updated in SongsDiscovered().
+  QObject::connect(collection_backend_, &CollectionBackend::SongsDiscovered, playlist_backend_, &PlaylistBackend::CollectionSongsChanged, Qt::DirectConnection);
+  QObject::connect(collection_backend_, &CollectionBackend::SongsStatisticsChanged, playlist_backend_, &PlaylistBackend::CollectionSongsChanged, Qt::DirectConnection);
+  QObject::connect(collection_backend_, &CollectionBackend::SongsDeleted, playlist_backend_, &PlaylistBackend::CollectionSongsDeleted, Qt::DirectConnection);
+  QObject::connect(collection_backend_, &CollectionBackend::DatabaseReset, playlist_backend_, &PlaylistBackend::CollectionReset, Qt::DirectConnection);
+
   for (const PlaylistBackend::Playlist &p : playlist_backend->GetAllOpenPlaylists()) {
-    ++playlists_loading_;
-    Playlist *ret = AddPlaylist(p.id, p.name, p.special_type, p.ui_path, p.favorite);
-    QObject::connect(ret, &Playlist::PlaylistLoaded, this, &PlaylistManager::PlaylistLoaded);
+    AddPlaylist(p.id, p.name, p.special_type, p.ui_path, p.favorite);
+  }
+
+  // Only the current and active playlists are restored now, the others when their tab is opened.
+  for (const Data &data : std::as_const(playlists_)) {
+    if (data.p->is_restored()) continue;
+    if (data.p->id() == current_ || data.p->id() == active_) {
+      ++playlists_loading_;
+      QObject::connect(data.p, &Playlist::PlaylistLoaded, this, &PlaylistManager::PlaylistLoaded);
+    }
   }
 
   // If no playlist exists then make a new one
@@ -212,11 +225,11 @@ void PlaylistManager::Load(const QString &filename) {
 
 void PlaylistManager::Save(const int id, const QString &filename, const PlaylistSettingsPage::PathType path_type) {
 
-  if (playlists_.contains(id)) {
+  if (playlists_.contains(id) && playlist(id)->is_restored()) {
     parser_->Save(playlist(id)->GetAllSongs(), filename, path_type);
   }
   else {
-    // Playlist is not in the playlist manager: probably save action was triggered from the left sidebar and the playlist isn't loaded.
+    // Playlist is not in the playlist manager or not restored yet: probably save action was triggered from the left sidebar and the playlist isn't loaded.
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     QFuture<SongList> future = QtConcurrent::run(&PlaylistBackend::GetPlaylistSongs, playlist_backend_, id);
 #else
@@ -364,6 +377,7 @@ void PlaylistManager::SetCurrentPlaylist(const int id) {
   }
 
   current_ = id;
+  playlists_[id].p->Restore();
   emit CurrentChanged(current(), playlists_[id].scroll_position);
   UpdateSummaryText();
 
@@ -377,6 +391,7 @@ void PlaylistManager::SetActivePlaylist(const int id) {
   if (active_ != -1 && active_ != id) active()->set_current_row(-1);
 
   active_ = id;
+  active()->Restore();
 
   emit ActiveChanged(active());
 
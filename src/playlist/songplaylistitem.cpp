@@ -28,12 +28,13 @@
 #include "core/sqlrow.h"
 #include "playlistitem.h"
 #include "songplaylistitem.h"
+#include "playlistbackend.h"
 
 SongPlaylistItem::SongPlaylistItem(const Song::Source source) : PlaylistItem(source) {}
 SongPlaylistItem::SongPlaylistItem(const Song &song) : PlaylistItem(song.source()), song_(song) {}
 
 bool SongPlaylistItem::InitFromQuery(const SqlRow &query) {
-  song_.InitFromQuery(query, false);
+  song_.InitFromQuery(query, false, PlaylistBackend::PlaylistItemsColumn());
   return true;
 }
 
@@ -23,6 +23,7 @@
 #include <QDir>
 #include <QBuffer>
 #include <QByteArray>
+#include <QList>
 #include <QString>
 #include <QStringList>
 #include <QSettings>
@@ -59,7 +60,8 @@ SongList M3UParser::Load(QIODevice *device, const QString &playlist_path, const
     line = QString::fromUtf8(buffer.readLine()).trimmed();
   }
 
-  SongList ret;
+  QStringList filenames_or_urls;
+  QList<Metadata> metadata;
   forever {
     if (line.startsWith('#')) {
       // Extended info or comment.
@@ -70,18 +72,8 @@ SongList M3UParser::Load(QIODevice *device, const QString &playlist_path, const
       }
     }
     else if (!line.isEmpty()) {
-      Song song = LoadSong(line, 0, dir, collection_search);
-      if (!current_metadata.title.isEmpty()) {
-        song.set_title(current_metadata.title);
-      }
-      if (!current_metadata.artist.isEmpty()) {
-        song.set_artist(current_metadata.artist);
-      }
-      if (current_metadata.length > 0) {
-        song.set_length_nanosec(current_metadata.length);
-      }
-      ret << song;
-
+      filenames_or_urls << line;
+      metadata << current_metadata;
       current_metadata = Metadata();
     }
     if (buffer.atEnd()) {
@@ -92,6 +84,20 @@ SongList M3UParser::Load(QIODevice *device, const QString &playlist_path, const
 
   buffer.close();
 
+  SongList ret = LoadSongs(filenames_or_urls, dir, collection_search);
+  for (int i = 0; i < ret.count(); ++i) {
+    Song &song = ret[i];
+    if (!metadata[i].title.isEmpty()) {
+      song.set_title(metadata[i].title);
+    }
+    if (!metadata[i].artist.isEmpty()) {
+      song.set_artist(metadata[i].artist);
+    }
+    if (metadata[i].length > 0) {
+      song.set_length_nanosec(metadata[i].length);
+    }
+  }
+
   return ret;
 
 }
@@ -23,7 +23,9 @@
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QList>
 #include <QString>
+#include <QStringList>
 #include <QRegularExpression>
 #include <QUrl>
 
@@ -36,10 +38,10 @@
 ParserBase::ParserBase(CollectionBackendInterface *collection, QObject *parent)
     : QObject(parent), collection_(collection) {}
 
-void ParserBase::LoadSong(const QString &filename_or_url, const qint64 beginning, const QDir &dir, Song *song, const bool collection_search) const {
+QString ParserBase::ResolveSong(const QString &filename_or_url, const qint64 beginning, const QDir &dir, Song *song, const bool collection_search) const {
 
   if (filename_or_url.isEmpty()) {
-    return;
+    return QString();
   }
 
   QString filename = filename_or_url;
@@ -54,11 +56,11 @@ void ParserBase::LoadSong(const QString &filename_or_url, const qint64 beginning
       song->set_url(QUrl::fromUserInput(filename_or_url));
       song->set_filetype(Song::FileType_Stream);
       song->set_valid(true);
-      return;
+      return QString();
     }
     else {
       qLog(Error) << "Don't know how to handle" << url;
-      return;
+      return QString();
     }
   }
 
@@ -84,11 +86,20 @@ void ParserBase::LoadSong(const QString &filename_or_url, const qint64 beginning
     // If it was found in the collection then use it, otherwise load metadata from disk.
     if (collection_song.is_valid()) {
       *song = collection_song;
-      return;
+      return QString();
     }
   }
 
-  TagReaderClient::Instance()->ReadFileBlocking(filename, song);
+  return filename;
+
+}
+
+void ParserBase::LoadSong(const QString &filename_or_url, const qint64 beginning, const QDir &dir, Song *song, const bool collection_search) const {
+
+  const QString filename = ResolveSong(filename_or_url, beginning, dir, song, collection_search);
+  if (!filename.isEmpty()) {
+    TagReaderClient::Instance()->ReadFileBlocking(filename, song);
+  }
 
 }
 
@@ -101,6 +112,40 @@ Song ParserBase::LoadSong(const QString &filename_or_url, const qint64 beginning
 
 }
 
+SongList ParserBase::LoadSongs(const QStringList &filenames_or_urls, const QDir &dir, const bool collection_search) const {
+
+  SongList songs;
+  songs.reserve(filenames_or_urls.count());
+
+  // Songs that aren't streams or in the collection are read from disk with one tagreader request.
+  QList<int> read_indexes;
+  QStringList read_filenames;
+  for (const QString &filename_or_url : filenames_or_urls) {
+    Song song(Song::Source_LocalFile);
+    const QString filename = ResolveSong(filename_or_url, 0, dir, &song, collection_search);
+    if (!filename.isEmpty()) {
+      read_indexes << songs.count();
+      read_filenames << filename;
+    }
+    songs << song;
+  }
+
+  if (!read_filenames.isEmpty()) {
+    SongList read_songs;
+    read_songs.reserve(read_indexes.count());
+    for (const int i : read_indexes) {
+      read_songs << songs[i];
+    }
+    TagReaderClient::Instance()->ReadFilesBlocking(read_filenames, &read_songs);
+    for (int i = 0; i < read_indexes.count(); ++i) {
+      songs[read_indexes[i]] = read_songs[i];
+    }
+  }
+
+  return songs;
+
+}
+
 QString ParserBase::URLOrFilename(const QUrl &url, const QDir &dir, const PlaylistSettingsPage::PathType path_type) {
 
   if (!url.isLocalFile()) return url.toString();
@@ -67,11 +67,18 @@ class ParserBase : public QObject {
   Song LoadSong(const QString &filename_or_url, const qint64 beginning, const QDir &dir, const bool collection_search) const;
   void LoadSong(const QString &filename_or_url, const qint64 beginning, const QDir &dir, Song *song, const bool collection_search) const;
 
+  // Like LoadSong(), but reads the metadata for all files that aren't in the collection with a single tagreader request.
+  SongList LoadSongs(const QStringList &filenames_or_urls, const QDir &dir, const bool collection_search) const;
+
   // If the URL is a file:// URL then returns its path, absolute or relative to the directory depending on the path_type option.
   // Otherwise, returns the URL as is. This function should always be used when saving a playlist.
   static QString URLOrFilename(const QUrl &url, const QDir &dir, const PlaylistSettingsPage::PathType path_type);
 
  private:
+  // Does the LoadSong() work apart from reading the file.
+  // Returns the filename to read the metadata from, or an empty string if the song is already complete.
+  QString ResolveSong(const QString &filename_or_url, const qint64 beginning, const QDir &dir, Song *song, const bool collection_search) const;
+
   CollectionBackendInterface *collection_;
 };
 
@@ -25,6 +25,7 @@
 
 #include "radioplaylistitem.h"
 #include "core/sqlrow.h"
+#include "playlist/playlistbackend.h"
 
 RadioPlaylistItem::RadioPlaylistItem(const Song::Source source)
     : PlaylistItem(source), source_(source) {}
@@ -38,7 +39,7 @@ RadioPlaylistItem::RadioPlaylistItem(const Song &metadata)
 
 bool RadioPlaylistItem::InitFromQuery(const SqlRow &query) {
 
-  metadata_.InitFromQuery(query, false);
+  metadata_.InitFromQuery(query, false, PlaylistBackend::PlaylistItemsColumn());
   InitMetadata();
   return true;
 
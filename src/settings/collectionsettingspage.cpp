@@ -241,6 +241,9 @@ void CollectionSettingsPage::Load() {
     workers = 4;
   }
   ui_->spinbox_tagreaderworkers->setValue(workers);
+  ui_->spinbox_tagreadermaxworkers->setValue(qBound(workers, s.value("tagreader_max_workers", qMax(workers, QThread::idealThreadCount())).toInt(), 16));
+
+  ui_->spinbox_scanjobs->setValue(qBound(1, s.value("scan_jobs", QThread::idealThreadCount()).toInt(), 32));
 
   s.endGroup();
 
@@ -312,6 +315,8 @@ void CollectionSettingsPage::Save() {
 
   s.setValue("thread_priority", ui_->combobox_threadpriority->currentIndex());
   s.setValue("tagreader_workers", ui_->spinbox_tagreaderworkers->value());
+  s.setValue("tagreader_max_workers", qMax(ui_->spinbox_tagreaderworkers->value(), ui_->spinbox_tagreadermaxworkers->value()));
+  s.setValue("scan_jobs", ui_->spinbox_scanjobs->value());
 
   s.endGroup();
 
@@ -20,12 +20,17 @@
  */
 
 #include <memory>
+#include <thread>
 
 #include <gtest/gtest.h>
 
 #include <QFileInfo>
 #include <QSignalSpy>
 #include <QThread>
+#include <QMutexLocker>
+#include <QSemaphore>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
 #include <QtDebug>
 
 #include "test_utils.h"
@@ -33,6 +38,9 @@
 #include "core/timeconstants.h"
 #include "core/song.h"
 #include "core/database.h"
+#include "core/scopedtransaction.h"
+#include "core/sqlquery.h"
+#include "core/sqlrow.h"
 #include "core/logging.h"
 #include "collection/collectionbackend.h"
 #include "collection/collection.h"
@@ -113,6 +121,76 @@ TEST_F(CollectionBackendTest, RemoveDirectory) {
 
 TEST_F(CollectionBackendTest, GetAlbumArtNonExistent) {}
 
+// Timing run with a large collection, run with --gtest_also_run_disabled_tests.
+TEST_F(CollectionBackendTest, DISABLED_SongCacheMemoryBenchmark) {
+
+  backend_->AddDirectory("/tmp");
+
+  // Songs by a few hundred artists on a few thousand albums, like a real collection.
+  const int count = 20000;
+  SongList songs;
+  songs.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    Song song = MakeDummySong(1);
+    song.set_title(QString("Title %1").arg(i));
+    song.set_artist(QString("Artist %1").arg(i % 200));
+    song.set_albumartist(QString("Artist %1").arg(i % 200));
+    song.set_album(QString("Album %1").arg(i % 2000));
+    song.set_genre(QString("Genre %1").arg(i % 20));
+    song.set_composer(QString("Composer %1").arg(i % 500));
+    song.set_url(QUrl::fromLocalFile(QString("/tmp/%1.flac").arg(i)));
+    songs << song;
+  }
+  backend_->AddOrUpdateSongs(songs);
+  songs.clear();
+
+  const qint64 heap_bytes = HeapBytes();
+  QElapsedTimer timer;
+  timer.start();
+  backend_->LoadSongCache();
+  const qint64 elapsed = timer.elapsed();
+  ASSERT_EQ(count, backend_->song_cache()->size());
+
+  if (heap_bytes >= 0) {
+    qLog(Info) << "Loaded" << count << "songs in" << elapsed << "ms, using" << (HeapBytes() - heap_bytes) / count << "bytes per song";
+  }
+  else {
+    qLog(Info) << "Loaded" << count << "songs in" << elapsed << "ms";
+  }
+
+}
+
+TEST_F(CollectionBackendTest, SongCacheInterning) {
+
+  backend_->AddDirectory("/tmp");
+
+  const int count = 400;
+  SongList songs;
+  songs.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    Song song = MakeDummySong(1);
+    song.set_title(QString("Title %1").arg(i));
+    song.set_artist(QString("Artist %1").arg(i % 20));
+    song.set_album(QString("Album %1").arg(i % 40));
+    song.set_genre(QString("Genre %1").arg(i % 5));
+    song.set_url(QUrl::fromLocalFile(QString("/tmp/%1.flac").arg(i)));
+    songs << song;
+  }
+  backend_->AddOrUpdateSongs(songs);
+
+  backend_->LoadSongCache();
+  ASSERT_EQ(count, backend_->song_cache()->size());
+
+  // Songs by the same artist share the text.
+  const Song song1 = backend_->GetSongById(1);
+  const Song song2 = backend_->GetSongById(21);
+  ASSERT_EQ(song1.artist(), song2.artist());
+  EXPECT_EQ(song1.artist().constData(), song2.artist().constData());
+  EXPECT_EQ(song1.artist_sortable().constData(), song2.artist_sortable().constData());
+  EXPECT_EQ(song1.genre().constData(), song2.genre().constData());
+
+}
+
 // Test adding a single song to the database, then getting various information back about it.
 class SingleSong : public CollectionBackendTest {
  protected:
@@ -349,6 +427,212 @@ TEST_F(SingleSong, MarkSongsUnavailable) {
 
 }
 
+TEST_F(SingleSong, SongCache) {
+
+  AddDummySong();
+  if (HasFatalFailure()) return;
+
+  EXPECT_FALSE(backend_->song_cache()->is_loaded());
+  backend_->LoadSongCache();
+  ASSERT_TRUE(backend_->song_cache()->is_loaded());
+  EXPECT_EQ(1, backend_->song_cache()->size());
+
+  // Lookups are answered from the cache.
+  const int hits = backend_->song_cache()->hits();
+  EXPECT_EQ("Title", backend_->GetSongById(1).title());
+  EXPECT_EQ(1, backend_->GetSongsByUrl(song_.url()).count());
+  EXPECT_EQ(hits + 2, backend_->song_cache()->hits());
+
+  // Updates are applied to the cache.
+  Song new_song(song_);
+  new_song.set_id(1);
+  new_song.set_title("New Title");
+  backend_->AddOrUpdateSongs(SongList() << new_song);
+  EXPECT_EQ("New Title", backend_->GetSongById(1).title());
+  EXPECT_EQ(1, backend_->song_cache()->size());
+
+  // Unavailable songs are kept, so they are found by the watcher when they become available again.
+  backend_->MarkSongsUnavailable(SongList() << new_song);
+  EXPECT_TRUE(backend_->GetSongById(1).is_unavailable());
+  EXPECT_TRUE(backend_->GetSongsByUrl(song_.url()).isEmpty());
+  EXPECT_EQ(1, backend_->GetSongsByUrl(song_.url(), true).count());
+
+  backend_->DeleteSongs(SongList() << new_song);
+  EXPECT_FALSE(backend_->GetSongById(1).is_valid());
+  EXPECT_EQ(0, backend_->song_cache()->size());
+
+}
+
+TEST_F(SingleSong, SongCacheStatistics) {
+
+  AddDummySong();
+  if (HasFatalFailure()) return;
+
+  backend_->LoadSongCache();
+  ASSERT_TRUE(backend_->song_cache()->is_loaded());
+
+  // Statistics updates are applied to the cache with the new values.
+  backend_->UpdatePlayCount("Artist", "Title", 5);
+  EXPECT_EQ(5, backend_->GetSongById(1).playcount());
+
+  backend_->UpdateLastPlayed("Artist", "Album", "Title", 1000);
+  EXPECT_EQ(1000, backend_->GetSongById(1).lastplayed());
+  EXPECT_EQ(5, backend_->GetSongById(1).playcount());
+
+}
+
+class AddOrUpdateSongsBatch : public CollectionBackendTest {
+ protected:
+  void SetUp() override {
+    CollectionBackendTest::SetUp();
+    backend_->AddDirectory("/mnt/music");
+  }
+
+  // Adds count songs in one batch, then updates all of them in another.
+  void AddAndUpdateSongs(const int count) {
+
+    SongList songs;
+    songs.reserve(count + 1);
+    for (int i = 0; i < count; ++i) {
+      Song song = MakeDummySong(1);
+      song.set_title(QString("Title %1").arg(i));
+      song.set_album(QString("Album %1").arg(i / 10));
+      song.set_artist(QString("Artist %1").arg(i / 100));
+      song.set_url(QUrl::fromLocalFile(QString("/mnt/music/%1.flac").arg(i)));
+      songs << song;
+    }
+    // Songs in a directory that doesn't exist are skipped.
+    songs << MakeDummySong(2);
+
+    QSignalSpy added_spy(backend_.get(), &CollectionBackend::SongsDiscovered);
+
+    QElapsedTimer timer;
+    timer.start();
+    backend_->AddOrUpdateSongs(songs);
+    const qint64 elapsed = timer.elapsed();
+
+    qLog(Info) << "Inserted" << count << "songs in" << elapsed << "ms," << (count * 1000 / qMax(elapsed, 1LL)) << "songs/second";
+
+    ASSERT_EQ(1, added_spy.count());
+    SongList added_songs = added_spy[0][0].value<SongList>();
+    ASSERT_EQ(count, added_songs.count());
+    EXPECT_EQ(count, backend_->GetAllSongs().count());
+
+    // Update every song, with the first song twice in the same batch.
+    for (Song &song : added_songs) {
+      song.set_title(song.title() + " updated");
+    }
+    Song first_again = added_songs.first();
+    first_again.set_title("Title 0 updated again");
+    added_songs << first_again;
+
+    QSignalSpy deleted_spy(backend_.get(), &CollectionBackend::SongsDeleted);
+    backend_->AddOrUpdateSongs(added_songs);
+
+    ASSERT_EQ(1, deleted_spy.count());
+    const SongList deleted_songs = deleted_spy[0][0].value<SongList>();
+    ASSERT_EQ(count + 1, deleted_songs.count());
+    EXPECT_EQ("Title 0", deleted_songs.first().title());
+    EXPECT_EQ("Title 0 updated", deleted_songs.last().title());
+
+    EXPECT_EQ(count, backend_->GetAllSongs().count());
+    EXPECT_EQ("Title 0 updated again", backend_->GetSongById(added_songs.first().id()).title());
+
+  }
+
+  // Reads count songs by column name and by column position, and compares them.
+  void ReadSongsByNameAndOrdinal(const int count) {
+
+    SongList songs;
+    songs.reserve(count);
+    for (int i = 0; i < count; ++i) {
+      Song song = MakeDummySong(1);
+      song.set_title(QString("Title %1").arg(i));
+      song.set_album(QString("Album %1").arg(i / 10));
+      song.set_artist(QString("Artist %1").arg(i / 100));
+      song.set_track(i % 20);
+      song.set_url(QUrl::fromLocalFile(QString("/mnt/music/%1.flac").arg(i)));
+      songs << song;
+    }
+    backend_->AddOrUpdateSongs(songs);
+
+    QSqlDatabase db(database_->Connect());
+
+    // Read every row once by column name through a SqlRow per row, like before.
+    SongList songs_by_name;
+    qint64 elapsed_by_name = 0;
+    {
+      SqlQuery q(db);
+      q.prepare(QString("SELECT ROWID, " + Song::kColumnSpec + " FROM %1").arg(SCollection::kSongsTable));
+      ASSERT_TRUE(q.Exec());
+      QElapsedTimer timer;
+      timer.start();
+      while (q.next()) {
+        Song song(Song::Source_Collection);
+        song.InitFromQuery(SqlRow(q), true);
+        songs_by_name << song;
+      }
+      elapsed_by_name = timer.elapsed();
+    }
+
+    // And again by column position, with the column table shared by all rows.
+    SongList songs_by_ordinal;
+    qint64 elapsed_by_ordinal = 0;
+    {
+      SqlQuery q(db);
+      q.prepare(QString("SELECT ROWID, " + Song::kColumnSpec + " FROM %1").arg(SCollection::kSongsTable));
+      ASSERT_TRUE(q.Exec());
+      QElapsedTimer timer;
+      timer.start();
+      const SqlRow::ColumnsPtr columns = SqlRow::ColumnsFromQuery(q);
+      while (q.next()) {
+        Song song(Song::Source_Collection);
+        song.InitFromQuery(SqlRow(q, columns), true, 0);
+        songs_by_ordinal << song;
+      }
+      elapsed_by_ordinal = timer.elapsed();
+    }
+
+    qLog(Info) << "Read" << count << "rows by name in" << elapsed_by_name << "ms," << (count * 1000 / qMax(elapsed_by_name, 1LL)) << "rows/second";
+    qLog(Info) << "Read" << count << "rows by ordinal in" << elapsed_by_ordinal << "ms," << (count * 1000 / qMax(elapsed_by_ordinal, 1LL)) << "rows/second";
+
+    ASSERT_EQ(count, songs_by_name.count());
+    ASSERT_EQ(count, songs_by_ordinal.count());
+    for (int i = 0; i < count; ++i) {
+      EXPECT_EQ(songs_by_name[i].id(), songs_by_ordinal[i].id());
+      EXPECT_TRUE(songs_by_name[i].IsMetadataEqual(songs_by_ordinal[i]));
+      EXPECT_EQ(songs_by_name[i].url(), songs_by_ordinal[i].url());
+      EXPECT_EQ(songs_by_name[i].directory_id(), songs_by_ordinal[i].directory_id());
+    }
+
+  }
+};
+
+TEST_F(AddOrUpdateSongsBatch, InsertAndUpdate) {
+
+  AddAndUpdateSongs(500);
+
+}
+
+TEST_F(AddOrUpdateSongsBatch, InitFromQueryByName) {
+
+  ReadSongsByNameAndOrdinal(500);
+
+}
+
+// Timing runs with a large collection, run with --gtest_also_run_disabled_tests.
+TEST_F(AddOrUpdateSongsBatch, DISABLED_InsertAndUpdateBenchmark) {
+
+  AddAndUpdateSongs(100000);
+
+}
+
+TEST_F(AddOrUpdateSongsBatch, DISABLED_InitFromQueryByNameBenchmark) {
+
+  ReadSongsByNameAndOrdinal(100000);
+
+}
+
 class TestUrls : public CollectionBackendTest {
  protected:
   void SetUp() override {
@@ -609,4 +893,91 @@ TEST_F(UpdateSongsBySongID, UpdateSongsBySongID) {
 
 }
 
+// Test reads against a WAL database on disk while another thread holds a write transaction open.
+class FileDatabaseTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.isValid());
+    database_ = std::make_unique<Database>(nullptr, nullptr, temp_dir_.filePath("strawberry.db"));
+    backend_ = std::make_unique<CollectionBackend>();
+    backend_->Init(database_.get(), nullptr, Song::Source_Collection, SCollection::kSongsTable, SCollection::kFtsTable, SCollection::kDirsTable, SCollection::kSubdirsTable);
+    backend_->AddDirectory("/mnt/music");
+  }
+
+  void TearDown() override {
+    backend_->Close();
+    backend_.reset();
+    database_.reset();
+  }
+
+  static Song MakeSong(const int i) {
+    Song song(Song::Source_Collection);
+    song.set_directory_id(1);
+    song.set_title(QString("Title %1").arg(i));
+    song.set_album(QString("Album %1").arg(i / 10));
+    song.set_artist(QString("Artist %1").arg(i / 100));
+    song.set_url(QUrl::fromLocalFile(QString("/mnt/music/%1.flac").arg(i)));
+    song.set_length_nanosec(kNsecPerSec);
+    song.set_mtime(1);
+    song.set_ctime(1);
+    song.set_filesize(1);
+    song.set_valid(true);
+    return song;
+  }
+
+  QTemporaryDir temp_dir_;  // NOLINT(cppcoreguidelines-non-private-member-variables-in-classes)
+  std::unique_ptr<Database> database_;  // NOLINT(cppcoreguidelines-non-private-member-variables-in-classes)
+  std::unique_ptr<CollectionBackend> backend_;  // NOLINT(cppcoreguidelines-non-private-member-variables-in-classes)
+};
+
+TEST_F(FileDatabaseTest, ReadDuringWrite) {
+
+  ASSERT_TRUE(database_->wal_enabled());
+
+  SongList songs;
+  for (int i = 0; i < 1000; ++i) {
+    songs << MakeSong(i);
+  }
+  backend_->AddOrUpdateSongs(songs);
+
+  QSemaphore writing;
+  QSemaphore read_done;
+
+  std::thread writer([this, &writing, &read_done]() {
+    {
+      QMutexLocker l(database_->Mutex());
+      QSqlDatabase db(database_->Connect());
+      ScopedTransaction t(&db);
+      SqlQuery q(db);
+      q.prepare(QString("INSERT INTO %1 (" + Song::kColumnSpec + ") VALUES (" + Song::kBindSpec + ")").arg(SCollection::kSongsTable));
+      for (int i = 1000; i < 11000; ++i) {
+        MakeSong(i).BindToQuery(&q);
+        q.Exec();
+      }
+      writing.release();
+      // Keep the transaction open until the reader is done, give up if the reader is blocked on us.
+      read_done.tryAcquire(1, 10000);
+      t.Commit();
+    }
+    database_->Close();
+  });
+
+  writing.acquire();
+
+  QElapsedTimer timer;
+  timer.start();
+  const SongList read_songs = backend_->GetAllSongs();
+  const qint64 elapsed = timer.elapsed();
+
+  read_done.release();
+  writer.join();
+
+  qLog(Info) << "Read" << read_songs.count() << "songs in" << elapsed << "ms while a write transaction was open";
+
+  // The reader gets the last committed snapshot without waiting for the writer.
+  EXPECT_EQ(1000, read_songs.count());
+  EXPECT_EQ(11000, backend_->GetAllSongs().count());
+
+}
+
 } // namespace
@@ -23,11 +23,15 @@
 
 #include <gtest/gtest.h>
 
+#include <QCoreApplication>
 #include <QMap>
+#include <QPair>
 #include <QString>
 #include <QUrl>
 #include <QThread>
+#include <QThreadPool>
 #include <QSignalSpy>
+#include <QPersistentModelIndex>
 #include <QSortFilterProxyModel>
 #include <QtDebug>
 
@@ -35,6 +39,7 @@
 
 #include "core/logging.h"
 #include "core/database.h"
+#include "collection/collectionitem.h"
 #include "collection/collectionmodel.h"
 #include "collection/collectionbackend.h"
 #include "collection/collection.h"
@@ -295,6 +300,84 @@ TEST_F(CollectionModelTest, RemoveSongsNotLazyLoaded) {
 
 }
 
+TEST_F(CollectionModelTest, RebuildKeepsExpandedItems) {
+
+  AddSong("Title 1", "Artist 1", "Album 1", 123);
+  AddSong("Title 2", "Artist 1", "Album 2", 123);
+  AddSong("Title 3", "Artist 2", "Album 3", 123);
+  model_->Init(false);
+
+  auto find_row = [this](const QModelIndex &parent, const QString &text) {
+    for (int i = 0; i < model_->rowCount(parent); ++i) {
+      const QModelIndex idx = model_->index(i, 0, parent);
+      if (idx.data().toString() == text) return idx;
+    }
+    return QModelIndex();
+  };
+
+  // Expand the first artist
+  QPersistentModelIndex artist_index = find_row(QModelIndex(), "Artist 1");
+  ASSERT_TRUE(artist_index.isValid());
+  model_->fetchMore(artist_index);
+  ASSERT_EQ(2, model_->rowCount(artist_index));
+
+  QSignalSpy spy_reset(model_.get(), &CollectionModel::modelReset);
+  QSignalSpy spy_built(model_.get(), &CollectionModel::TreeBuilt);
+
+  model_->SetGroupBy(CollectionModel::Grouping(CollectionModel::GroupBy_Artist, CollectionModel::GroupBy_Year, CollectionModel::GroupBy_None));
+  EXPECT_TRUE(model_->is_building());
+
+  // Songs added while the tree is built are not lost
+  AddSong("Title 4", "Artist 3", "Album 4", 123);
+
+  ASSERT_TRUE(spy_built.wait(5000));
+  EXPECT_FALSE(model_->is_building());
+  EXPECT_EQ(0, spy_reset.count());
+
+  // The artist item is kept and still populated, with the children of the new grouping
+  ASSERT_TRUE(artist_index.isValid());
+  EXPECT_EQ("Artist 1", artist_index.data().toString());
+  EXPECT_EQ(1, model_->rowCount(artist_index));
+  EXPECT_TRUE(find_row(QModelIndex(), "Artist 2").isValid());
+  EXPECT_TRUE(find_row(QModelIndex(), "Artist 3").isValid());
+
+}
+
+TEST_F(CollectionModelTest, TopResults) {
+
+  AddSong("Blue", "Artist 1", "Love Album", 123);
+  AddSong("Love Song", "Artist 2", "Album", 123);
+  AddSong("Other", "Artist 3", "Album", 123);
+  model_->Init(false);
+  model_->SetFilterTopResults(true);
+
+  QSignalSpy spy_built(model_.get(), &CollectionModel::TreeBuilt);
+
+  // Matches in the title rank higher than matches in the album, and the songs are not grouped.
+  model_->SetFilterText("love");
+  ASSERT_TRUE(spy_built.wait(5000));
+  ASSERT_EQ(2, model_sorted_->rowCount(QModelIndex()));
+  EXPECT_EQ("Love Song", model_sorted_->index(0, 0, QModelIndex()).data().toString());
+  EXPECT_EQ("Blue", model_sorted_->index(1, 0, QModelIndex()).data().toString());
+
+  // Going back to a previous filter text is answered from the query cache.
+  model_->SetFilterText("other");
+  ASSERT_TRUE(spy_built.wait(5000));
+  ASSERT_EQ(1, model_sorted_->rowCount(QModelIndex()));
+
+  const int hits = model_->query_cache_hits();
+  model_->SetFilterText("love");
+  ASSERT_TRUE(spy_built.wait(5000));
+  EXPECT_EQ(hits + 1, model_->query_cache_hits());
+  EXPECT_EQ(2, model_sorted_->rowCount(QModelIndex()));
+
+  // Without a filter text the grouping is used again.
+  model_->SetFilterText(QString());
+  ASSERT_TRUE(spy_built.wait(5000));
+  EXPECT_EQ("A", model_sorted_->index(0, 0, QModelIndex()).data().toString());
+
+}
+
 TEST_F(CollectionModelTest, RemoveEmptyAlbums) {
 
   Song one = AddSong("Title 1", "Artist", "Album 1", 123); one.set_id(1);
@@ -352,6 +435,61 @@ TEST_F(CollectionModelTest, RemoveEmptyArtists) {
 // model3 - All container nodes are created in SongsDiscovered.
 
 // WARNING: This test can take up to 30 minutes to complete.
+TEST_F(CollectionModelTest, MemoryBenchmark) {
+
+  SongList songs;
+  for (int artist_number = 1; artist_number <= 100; ++artist_number) {
+    for (int album_number = 1; album_number <= 5; ++album_number) {
+      for (int song_number = 1; song_number <= 10; ++song_number) {
+        Song song(Song::Source_Collection);
+        song.Init(QString("Title %1").arg(song_number), QString("Artist %1").arg(artist_number), QString("Album %1").arg(album_number), 123);
+        song.set_genre(QString("Genre %1").arg(artist_number % 10));
+        song.set_year(1960 + album_number + artist_number % 40);
+        song.set_track(song_number);
+        song.set_directory_id(1);
+        song.set_mtime(1);
+        song.set_ctime(1);
+        song.set_filesize(1);
+        song.set_url(QUrl::fromLocalFile(QString("/music/%1/%2/%3.flac").arg(artist_number).arg(album_number).arg(song_number)));
+        songs << song;
+      }
+    }
+  }
+  backend_->AddDirectory("/music");
+  backend_->AddOrUpdateSongs(songs);
+
+  const QList<QPair<QString, CollectionModel::Grouping>> groupings = QList<QPair<QString, CollectionModel::Grouping>>()
+    << qMakePair(QString("Album artist/Album - Disc"), CollectionModel::Grouping(CollectionModel::GroupBy_AlbumArtist, CollectionModel::GroupBy_AlbumDisc, CollectionModel::GroupBy_None))
+    << qMakePair(QString("Artist/Year - Album"), CollectionModel::Grouping(CollectionModel::GroupBy_Artist, CollectionModel::GroupBy_YearAlbum, CollectionModel::GroupBy_None))
+    << qMakePair(QString("Genre/Album artist/Album"), CollectionModel::Grouping(CollectionModel::GroupBy_Genre, CollectionModel::GroupBy_AlbumArtist, CollectionModel::GroupBy_Album))
+    << qMakePair(QString("Album"), CollectionModel::Grouping(CollectionModel::GroupBy_Album, CollectionModel::GroupBy_None, CollectionModel::GroupBy_None));
+
+  for (const QPair<QString, CollectionModel::Grouping> &grouping : groupings) {
+    std::unique_ptr<CollectionModel> model = std::make_unique<CollectionModel>(backend_.get(), nullptr);
+    model->SetGroupBy(grouping.second);
+    // Let the background build started by SetGroupBy finish, so only the items of the model below are counted.
+    QThreadPool::globalInstance()->waitForDone();
+    QCoreApplication::processEvents();
+
+    const qint64 items_before = CollectionItem::allocated_items();
+    const qint64 heap_before = HeapBytes();
+
+    model->Init(false);
+    model->ExpandAll();
+
+    const qint64 items = CollectionItem::allocated_items() - items_before;
+    ASSERT_GT(items, songs.count());
+    EXPECT_EQ(songs.count(), model->song_nodes().count());
+    if (heap_before >= 0) {
+      qLog(Info) << grouping.first << ":" << items << "items," << (HeapBytes() - heap_before) / items << "bytes per item";
+    }
+    else {
+      qLog(Info) << grouping.first << ":" << items << "items," << CollectionItem::allocated_bytes() / items << "bytes per item in the item pool";
+    }
+  }
+
+}
+
 #if 0
 TEST_F(CollectionModelTest, TestContainerNodes) {
 
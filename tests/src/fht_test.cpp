@@ -0,0 +1,181 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include <QtGlobal>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QtMath>
+
+#include "core/logging.h"
+#include "analyzer/fht.h"
+
+// clazy:excludeall=non-pod-global-static
+
+namespace {
+
+using Kernel = FHT::Kernel;
+
+// Values between -1 and 1, like the downmixed audio.
+QVector<float> MakeValues(const int count) {
+
+  QVector<float> values(count);
+  QRandomGenerator random(1);
+  for (int i = 0; i < count; ++i) {
+    values[i] = static_cast<float>(random.generateDouble() * 2.0 - 1.0);
+  }
+  return values;
+
+}
+
+// Interleaved stereo samples.
+QVector<qint16> MakeSamples(const int frames) {
+
+  QVector<qint16> samples(frames * 2);
+  QRandomGenerator random(2);
+  for (int i = 0; i < samples.size(); ++i) {
+    samples[i] = static_cast<qint16>(random.bounded(65536) - 32768);
+  }
+  return samples;
+
+}
+
+void ExpectNear(const QVector<float> &expected, const QVector<float> &result, const int count, const Kernel kernel) {
+
+  for (int i = 0; i < count; ++i) {
+    EXPECT_NEAR(expected[i], result[i], 1e-4 * qMax(1.0F, std::abs(expected[i]))) << FHT::kernelName(kernel).toStdString() << " value " << i;
+  }
+
+}
+
+class FHTTest : public ::testing::TestWithParam<int> {};
+
+TEST_P(FHTTest, TransformMatchesDefinition) {
+
+  const int exp = GetParam();
+  const int n = 1 << exp;
+  const QVector<float> values = MakeValues(n);
+
+  // The discrete Hartley transform, H(k) is the sum of x(t) * cas(2 * pi * k * t / n).
+  QVector<float> expected(n);
+  for (int k = 0; k < n; ++k) {
+    double sum = 0.0;
+    for (int t = 0; t < n; ++t) {
+      const double angle = 2.0 * M_PI * static_cast<double>(k) * static_cast<double>(t) / static_cast<double>(n);
+      sum += static_cast<double>(values[t]) * (std::cos(angle) + std::sin(angle));
+    }
+    expected[k] = static_cast<float>(sum);
+  }
+
+  for (const Kernel kernel : FHT::supportedKernels()) {
+    FHT fht(static_cast<uint>(exp), kernel);
+    QVector<float> result = values;
+    fht.transform(result.data());
+    ExpectNear(expected, result, n, kernel);
+  }
+
+}
+
+TEST_P(FHTTest, KernelsMatchScalar) {
+
+  const int exp = GetParam();
+  const int n = 1 << exp;
+  const QVector<float> values = MakeValues(n);
+  const QVector<qint16> samples = MakeSamples(n);
+
+  FHT scalar(static_cast<uint>(exp), Kernel::Scalar);
+
+  QVector<float> expected_spectrum = values;
+  scalar.spectrum(expected_spectrum.data());
+  scalar.scale(expected_spectrum.data(), 1.0F / 20);
+
+  QVector<float> expected_power = values;
+  scalar.power(expected_power.data());
+
+  QVector<float> expected_log_spectrum(n);
+  QVector<float> aux = values;
+  scalar.logSpectrum(expected_log_spectrum.data(), aux.data());
+
+  // An odd number of frames so the vector kernels leave a tail for the scalar kernel.
+  QVector<float> expected_mono(n - 1);
+  scalar.downmix(samples.constData(), expected_mono.data(), n - 1);
+
+  for (const Kernel kernel : FHT::supportedKernels()) {
+    FHT fht(static_cast<uint>(exp), kernel);
+
+    QVector<float> spectrum = values;
+    fht.spectrum(spectrum.data());
+    fht.scale(spectrum.data(), 1.0F / 20);
+    ExpectNear(expected_spectrum, spectrum, n / 2, kernel);
+
+    QVector<float> power = values;
+    fht.power(power.data());
+    ExpectNear(expected_power, power, n / 2, kernel);
+
+    QVector<float> log_spectrum(n);
+    aux = values;
+    fht.logSpectrum(log_spectrum.data(), aux.data());
+    ExpectNear(expected_log_spectrum, log_spectrum, n / 2, kernel);
+
+    QVector<float> mono(n - 1);
+    fht.downmix(samples.constData(), mono.data(), n - 1);
+    EXPECT_EQ(expected_mono, mono) << FHT::kernelName(kernel).toStdString();
+  }
+
+}
+
+TEST_P(FHTTest, Benchmark) {
+
+  const int exp = GetParam();
+  const int n = 1 << exp;
+  const QVector<qint16> samples = MakeSamples(n);
+  QVector<float> scope(n);
+  QVector<float> aux(n);
+
+  // What the analyzers do for each frame: downmix, then the log spectrum of Analyzer::Base or the spectrum of BlockAnalyzer and RainbowAnalyzer.
+  const int frames = 10000;
+  for (const Kernel kernel : FHT::supportedKernels()) {
+    FHT fht(static_cast<uint>(exp), kernel);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < frames; ++i) {
+      fht.downmix(samples.constData(), aux.data(), n);
+      fht.logSpectrum(scope.data(), aux.data());
+      fht.scale(scope.data(), 1.0F / 20);
+    }
+    const qint64 log_spectrum_nsec = timer.nsecsElapsed();
+    timer.restart();
+    for (int i = 0; i < frames; ++i) {
+      fht.downmix(samples.constData(), scope.data(), n);
+      fht.spectrum(scope.data());
+      fht.scale(scope.data(), 1.0F / 20);
+    }
+    const qint64 spectrum_nsec = timer.nsecsElapsed();
+    qLog(Info) << n << "point transform with the" << FHT::kernelName(kernel) << "kernel:" << frames * 1000000000LL / qMax(1LL, log_spectrum_nsec) << "log spectrum frames per second," << frames * 1000000000LL / qMax(1LL, spectrum_nsec) << "spectrum frames per second";
+  }
+
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, FHTTest, ::testing::Values(4, 8, 9, 10));
+
+}  // namespace
@@ -0,0 +1,147 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstring>
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include <QtGlobal>
+#include <QVector>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+
+#include "core/logging.h"
+#include "engine/pcmconverter.h"
+
+// clazy:excludeall=non-pod-global-static
+
+namespace {
+
+using PCMConverter::Format;
+using PCMConverter::Kernel;
+
+class PCMConverterTest : public ::testing::TestWithParam<Format> {
+ protected:
+  // Random samples, F32LE samples are between -1.5 and 1.5 so some are clipped, with NaN and infinity in the vector part and the tail.
+  static QByteArray MakeSamples(const Format format, const int samples) {
+
+    QByteArray data(samples * PCMConverter::SampleSize(format), Qt::Uninitialized);
+    QRandomGenerator random(1);
+    if (format == Format::F32LE) {
+      float *s = reinterpret_cast<float*>(data.data());
+      for (int i = 0; i < samples; ++i) {
+        s[i] = static_cast<float>(random.generateDouble() * 3.0 - 1.5);
+      }
+      s[5] = std::numeric_limits<float>::quiet_NaN();
+      s[17] = std::numeric_limits<float>::infinity();
+      s[30] = -std::numeric_limits<float>::infinity();
+      s[samples - 1] = std::numeric_limits<float>::quiet_NaN();
+    }
+    else {
+      for (int i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(random.bounded(256));
+      }
+    }
+    return data;
+
+  }
+};
+
+TEST(PCMConverterFormatTest, FormatFromString) {
+
+  EXPECT_EQ(Format::S16LE, PCMConverter::FormatFromString("S16LE"));
+  EXPECT_EQ(Format::S24LE, PCMConverter::FormatFromString("S24LE"));
+  EXPECT_EQ(Format::S24_32LE, PCMConverter::FormatFromString("S24_32LE"));
+  EXPECT_EQ(Format::S32LE, PCMConverter::FormatFromString("S32LE"));
+  EXPECT_EQ(Format::F32LE, PCMConverter::FormatFromString("F32LE"));
+  EXPECT_EQ(Format::Unsupported, PCMConverter::FormatFromString("U8"));
+
+}
+
+TEST(PCMConverterFormatTest, ScalarConversion) {
+
+  qint16 dest = 0;
+
+  const qint32 s32 = 0x12345678;
+  PCMConverter::ConvertToS16(Format::S32LE, Kernel::Scalar, &s32, &dest, 1);
+  EXPECT_EQ(0x1234, dest);
+
+  const quint8 s24[] = { 0x11, 0x34, 0x92 };
+  PCMConverter::ConvertToS16(Format::S24LE, Kernel::Scalar, s24, &dest, 1);
+  EXPECT_EQ(static_cast<qint16>(0x9234), dest);
+
+  const qint32 s24_32 = -0x123456;
+  PCMConverter::ConvertToS16(Format::S24_32LE, Kernel::Scalar, &s24_32, &dest, 1);
+  EXPECT_EQ(static_cast<qint16>(-0x123456 >> 8), dest);
+
+  const float f32[] = { 0.5F, -1.0F, 2.0F, -2.0F, std::numeric_limits<float>::quiet_NaN() };
+  qint16 dest_f32[5] = {};
+  PCMConverter::ConvertToS16(Format::F32LE, Kernel::Scalar, f32, dest_f32, 5);
+  EXPECT_EQ(16384, dest_f32[0]);
+  EXPECT_EQ(-32768, dest_f32[1]);
+  EXPECT_EQ(32767, dest_f32[2]);
+  EXPECT_EQ(-32768, dest_f32[3]);
+  EXPECT_EQ(32767, dest_f32[4]);
+
+}
+
+TEST_P(PCMConverterTest, KernelsMatchScalar) {
+
+  const Format format = GetParam();
+
+  // An odd number of samples so the vector kernels leave a tail for the scalar kernel.
+  const int samples = 1027;
+  const QByteArray data = MakeSamples(format, samples);
+
+  QVector<qint16> expected(samples);
+  PCMConverter::ConvertToS16(format, Kernel::Scalar, data.constData(), expected.data(), samples);
+
+  for (const Kernel kernel : PCMConverter::SupportedKernels()) {
+    QVector<qint16> result(samples, 0x5555);
+    PCMConverter::ConvertToS16(format, kernel, data.constData(), result.data(), samples);
+    EXPECT_EQ(expected, result) << PCMConverter::KernelName(kernel).toStdString();
+  }
+
+}
+
+TEST_P(PCMConverterTest, Benchmark) {
+
+  const Format format = GetParam();
+
+  // Ten seconds of stereo audio at 44.1 kHz.
+  const int samples = 44100 * 2 * 10;
+  const QByteArray data = MakeSamples(format, samples);
+  QVector<qint16> dest(samples);
+
+  for (const Kernel kernel : PCMConverter::SupportedKernels()) {
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < 10; ++i) {
+      PCMConverter::ConvertToS16(format, kernel, data.constData(), dest.data(), samples);
+    }
+    qLog(Info) << "Converted" << samples * 10 << "samples with the" << PCMConverter::KernelName(kernel) << "kernel in" << timer.nsecsElapsed() / 1000 << "us";
+  }
+
+}
+
+INSTANTIATE_TEST_SUITE_P(Formats, PCMConverterTest, ::testing::Values(Format::S24LE, Format::S24_32LE, Format::S32LE, Format::F32LE));
+
+}  // namespace
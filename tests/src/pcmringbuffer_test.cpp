@@ -0,0 +1,176 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <thread>
+#include <atomic>
+
+#include <gtest/gtest.h>
+
+#include <QtGlobal>
+#include <QVector>
+
+#include "core/timeconstants.h"
+#include "engine/pcmconverter.h"
+#include "engine/pcmringbuffer.h"
+
+// clazy:excludeall=non-pod-global-static
+
+namespace {
+
+using PCMConverter::Format;
+
+// Mono audio at 1000 Hz, so each sample is one millisecond and its value is its time in milliseconds.
+const int kRate = 1000;
+
+QVector<qint16> MakeSamples(const int first, const int count) {
+
+  QVector<qint16> samples(count);
+  for (int i = 0; i < count; ++i) {
+    samples[i] = static_cast<qint16>(first + i);
+  }
+  return samples;
+
+}
+
+void Write(PCMRingBuffer *buffer, const int first, const int count) {
+
+  const QVector<qint16> samples = MakeSamples(first, count);
+  buffer->Write(first * kNsecPerMsec, 1, kRate, Format::S16LE, samples.constData(), count);
+
+}
+
+TEST(PCMRingBufferTest, ReadAtTimestamp) {
+
+  PCMRingBuffer buffer;
+  Write(&buffer, 0, 100);
+  Write(&buffer, 100, 100);
+
+  QVector<qint16> dest(50);
+  ASSERT_EQ(50, buffer.Read(80 * kNsecPerMsec, dest.data(), 50));
+  EXPECT_EQ(MakeSamples(80, 50), dest);
+
+  // Reading later audio discards the audio that was played.
+  ASSERT_EQ(50, buffer.Read(150 * kNsecPerMsec, dest.data(), 50));
+  EXPECT_EQ(MakeSamples(150, 50), dest);
+
+  // There is no audio after the last sample.
+  EXPECT_EQ(0, buffer.Read(200 * kNsecPerMsec, dest.data(), 50));
+
+}
+
+TEST(PCMRingBufferTest, StopsAtGap) {
+
+  PCMRingBuffer buffer;
+  Write(&buffer, 0, 100);
+  // The audio from 100 to 150 ms was dropped.
+  Write(&buffer, 150, 100);
+
+  QVector<qint16> dest(50);
+  ASSERT_EQ(20, buffer.Read(80 * kNsecPerMsec, dest.data(), 50));
+  EXPECT_EQ(MakeSamples(80, 20), dest.mid(0, 20));
+
+  // Audio with a different format is not appended either.
+  const qint16 stereo[] = { 250, 250 };
+  buffer.Write(250 * kNsecPerMsec, 2, kRate, Format::S16LE, stereo, 2);
+  dest.fill(0, 100);
+  ASSERT_EQ(50, buffer.Read(200 * kNsecPerMsec, dest.data(), 100));
+  EXPECT_EQ(MakeSamples(200, 50), dest.mid(0, 50));
+
+}
+
+TEST(PCMRingBufferTest, ConvertsToS16) {
+
+  PCMRingBuffer buffer;
+  const qint32 samples[] = { 0x10000, 0x20000, 0x30000, 0x40000 };
+  buffer.Write(0, 2, kRate, Format::S32LE, samples, 4);
+
+  qint16 dest[4] = {};
+  ASSERT_EQ(2, buffer.Read(kNsecPerMsec, dest, 4));
+  EXPECT_EQ(3, dest[0]);
+  EXPECT_EQ(4, dest[1]);
+
+}
+
+TEST(PCMRingBufferTest, DropsAudioWhenFull) {
+
+  PCMRingBuffer buffer;
+  const int capacity = PCMRingBuffer::kSlotCount * PCMRingBuffer::kSlotSamples;
+  Write(&buffer, 0, capacity);
+  EXPECT_EQ(0, buffer.dropped_samples());
+
+  Write(&buffer, capacity, 100);
+  EXPECT_EQ(100, buffer.dropped_samples());
+
+  // Reading frees the slots which were played.
+  QVector<qint16> dest(10);
+  EXPECT_EQ(10, buffer.Read(PCMRingBuffer::kSlotSamples * kNsecPerMsec, dest.data(), 10));
+  Write(&buffer, capacity, 100);
+  EXPECT_EQ(100, buffer.dropped_samples());
+  EXPECT_EQ(capacity + 100, buffer.written_samples());
+
+}
+
+TEST(PCMRingBufferTest, DiscardsAudioFromBeforeSeek) {
+
+  PCMRingBuffer buffer;
+  // Audio far ahead of the position, then the audio after seeking back.
+  Write(&buffer, 10000, 100);
+  Write(&buffer, 0, 100);
+
+  QVector<qint16> dest(10);
+  ASSERT_EQ(10, buffer.Read(20 * kNsecPerMsec, dest.data(), 10));
+  EXPECT_EQ(MakeSamples(20, 10), dest);
+
+  buffer.Clear();
+  EXPECT_EQ(0, buffer.Read(30 * kNsecPerMsec, dest.data(), 10));
+
+}
+
+TEST(PCMRingBufferTest, ConcurrentReadAndWrite) {
+
+  PCMRingBuffer buffer;
+  const int chunk = 1000;
+  const int chunks = 2000;
+  std::atomic<qint64> position(0);
+  std::atomic<bool> done(false);
+
+  // The reader follows the writer and checks that every sample it reads is the sample at its time.
+  std::thread reader([&buffer, &position, &done]() {
+    QVector<qint16> dest(256);
+    while (!done) {
+      const qint64 timestamp = position.load();
+      const int samples = buffer.Read(timestamp * kNsecPerMsec, dest.data(), dest.size());
+      for (int i = 0; i < samples; ++i) {
+        ASSERT_EQ(static_cast<qint16>(timestamp + i), dest[i]);
+      }
+    }
+  });
+
+  for (int i = 0; i < chunks; ++i) {
+    Write(&buffer, (i * chunk) % 30000, chunk);
+    position = (i * chunk) % 30000;
+  }
+  done = true;
+  reader.join();
+
+  EXPECT_EQ(static_cast<qint64>(chunk) * chunks, buffer.written_samples() + buffer.dropped_samples());
+
+}
+
+}  // namespace
@@ -25,13 +25,20 @@
 
 #include "test_utils.h"
 
+#include "core/logging.h"
+#include "core/timeconstants.h"
 #include "collection/collectionplaylistitem.h"
 #include "playlist/playlist.h"
+#include "playlist/playlistfilter.h"
+#include "playlist/songplaylistitem.h"
 #include "mock_settingsprovider.h"
 #include "mock_playlistitem.h"
 
 #include <QtDebug>
 #include <QUndoStack>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QPair>
 
 using ::testing::Return;
 
@@ -543,5 +550,265 @@ TEST_F(PlaylistTest, CollectionIdMapMulti) {
 
 }
 
+TEST_F(PlaylistTest, FilterText) {
+
+  playlist_.InsertItems(PlaylistItemList() << MakeMockItemP("Title", "Artist", "Album") << MakeMockItemP("Other", "Somebody", "Album"));
+  ASSERT_EQ(2, playlist_.rowCount(QModelIndex()));
+
+  PlaylistFilter *filter = playlist_.filter();
+  filter->SetFilterText("artist");
+  EXPECT_EQ(1, filter->rowCount());
+  filter->SetFilterText("album");
+  EXPECT_EQ(2, filter->rowCount());
+  filter->SetFilterText("artist:some");
+  EXPECT_EQ(1, filter->rowCount());
+  filter->SetFilterText("title:=other");
+  EXPECT_EQ(1, filter->rowCount());
+  filter->SetFilterText("-title");
+  EXPECT_EQ(1, filter->rowCount());
+  filter->SetFilterText("nothing");
+  EXPECT_EQ(0, filter->rowCount());
+  filter->SetFilterText("");
+  EXPECT_EQ(2, filter->rowCount());
+
+}
+
+TEST_F(PlaylistTest, FilterNumericalColumns) {
+
+  auto make_song = [](const QString &title, const int year, const qint64 length) {
+    Song song;
+    song.Init(title, "artist", "album", length * kNsecPerSec);
+    song.set_year(year);
+    return PlaylistItemPtr(std::make_shared<SongPlaylistItem>(song));
+  };
+
+  playlist_.InsertItems(PlaylistItemList() << make_song("One", 1999, 225) << make_song("Two", 2005, 90) << make_song("Three", 2010, 300));
+
+  PlaylistFilter *filter = playlist_.filter();
+  filter->SetFilterText("year:>=2005");
+  EXPECT_EQ(2, filter->rowCount());
+  filter->SetFilterText("year:1999");
+  EXPECT_EQ(1, filter->rowCount());
+  filter->SetFilterText("year:!=1999");
+  EXPECT_EQ(2, filter->rowCount());
+  filter->SetFilterText("length:3:45");
+  EXPECT_EQ(1, filter->rowCount());
+  filter->SetFilterText("length:<4:00");
+  EXPECT_EQ(2, filter->rowCount());
+  filter->SetFilterText("year:>2000 length:>2:00");
+  EXPECT_EQ(1, filter->rowCount());
+
+}
+
+TEST_F(PlaylistTest, FilterTextCacheInvalidatedOnItemChanged) {
+
+  Song song;
+  song.Init("Before", "artist", "album", 123);
+  PlaylistItemPtr item = std::make_shared<SongPlaylistItem>(song);
+  playlist_.InsertItems(PlaylistItemList() << item);
+
+  EXPECT_EQ("before", playlist_.FilterText(0, Playlist::Column_Title));
+
+  Song changed_song(song);
+  changed_song.set_title("After");
+  item->SetTemporaryMetadata(changed_song);
+  EXPECT_EQ("before", playlist_.FilterText(0, Playlist::Column_Title));
+
+  playlist_.ItemChanged(0);
+  EXPECT_EQ("after", playlist_.FilterText(0, Playlist::Column_Title));
+
+}
+
+PlaylistItemList MakeFilterItems(const int count) {
+
+  PlaylistItemList items;
+  items.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    Song song;
+    song.Init(QString("Title %1").arg(i), QString("Artist %1").arg(i / 100), QString("Album %1").arg(i / 10), (i % 600) * kNsecPerSec);
+    song.set_year(1950 + i % 70);
+    items << PlaylistItemPtr(std::make_shared<SongPlaylistItem>(song));
+  }
+
+  return items;
+
+}
+
+// Applies the filter texts in turn, and checks the number of matching rows after each.
+// The rows are filtered in the background, the narrower texts only test the rows that matched the previous text.
+void ExpectFilterRowCounts(PlaylistFilter *filter, const int count, const QList<QPair<QString, int>> &filters) {
+
+  for (const QPair<QString, int> &filter_text : filters) {
+    QSignalSpy spy(filter, &PlaylistFilter::FilterApplied);
+    QElapsedTimer timer;
+    timer.start();
+    filter->SetFilterText(filter_text.first);
+    const qint64 gui_elapsed = timer.elapsed();
+    if (spy.isEmpty()) ASSERT_TRUE(spy.wait(60000));
+    qLog(Info) << "Filtered" << count << "items by" << filter_text.first << "in" << timer.elapsed() << "ms," << gui_elapsed << "ms on the GUI thread," << filter->rowCount() << "matches";
+    EXPECT_EQ(filter_text.second, filter->rowCount()) << filter_text.first.toStdString();
+  }
+
+}
+
+TEST_F(PlaylistTest, FilterManyItems) {
+
+  const int count = 1000;
+  playlist_.InsertItems(MakeFilterItems(count));
+
+  QList<QPair<QString, int>> filters;
+  filters << qMakePair(QString("a"), count)
+          << qMakePair(QString("ar"), count)
+          << qMakePair(QString("artist 9"), 100)
+          << qMakePair(QString("year:>2000"), 266)
+          << qMakePair(QString("title:9 length:<5:00"), 114)
+          << qMakePair(QString(), count);
+
+  ExpectFilterRowCounts(playlist_.filter(), count, filters);
+
+}
+
+// Timing run with a large playlist, run with --gtest_also_run_disabled_tests.
+TEST_F(PlaylistTest, DISABLED_FilterBenchmark) {
+
+  const int count = 100000;
+  playlist_.InsertItems(MakeFilterItems(count));
+
+  QList<QPair<QString, int>> filters;
+  filters << qMakePair(QString("a"), count)
+          << qMakePair(QString("ar"), count)
+          << qMakePair(QString("art"), count)
+          << qMakePair(QString("arti"), count)
+          << qMakePair(QString("artist 99"), 1100)
+          << qMakePair(QString("year:>2000"), 27132)
+          << qMakePair(QString("title:9 length:<5:00"), 19482)
+          << qMakePair(QString(), count);
+
+  ExpectFilterRowCounts(playlist_.filter(), count, filters);
+
+}
+
+TEST_F(PlaylistTest, SortByAlbumDiscTrack) {
+
+  auto make_song = [](const QString &album, const int disc, const int track) {
+    Song song;
+    song.Init(QString("%1 %2-%3").arg(album).arg(disc).arg(track), "artist", album, 123);
+    song.set_disc(disc);
+    song.set_track(track);
+    return PlaylistItemPtr(std::make_shared<SongPlaylistItem>(song));
+  };
+
+  PlaylistItemList items;
+  items << make_song("b", 1, 2) << make_song("a", 2, 1) << make_song("B", 1, 1) << make_song("a", 1, 3) << make_song("a", 1, 1);
+
+  Playlist::SortItems(items.begin(), items.end(), Playlist::Column_Album, Qt::AscendingOrder);
+  QStringList titles;
+  for (const PlaylistItemPtr &item : items) titles << item->Metadata().title();
+  EXPECT_EQ(QStringList() << "a 1-1" << "a 1-3" << "a 2-1" << "B 1-1" << "b 1-2", titles);
+
+  Playlist::SortItems(items.begin(), items.end(), Playlist::Column_Album, Qt::DescendingOrder);
+  titles.clear();
+  for (const PlaylistItemPtr &item : items) titles << item->Metadata().title();
+  EXPECT_EQ(QStringList() << "b 1-2" << "B 1-1" << "a 2-1" << "a 1-3" << "a 1-1", titles);
+
+}
+
+TEST_F(PlaylistTest, SortByFilenameBreadthFirst) {
+
+  auto make_song = [](const QString &filename) {
+    Song song;
+    song.Init(filename, "artist", "album", 123);
+    song.set_url(QUrl::fromLocalFile(filename));
+    return PlaylistItemPtr(std::make_shared<SongPlaylistItem>(song));
+  };
+
+  PlaylistItemList items;
+  items << make_song("/music/b/1.flac") << make_song("/music/z.flac") << make_song("/music/a/2.flac") << make_song("/music/a.flac");
+
+  Playlist::SortItems(items.begin(), items.end(), Playlist::Column_Filename, Qt::AscendingOrder);
+  QStringList titles;
+  for (const PlaylistItemPtr &item : items) titles << item->Metadata().title();
+  EXPECT_EQ(QStringList() << "/music/a.flac" << "/music/z.flac" << "/music/a/2.flac" << "/music/b/1.flac", titles);
+
+}
+
+// Items with the values spread, so a sort has to move most of them.
+PlaylistItemList MakeSortItems(const int count) {
+
+  PlaylistItemList items;
+  items.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    const int n = static_cast<int>((static_cast<qint64>(i) * 7919) % count);
+    Song song;
+    song.Init(QString("Title %1").arg(n), QString("Artist %1").arg(n / 100), QString("Album %1").arg(n / 10), (n % 600) * kNsecPerSec);
+    song.set_track(n % 10);
+    song.set_disc(n % 2);
+    song.set_year(1950 + n % 70);
+    song.set_rating(static_cast<float>(n % 11) / 10.0F);
+    song.set_url(QUrl::fromLocalFile(QString("/music/Artist %1/Album %2/%3.flac").arg(n / 100).arg(n / 10).arg(n)));
+    song.set_basefilename(QString("%1.flac").arg(n));
+    items << PlaylistItemPtr(std::make_shared<SongPlaylistItem>(song));
+  }
+
+  return items;
+
+}
+
+TEST_F(PlaylistTest, SortManyItems) {
+
+  const int count = 1000;
+  const PlaylistItemList items = MakeSortItems(count);
+
+  // Numerical columns end up in order.
+  PlaylistItemList sorted_items(items);
+  Playlist::SortItems(sorted_items.begin(), sorted_items.end(), Playlist::Column_Year, Qt::AscendingOrder);
+  ASSERT_EQ(count, sorted_items.count());
+  for (int i = 1; i < count; ++i) {
+    EXPECT_LE(sorted_items[i - 1]->Metadata().year(), sorted_items[i]->Metadata().year());
+  }
+
+  sorted_items = items;
+  Playlist::SortItems(sorted_items.begin(), sorted_items.end(), Playlist::Column_Length, Qt::DescendingOrder);
+  ASSERT_EQ(count, sorted_items.count());
+  for (int i = 1; i < count; ++i) {
+    EXPECT_GE(sorted_items[i - 1]->Metadata().length_nanosec(), sorted_items[i]->Metadata().length_nanosec());
+  }
+
+  // Text columns with a different value for each item give the same order whatever the order of the items was.
+  for (const int column : { Playlist::Column_Title, Playlist::Column_Filename, Playlist::Column_BaseFilename }) {
+    sorted_items = items;
+    Playlist::SortItems(sorted_items.begin(), sorted_items.end(), column, Qt::AscendingOrder);
+    PlaylistItemList reversed_items;
+    reversed_items.reserve(count);
+    for (int i = count - 1; i >= 0; --i) reversed_items << items[i];
+    Playlist::SortItems(reversed_items.begin(), reversed_items.end(), column, Qt::AscendingOrder);
+    ASSERT_EQ(count, reversed_items.count());
+    for (int i = 0; i < count; ++i) {
+      EXPECT_EQ(sorted_items[i], reversed_items[i]) << Playlist::column_name(static_cast<Playlist::Column>(column)).toStdString() << " item " << i;
+    }
+  }
+
+}
+
+// Timing run with large playlists, run with --gtest_also_run_disabled_tests.
+TEST_F(PlaylistTest, DISABLED_SortBenchmark) {
+
+  const QList<int> columns = QList<int>() << Playlist::Column_Title << Playlist::Column_Album << Playlist::Column_Length << Playlist::Column_Year << Playlist::Column_Filename << Playlist::Column_BaseFilename << Playlist::Column_Rating;
+
+  for (const int count : { 10000, 100000 }) {
+    const PlaylistItemList items = MakeSortItems(count);
+
+    for (const int column : columns) {
+      PlaylistItemList sorted_items(items);
+      QElapsedTimer timer;
+      timer.start();
+      Playlist::SortItems(sorted_items.begin(), sorted_items.end(), column, Qt::AscendingOrder);
+      const qint64 elapsed = timer.elapsed();
+      qLog(Info) << "Sorted" << count << "items by" << Playlist::column_name(static_cast<Playlist::Column>(column)) << "in" << elapsed << "ms";
+      ASSERT_EQ(count, sorted_items.count());
+    }
+  }
+
+}
 
 }  // namespace
@@ -0,0 +1,238 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2026, agent <agent@local>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <memory>
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+#include <QElapsedTimer>
+#include <QSqlDatabase>
+
+#include "test_utils.h"
+
+#include "core/database.h"
+#include "core/logging.h"
+#include "core/song.h"
+#include "core/sqlquery.h"
+#include "collection/collectionplaylistitem.h"
+#include "playlist/playlistbackend.h"
+#include "playlist/playlistitem.h"
+#include "playlist/songplaylistitem.h"
+
+// clazy:excludeall=non-pod-global-static,returning-void-expression
+
+namespace {
+
+class PlaylistBackendTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    database_ = std::make_shared<MemoryDatabase>(nullptr);
+    backend_ = std::make_unique<PlaylistBackend>(database_.get());
+    playlist_ = backend_->CreatePlaylist("Test", QString());
+  }
+
+  static PlaylistItemPtr MakeItem(const int number) {
+    Song song(Song::Source_LocalFile);
+    song.Init(QString("Title %1").arg(number), "Artist", "Album", 123);
+    song.set_url(QUrl::fromLocalFile(QString("/music/%1.flac").arg(number)));
+    return std::make_shared<SongPlaylistItem>(song);
+  }
+
+  static PlaylistItemList MakeItems(const int count) {
+    PlaylistItemList items;
+    items.reserve(count);
+    for (int i = 0; i < count; ++i) {
+      items << MakeItem(i);
+    }
+    return items;
+  }
+
+  static QStringList Titles(const PlaylistItemList &items) {
+    QStringList titles;
+    for (PlaylistItemPtr item : items) {  // clazy:exclude=range-loop-reference
+      titles << item->Metadata().title();
+    }
+    return titles;
+  }
+
+  QStringList SavedTitles() const {
+    QStringList titles;
+    const SongList songs = backend_->GetPlaylistSongs(playlist_);
+    for (const Song &song : songs) {
+      titles << song.title();
+    }
+    return titles;
+  }
+
+  void Save(const PlaylistItemList &items) {
+    backend_->SavePlaylist(playlist_, items, -1, PlaylistGeneratorPtr());
+  }
+
+  std::shared_ptr<Database> database_;  // NOLINT(cppcoreguidelines-non-private-member-variables-in-classes)
+  std::unique_ptr<PlaylistBackend> backend_;  // NOLINT(cppcoreguidelines-non-private-member-variables-in-classes)
+  int playlist_;  // NOLINT(cppcoreguidelines-non-private-member-variables-in-classes)
+};
+
+TEST_F(PlaylistBackendTest, SaveChanges) {
+
+  PlaylistItemList items = MakeItems(10);
+  Save(items);
+  EXPECT_EQ(Titles(items), SavedTitles());
+
+  // Move an item up
+  items.move(8, 2);
+  Save(items);
+  EXPECT_EQ(Titles(items), SavedTitles());
+
+  // Insert, remove and append items
+  items.insert(5, MakeItem(10));
+  items.removeAt(0);
+  items << MakeItem(11);
+  Save(items);
+  EXPECT_EQ(Titles(items), SavedTitles());
+
+  // Change the metadata of an item
+  Song song = items[3]->Metadata();
+  song.set_title("Changed");
+  items[3] = std::make_shared<SongPlaylistItem>(song);
+  Save(items);
+  EXPECT_EQ(Titles(items), SavedTitles());
+
+  // Reverse the playlist, which moves most items
+  std::reverse(items.begin(), items.end());
+  Save(items);
+  EXPECT_EQ(Titles(items), SavedTitles());
+
+}
+
+TEST_F(PlaylistBackendTest, SaveChangesAfterRestore) {
+
+  Save(MakeItems(20));
+
+  PlaylistItemList items = backend_->GetPlaylistItems(playlist_);
+  ASSERT_EQ(20, items.count());
+
+  // Insert more items between two items than there are free positions
+  for (int i = 0; i < 2000; ++i) {
+    items.insert(10, MakeItem(100 + i));
+  }
+  items.move(0, 15);
+  Save(items);
+  EXPECT_EQ(Titles(items), SavedTitles());
+
+  items.removeAt(5);
+  Save(items);
+  EXPECT_EQ(Titles(items), SavedTitles());
+
+}
+
+TEST_F(PlaylistBackendTest, RestorePages) {
+
+  const PlaylistItemList items = MakeItems(25);
+  Save(items);
+
+  PlaylistItemList restored_items;
+  for (int offset = 0; offset < 30; offset += 10) {
+    const PlaylistItemList page = backend_->GetPlaylistItems(playlist_, offset, 10);
+    EXPECT_EQ(qMin(10, 25 - offset), page.count());
+    restored_items << page;
+  }
+  EXPECT_EQ(Titles(items), Titles(restored_items));
+
+  // Saving a playlist of which only some pages were restored replaces all items.
+  const PlaylistItemList first_page = backend_->GetPlaylistItems(playlist_, 0, 10);
+  Save(first_page);
+  EXPECT_EQ(Titles(first_page), SavedTitles());
+
+}
+
+TEST_F(PlaylistBackendTest, SaveDuplicateItems) {
+
+  PlaylistItemList items = MakeItems(5);
+  items << items[2];
+  Save(items);
+  EXPECT_EQ(Titles(items), SavedTitles());
+
+  items.removeAt(2);
+  Save(items);
+  EXPECT_EQ(Titles(items), SavedTitles());
+
+}
+
+TEST_F(PlaylistBackendTest, SaveCollectionItemsById) {
+
+  Song song(Song::Source_Collection);
+  song.Init("Title", "Artist", "Album", 123);
+  song.set_id(42);
+  song.set_url(QUrl::fromLocalFile("/music/collection.flac"));
+  Save(PlaylistItemList() << std::make_shared<CollectionPlaylistItem>(song));
+
+  QSqlDatabase db(database_->Connect());
+  SqlQuery q(db);
+  q.prepare("SELECT collection_id, title, url FROM playlist_items WHERE playlist = :playlist");
+  q.BindValue(":playlist", playlist_);
+  ASSERT_TRUE(q.Exec());
+  ASSERT_TRUE(q.next());
+  EXPECT_EQ(42, q.value(0).toInt());
+  EXPECT_TRUE(q.value(1).isNull());
+  EXPECT_TRUE(q.value(2).toString().isEmpty());
+
+}
+
+// Timing run with a large playlist, run with --gtest_also_run_disabled_tests.  SaveChanges covers the same edits.
+TEST_F(PlaylistBackendTest, DISABLED_SaveBenchmark) {
+
+  const int count = 30000;
+  PlaylistItemList items = MakeItems(count);
+
+  QElapsedTimer timer;
+  timer.start();
+  Save(items);
+  qLog(Info) << "Saved" << count << "items in" << timer.elapsed() << "ms";
+
+  auto save_edit = [this, &items](const char *edit) {
+    QElapsedTimer edit_timer;
+    edit_timer.start();
+    Save(items);
+    qLog(Info) << "Saved" << items.count() << "items after" << edit << "in" << edit_timer.elapsed() << "ms";
+  };
+
+  items.move(count - 1, 0);
+  save_edit("moving one item");
+
+  items << MakeItem(count);
+  save_edit("appending one item");
+
+  items.removeAt(count / 2);
+  save_edit("removing one item");
+
+  Song song = items[100]->Metadata();
+  song.set_title("Changed");
+  items[100] = std::make_shared<SongPlaylistItem>(song);
+  save_edit("changing one item");
+
+  EXPECT_EQ(Titles(items), SavedTitles());
+
+}
+
+}  // namespace
@@ -20,6 +20,10 @@
 
 #include "test_utils.h"
 
+#ifdef __GLIBC__
+#  include <malloc.h>
+#endif
+
 #include <QObject>
 #include <QIODevice>
 #include <QDir>
@@ -60,6 +64,18 @@ void PrintTo(const ::QUrl &url, std::ostream &os) {
   os << url.toString().toStdString();
 }
 
+qint64 HeapBytes() {
+#ifdef __GLIBC__
+#  if __GLIBC_PREREQ(2, 33)
+  return static_cast<qint64>(mallinfo2().uordblks);
+#  else
+  return static_cast<qint64>(mallinfo().uordblks);
+#  endif
+#else
+  return -1;
+#endif
+}
+
 TemporaryResource::TemporaryResource(const QString &filename, QObject *parent) : QTemporaryFile(parent) {
 
   setFileTemplate(QDir::tempPath() + "/strawberry_test-XXXXXX." + filename.section('.', -1, -1));
@@ -23,6 +23,7 @@
 
 #include <iostream>
 
+#include <QtGlobal>
 #include <QMetaType>
 #include <QModelIndex>
 #include <QTemporaryFile>
@@ -51,6 +52,9 @@ void PrintTo(const ::QString& str, std::ostream& os);
 void PrintTo(const ::QVariant& var, std::ostream& os);
 void PrintTo(const ::QUrl& url, std::ostream& os);
 
+// Bytes allocated on the heap, or -1 if this is not known.
+qint64 HeapBytes();
+
 #define EXPOSE_SIGNAL0(n) \
     void Emit##n() { emit n(); }
 #define EXPOSE_SIGNAL1(n, t1) \